@@ -4,7 +4,18 @@
 
 #if defined(__linux__) || defined(__APPLE__) 
 
-#define FORCE_INLINE inline __attribute__((always_inline))
+// Same layout as the Win32 GUID so serialized GUIDs are portable
+typedef struct MAPLE_GUID
+{
+    uint32_t Data1;
+    uint16_t Data2;
+    uint16_t Data3;
+    uint8_t  Data4[8];
+} MAPLE_GUID;
+
+#define INVALID_FILE_ID -1
+#define FORCE_INLINE    inline __attribute__((always_inline))
+#define DebugBreak()    __builtin_trap()
 
 #elif defined(_WIN32)
 
@@ -0,0 +1,145 @@
+#ifndef _ARENA_H
+#define _ARENA_H
+
+//
+// A bump-pointer allocator for transient memory. Allocations are never freed
+// individually. Instead, a caller records a marker, allocates any scratch memory
+// it needs, and pops back to the marker when finished. The whole arena is reset
+// at once, for example at the start of a frame.
+//
+// An arena is not thread safe.
+//
+
+typedef struct arena* arena_t;
+typedef u64 arena_marker;
+
+void arena_init(arena_t *Arena, u64 Size, void *Ptr);
+void arena_free(arena_t *Arena);
+
+void* arena_alloc(arena_t Arena, u64 Size, u64 Alignment = 16);
+// Resizes an allocation. The last allocation of the arena is resized in place, any other
+// is copied to a new allocation (the old memory is only reclaimed when the arena pops).
+void* arena_realloc(arena_t Arena, void *Ptr, u64 OldSize, u64 NewSize, u64 Alignment = 16);
+void  arena_reset(arena_t Arena);
+
+arena_marker arena_push(arena_t Arena);
+void         arena_pop(arena_t Arena, arena_marker Marker);
+
+#ifdef __cplusplus
+
+// Pops the arena back to where it was when the scope was entered
+struct arena_scope
+{
+    arena_t      Arena;
+    arena_marker Marker;
+
+    arena_scope(arena_t arena) : Arena(arena), Marker(arena_push(arena)) {}
+    ~arena_scope() { arena_pop(Arena, Marker); }
+};
+
+#endif
+
+#endif //_ARENA_H
+
+#if defined(MAPLE_ARENA_IMPLEMENTATION)
+
+typedef struct arena
+{
+    u64   Size;
+    u64   Offset;
+
+    void *Start;
+
+    // Memory Usage tracking
+    u64   HighWater;
+} arena;
+
+void arena_init(arena_t *Arena, u64 Size, void *Ptr)
+{
+    if (!Ptr)
+    {
+        *Arena = 0;
+    }
+    else
+    {
+        *Arena = (arena_t)Ptr;
+        (*Arena)->Size      = Size - sizeof(arena);
+        (*Arena)->Offset    = 0;
+        (*Arena)->Start     = (void*)((char*)Ptr + sizeof(arena));
+        (*Arena)->HighWater = 0;
+    }
+}
+
+void arena_free(arena_t *Arena)
+{
+    (*Arena)->Size      = 0;
+    (*Arena)->Offset    = 0;
+    (*Arena)->Start     = NULL;
+    (*Arena)->HighWater = 0;
+    *Arena = NULL;
+}
+
+void* arena_alloc(arena_t Arena, u64 Size, u64 Alignment)
+{
+    if (Size == 0) return NULL;
+
+    void *Result = NULL;
+
+    uptr Base    = (uptr)Arena->Start;
+    uptr Aligned = memory_align(Base + Arena->Offset, (uptr)Alignment);
+    u64  Offset  = (u64)(Aligned - Base) + Size;
+
+    if (Offset <= Arena->Size)
+    {
+        Result = (void*)Aligned;
+        Arena->Offset = Offset;
+
+        if (Offset > Arena->HighWater) Arena->HighWater = Offset;
+    }
+
+    return Result;
+}
+
+void* arena_realloc(arena_t Arena, void *Ptr, u64 OldSize, u64 NewSize, u64 Alignment)
+{
+    if (!Ptr) return arena_alloc(Arena, NewSize, Alignment);
+
+    void *Result = NULL;
+
+    if ((char*)Ptr + OldSize == (char*)Arena->Start + Arena->Offset)
+    {
+        u64 Offset = (u64)((char*)Ptr - (char*)Arena->Start) + NewSize;
+        if (Offset <= Arena->Size)
+        {
+            Result = Ptr;
+            Arena->Offset = Offset;
+
+            if (Offset > Arena->HighWater) Arena->HighWater = Offset;
+        }
+    }
+    else
+    {
+        Result = arena_alloc(Arena, NewSize, Alignment);
+        if (Result) memcpy(Result, Ptr, (OldSize < NewSize) ? OldSize : NewSize);
+    }
+
+    return Result;
+}
+
+void arena_reset(arena_t Arena)
+{
+    Arena->Offset = 0;
+}
+
+arena_marker arena_push(arena_t Arena)
+{
+    return Arena->Offset;
+}
+
+void arena_pop(arena_t Arena, arena_marker Marker)
+{
+    assert(Marker <= Arena->Offset);
+    Arena->Offset = Marker;
+}
+
+#endif // MAPLE_ARENA_IMPLEMENTATION
@@ -198,7 +198,7 @@ r32 clamp(r32 min, r32 max, r32 val);
 r32 smoothstep(r32 v0, r32 v1, r32 t);
 r32 smootherstep(r32 v0, r32 v1, r32 t);
 
-static r32 random();
+static r32 random_r32();
 static r32 random_clamped(r32 Min, r32 Max);
 static i32 random_int_clamped(i32 Min, i32 Max);
 static v3 v3_random();
@@ -1230,14 +1230,14 @@ v3 v3_compute_normal(v3 a, v3 b, v3 c)
     return v3_norm(v3_cross(ba, ca));
 }
 
-static r32 random()
+static r32 random_r32()
 {
     return rand() / (RAND_MAX + 1.0f);
 }
 
 static r32 random_clamped(r32 Min, r32 Max)
 {
-    return Min + (Max - Min) * random();
+    return Min + (Max - Min) * random_r32();
 }
 
 static i32 random_int_clamped(i32 Min, i32 Max)
@@ -1250,9 +1250,9 @@ static v3 v3_random()
 {
     v3 Result;
     
-    Result.x = random();
-    Result.y = random();
-    Result.z = random();
+    Result.x = random_r32();
+    Result.y = random_r32();
+    Result.z = random_r32();
     
     return Result;
 }
@@ -3,7 +3,17 @@
 
 typedef struct memory* memory_t;
 
-void memory_init(memory_t *Memory, u64 Size, void *Ptr);
+// Allocation strategy used by a memory_t. First fit walks a single address-ordered
+// free list. Segregated fit keeps free blocks in power-of-two size class bins and
+// tracks non-empty bins in a bitmap, so finding, releasing and coalescing a block
+// does not depend on the number of free blocks in the heap.
+typedef enum memory_mode
+{
+    MemoryMode_FirstFit,
+    MemoryMode_Segregated,
+} memory_mode;
+
+void memory_init(memory_t *Memory, u64 Size, void *Ptr, memory_mode Mode = MemoryMode_FirstFit);
 void memory_free(memory_t *Memory);
 
 void* memory_alloc(memory_t   Memory, u64 Size);
@@ -14,18 +24,29 @@ void  memory_release(memory_t  Memory, void *Ptr);
 
 #if defined(MAPLE_MEMORY_IMPLEMENTATION)
 
-// TODO(Dustin): Handle multithreading allocation requests
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// NOTE(Dustin): A memory_t is not thread safe. Callers sharing an allocator across
+// threads are responsible for synchronization (see SysMemory).
 
 #define BLOCK_SIZE       8
 #define HEADER_SIZE      BLOCK_SIZE
 #define MIN_HEADER_SIZE  sizeof(void*)
 #define LIST_HEADER_SIZE 2*MIN_HEADER_SIZE
 
+// Segregated fit blocks store a boundary tag (copy of the block size) in the last
+// 8 bytes of a free block, so the minimum data size must hold both links and the tag.
+#define SEG_MIN_DATA_SIZE (LIST_HEADER_SIZE + BLOCK_SIZE)
+#define SEG_BIN_COUNT     64
+
 typedef struct header* header_t;
 
 typedef struct header
 {
-    u64 Size:63;
+    u64 Size:62;
+    u64 PrevFree:1; // Segregated fit only: the physically previous block is free
     u64 Used:1;
     
     header_t Next;
@@ -39,8 +60,15 @@ typedef struct memory
     void *Start;
     void *Brkp;
     
+    memory_mode Mode;
+    
     header_t FreeList;
     
+    // Segregated fit bins. Bin i holds free blocks with a data size in [2^i, 2^(i+1)).
+    // Bit i of BinMask is set when bin i is non-empty.
+    u64      BinMask;
+    header_t Bins[SEG_BIN_COUNT];
+    
     // Memory Usage tracking
     u64 NumAllocations;
     u64 UsedMemory;
@@ -51,6 +79,9 @@ typedef struct memory
 #define header_adjusted_size(n) (MIN_HEADER_SIZE + data_block_adjusted_size(n))
 #define header_to_mem(h)        (void*)((char*)(h) + MIN_HEADER_SIZE)
 #define mem_to_header(p)        (header_t)((char*)(p) - MIN_HEADER_SIZE)
+#define seg_adjusted_size(n)    (((n) >= SEG_MIN_DATA_SIZE) ? (n) : SEG_MIN_DATA_SIZE)
+#define seg_next_header(h)      (header_t)((char*)(h) + MIN_HEADER_SIZE + (h)->Size)
+#define seg_footer(h)           (u64*)((char*)(h) + MIN_HEADER_SIZE + (h)->Size - BLOCK_SIZE)
 
 file_internal header_t memory_find_free_header(header_t* FreeList, u64 Size);
 file_internal void memory_free_list_add(header_t *FreeList, header_t Header);
@@ -58,7 +89,16 @@ file_internal void memory_free_list_remove(header_t* FreeList, header_t HeaderTo
 file_internal header_t memory_block_split(header_t* FreeList, header_t Header, u64 Size);
 file_internal void memory_block_coalesce(header_t LeftHeader, header_t RightHeader);
 
-void memory_init(memory_t *Memory, u64 Size, void *Ptr)
+file_internal u32      memory_seg_bin_index(u64 Size);
+file_internal void     memory_seg_bin_add(memory_t Memory, header_t Header);
+file_internal void     memory_seg_bin_remove(memory_t Memory, header_t Header);
+file_internal header_t memory_seg_find_free_header(memory_t Memory, u64 Size);
+file_internal void     memory_seg_block_split(memory_t Memory, header_t Header, u64 Size);
+file_internal void     memory_seg_block_free(memory_t Memory, header_t Header);
+
+file_internal bool     memory_grow_in_place(memory_t Memory, header_t Header, u64 Size);
+
+void memory_init(memory_t *Memory, u64 Size, void *Ptr, memory_mode Mode)
 {
     assert(Size % BLOCK_SIZE == 0);
     if (!Ptr)
@@ -71,9 +111,14 @@ void memory_init(memory_t *Memory, u64 Size, void *Ptr)
         (*Memory)->Size = Size - sizeof(memory);
         (*Memory)->Start          = (void*)((char*)Ptr + sizeof(memory));
         (*Memory)->Brkp           = (*Memory)->Start;
+        (*Memory)->Mode           = Mode;
         (*Memory)->FreeList       = NULL;
+        (*Memory)->BinMask        = 0;
         (*Memory)->UsedMemory     = 0;
         (*Memory)->NumAllocations = 0;
+        
+        for (u32 i = 0; i < SEG_BIN_COUNT; ++i)
+            (*Memory)->Bins[i] = NULL;
     }
 }
 
@@ -89,6 +134,7 @@ void memory_free(memory_t *Memory)
     (*Memory)->Start          = NULL;
     (*Memory)->Brkp           = NULL;
     (*Memory)->FreeList       = NULL;
+    (*Memory)->BinMask        = 0;
     (*Memory)->Size           = 0;
     (*Memory)->UsedMemory     = 0;
     (*Memory)->NumAllocations = 0;
@@ -103,11 +149,28 @@ void* memory_alloc(memory_t Memory, u64 Size)
     void *Result = NULL;
     
     Size = mem_align(Size);
+    if (Memory->Mode == MemoryMode_Segregated)
+        Size = seg_adjusted_size(Size);
     u64 AdjSize = header_adjusted_size(Size);
     
     // Search for an available header
     header_t Header = NULL;
-    if (Memory->FreeList && (Header = memory_find_free_header(&Memory->FreeList, Size)))
+    if (Memory->Mode == MemoryMode_Segregated && (Header = memory_seg_find_free_header(Memory, Size)))
+    {
+        Header->Used = 1;
+        
+        header_t NextHeader = seg_next_header(Header);
+        if ((void*)NextHeader < Memory->Brkp) NextHeader->PrevFree = 0;
+        
+        memory_seg_block_split(Memory, Header, Size);
+        
+        Memory->NumAllocations++;
+        Memory->UsedMemory += Header->Size;
+        
+        Result = header_to_mem(Header);
+    }
+    else if (Memory->Mode == MemoryMode_FirstFit && Memory->FreeList && 
+             (Header = memory_find_free_header(&Memory->FreeList, Size)))
     {
         memory_block_split(&Memory->FreeList, Header, Size);
         Header->Used = 1;
@@ -125,8 +188,11 @@ void* memory_alloc(memory_t Memory, u64 Size)
             Memory->Brkp = (char*)Memory->Brkp + AdjSize;
             Header = (header_t)NextAddr;
             
-            Header->Size = Size;
-            Header->Used = 1;
+            // NOTE(Dustin): Segregated fit returns free blocks at the end of the heap
+            // to the break pointer, so the block before the break is never free.
+            Header->Size     = Size;
+            Header->PrevFree = 0;
+            Header->Used     = 1;
             Header->Next = NULL;
             Header->Prev = NULL;
             
@@ -151,6 +217,9 @@ void* memory_realloc(memory_t Memory, void *Ptr, u64 Size)
     void *Result = NULL;
     
     Size = mem_align(Size);
+    if (Memory->Mode == MemoryMode_Segregated)
+        Size = seg_adjusted_size(Size);
+    
     if (!Ptr)
     {
         Result = memory_alloc(Memory, Size);
@@ -161,13 +230,23 @@ void* memory_realloc(memory_t Memory, void *Ptr, u64 Size)
     }
     else if (Size > Header->Size)
     {
-        // Size is greater than the allocation, so we
-        // have allocate a new block of memory, copy
-        // the old block over, and finally free the old
-        // block
-        Result = memory_alloc(Memory, Size);
-        memcpy(Result, Ptr, Size);
-        memory_release(Memory, Ptr);
+        // Size is greater than the allocation. First attempt to
+        // absorb the physically next block (or the break pointer)
+        // so the data does not have to move. Otherwise, allocate
+        // a new block of memory, copy the old block over, and
+        // finally free the old block.
+        u64 OldSize = Header->Size;
+        
+        if (memory_grow_in_place(Memory, Header, Size))
+        {
+            Memory->UsedMemory += Header->Size - OldSize;
+            Result = Ptr;
+        }
+        else if ((Result = memory_alloc(Memory, Size)))
+        {
+            memcpy(Result, Ptr, OldSize);
+            memory_release(Memory, Ptr);
+        }
     }
     else
     {
@@ -175,7 +254,14 @@ void* memory_realloc(memory_t Memory, void *Ptr, u64 Size)
         // we attempt to split the block, adjust
         // size, add new block back to the free list
         // and return adjusted block.
-        memory_block_split(&Memory->FreeList, Header, Size);
+        u64 OldSize = Header->Size;
+        
+        if (Memory->Mode == MemoryMode_Segregated)
+            memory_seg_block_split(Memory, Header, Size);
+        else
+            memory_block_split(&Memory->FreeList, Header, Size);
+        
+        Memory->UsedMemory -= OldSize - Header->Size;
         
         Result = header_to_mem(Header);
     }
@@ -204,6 +290,12 @@ void memory_release(memory_t Memory, void *Ptr)
     Memory->UsedMemory -= Header->Size;
     Memory->NumAllocations--;
     
+    if (Memory->Mode == MemoryMode_Segregated)
+    {
+        memory_seg_block_free(Memory, Header);
+        return;
+    }
+    
     // When there is an 8 byte allocation, the total allocated size ends up being
     // 24 bytes, and only 8 bytes are reserved (16 bytes are for the Free List and are
     // only needed when in the Free List). So if this block were to be allocated again,
@@ -431,10 +523,197 @@ file_internal header_t memory_block_split(header_t* FreeList, header_t Header, u
     return Header;
 }
 
+file_internal bool memory_grow_in_place(memory_t Memory, header_t Header, u64 Size)
+{
+    bool Result = false;
+    
+    // Blocks are laid out contiguously from Start to Brkp, so the next
+    // block's header immediately follows this block's data.
+    u64      DataSize   = (Memory->Mode == MemoryMode_Segregated) ? Header->Size : data_block_adjusted_size(Header->Size);
+    header_t NextHeader = (header_t)((char*)header_to_mem(Header) + DataSize);
+    
+    if ((void*)NextHeader == Memory->Brkp)
+    {
+        // Last block in the heap, move the break pointer
+        char *NewBrkp = (char*)header_to_mem(Header) + ((Memory->Mode == MemoryMode_Segregated) ? Size : data_block_adjusted_size(Size));
+        if (NewBrkp <= ((char*)Memory->Start + Memory->Size))
+        {
+            Memory->Brkp = NewBrkp;
+            Header->Size = Size;
+            Result = true;
+        }
+    }
+    else if (!NextHeader->Used && DataSize + header_adjusted_size(NextHeader->Size) >= Size)
+    {
+        if (Memory->Mode == MemoryMode_Segregated)
+        {
+            memory_seg_bin_remove(Memory, NextHeader);
+            Header->Size = DataSize + MIN_HEADER_SIZE + NextHeader->Size;
+            
+            header_t AfterHeader = (header_t)((char*)header_to_mem(Header) + Header->Size);
+            if ((void*)AfterHeader < Memory->Brkp) AfterHeader->PrevFree = 0;
+            
+            memory_seg_block_split(Memory, Header, Size);
+        }
+        else
+        {
+            memory_free_list_remove(&Memory->FreeList, NextHeader);
+            Header->Size = DataSize + header_adjusted_size(NextHeader->Size);
+            
+            memory_block_split(&Memory->FreeList, Header, Size);
+        }
+        
+        Result = true;
+    }
+    
+    return Result;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Segregated Fit
+
+file_internal u32 memory_seg_bin_index(u64 Size)
+{
+    // Floor of log2(Size). Size is never 0 since the minimum data size is enforced.
+#if defined(_MSC_VER)
+    unsigned long Index = 0;
+    _BitScanReverse64(&Index, Size);
+    return (u32)Index;
+#else
+    return 63 - (u32)__builtin_clzll(Size);
+#endif
+}
+
+file_internal void memory_seg_bin_add(memory_t Memory, header_t Header)
+{
+    u32 Bin = memory_seg_bin_index(Header->Size);
+    
+    Header->Prev = NULL;
+    Header->Next = Memory->Bins[Bin];
+    if (Header->Next) Header->Next->Prev = Header;
+    
+    Memory->Bins[Bin] = Header;
+    Memory->BinMask |= BIT(Bin);
+}
+
+file_internal void memory_seg_bin_remove(memory_t Memory, header_t Header)
+{
+    u32 Bin = memory_seg_bin_index(Header->Size);
+    
+    if (Header->Prev) Header->Prev->Next = Header->Next;
+    else              Memory->Bins[Bin]  = Header->Next;
+    
+    if (Header->Next) Header->Next->Prev = Header->Prev;
+    
+    if (!Memory->Bins[Bin]) Memory->BinMask &= ~(1ULL << Bin);
+    
+    Header->Next = NULL;
+    Header->Prev = NULL;
+}
+
+file_internal header_t memory_seg_find_free_header(memory_t Memory, u64 Size)
+{
+    header_t Result = NULL;
+    
+    // Every block in a bin above the request's floor bin is large enough, so
+    // start the search at the first bin guaranteed to fit (Size rounded up to
+    // the next power of 2) and let the bitmap pick the first non-empty bin.
+    u32 FloorBin = memory_seg_bin_index(Size);
+    u32 FitBin   = ((Size & (Size - 1)) == 0) ? FloorBin : FloorBin + 1;
+    
+    u64 Mask = (FitBin < SEG_BIN_COUNT) ? (Memory->BinMask & (~0ULL << FitBin)) : 0;
+    if (Mask)
+    {
+#if defined(_MSC_VER)
+        unsigned long Bin = 0;
+        _BitScanForward64(&Bin, Mask);
+#else
+        u32 Bin = (u32)__builtin_ctzll(Mask);
+#endif
+        Result = Memory->Bins[Bin];
+    }
+    else if (FitBin != FloorBin && (Memory->BinMask & BIT(FloorBin)))
+    {
+        // No larger block is available. Before growing the heap, check the
+        // floor bin for a block that happens to be large enough.
+        for (header_t Iter = Memory->Bins[FloorBin]; Iter; Iter = Iter->Next)
+        {
+            if (Iter->Size >= Size)
+            {
+                Result = Iter;
+                break;
+            }
+        }
+    }
+    
+    if (Result)
+    {
+        memory_seg_bin_remove(Memory, Result);
+    }
+    
+    return Result;
+}
+
+file_internal void memory_seg_block_split(memory_t Memory, header_t Header, u64 Size)
+{
+    // The leftover has to hold a header and a minimum sized free block
+    if (Header->Size < Size + header_adjusted_size(SEG_MIN_DATA_SIZE)) return;
+    
+    u64 Leftover = Header->Size - Size;
+    Header->Size = Size;
+    
+    header_t SplitHeader = seg_next_header(Header);
+    SplitHeader->Size     = Leftover - MIN_HEADER_SIZE;
+    SplitHeader->PrevFree = Header->Used ? 0 : 1;
+    SplitHeader->Used     = 0;
+    
+    memory_seg_block_free(Memory, SplitHeader);
+}
+
+file_internal void memory_seg_block_free(memory_t Memory, header_t Header)
+{
+    // Merge with the physically next block if it is free
+    header_t NextHeader = seg_next_header(Header);
+    if ((void*)NextHeader < Memory->Brkp && !NextHeader->Used)
+    {
+        memory_seg_bin_remove(Memory, NextHeader);
+        Header->Size += header_adjusted_size(NextHeader->Size);
+    }
+    
+    // Merge with the physically previous block by reading its boundary tag
+    if (Header->PrevFree)
+    {
+        u64 PrevSize = *((u64*)Header - 1);
+        header_t PrevHeader = (header_t)((char*)Header - PrevSize - MIN_HEADER_SIZE);
+        
+        memory_seg_bin_remove(Memory, PrevHeader);
+        PrevHeader->Size += header_adjusted_size(Header->Size);
+        Header = PrevHeader;
+    }
+    
+    NextHeader = seg_next_header(Header);
+    if ((void*)NextHeader >= Memory->Brkp)
+    {
+        // Last block in the heap, hand the memory back to the break pointer
+        Memory->Brkp = Header;
+        return;
+    }
+    
+    *seg_footer(Header) = Header->Size;
+    NextHeader->PrevFree = 1;
+    
+    memory_seg_bin_add(Memory, Header);
+}
+
+#undef seg_footer
+#undef seg_next_header
+#undef seg_adjusted_size
 #undef mem_to_header
 #undef header_to_mem
 #undef header_adjusted_size
 #undef mem_align
+#undef SEG_BIN_COUNT
+#undef SEG_MIN_DATA_SIZE
 #undef LIST_HEADER_SIZE
 #undef MIN_LINK_SIZE
 #undef HEADER_SIZE
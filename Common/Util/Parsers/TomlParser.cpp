@@ -9,6 +9,20 @@
 #define TOML_ASSERT assert
 #endif
 
+// For stat
+#include <sys/stat.h>
+
+// NOTE(Dustin): Strings and comments are the long runs of a metadata file, their end is found
+// 16 characters at a time with SSE2. Everything else is short enough to walk one character at
+// a time.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TOML_SSE2
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
 #define TOMLDATA_AS_STRING(data)  (data)->s
 #define TOMLDATA_AS_INT(data)     (data)->i
 #define TOMLDATA_AS_BOOL(data)    (data)->b
@@ -16,80 +30,50 @@
 #define TOMLDATA_AS_TABLE(data)   (data)->t
 #define TOMLDATA_AS_ARRAY(data)   (data)->a
 #define TOMLDATA_STRING_LEN(data) (data)->sl
-#define TOMLDATA_ARRAY_LEN(a)     (int)arrlen(a)
+#define TOMLDATA_ARRAY_LEN(a)     TomlArrayLen(a)
 
-enum TomlLexemeType
-{
-    TomlLexeme_Identifier,
-    TomlLexeme_Seperator,
-    TomlLexeme_Operator,
-    TomlLexeme_Literal,
-    TomlLexeme_Comment,
-    
-    TomlLexeme_Count,
-};
+// Smallest block of the arena, the first block is this plus the size of the file
+#define TOML_ARENA_MIN_BLOCK  _KB(4)
+// Size of the scratch stack that lives on the C stack of TomlLoad, larger files move it to
+// the heap
+#define TOML_STACK_INLINE_SIZE _KB(4)
 
-struct TomlLexeme
+struct TomlArena
 {
-    TomlLexemeType  type;
-    char           *start;
-    int             len;
-    int             line;
+    TomlArena *next;
+    uint64_t   size; // bytes after the block header
+    uint64_t   used;
 };
 
-struct TomlScanner
+// Scratch space of the parser. The elements of an array and the key/values of an object are
+// pushed while they are parsed, and copied to the arena in one piece once their count is
+// known. Arrays and objects are nested, so the stack only ever changes at the top.
+struct TomlStack
 {
-    char   *start;   // beginning of the file
-    char   *end;     // end of the file
-    char   *iter;    // current location in the file
-    TomlLexeme *lexemes; // list of lexemes completed after scanning th efile
-};
-
-// Fun fact, Windows in all its glory decided to enumerate "TokenType"
-// As if that is not a common parser name...
-enum TomlTokenType
-{
-    // Identifiers
-    TomlToken_Identifier,
-    
-    // Seperators
-    TomlToken_OpenBrace,
-    TomlToken_CloseBrace,
-    TomlToken_OpenBracket,
-    TomlToken_CloseBracket,
-    TomlToken_Comma,
-    TomlToken_NewLine,
-    
-    // Operators
-    TomlToken_Equals,
-    
-    // Literals
-    TomlToken_String,
-    TomlToken_Boolean,
-    TomlToken_Integer,
-    TomlToken_Float,
-    
-    TomlToken_Count,
+    char     *data;
+    uint64_t  size;
+    uint64_t  cap;
+    bool      on_heap;
 };
 
-struct TomlToken
-{
-    TomlTokenType type;
-    char         *start;
-    int           len;
-    int           line;
-    union
-    { // converted literal data
-        int         i; // integer literal
-        bool        b; // boolean literal
-        float       f; // float   literal
-        char       *s; // string  literal
-    };
+struct TomlParser
+{
+    char      *iter;
+    char      *end;   // the NULL terminator of the file
+    Toml      *toml;
+    TomlStack  stack;
 };
 
-struct TomlTokenizer
+// Cache file being written. Everything is written at an offset, since the buffer moves when
+// it grows, and every pointer written is recorded for the relocation.
+struct TomlCacheWriter
 {
-    TomlToken *tokens;
+    char     *data;
+    uint64_t  size;
+    uint64_t  cap;
+    uint64_t *relocs;
+    uint32_t  reloc_count;
+    uint32_t  reloc_cap;
 };
 
 struct TomlBuffer
@@ -101,31 +85,60 @@ struct TomlBuffer
 };
 
 static int        TomlStrToInt(const char *start, const char *stop);
-static float      TomlStrToFloat(const char *ptr);
+static float      TomlStrToFloat(const char *start, const char *stop);
 static bool       TomlIsChar(char c);
 static bool       TomlIsDigit(char c);
+static bool       TomlIsIdentChar(char c);
 static bool       TomlIsSkippableChar(char c);
-static bool       TomlLexemeIsIdentifier(const char *buffer);
-static bool       TomlLexemeIsSeperator(const char *buffer);
-static bool       TomlLexemeIsOperator(const char *buffer);
-static bool       TomlLexemeIsLiteral(const char *buffer);
-static bool       TomlLexemeIsComment(const char *buffer);
-static TomlResult TomlScanFile(TomlScanner *scanner);
-static TomlResult TomlTokenizeFile(TomlTokenizer *tokenizer, TomlScanner *scanner);
-static TomlResult TomlParseArray(TomlData *array, TomlToken *tokens, int token_count, int *iter_advance);
-static TomlResult TomlParseExpression(TomlObject *object, TomlToken *tokens, int token_count, int *iter_advance);
-static TomlResult TomlParseObject(Toml *toml, TomlToken *tokens, int token_count, int *iter_advance);
-static TomlResult TomlParseTitle(char **title, TomlToken *tokens, int token_count, int *iter_advance);
-static TomlResult TomlParseFile(Toml *toml, TomlTokenizer *tokenizer);
+static uint32_t   TomlHash(const char *str, int len);
+static int        TomlArrayLen(const void *array);
+
+static void*      TomlArenaAlloc(Toml *toml, uint64_t size);
+static void       TomlArenaFree(Toml *toml);
+static void*      TomlStackPush(TomlParser *parser, const void *data, uint64_t size);
+
+static char*      TomlFindChar(char *iter, char *end, char c);
+static char*      TomlSkipSpaces(char *iter, char *end);
+static void       TomlSkipBlank(TomlParser *parser, bool skip_newlines);
+static void       TomlParseName(TomlParser *parser, char **name, uint32_t *hash);
+static char       TomlTerminate(TomlParser *parser);
+static TomlResult TomlParseValue(TomlParser *parser, TomlData *value);
+static TomlResult TomlParseArray(TomlParser *parser, TomlData *array);
+static TomlResult TomlParseKeyValue(TomlParser *parser, bool in_object);
+static TomlResult TomlParseObjectName(TomlParser *parser, char **name, uint32_t *hash);
+static TomlResult TomlParseFile(TomlParser *parser);
+static TomlResult TomlParseFileData(Toml *toml, int size);
+
+static uint64_t   TomlHash64(const void *data, uint64_t size);
+static uint64_t   TomlCacheChecksum(const char *doc, uint64_t size);
+static uint64_t   TomlCacheReserve(TomlCacheWriter *writer, uint64_t size);
+static void       TomlCacheSetPointer(TomlCacheWriter *writer, uint64_t slot, uint64_t target);
+static uint64_t   TomlCacheWriteString(TomlCacheWriter *writer, const char *str, uint64_t len);
+static uint64_t   TomlCacheWriteArray(TomlCacheWriter *writer, TomlData *array);
+static void       TomlCacheWriteData(TomlCacheWriter *writer, uint64_t slot);
+static uint64_t   TomlCacheWriteIndex(TomlCacheWriter *writer, uint32_t *index, uint32_t index_mask);
+static uint64_t   TomlCacheWriteKeyValues(TomlCacheWriter *writer, TomlKeyValue *table);
+static uint64_t   TomlCacheWriteObjects(TomlCacheWriter *writer, TomlObjectKeyValue *table);
+static void       TomlCacheCompile(TomlCache *cache, Toml *toml, const char *filepath, uint64_t path_hash,
+                                   uint64_t hash, uint64_t time, uint64_t size);
+static bool       TomlCacheIsValid(const char *doc, uint64_t size);
+static void       TomlCacheRelocate(char *doc, uint64_t delta);
+static char*      TomlCacheFind(TomlCache *cache, const char *filepath, uint64_t path_hash);
+static void       TomlCacheUse(Toml *toml, TomlCache *cache, char *doc);
+static int        TomlCachePendingCmp(const void *left, const void *right);
+static void       TomlCacheSave(TomlCache *cache);
 
 static void*      TomlAlloc_Internal(uint64_t size);
 static void       TomlFree_Internal(void *ptr);
 static void       TomlLoadFile_Internal(const char* file_path, u8** buffer, int* size);
 static void       TomlFreeFile_Internal(void *ptr);
+static bool       TomlGetFileInfo_Internal(const char* file_path, uint64_t* write_time, uint64_t* size);
+static void*      TomlMapFile_Internal(const char* file_path, uint64_t* size);
+static void       TomlUnmapFile_Internal(void *ptr, uint64_t size);
+static void       TomlWriteFile_Internal(const char* file_path, const void* buffer, uint64_t size);
 
-/* Testing purposes only */
-static void       TomlScannerPrintResults(TomlScanner *scanner);
-static void       TomlTokenizerPrintResults(TomlTokenizer *tokenizer);
+static void*      TomlHeapArrayPush(void *array, const void *elem, int elem_size);
+static void       TomlHeapArrayFree(TomlData *data);
 
 static void       TomlBufferInit(TomlBuffer *buffer, int initial_size);
 static void       TomlBufferFree(TomlBuffer *buffer);
@@ -139,24 +152,40 @@ TomlCallbacks g_toml_internal_callbacks = {
     TomlFree_Internal,
     TomlLoadFile_Internal,
     TomlFreeFile_Internal,
+    TomlGetFileInfo_Internal,
+    TomlMapFile_Internal,
+    TomlUnmapFile_Internal,
+    TomlWriteFile_Internal,
 };
 
-static int 
+static int
 TomlStrToInt(const char *start, const char *stop)
 {
+    bool negative = (start < stop && start[0] == '-');
+    if (negative) ++start;
+
     int result = 0;
     for (const char *c = start; c < stop; ++c)
     {
-        result = result * 10 + c[0] - '0';
+        if (c[0] != '_') result = result * 10 + c[0] - '0';
     }
-    return result;
+    return negative ? -result : result;
 }
 
-static float 
-TomlStrToFloat(const char *ptr)
+static float
+TomlStrToFloat(const char *start, const char *stop)
 {
     // TODO(Dustin): Implement a more reliable parser for floats
-    float result = strtof(ptr, 0);
+    // strtof stops at the '_' separators, so they are dropped first
+    char buffer[64];
+    int  len = 0;
+    for (const char *c = start; c < stop && len < (int)sizeof(buffer) - 1; ++c)
+    {
+        if (c[0] != '_') buffer[len++] = c[0];
+    }
+    buffer[len] = 0;
+
+    float result = strtof(buffer, 0);
     return result;
 }
 
@@ -166,1083 +195,1434 @@ TomlIsChar(char c)
     return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
 }
 
-static bool 
+static bool
 TomlIsDigit(char c)
 {
     return c >= '0' && c <= '9';
 }
 
+static bool
+TomlIsIdentChar(char c)
+{
+    return TomlIsChar(c) || TomlIsDigit(c) || c == '_';
+}
+
 static bool
 TomlIsSkippableChar(char c)
 {
-    bool result = false;
-    switch (c)
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// FNV-1a
+static uint32_t
+TomlHash(const char *str, int len)
+{
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < len; ++i)
     {
-        case ' ':
-        case '\0': /* Not sure if null terminator should be skippable */
-        case '\t':
-        case '\r': result = true;  break;
-        default:   result = false; break;
+        hash = (hash ^ (uint8_t)str[i]) * 16777619u;
     }
-    return result;
+    return hash;
 }
 
-static bool
-TomlLexemeIsIdentifier(const char *buffer)
+static int
+TomlArrayLen(const void *array)
 {
-    return TomlIsChar(buffer[0]);
+    return array ? ((const TomlArrayHeader*)array - 1)->len : 0;
 }
 
-static bool
-TomlLexemeIsSeperator(const char *buffer)
+#if defined(TOML_SSE2)
+static int
+TomlCountTrailingZeros(uint32_t mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (int)index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+//-----------------------------------------------------------------------------------------------//
+// Arena
+
+static void*
+TomlArenaAlloc(Toml *toml, uint64_t size)
 {
-    bool result;
-    switch (buffer[0])
+    // Every allocation is an array of pointers and ints, 8 byte alignment is enough
+    size = (size + 7) & ~(uint64_t)7;
+
+    TomlArena *block = toml->arena;
+    if (!block || block->used + size > block->size)
     {
-        case '[':
-        case ']':
-        case '{':
-        case '}':
-        case ',':
-        case '\n': result = true;  break;
-        default:   result = false; break;
+        uint64_t block_size = block ? block->size * 2 : TOML_ARENA_MIN_BLOCK;
+        if (block_size < size) block_size = size;
+
+        TomlArena *next = (TomlArena*)g_toml_internal_callbacks.Alloc(sizeof(TomlArena) + block_size);
+        next->next = block;
+        next->size = block_size;
+        next->used = 0;
+        toml->arena = next;
+        block = next;
     }
+
+    void *result = (char*)(block + 1) + block->used;
+    block->used += size;
     return result;
 }
 
-static bool
-TomlLexemeIsOperator(const char *buffer)
+static void
+TomlArenaFree(Toml *toml)
 {
-    bool result = false;
-    if (buffer[0] == '=')
-        result = true;
-    return result;
+    TomlArena *block = toml->arena;
+    while (block)
+    {
+        TomlArena *next = block->next;
+        g_toml_internal_callbacks.Free(block);
+        block = next;
+    }
+    toml->arena = NULL;
 }
 
-static bool
-TomlLexemeIsLiteral(const char *buffer)
-{
-    bool result = false;
-    
-    if (buffer[0] == '\"')
-        result = true;
-    else if (TomlIsDigit(buffer[0]))
-        result = true;
-    else if (buffer[0] == '.')
-        result = true;
-    else if ((strncmp(buffer, "true", 4) == 0) || (strncmp(buffer, "false", 5) == 0))
-        result = true;
-    
+static void*
+TomlStackPush(TomlParser *parser, const void *data, uint64_t size)
+{
+    TomlStack *stack = &parser->stack;
+    if (stack->size + size > stack->cap)
+    {
+        uint64_t cap = stack->cap * 2;
+        if (cap < stack->size + size) cap = stack->size + size;
+
+        char *tmp = (char*)g_toml_internal_callbacks.Alloc(cap);
+        memcpy(tmp, stack->data, stack->size);
+        if (stack->on_heap) g_toml_internal_callbacks.Free(stack->data);
+
+        stack->data    = tmp;
+        stack->cap     = cap;
+        stack->on_heap = true;
+    }
+
+    void *result = stack->data + stack->size;
+    memcpy(result, data, size);
+    stack->size += size;
     return result;
 }
 
-static bool
-TomlLexemeIsComment(const char *buffer)
+// Copies the "count" items on the top of the stack into an arena array, and pops them
+template<typename T> static T*
+TomlStackPopArray(TomlParser *parser, int count)
 {
-    bool result = false;
-    if (buffer[0] == '#') 
-        result = true;
-    return result;
+    if (count == 0) return NULL;
+
+    uint64_t bytes = (uint64_t)count * sizeof(T);
+    TomlArrayHeader *header = (TomlArrayHeader*)TomlArenaAlloc(parser->toml, sizeof(TomlArrayHeader) + bytes);
+    header->len = count;
+    header->cap = count;
+
+    parser->stack.size -= bytes;
+    memcpy(header + 1, parser->stack.data + parser->stack.size, bytes);
+    return (T*)(header + 1);
 }
 
-static TomlResult
-TomlScanFile(TomlScanner *scanner)
+// Looks up a key in a table of TomlKeyValue or TomlObjectKeyValue
+template<typename T> static T*
+TomlFindKey(T *table, uint32_t *index, uint32_t index_mask, const char *name, uint32_t hash)
 {
-    TomlResult result = TomlResult_Success;
-    char *iter = scanner->start;
-    int   line = 0;
-    while (iter < scanner->end)
+    if (index)
     {
-        // Skip any unnecessary characters
-        while (TomlIsSkippableChar(iter[0]))
-            ++iter;
-        if (iter >= scanner->end) break;
-        
-        TomlLexeme lex = {};
-        lex.type = TomlLexeme_Count;
-        lex.line = line;
-        
-        if (TomlLexemeIsSeperator(iter))
+        for (uint32_t slot = hash & index_mask; index[slot]; slot = (slot + 1) & index_mask)
         {
-            if (iter[0] == '\n')
-                ++line;
-            
-            lex.type  = TomlLexeme_Seperator;
-            lex.start = iter;
-            lex.len   = 1;
-            iter += lex.len;
+            T *item = table + index[slot] - 1;
+            if (item->hash == hash && strcmp(item->key, name) == 0) return item;
         }
-        else if (TomlLexemeIsOperator(iter))
+        return NULL;
+    }
+
+    int len = TomlArrayLen(table);
+    for (int i = 0; i < len; ++i)
+    {
+        if (table[i].hash == hash && strcmp(table[i].key, name) == 0) return table + i;
+    }
+    return NULL;
+}
+
+// Moves the "count" key/values on the top of the stack into an arena table. A key that was
+// already seen takes the new value and keeps its position. Tables with more than
+// TOML_INDEX_MIN_COUNT items also get a hash index, the slots store the position + 1.
+template<typename T> static T*
+TomlStackPopTable(TomlParser *parser, int count, uint32_t **index, uint32_t *index_mask)
+{
+    *index      = NULL;
+    *index_mask = 0;
+    if (count == 0) return NULL;
+
+    parser->stack.size -= (uint64_t)count * sizeof(T);
+    T *items = (T*)(parser->stack.data + parser->stack.size);
+
+    TomlArrayHeader *header = (TomlArrayHeader*)TomlArenaAlloc(parser->toml, sizeof(TomlArrayHeader) + count * sizeof(T));
+    header->len = 0;
+    header->cap = count;
+    T *table = (T*)(header + 1);
+
+    if (count > TOML_INDEX_MIN_COUNT)
+    {
+        uint32_t slots = 1;
+        while (slots < (uint32_t)count * 2) slots <<= 1;
+
+        *index      = (uint32_t*)TomlArenaAlloc(parser->toml, slots * sizeof(uint32_t));
+        *index_mask = slots - 1;
+        memset(*index, 0, slots * sizeof(uint32_t));
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        T *existing = TomlFindKey(table, *index, *index_mask, items[i].key, items[i].hash);
+        if (existing)
         {
-            lex.type  = TomlLexeme_Operator;
-            lex.start = iter;
-            lex.len   = 1;
-            iter     += lex.len;
+            existing->value = items[i].value;
+            continue;
         }
-        else if (TomlLexemeIsLiteral(iter))
+
+        if (*index)
         {
-            lex.type  = TomlLexeme_Literal;
-            lex.start = iter;
-            
-            if (iter[0] == '\"')
-            { 
-                // consume until the next quotation
-                // Must be handle seperately because string
-                // literals allow spaces, while bool/int/float
-                // literals do not allow spaces
-                do { ++iter; } 
-                while (iter[0] != '\"');
-                ++iter; // consume the last quotation
-            }
-            else
-            { // consume digits, characters, decimals
-                do { ++iter; } 
-                while (TomlIsDigit(iter[0]) || TomlIsChar(iter[0]) || iter[0] == '.');
-            }
-            lex.len = (int)(iter - lex.start);
+            uint32_t slot = items[i].hash & *index_mask;
+            while ((*index)[slot]) slot = (slot + 1) & *index_mask;
+            (*index)[slot] = header->len + 1;
         }
-        else if (TomlLexemeIsIdentifier(iter))
+        table[header->len++] = items[i];
+    }
+
+    return table;
+}
+
+//-----------------------------------------------------------------------------------------------//
+// Parser
+
+// @returns the first "c" in [iter, end), or end
+static char*
+TomlFindChar(char *iter, char *end, char c)
+{
+#if defined(TOML_SSE2)
+    __m128i needle = _mm_set1_epi8(c);
+    for (; end - iter >= 16; iter += 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)iter);
+        int     mask  = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+        if (mask) return iter + TomlCountTrailingZeros((uint32_t)mask);
+    }
+#endif
+
+    while (iter < end && iter[0] != c) ++iter;
+    return iter;
+}
+
+// @returns the first character in [iter, end) that is not a space, tab or '\r', or end
+static char*
+TomlSkipSpaces(char *iter, char *end)
+{
+#if defined(TOML_SSE2)
+    // Only indentation is long enough to be worth it
+    while (end - iter >= 16 && TomlIsSkippableChar(iter[0]) && TomlIsSkippableChar(iter[1]))
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)iter);
+        __m128i space = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+                                                  _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))),
+                                     _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')));
+
+        uint32_t mask = ~(uint32_t)_mm_movemask_epi8(space) & 0xFFFF;
+        if (mask) return iter + TomlCountTrailingZeros(mask);
+        iter += 16;
+    }
+#endif
+
+    while (iter < end && TomlIsSkippableChar(iter[0])) ++iter;
+    return iter;
+}
+
+// Skips spaces and comments, and newlines if "skip_newlines" is set
+static void
+TomlSkipBlank(TomlParser *parser, bool skip_newlines)
+{
+    char *iter = parser->iter;
+    char *end  = parser->end;
+    for (;;)
+    {
+        iter = TomlSkipSpaces(iter, end);
+        if (iter >= end) break;
+
+        if (iter[0] == '#')
         {
-            lex.type = TomlLexeme_Identifier;
-            lex.start = iter;
-            { // consume the identifier
-                do { ++iter; } 
-                while (TomlIsDigit(iter[0]) || TomlIsChar(iter[0]) || iter[0] == '_');
-            }
-            lex.len = (int)(iter - lex.start);
+            iter = TomlFindChar(iter, end, '\n');
         }
-        else if (TomlLexemeIsComment(iter))
+        else if (iter[0] == '\n' && skip_newlines)
         {
-            lex.type  = TomlLexeme_Comment;
-            lex.start = iter;
-            { // consume the identifier
-                do { ++iter; } 
-                while (iter < scanner->end && iter[0] != '\n');
-            }
-            lex.len = (int)(iter - lex.start);
-        }
-        else
-        { // Unknown lexeme
-            result = TomlResult_UnknownLexeme;
-            return result;
+            ++iter;
         }
-        
-        arrput(scanner->lexemes, lex);
+        else break;
     }
-    return result;
+    parser->iter = iter;
 }
 
-static TomlResult
-TomlTokenizeFile(TomlTokenizer *tokenizer, TomlScanner *scanner)
-{
-    TomlResult result = TomlResult_Success;
-    for (int i = 0; i < (int)arrlen(scanner->lexemes); ++i)
-    {
-        TomlLexeme *lex = scanner->lexemes + i;
-        
-        TomlToken token = {};
-        token.type  = TomlToken_Count;
-        token.start = lex->start;
-        token.len   = lex->len;
-        token.line  = lex->line;
-        
-        switch (lex->type)
-        {
-            case TomlLexeme_Identifier:
-            {
-                token.type = TomlToken_Identifier;
-            } break;
-            
-            case TomlLexeme_Seperator:
-            {
-                if (lex->start[0] == '[')
-                    token.type = TomlToken_OpenBrace;
-                else if (lex->start[0] == ']')
-                    token.type = TomlToken_CloseBrace;
-                else if (lex->start[0] == '{')
-                    token.type = TomlToken_OpenBracket;
-                else if (lex->start[0] == '}')
-                    token.type = TomlToken_CloseBracket;
-                else if (lex->start[0] == ',')
-                    token.type = TomlToken_Comma;
-                else if (lex->start[0] == '\n')
-                {
-                    // Strip empty lines. An empty line is a line
-                    // in which the previous token is newline token
-                    if (arrlen(tokenizer->tokens) == 0 || 
-                        tokenizer->tokens[arrlen(tokenizer->tokens)-1].type == TomlToken_NewLine) 
-                        continue;
-                    token.type = TomlToken_NewLine;
-                }
-                else
-                { // Uknown seperator type
-                    result = TomlResult_InvalidSyntax;
-                    return result;
-                }
-            } break;
-            
-            case TomlLexeme_Operator:
-            {
-                if (lex->start[0] == '=')
-                    token.type = TomlToken_Equals;
-                else
-                { // Uknown operator type
-                    result = TomlResult_InvalidSyntax;
-                    return result;
-                }
-            } break;
-            
-            case TomlLexeme_Literal:
-            {
-                if (lex->start[0] == '\"')
-                {
-                    token.type = TomlToken_String;
-                    token.len -= 2; // consume the quoations
-                    token.s = token.start + 1;
-                }
-                else if (lex->start[0] == 't')
-                {
-                    token.type = TomlToken_Boolean;
-                    token.b = true;
-                }
-                else if (lex->start[0] == 'f')
-                {
-                    token.type = TomlToken_Boolean;
-                    token.b = false;
-                }
-                else if (TomlIsDigit(lex->start[0]) || lex->start[0] == '.')
-                {
-                    token.type = TomlToken_Integer;
-                    // determine if token is an integer or float
-                    for (int c = 0; c < lex->len; ++c)
-                    {
-                        if (lex->start[c] == '.')
-                        {
-                            token.type = TomlToken_Float;
-                            break;
-                        }
-                    }
-                    
-                    if (token.type == TomlToken_Integer)
-                        token.i = TomlStrToInt(lex->start, lex->start + lex->len);
-                    else
-                        token.f = TomlStrToFloat(lex->start);
-                }
-            } break;
-            
-            // comments are stripped
-            case TomlLexeme_Comment:
-            default: continue;
-        }
-        
-        arrput(tokenizer->tokens, token);
+// Reads an identifier ([A-Za-z][A-Za-z0-9_]*) starting at the iterator, which is left on the
+// character after it. The identifier is not terminated yet, see TomlTerminate.
+static void
+TomlParseName(TomlParser *parser, char **name, uint32_t *hash)
+{
+    char     *iter   = parser->iter;
+    uint32_t  result = 2166136261u;
+    while (TomlIsIdentChar(iter[0]))
+    {
+        result = (result ^ (uint8_t)iter[0]) * 16777619u;
+        ++iter;
     }
-    
-    return result;
+
+    *name        = parser->iter;
+    *hash        = result;
+    parser->iter = iter;
 }
 
-// @returns the offset from the start of the array. For example, if 5 tokens
-// were consumed to parse the object, then 5 will be returned
-static TomlResult
-TomlParseArray(TomlData *array, TomlToken *tokens, int token_count, int *iter_advance)
-{
-    TomlResult result = TomlResult_Success;
-    array->a = 0;
-    
-    bool found_comma = true;
-    int offset = 0;
-    TomlToken *iter = tokens;
-    TomlType array_type = Toml_Count;
-    while (offset < token_count && iter->type != TomlToken_CloseBrace)
-    {
-        switch (iter->type)
-        {
-            case TomlToken_OpenBrace:
-            { // Nested arrays
-                if (array_type == Toml_Count) array_type = Toml_Array; // set array type
-                if (array_type != Toml_Array) 
-                { // Did not find an array type
-                    result = TomlResult_UnexpectedDataType;
-                    return result;
-                }
-                if (!found_comma)
-                { // Did not find comma delimeter between array elements
-                    result = TomlResult_InvalidSyntax;
-                    return result;
-                }
-                else
-                    found_comma = false;
-                
-                ++offset;
-                
-                TomlData data = {};
-                data.type = Toml_Array;
-                result = TomlParseArray(&data, tokens + offset, token_count - offset, &offset);
-                if (result != TomlResult_Success) return result;
-                arrput(array->a, data);
-            } break;
-            
-            case TomlToken_Integer:
-            {
-                if (array_type == Toml_Count) array_type = Toml_Int; // set array type
-                if (array_type != Toml_Int) // Does not match array type
-                { // Did not find an int type
-                    result = TomlResult_UnexpectedDataType;
-                    return result;
-                }
-                if (!found_comma)
-                { // Did not find comma delimeter between array elements
-                    result = TomlResult_InvalidSyntax;
-                    return result;
-                }
-                else
-                    found_comma = false;
-                
-                TomlData data = {};
-                data.type = Toml_Int;
-                data.i = iter->i;
-                arrput(array->a, data);
-                ++offset;
-            } break;
-            
-            case TomlToken_Boolean:
-            {
-                if (array_type == Toml_Count) array_type = Toml_Bool; // set array type
-                if (array_type != Toml_Bool) // Does not match array type
-                { // Did not find an boolean type
-                    result = TomlResult_UnexpectedDataType;
-                    return result;
-                }
-                if (!found_comma)
-                { // Did not find comma delimeter between array elements
-                    result = TomlResult_InvalidSyntax;
-                    return result;
-                }
-                else
-                    found_comma = false;
-                
-                TomlData data = {};
-                data.type = Toml_Bool;
-                data.b = iter->b;
-                arrput(array->a, data);
-                ++offset;
-            } break;
-            
-            case TomlToken_Float:
-            {
-                if (array_type == Toml_Count) array_type = Toml_Float; // set array type
-                if (array_type != Toml_Float) // Does not match array type
-                { // Did not find an float type
-                    result = TomlResult_UnexpectedDataType;
-                    return result;
-                }
-                if (!found_comma)
-                { // Did not find comma delimeter between array elements
-                    result = TomlResult_InvalidSyntax;
-                    return result;
-                }
-                else
-                    found_comma = false;
-                
-                TomlData data = {};
-                data.type = Toml_Float;
-                data.f = iter->f;
-                arrput(array->a, data);
-                ++offset;
-            } break;
-            
-            case TomlToken_String:
-            {
-                if (array_type == Toml_Count) array_type = Toml_String; // set array type
-                if (array_type != Toml_String) // Does not match array type
-                { // Did not find string type
-                    result = TomlResult_UnexpectedDataType;
-                    return result;
-                }
-                if (!found_comma)
-                { // Did not find comma delimeter between array elements
-                    result = TomlResult_InvalidSyntax;
-                    return result;
-                }
-                else
-                    found_comma = false;
-                
-                TomlData data = {};
-                data.type = Toml_String;
-                data.s = iter->s;
-                data.sl = iter->len;
-                arrput(array->a, data);
-                ++offset;
-            } break;
-            
-            case TomlToken_OpenBracket:
-            { // TODO(Dustin): INLINE TABLES NOT SUPPORTED
-                result = TomlResult_Count;
-            } break;
-            
-            case TomlToken_Comma:
-            { // do nothing with a comma
-                found_comma = true;
-                ++offset;
-            } break;
-            
-            default:
-            {
-                result = TomlResult_UnknownToken;
-                return result;
-            } break;
-        }
-        
-        iter = tokens + offset;
-    }
-    
-    if (offset >= token_count || tokens[offset].type != TomlToken_CloseBrace)
-    { // Missing closing brace for array
-        result = TomlResult_InvalidSyntax;
-        return result;
-    }
-    
-    ++offset;
-    *iter_advance += offset;
+// Writes a NULL terminator over the character at the iterator and steps over it
+// @returns the character that was overwritten
+static char
+TomlTerminate(TomlParser *parser)
+{
+    char result = parser->iter[0];
+    parser->iter[0] = 0;
+    if (parser->iter < parser->end) ++parser->iter;
     return result;
 }
 
-// @returns the offset from the start of the array. For example, if 5 tokens
-// were consumed to parse the object, then 5 will be returned
 static TomlResult
-TomlParseExpression(TomlObject *object, TomlToken *tokens, int token_count, int *iter_advance)
-{
-    TomlResult result = TomlResult_Success;
-    int offset = 0;
-    
-    if (tokens[offset].type != TomlToken_Identifier)
-    { // Expected name for expression, but was not found
-        result = TomlResult_InvalidSyntax;
-        return result;
-    }
-    
-    char *expr_name = tokens[offset].start;
-    uint64_t expr_name_len = tokens[offset].len;
-    ++offset;
-    
-    if (tokens[offset].type != TomlToken_Equals)
-    { // Expected equals sign, but was not found!
-        result = TomlResult_InvalidSyntax;
-        return result;
-    }
-    ++offset;
-    
-    TomlData data = {};
-    switch (tokens[offset].type)
+TomlParseValue(TomlParser *parser, TomlData *value)
+{
+    char *iter = parser->iter;
+    char  c    = iter[0];
+
+    *value = {};
+    if (c == '"')
+    {
+        char *start = iter + 1;
+        char *stop  = TomlFindChar(start, parser->end, '"');
+        if (stop >= parser->end) return TomlResult_ParseError;
+
+        stop[0]      = 0;
+        value->type  = Toml_String;
+        value->s     = start;
+        value->sl    = (int)(stop - start);
+        parser->iter = stop + 1;
+    }
+    else if (c == '[')
+    {
+        parser->iter = iter + 1;
+        return TomlParseArray(parser, value);
+    }
+    else if (TomlIsDigit(c) || c == '.' || (c == '-' && (TomlIsDigit(iter[1]) || iter[1] == '.')))
     {
-        case TomlToken_OpenBrace:
+        // [0-9_.]+ then an optional exponent [eE][+-]?[0-9]+
+        bool  is_float = (c == '.');
+        char *stop     = iter + 1;
+        while (TomlIsDigit(stop[0]) || stop[0] == '_' || stop[0] == '.')
         {
-            ++offset;
-            
-            data.type = Toml_Array;
-            result = TomlParseArray(&data, tokens + offset, token_count - offset, &offset);
-            if (result != TomlResult_Success) return result;
-        } break;
-        
-        case TomlToken_Integer:
+            is_float |= (stop[0] == '.');
+            ++stop;
+        }
+        if (stop[0] == 'e' || stop[0] == 'E')
         {
-            data.type = Toml_Int;
-            data.i = tokens[offset].i;
-            ++offset;
-        } break;
-        
-        case TomlToken_Boolean:
+            char *exponent = stop + 1;
+            if (exponent[0] == '+' || exponent[0] == '-') ++exponent;
+            if (!TomlIsDigit(exponent[0])) return TomlResult_ParseError;
+            while (TomlIsDigit(exponent[0])) ++exponent;
+
+            stop     = exponent;
+            is_float = true;
+        }
+        // "12abc" is an error, not the number 12 followed by a name
+        if (TomlIsIdentChar(stop[0])) return TomlResult_ParseError;
+
+        if (is_float)
         {
-            data.type = Toml_Bool;
-            data.b = tokens[offset].b;
-            ++offset;
-        } break;
-        
-        case TomlToken_Float:
+            value->type = Toml_Float;
+            value->f    = TomlStrToFloat(iter, stop);
+        }
+        else
         {
-            data.type = Toml_Float;
-            data.f = tokens[offset].f;
-            ++offset;
-        } break;
-        
-        case TomlToken_String:
+            value->type = Toml_Int;
+            value->i    = TomlStrToInt(iter, stop);
+        }
+        parser->iter = stop;
+    }
+    else if (c == 't' && strncmp(iter, "true", 4) == 0 && !TomlIsIdentChar(iter[4]))
+    {
+        value->type  = Toml_Bool;
+        value->b     = true;
+        parser->iter = iter + 4;
+    }
+    else if (c == 'f' && strncmp(iter, "false", 5) == 0 && !TomlIsIdentChar(iter[5]))
+    {
+        value->type  = Toml_Bool;
+        value->b     = false;
+        parser->iter = iter + 5;
+    }
+    else if (c == '{')
+    {
+        // NOTE(Dustin): Inline tables are not currently supported!
+        return TomlResult_ParseError;
+    }
+    else
+    {
+        return TomlResult_UnknownToken;
+    }
+
+    return TomlResult_Success;
+}
+
+// Parses the elements of an array, the iterator is after the '['. Elements can be separated
+// by newlines and comments, and all of them must have the same type.
+static TomlResult
+TomlParseArray(TomlParser *parser, TomlData *array)
+{
+    TomlType type  = Toml_Count;
+    int      count = 0;
+
+    for (;;)
+    {
+        TomlSkipBlank(parser, true);
+        if (parser->iter >= parser->end) return TomlResult_InvalidSyntax;
+
+        if (parser->iter[0] == ']') break;
+
+        if (count > 0)
         {
-            data.type = Toml_String;
-            data.s  = tokens[offset].s;
-            data.sl = tokens[offset].len;
-            ++offset;
-        } break;
-        
-        default:
-        { // Unknown token found
-            result = TomlResult_UnknownToken;
-            return result;
-        } break;
+            if (parser->iter[0] != ',') return TomlResult_InvalidSyntax;
+            ++parser->iter;
+
+            // A trailing comma is allowed
+            TomlSkipBlank(parser, true);
+            if (parser->iter[0] == ']') break;
+        }
+
+        TomlData elem;
+        TomlResult result = TomlParseValue(parser, &elem);
+        if (result != TomlResult_Success) return result;
+
+        if (type == Toml_Count) type = elem.type;
+        else if (elem.type != type) return TomlResult_UnexpectedDataType;
+
+        TomlStackPush(parser, &elem, sizeof(elem));
+        ++count;
     }
-    
-    // Insert the toml data into the data table for the current object
+    ++parser->iter; // ']'
+
+    *array = {};
+    array->type = Toml_Array;
+    array->a    = TomlStackPopArray<TomlData>(parser, count);
+    return TomlResult_Success;
+}
+
+// Parses "key = value", the iterator is on the first character of the key. Outside of an
+// object, only the title is accepted.
+static TomlResult
+TomlParseKeyValue(TomlParser *parser, bool in_object)
+{
     TomlKeyValue key_val = {};
-    key_val.key   = expr_name;
-    key_val.value = data;
-    shputs_len(object->data_table, key_val, expr_name_len);
-    
-    *iter_advance += offset;
-    return result;
+    TomlParseName(parser, &key_val.key, &key_val.hash);
+
+    char c = TomlTerminate(parser);
+    if (TomlIsSkippableChar(c))
+    {
+        parser->iter = TomlSkipSpaces(parser->iter, parser->end);
+        c = parser->iter[0];
+        if (parser->iter < parser->end) ++parser->iter;
+    }
+    if (c != '=') return TomlResult_InvalidSyntax;
+
+    parser->iter = TomlSkipSpaces(parser->iter, parser->end);
+    if (!in_object)
+    {
+        if (strcmp(key_val.key, "title") != 0) return TomlResult_UnknownToken;
+        if (parser->iter[0] != '"')            return TomlResult_InvalidSyntax;
+    }
+
+    TomlResult result = TomlParseValue(parser, &key_val.value);
+    if (result != TomlResult_Success) return result;
+
+    if (in_object) TomlStackPush(parser, &key_val, sizeof(key_val));
+    else           parser->toml->title = key_val.value.s;
+
+    return TomlResult_Success;
 }
 
-// @returns the offset from the start of the array. For example, if 5 tokens
-// were consumed to parse the object, then 5 will be returned
+// Parses "[name]", the iterator is on the '['
 static TomlResult
-TomlParseObject(Toml *toml, TomlToken *tokens, int token_count, int *iter_advance)
-{
-    TomlResult result = TomlResult_Success;
-    int offset = 0;
-    
-    if (tokens[offset].type != TomlToken_Identifier)
-    { // Expected a name for the object, but did not find one
-        result = TomlResult_UnknownToken;
-        return result;
-    }
-    
-    char *expr_name = tokens[offset].start;
-    uint64_t expr_name_len = tokens[offset].len;
-    ++offset;
-    
-    if (tokens[offset].type != TomlToken_CloseBrace)
-    { // Expected a close brace, but did not find one
-        result = TomlResult_UnknownToken;
-        return result;
-    }
-    ++offset;
-    
-    TomlObject object = {};
-    object.data_table = 0;
-    sh_new_strdup(object.data_table);
-    
-    for (; offset < token_count;)
-    {
-        TomlToken *tok = tokens + offset;
-        if (tok->type == TomlToken_OpenBrace)
-        { // At next object, go ahead and return
-            break;
+TomlParseObjectName(TomlParser *parser, char **name, uint32_t *hash)
+{
+    parser->iter = TomlSkipSpaces(parser->iter + 1, parser->end);
+    if (!TomlIsChar(parser->iter[0])) return TomlResult_UnknownToken;
+
+    TomlParseName(parser, name, hash);
+
+    char c = TomlTerminate(parser);
+    if (TomlIsSkippableChar(c))
+    {
+        parser->iter = TomlSkipSpaces(parser->iter, parser->end);
+        c = parser->iter[0];
+        if (parser->iter < parser->end) ++parser->iter;
+    }
+    return (c == ']') ? TomlResult_Success : TomlResult_UnknownToken;
+}
+
+static TomlResult
+TomlParseFile(TomlParser *parser)
+{
+    // The open object and where its key/values start on the stack. Closed objects are below
+    // it on the stack.
+    TomlObjectKeyValue object      = {};
+    uint64_t           object_base = 0;
+    int                objects     = 0;
+
+    for (;;)
+    {
+        TomlSkipBlank(parser, true);
+        if (parser->iter >= parser->end) break;
+
+        TomlResult result;
+        if (parser->iter[0] == '[')
+        {
+            if (object.key)
+            {
+                int count = (int)((parser->stack.size - object_base) / sizeof(TomlKeyValue));
+                object.value.data_table = TomlStackPopTable<TomlKeyValue>(parser, count, &object.value.index,
+                                                                         &object.value.index_mask);
+                TomlStackPush(parser, &object, sizeof(object));
+                ++objects;
+            }
+
+            object = {};
+            result = TomlParseObjectName(parser, &object.key, &object.hash);
+            object_base = parser->stack.size;
+        }
+        else if (TomlIsChar(parser->iter[0]))
+        {
+            result = TomlParseKeyValue(parser, object.key != NULL);
         }
-        else if (tok->type == TomlToken_NewLine)
-            ++offset;
         else
         {
-            result = TomlParseExpression(&object, tokens + offset, token_count - offset, &offset);
-            if (result != TomlResult_Success) return result;
+            result = TomlResult_UnknownToken;
         }
+
+        if (result != TomlResult_Success) return result;
     }
-    
-    // Insert the toml data into the data table for the current object
-    TomlObjectKeyValue key_val = {};
-    key_val.key   = expr_name;
-    key_val.value = object;
-    shputs_len(toml->table, key_val, expr_name_len);
-    
-    *iter_advance += offset;
-    return result;
+
+    if (object.key)
+    {
+        int count = (int)((parser->stack.size - object_base) / sizeof(TomlKeyValue));
+        object.value.data_table = TomlStackPopTable<TomlKeyValue>(parser, count, &object.value.index,
+                                                                 &object.value.index_mask);
+        TomlStackPush(parser, &object, sizeof(object));
+        ++objects;
+    }
+
+    Toml *toml = parser->toml;
+    toml->table = TomlStackPopTable<TomlObjectKeyValue>(parser, objects, &toml->index, &toml->index_mask);
+    return TomlResult_Success;
 }
 
-// @returns the offset from the start of the array. For example, if 5 tokens
-// were consumed to parse the object, then 5 will be returned
+// Parses the "size" bytes of toml->file_data
 static TomlResult
-TomlParseTitle(char **title, TomlToken *tokens, int token_count, int *iter_advance)
-{
-    TomlResult result = TomlResult_Success;
-    int offset = 0;
-    
-    if (tokens[offset].type != TomlToken_Equals)
-    {
-        result = TomlResult_InvalidSyntax;
-        return result;
-    }
-    ++offset;
-    
-    if (tokens[offset].type != TomlToken_String)
-    {
-        result = TomlResult_InvalidSyntax;
-        return result;
-    }
-    
-    *title = (char*)g_toml_internal_callbacks.Alloc(tokens[offset].len + 1);
-    memcpy(*title, tokens[offset].s, tokens[offset].len);
-    (*title)[tokens[offset].len] = 0;
-    
-    ++offset;
-    *iter_advance += offset;
+TomlParseFileData(Toml *toml, int size)
+{
+    // Most of the file ends up in the arena as views, so the first block is sized after it
+    TomlArena *block = (TomlArena*)g_toml_internal_callbacks.Alloc(sizeof(TomlArena) + size + TOML_ARENA_MIN_BLOCK);
+    block->next = NULL;
+    block->size = size + TOML_ARENA_MIN_BLOCK;
+    block->used = 0;
+    toml->arena = block;
+
+    alignas(16) char stack_buffer[TOML_STACK_INLINE_SIZE];
+
+    TomlParser parser = {};
+    parser.iter          = (char*)toml->file_data;
+    parser.end           = parser.iter + size;
+    parser.toml          = toml;
+    parser.stack.data    = stack_buffer;
+    parser.stack.cap     = sizeof(stack_buffer);
+
+    TomlResult result = TomlParseFile(&parser);
+
+    if (parser.stack.on_heap) g_toml_internal_callbacks.Free(parser.stack.data);
     return result;
 }
 
 static TomlResult
-TomlParseFile(Toml *toml, TomlTokenizer *tokenizer)
-{
-    TomlResult result = TomlResult_Success;
-    bool object_set = false;
-    sh_new_strdup(toml->table);
-    
-    TomlToken *iter = tokenizer->tokens;
-    int tok_count = (int)arrlen(tokenizer->tokens);
-    
-    int i = 0;
-    while (i < tok_count)
-    {
-        TomlToken *tok = iter + i;
-        switch (tok->type)
-        {
-            case TomlToken_OpenBrace:
-            {
-                ++i;
-                result = TomlParseObject(toml, tokenizer->tokens + i, tok_count - i, &i);
-                if (result != TomlResult_Success) return result;
-            } break;
-            
-            case TomlToken_Identifier:
-            {
-                if (!object_set)
-                {
-                    if (strncmp("title", tok->start, tok->len) == 0)
-                    {
-                        ++i;
-                        result = TomlParseTitle(&toml->title, tokenizer->tokens + i, tok_count - i, &i);
-                        if (result != TomlResult_Success) return result;
-                    }
-                    else
-                    {
-                        // Identifier other than "title" was found outside of a toml object
-                        result = TomlResult_UnknownToken;
-                        return result;
-                    }
-                }
-            } break;
-            
-            case TomlToken_NewLine:
-            { // Skip new line tokens
-                ++i;
-            } break;
-            
-            default:
-            {
-                result = TomlResult_UnknownToken;
-                return result;
-            } break;
-        }
+TomlLoad(Toml *toml, const char *filepath)
+{
+    *toml = {};
+
+    int size = 0;
+    g_toml_internal_callbacks.LoadFile(filepath, (u8**)&toml->file_data, &size);
+    if (!toml->file_data) return TomlResult_Success;
+
+    return TomlParseFileData(toml, size);
+}
+
+static TomlResult
+TomlLoadCached(Toml *toml, const char *filepath, TomlCache *cache)
+{
+    if (!cache) return TomlLoad(toml, filepath);
+
+    TomlCallbacks *callbacks = &g_toml_internal_callbacks;
+    *toml = {};
+
+    uint64_t source_time, source_size;
+    if (!callbacks->GetFileInfo(filepath, &source_time, &source_size)) return TomlLoad(toml, filepath);
+
+    uint64_t path_hash = TomlHash64(filepath, strlen(filepath));
+    char *doc = TomlCacheFind(cache, filepath, path_hash);
+
+    TomlCacheDocument *header = (TomlCacheDocument*)doc;
+    if (header && header->source_time == source_time && header->source_size == source_size)
+    {
+        TomlCacheUse(toml, cache, doc);
+        return TomlResult_Success;
+    }
+
+    int size = 0;
+    callbacks->LoadFile(filepath, (u8**)&toml->file_data, &size);
+    if (!toml->file_data) return TomlResult_Success;
+
+    // Hashed before parsing, which writes to the file data
+    uint64_t source_hash = TomlHash64(toml->file_data, (uint64_t)size);
+    if (header && header->source_hash == source_hash && header->source_size == (uint64_t)size)
+    {
+        // Only the time changed
+        header->source_time = source_time;
+        cache->dirty = true;
+
+        callbacks->FreeFile(toml->file_data);
+        toml->file_data = NULL;
+        TomlCacheUse(toml, cache, doc);
+        return TomlResult_Success;
+    }
+
+    TomlResult result = TomlParseFileData(toml, size);
+    if (result == TomlResult_Success)
+    {
+        TomlCacheCompile(cache, toml, filepath, path_hash, source_hash, source_time, (uint64_t)size);
     }
-    
     return result;
 }
 
-#if 0
 static void
-TomlScannerPrintResults(TomlScanner *scanner)
-{
-    PrettyBuffer buffer = {};
-    pb_init(&buffer, _KB(1));
-    
-    pb_write(&buffer, "[\n");
-    
-    for (int i = 0; i < (int)arrlen(scanner->lexemes); ++i)
-    {
-        TomlLexeme *lex = scanner->lexemes + i;
-        Str str = StrInit(lex->len, lex->start);
-        
-        pb_write(&buffer, "\ttype: ");
-        switch (lex->type)
+TomlFree(Toml *toml)
+{
+    if (toml->arena)
+    {
+        TomlArenaFree(toml);
+    }
+    else if (toml->cache)
+    {
+        // The tables belong to the cache
+    }
+    else
+    {
+        // Made with TomlCreate
+        for (int i = 0; i < TomlArrayLen(toml->table); ++i)
         {
-            case TomlLexeme_Identifier:
-            {
-                pb_write(&buffer, "IDENTIFIER, value: %s\n", StrGetString(&str));
-            } break;
-            
-            case TomlLexeme_Seperator:
-            {
-                if (lex->start[0] == '\n')
-                    pb_write(&buffer, "SEPERATOR, value: newline\n");
-                else
-                    pb_write(&buffer, "SEPERATOR, value: %s\n", StrGetString(&str));
-            } break;
-            
-            case TomlLexeme_Operator:
-            {
-                pb_write(&buffer, "OPERATOR, value: %s\n", StrGetString(&str));
-            } break;
-            
-            case TomlLexeme_Literal:
+            TomlObject *obj = &toml->table[i].value;
+            for (int j = 0; j < TomlArrayLen(obj->data_table); ++j)
             {
-                pb_write(&buffer, "LITERAL, value: %s\n", StrGetString(&str));
-            } break;
-            
-            case TomlLexeme_Comment:
-            {
-                pb_write(&buffer, "COMMENT, value: %s\n", StrGetString(&str));
-            } break;
-            
-            StrFree(&str);
+                TomlHeapArrayFree(&obj->data_table[j].value);
+                g_toml_internal_callbacks.Free(obj->data_table[j].key);
+            }
+            if (obj->data_table) g_toml_internal_callbacks.Free((TomlArrayHeader*)obj->data_table - 1);
+            g_toml_internal_callbacks.Free(toml->table[i].key);
         }
+        if (toml->table) g_toml_internal_callbacks.Free((TomlArrayHeader*)toml->table - 1);
+    }
+
+    if (toml->file_data) g_toml_internal_callbacks.FreeFile(toml->file_data);
+
+    toml->title     = NULL;
+    toml->table     = NULL;
+    toml->index     = NULL;
+    toml->file_data = NULL;
+    toml->cache     = NULL;
+}
+
+static TomlObject
+TomlGetObject(Toml *toml, const char *name)
+{
+    TomlObjectKeyValue *obj = TomlFindKey(toml->table, toml->index, toml->index_mask, name,
+                                          TomlHash(name, (int)strlen(name)));
+    if (obj) return obj->value;
+
+    TomlObject result = {};
+    return result;
+}
+
+static int
+TomlGetObjectCount(Toml *toml)
+{
+    return TomlArrayLen(toml->table);
+}
+
+static TomlObject
+TomlGetObjectAt(Toml *toml, int idx)
+{
+    TOML_ASSERT(idx < TomlArrayLen(toml->table));
+    return toml->table[idx].value;
+}
+
+static const char*
+TomlGetObjectName(Toml *toml, int idx)
+{
+    TOML_ASSERT(idx < TomlArrayLen(toml->table));
+    return toml->table[idx].key;
+}
+
+static TomlData*
+TomlGetData(TomlObject *obj, const char *name)
+{
+    TomlKeyValue *key_val = TomlFindKey(obj->data_table, obj->index, obj->index_mask, name,
+                                        TomlHash(name, (int)strlen(name)));
+    return key_val ? &key_val->value : NULL;
+}
+
+static int
+TomlGetInt(TomlObject *obj, const char *name)
+{
+    TomlData *data = TomlGetData(obj, name);
+    TOML_ASSERT(data && data->type == Toml_Int);
+    return data ? TOMLDATA_AS_INT(data) : 0;
+}
+
+static bool
+TomlGetBool(TomlObject *obj, const char *name)
+{
+    TomlData *data = TomlGetData(obj, name);
+    TOML_ASSERT(data && data->type == Toml_Bool);
+    return data ? TOMLDATA_AS_BOOL(data) : false;
+}
+
+static float
+TomlGetFloat(TomlObject *obj, const char *name)
+{
+    TomlData *data = TomlGetData(obj, name);
+    TOML_ASSERT(data && data->type == Toml_Float);
+    return data ? TOMLDATA_AS_FLOAT(data) : 0.0f;
+}
+
+static const char*
+TomlGetString(TomlObject *obj, const char *name)
+{
+    TomlData *data = TomlGetData(obj, name);
+    TOML_ASSERT(data && data->type == Toml_String);
+    return data ? TOMLDATA_AS_STRING(data) : NULL;
+}
+
+static int
+TomlGetStringLen(TomlObject *obj, const char *name)
+{
+    TomlData *data = TomlGetData(obj, name);
+    TOML_ASSERT(data && data->type == Toml_String);
+    return data ? TOMLDATA_STRING_LEN(data) : 0;
+}
+
+static TomlData*
+TomlGetArray(TomlObject *obj, const char *name)
+{
+    TomlData *data = TomlGetData(obj, name);
+    TOML_ASSERT(data && data->type == Toml_Array);
+    return data ? TOMLDATA_AS_ARRAY(data) : NULL;
+}
+
+static int
+TomlGetArrayLen(TomlData *data)
+{
+    return TOMLDATA_ARRAY_LEN(data);
+}
+
+static int
+TomlGetIntArrayElem(TomlData *data, int idx)
+{
+    TOML_ASSERT(TOMLDATA_ARRAY_LEN(data) > idx);
+    TOML_ASSERT(data[idx].type == Toml_Int);
+    return TOMLDATA_AS_INT(&data[idx]);
+}
+
+static bool
+TomlGetBoolArrayElem(TomlData *data, int idx)
+{
+    TOML_ASSERT(TOMLDATA_ARRAY_LEN(data) > idx);
+    TOML_ASSERT(data[idx].type == Toml_Bool);
+    return TOMLDATA_AS_BOOL(&data[idx]);
+}
+
+static float
+TomlGetFloatArrayElem(TomlData *data, int idx)
+{
+    TOML_ASSERT(TOMLDATA_ARRAY_LEN(data) > idx);
+    TOML_ASSERT(data[idx].type == Toml_Float);
+    return TOMLDATA_AS_FLOAT(&data[idx]);
+}
+
+static const char*
+TomlGetStringArrayElem(TomlData *data, int idx)
+{
+    TOML_ASSERT(TOMLDATA_ARRAY_LEN(data) > idx);
+    TOML_ASSERT(data[idx].type == Toml_String);
+    return TOMLDATA_AS_STRING(&data[idx]);
+}
+
+static int
+TomlGetStringLenArrayElem(TomlData *data, int idx)
+{
+    TOML_ASSERT(TOMLDATA_ARRAY_LEN(data) > idx);
+    TOML_ASSERT(data[idx].type == Toml_String);
+    return TOMLDATA_STRING_LEN(&data[idx]);
+}
+
+static TomlData*
+TomlGetArrayElem(TomlData *data, int idx)
+{
+    TOML_ASSERT(TOMLDATA_ARRAY_LEN(data) > idx);
+    TOML_ASSERT(data[idx].type == Toml_Array);
+    return TOMLDATA_AS_ARRAY(&data[idx]);
+}
+
+static void*
+TomlAlloc_Internal(uint64_t size)
+{
+    return malloc(size);
+}
+
+static void
+TomlFree_Internal(void *ptr)
+{
+    free(ptr);
+}
+
+static void
+TomlLoadFile_Internal(const char* file_path, u8** buffer, int* size)
+{
+    FILE *fp = fopen(file_path, "r");
+    TOML_ASSERT(fp);
+
+    fseek(fp, 0, SEEK_END); // seek to end of file
+    uint64_t fsize = ftell(fp); // get current file pointer
+    fseek(fp, 0, SEEK_SET); // seek back to beginning of file
+
+    *buffer = (u8*)g_toml_internal_callbacks.Alloc(fsize+1);
+
+    uint64_t read = fread(*buffer, 1, fsize, fp);
+    TOML_ASSERT(read <= fsize);
+
+    *size   = (int)read;
+    (*buffer)[read] = 0;
+}
+
+static void
+TomlFreeFile_Internal(void *ptr)
+{
+    g_toml_internal_callbacks.Free(ptr);
+}
+
+static bool
+TomlGetFileInfo_Internal(const char* file_path, uint64_t* write_time, uint64_t* size)
+{
+    struct stat info;
+    if (stat(file_path, &info) != 0) return false;
+
+    *write_time = (uint64_t)info.st_mtime;
+    *size       = (uint64_t)info.st_size;
+    return true;
+}
+
+static void*
+TomlMapFile_Internal(const char* file_path, uint64_t* size)
+{
+    FILE *fp = fopen(file_path, "rb");
+    if (!fp) return NULL;
+
+    fseek(fp, 0, SEEK_END);
+    uint64_t fsize = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    void *result = g_toml_internal_callbacks.Alloc(fsize);
+    if (fread(result, 1, fsize, fp) != fsize)
+    {
+        g_toml_internal_callbacks.Free(result);
+        result = NULL;
+    }
+    fclose(fp);
+
+    *size = fsize;
+    return result;
+}
+
+static void
+TomlUnmapFile_Internal(void *ptr, uint64_t size)
+{
+    g_toml_internal_callbacks.Free(ptr);
+}
+
+static void
+TomlWriteFile_Internal(const char* file_path, const void* buffer, uint64_t size)
+{
+    FILE *fp = fopen(file_path, "wb");
+    if (!fp) return;
+
+    fwrite(buffer, 1, size, fp);
+    fclose(fp);
+}
+
+//-----------------------------------------------------------------------------------------------//
+// Cache
+
+// FNV-1a
+static uint64_t
+TomlHash64(const void *data, uint64_t size)
+{
+    const uint8_t *bytes = (const uint8_t*)data;
+    uint64_t hash = 14695981039346656037ull;
+    for (uint64_t i = 0; i < size; ++i)
+    {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
     }
-    
-    pb_write(&buffer, "]\n");
-    
-    buffer.current[0] = 0;
-    LogInfo("Scanner Results: %s", buffer.start);
-    
-    pb_free(&buffer);
+    return hash;
 }
 
-static void
-TomlTokenizerPrintResults(TomlTokenizer *tokenizer)
-{
-    PrettyBuffer buffer = {};
-    pb_init(&buffer, _KB(1));
-    
-    pb_write(&buffer, "[\n");
-    
-    for (int i = 0; i < (int)arrlen(tokenizer->tokens); ++i)
-    {
-        TomlToken *tok = tokenizer->tokens + i;
-        
-        switch (tok->type)
-        {
-            case TomlToken_Identifier:
-            {
-                Str str = StrInit(tok->len, tok->start);
-                pb_write(&buffer, "\tTOKEN_IDENTIFIER, value: %s\n", StrGetString(&str));
-                StrFree(&str);
-            }break;
-            
-            case TomlToken_OpenBrace:
-            {
-                pb_write(&buffer, "\tTOKEN_OPENBRACE\n");
-            }break;
-            
-            case TomlToken_CloseBrace:
-            {
-                pb_write(&buffer, "\tTOKEN_CLOSEBRACE\n");
-            }break;
-            
-            case TomlToken_OpenBracket:
-            {
-                pb_write(&buffer, "\tTOKEN_OPENBRACKET\n");
-            }break;
-            
-            case TomlToken_CloseBracket:
-            {
-                pb_write(&buffer, "\tTOKEN_CLOSEBRACKET\n");
-            }break;
-            
-            case TomlToken_Comma:
-            {
-                pb_write(&buffer, "\tTOKEN_COMMA\n");
-            }break;
-            
-            case TomlToken_NewLine:
-            {
-                pb_write(&buffer, "\tTOKEN_NEWLINE\n");
-            }break;
-            
-            case TomlToken_Equals:
-            {
-                pb_write(&buffer, "\tTOKEN_EQUALS\n");
-            }break;
-            
-            case TomlToken_String:
-            {
-                Str str = StrInit(tok->len, tok->s);
-                pb_write(&buffer, "\tTOKEN_STRING, value: %s\n", StrGetString(&str));
-                StrFree(&str);
-            }break;
-            
-            case TomlToken_Boolean:
-            {
-                pb_write(&buffer, "\tTOKEN_BOOLEAN, value: %s\n", (tok->b) ? "true" : "false");
-            }break;
-            
-            case TomlToken_Integer:
-            {
-                pb_write(&buffer, "\tTOKEN_INTEGER, value: %d\n", tok->i);
-            }break;
-            
-            case TomlToken_Float:
-            {
-                pb_write(&buffer, "\tTOKEN_INTEGER, value: %lf\n", tok->f);
-            }break;
-        }
+// A word at a time, FNV-1a over a whole document costs as much as the rest of the load. Any
+// single changed word changes the result, every step is a bijection of the state.
+static uint64_t
+TomlCacheChecksum(const char *doc, uint64_t size)
+{
+    uint64_t start = offsetof(TomlCacheDocument, source_hash);
+    uint64_t hash  = 14695981039346656037ull ^ size;
+    for (uint64_t i = start; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, doc + i, sizeof(word));
+        hash  = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+        hash ^= hash >> 29;
     }
-    
-    pb_write(&buffer, "]\n");
-    
-    buffer.current[0] = 0;
-    LogInfo("TomlTokenizer Results: %s", buffer.start);
-    
-    pb_free(&buffer);
+    return hash;
 }
-#endif
 
-static TomlResult 
-TomlLoad(Toml *toml, const char *filepath)
+// @returns the offset of "size" zeroed bytes, 8 byte aligned
+static uint64_t
+TomlCacheReserve(TomlCacheWriter *writer, uint64_t size)
 {
-    *toml = {};
-    toml->file_data = 0;
-    toml->table = 0;
-    
-    int size;
-    g_toml_internal_callbacks.LoadFile(filepath, (u8**)&toml->file_data, &size);
-    
-    //---------------------------------------------------------------------------------------------
-    // Lexer Pass
-    
-    TomlScanner scanner = {};
-    scanner.start   = (char*)toml->file_data;
-    scanner.end     = (char*)toml->file_data + size;
-    scanner.lexemes = 0;
-    TomlResult result = TomlScanFile(&scanner);
-    if (result != TomlResult_Success) return result;
-    
-    TomlTokenizer tokenizer = {};
-    tokenizer.tokens = 0;
-    result = TomlTokenizeFile(&tokenizer, &scanner);
-    if (result != TomlResult_Success) return result;
-    
-#if 0 // Print results
-    TomlScannerPrintResults(&scanner);
-    TomlTokenizerPrintResults(&tokenizer);
-#endif
-    
-    //---------------------------------------------------------------------------------------------
-    // Parser Pass
-    
-    result = TomlParseFile(toml, &tokenizer);
-    
+    size = (size + 7) & ~(uint64_t)7;
+    if (writer->size + size > writer->cap)
+    {
+        uint64_t cap = writer->cap ? writer->cap * 2 : _KB(4);
+        while (cap < writer->size + size) cap *= 2;
+
+        char *tmp = (char*)g_toml_internal_callbacks.Alloc(cap);
+        if (writer->data)
+        {
+            memcpy(tmp, writer->data, writer->size);
+            g_toml_internal_callbacks.Free(writer->data);
+        }
+        writer->data = tmp;
+        writer->cap  = cap;
+    }
+
+    uint64_t result = writer->size;
+    memset(writer->data + result, 0, size);
+    writer->size += size;
     return result;
 }
 
-static void 
-TomlFree(Toml *toml)
+// Writes the offset "target" into the pointer at "slot", and records it for the relocation
+static void
+TomlCacheSetPointer(TomlCacheWriter *writer, uint64_t slot, uint64_t target)
 {
-    // TODO(Dustin): Make it so title is not heap allocated!
-    //g_toml_internal_callbacks.Free(toml->title);
-    
-    for (int i = 0; i < (int)shlen(toml->table); ++i)
+    memcpy(writer->data + slot, &target, sizeof(target));
+    if (!target) return;
+
+    if (writer->reloc_count == writer->reloc_cap)
     {
-        TomlObject *obj = &toml->table[i].value;
-        
-        for (int j = 0; j < (int)shlen(obj->data_table); ++j)
+        uint32_t cap = writer->reloc_cap ? writer->reloc_cap * 2 : 256;
+        uint64_t *tmp = (uint64_t*)g_toml_internal_callbacks.Alloc(cap * sizeof(uint64_t));
+        if (writer->relocs)
         {
-            TomlData *data = &obj->data_table[j].value;
-            
-            switch (data->type)
-            {
-                case Toml_Array:
-                {
-                    if (data->a[0].type == Toml_Array)
-                    {
-                        TomlData *queue = 0;
-                        for (int k = 0; k < arrlen(data->a); ++k)
-                        {
-                            arrput(queue, data->a[k]);
-                        }
-                        
-                        while (arrlen(queue) > 0)
-                        {
-                            TomlData elem = arrpop(queue);
-                            TOML_ASSERT(elem.type == Toml_Array);
-                            if (elem.a[0].type == Toml_Array)
-                            {
-                                for (int k = 0; k < arrlen(data->a); ++k)
-                                {
-                                    arrput(queue, elem.a[k]);
-                                }
-                            }
-                            arrfree(elem.a);
-                        }
-                        arrfree(queue);
-                    }
-                    if (data->a) arrfree(data->a);
-                } break;
-                
-                case Toml_String:
-                case Toml_Int:
-                case Toml_Bool:
-                case Toml_Float:
-                case Toml_Table: /* NOTE(Dustin): Tables are not currently supported! */
-                default: break;
-            }
+            memcpy(tmp, writer->relocs, writer->reloc_count * sizeof(uint64_t));
+            g_toml_internal_callbacks.Free(writer->relocs);
         }
-        shfree(obj->data_table);
+        writer->relocs    = tmp;
+        writer->reloc_cap = cap;
     }
-    shfree(toml->table);
-    
-    g_toml_internal_callbacks.FreeFile(toml->file_data);
+    writer->relocs[writer->reloc_count++] = slot;
 }
 
-static TomlObject
-TomlGetObject(Toml *toml, const char *name)
+static uint64_t
+TomlCacheWriteString(TomlCacheWriter *writer, const char *str, uint64_t len)
 {
-    return shget(toml->table, name);
-}
+    if (!str) return 0;
 
-static int
-TomlGetInt(TomlObject *obj, const char *name)
-{
-    TomlData data = shget(obj->data_table, name);
-    TOML_ASSERT(data.type == Toml_Int);
-    return TOMLDATA_AS_INT(&data);
+    uint64_t result = TomlCacheReserve(writer, len + 1);
+    memcpy(writer->data + result, str, len);
+    return result;
 }
 
-static bool
-TomlGetBool(TomlObject *obj, const char *name)
+// @returns the offset of the first element, after the TomlArrayHeader
+static uint64_t
+TomlCacheWriteArray(TomlCacheWriter *writer, TomlData *array)
 {
-    TomlData data = shget(obj->data_table, name);
-    TOML_ASSERT(data.type == Toml_Bool);
-    return TOMLDATA_AS_BOOL(&data);
+    int len = TomlArrayLen(array);
+    if (len == 0) return 0;
+
+    uint64_t header = TomlCacheReserve(writer, sizeof(TomlArrayHeader) + len * sizeof(TomlData));
+    TomlArrayHeader array_header = { len, len };
+    memcpy(writer->data + header, &array_header, sizeof(array_header));
+
+    uint64_t result = header + sizeof(TomlArrayHeader);
+    memcpy(writer->data + result, array, len * sizeof(TomlData));
+    for (int i = 0; i < len; ++i)
+    {
+        TomlCacheWriteData(writer, result + i * sizeof(TomlData));
+    }
+    return result;
 }
 
-static float
-TomlGetFloat(TomlObject *obj, const char *name)
+// Replaces the pointer of the TomlData at "slot", which was copied from the Toml
+static void
+TomlCacheWriteData(TomlCacheWriter *writer, uint64_t slot)
 {
-    TomlData data = shget(obj->data_table, name);
-    TOML_ASSERT(data.type == Toml_Float);
-    return TOMLDATA_AS_FLOAT(&data);
+    TomlData data;
+    memcpy(&data, writer->data + slot, sizeof(data));
+
+    if (data.type == Toml_String)
+    {
+        uint64_t str = TomlCacheWriteString(writer, data.s, (uint64_t)data.sl);
+        TomlCacheSetPointer(writer, slot + offsetof(TomlData, s), str);
+    }
+    else if (data.type == Toml_Array)
+    {
+        uint64_t array = TomlCacheWriteArray(writer, data.a);
+        TomlCacheSetPointer(writer, slot + offsetof(TomlData, a), array);
+    }
 }
 
-static const char*
-TomlGetString(TomlObject *obj, const char *name)
+static uint64_t
+TomlCacheWriteIndex(TomlCacheWriter *writer, uint32_t *index, uint32_t index_mask)
 {
-    TomlData data = shget(obj->data_table, name);
-    TOML_ASSERT(data.type == Toml_String);
-    return TOMLDATA_AS_STRING(&data);
+    if (!index) return 0;
+
+    uint64_t bytes  = ((uint64_t)index_mask + 1) * sizeof(uint32_t);
+    uint64_t result = TomlCacheReserve(writer, bytes);
+    memcpy(writer->data + result, index, bytes);
+    return result;
 }
 
-static int
-TomlGetStringLen(TomlObject *obj, const char *name)
+static uint64_t
+TomlCacheWriteKeyValues(TomlCacheWriter *writer, TomlKeyValue *table)
 {
-    TomlData data = shget(obj->data_table, name);
-    TOML_ASSERT(data.type == Toml_String);
-    return TOMLDATA_STRING_LEN(&data);
+    int len = TomlArrayLen(table);
+    if (len == 0) return 0;
+
+    uint64_t header = TomlCacheReserve(writer, sizeof(TomlArrayHeader) + len * sizeof(TomlKeyValue));
+    TomlArrayHeader array_header = { len, len };
+    memcpy(writer->data + header, &array_header, sizeof(array_header));
+
+    uint64_t result = header + sizeof(TomlArrayHeader);
+    memcpy(writer->data + result, table, len * sizeof(TomlKeyValue));
+    for (int i = 0; i < len; ++i)
+    {
+        uint64_t slot = result + i * sizeof(TomlKeyValue);
+        uint64_t key  = TomlCacheWriteString(writer, table[i].key, strlen(table[i].key));
+        TomlCacheSetPointer(writer, slot + offsetof(TomlKeyValue, key), key);
+        TomlCacheWriteData(writer, slot + offsetof(TomlKeyValue, value));
+    }
+    return result;
 }
 
-static TomlData*
-TomlGetArray(TomlObject *obj, const char *name)
+static uint64_t
+TomlCacheWriteObjects(TomlCacheWriter *writer, TomlObjectKeyValue *table)
 {
-    TomlData data = shget(obj->data_table, name);
-    TOML_ASSERT(data.type == Toml_Array);
-    return TOMLDATA_AS_ARRAY(&data);
+    int len = TomlArrayLen(table);
+    if (len == 0) return 0;
+
+    uint64_t header = TomlCacheReserve(writer, sizeof(TomlArrayHeader) + len * sizeof(TomlObjectKeyValue));
+    TomlArrayHeader array_header = { len, len };
+    memcpy(writer->data + header, &array_header, sizeof(array_header));
+
+    uint64_t result = header + sizeof(TomlArrayHeader);
+    memcpy(writer->data + result, table, len * sizeof(TomlObjectKeyValue));
+    for (int i = 0; i < len; ++i)
+    {
+        uint64_t    slot = result + i * sizeof(TomlObjectKeyValue);
+        TomlObject *obj  = &table[i].value;
+
+        uint64_t key   = TomlCacheWriteString(writer, table[i].key, strlen(table[i].key));
+        uint64_t data  = TomlCacheWriteKeyValues(writer, obj->data_table);
+        uint64_t index = TomlCacheWriteIndex(writer, obj->index, obj->index_mask);
+        TomlCacheSetPointer(writer, slot + offsetof(TomlObjectKeyValue, key), key);
+        TomlCacheSetPointer(writer, slot + offsetof(TomlObjectKeyValue, value) + offsetof(TomlObject, data_table), data);
+        TomlCacheSetPointer(writer, slot + offsetof(TomlObjectKeyValue, value) + offsetof(TomlObject, index), index);
+    }
+    return result;
 }
 
-static int
-TomlGetArrayLen(TomlData *data)
-{
-    return TOMLDATA_ARRAY_LEN(data);
+// Compiles the Toml into a document, written to the cache by TomlCacheClose
+static void
+TomlCacheCompile(TomlCache *cache, Toml *toml, const char *filepath, uint64_t path_hash,
+                 uint64_t hash, uint64_t time, uint64_t size)
+{
+    TomlCacheWriter writer = {};
+    TomlCacheReserve(&writer, sizeof(TomlCacheDocument));
+
+    TomlCacheDocument doc = {};
+    doc.source_hash = hash;
+    doc.source_time = time;
+    doc.source_size = size;
+    doc.path        = TomlCacheWriteString(&writer, filepath, strlen(filepath));
+    doc.index_mask  = toml->index_mask;
+    memcpy(writer.data, &doc, sizeof(doc));
+
+    uint64_t title = TomlCacheWriteString(&writer, toml->title, toml->title ? strlen(toml->title) : 0);
+    uint64_t table = TomlCacheWriteObjects(&writer, toml->table);
+    uint64_t index = TomlCacheWriteIndex(&writer, toml->index, toml->index_mask);
+    TomlCacheSetPointer(&writer, offsetof(TomlCacheDocument, title), title);
+    TomlCacheSetPointer(&writer, offsetof(TomlCacheDocument, table), table);
+    TomlCacheSetPointer(&writer, offsetof(TomlCacheDocument, index), index);
+
+    uint64_t relocs = TomlCacheReserve(&writer, writer.reloc_count * sizeof(uint64_t));
+    if (writer.reloc_count) memcpy(writer.data + relocs, writer.relocs, writer.reloc_count * sizeof(uint64_t));
+
+    TomlCacheDocument *header = (TomlCacheDocument*)writer.data;
+    header->size        = writer.size;
+    header->reloc_count = writer.reloc_count;
+    header->relocs      = relocs;
+    header->checksum    = TomlCacheChecksum(writer.data, writer.size);
+
+    if (writer.relocs) g_toml_internal_callbacks.Free(writer.relocs);
+
+    if (cache->pending_count == cache->pending_cap)
+    {
+        uint64_t cap = cache->pending_cap ? cache->pending_cap * 2 : 64;
+        TomlCachePending *tmp = (TomlCachePending*)g_toml_internal_callbacks.Alloc(cap * sizeof(TomlCachePending));
+        if (cache->pending)
+        {
+            memcpy(tmp, cache->pending, cache->pending_count * sizeof(TomlCachePending));
+            g_toml_internal_callbacks.Free(cache->pending);
+        }
+        cache->pending     = tmp;
+        cache->pending_cap = cap;
+    }
+
+    TomlCachePending *pending = cache->pending + cache->pending_count++;
+    pending->path_hash = path_hash;
+    pending->data      = writer.data;
+    pending->size      = writer.size;
+    cache->dirty       = true;
 }
 
-static int
-TomlGetIntArrayElem(TomlData *data, int idx)
+// Checks the checksum, which covers the values, strings and arrays the relocation does not
+// look at, then that every pointer to relocate is inside the document and points inside it.
+// A damaged document is compiled again instead of crashing.
+static bool
+TomlCacheIsValid(const char *doc, uint64_t size)
 {
-    TOML_ASSERT(arrlen(data) > idx);
-    TOML_ASSERT(data[0].type == Toml_Int);
-    return TOMLDATA_AS_INT(&data[idx]);
+    const TomlCacheDocument *header = (const TomlCacheDocument*)doc;
+    if (size < sizeof(TomlCacheDocument) || header->size != size) return false;
+    if (header->checksum != TomlCacheChecksum(doc, size)) return false;
+
+    if (header->path >= size || !memchr(doc + header->path, 0, size - header->path)) return false;
+
+    if (header->title >= size || header->table >= size || header->index >= size ||
+        header->relocs > size || header->reloc_count > (size - header->relocs) / sizeof(uint64_t))
+    {
+        return false;
+    }
+
+    const uint64_t *relocs = (const uint64_t*)(doc + header->relocs);
+    for (uint32_t i = 0; i < header->reloc_count; ++i)
+    {
+        if (relocs[i] % sizeof(uint64_t) || relocs[i] > size - sizeof(uint64_t)) return false;
+
+        uint64_t target;
+        memcpy(&target, doc + relocs[i], sizeof(target));
+        if (target >= size) return false;
+    }
+    return true;
 }
 
-static bool
-TomlGetBoolArrayElem(TomlData *data, int idx)
+// Adds "delta" to every pointer of the document: its address to relocate it, minus its
+// address to turn the pointers back into offsets
+static void
+TomlCacheRelocate(char *doc, uint64_t delta)
 {
-    TOML_ASSERT(arrlen(data) > idx);
-    TOML_ASSERT(data[0].type == Toml_Bool);
-    return TOMLDATA_AS_FLOAT(&data[idx]);
+    TomlCacheDocument *header = (TomlCacheDocument*)doc;
+
+    uint64_t *relocs = (uint64_t*)(doc + header->relocs);
+    for (uint32_t i = 0; i < header->reloc_count; ++i)
+    {
+        uint64_t *slot = (uint64_t*)(doc + relocs[i]);
+        *slot += delta;
+    }
 }
 
-static float
-TomlGetFloatArrayElem(TomlData *data, int idx)
+// @returns the relocated document of the file, NULL if the cache does not have a valid one
+static char*
+TomlCacheFind(TomlCache *cache, const char *filepath, uint64_t path_hash)
 {
-    TOML_ASSERT(arrlen(data) > idx);
-    TOML_ASSERT(data[0].type == Toml_Float);
-    return TOMLDATA_AS_FLOAT(&data[idx]);
+    // First entry with the hash
+    uint64_t lo = 0, hi = cache->count;
+    while (lo < hi)
+    {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (cache->entries[mid].path_hash < path_hash) lo = mid + 1;
+        else                                           hi = mid;
+    }
+
+    for (; lo < cache->count && cache->entries[lo].path_hash == path_hash; ++lo)
+    {
+        TomlCacheEntry *entry = cache->entries + lo;
+        char *doc = cache->data + entry->offset;
+        if (!cache->relocated[lo])
+        {
+            if (!TomlCacheIsValid(doc, entry->size)) continue;
+
+            TomlCacheRelocate(doc, (uint64_t)(uintptr_t)doc);
+            cache->relocated[lo] = 1;
+        }
+
+        if (strcmp(doc + ((TomlCacheDocument*)doc)->path, filepath) == 0) return doc;
+    }
+    return NULL;
 }
 
-static const char*
-TomlGetStringArrayElem(TomlData *data, int idx)
+static void
+TomlCacheUse(Toml *toml, TomlCache *cache, char *doc)
 {
-    TOML_ASSERT(arrlen(data) > idx);
-    TOML_ASSERT(data[0].type == Toml_String);
-    return TOMLDATA_AS_STRING(&data[idx]);
+    TomlCacheDocument *header = (TomlCacheDocument*)doc;
+    toml->title      = (char*)(uintptr_t)header->title;
+    toml->table      = (TomlObjectKeyValue*)(uintptr_t)header->table;
+    toml->index      = (uint32_t*)(uintptr_t)header->index;
+    toml->index_mask = header->index_mask;
+    toml->cache      = cache;
 }
 
 static int
-TomlGetStringLenArrayElem(TomlData *data, int idx)
+TomlCachePendingCmp(const void *left, const void *right)
 {
-    TOML_ASSERT(arrlen(data) > idx);
-    TOML_ASSERT(data[0].type == Toml_String);
-    return TOMLDATA_STRING_LEN(&data[idx]);
+    uint64_t l = ((const TomlCachePending*)left)->path_hash;
+    uint64_t r = ((const TomlCachePending*)right)->path_hash;
+    return (l < r) ? -1 : (l > r) ? 1 : 0;
 }
 
-static TomlData*
-TomlGetArrayElem(TomlData *data, int idx)
+static void
+TomlCacheOpen(TomlCache *cache, const char *cache_path)
 {
-    TOML_ASSERT(arrlen(data) > idx);
-    TOML_ASSERT(data[0].type == Toml_Array);
-    return TOMLDATA_AS_ARRAY(&data[idx]);
+    *cache = {};
+
+    uint64_t len = strlen(cache_path);
+    cache->path = (char*)g_toml_internal_callbacks.Alloc(len + 1);
+    memcpy(cache->path, cache_path, len + 1);
+
+    uint64_t size = 0;
+    char *data = (char*)g_toml_internal_callbacks.MapFile(cache_path, &size);
+    if (!data) return;
+
+    const TomlCacheHeader *header = (const TomlCacheHeader*)data;
+    bool valid = size >= sizeof(TomlCacheHeader) && header->magic == TOML_CACHE_MAGIC &&
+        header->version == TOML_CACHE_VERSION && header->size == size &&
+        header->count <= (size - sizeof(TomlCacheHeader)) / sizeof(TomlCacheEntry);
+
+    const TomlCacheEntry *entries = (const TomlCacheEntry*)(header + 1);
+    for (uint64_t i = 0; valid && i < header->count; ++i)
+    {
+        valid = entries[i].offset % sizeof(uint64_t) == 0 && entries[i].offset <= size &&
+            entries[i].size <= size - entries[i].offset &&
+            (i == 0 || entries[i - 1].path_hash <= entries[i].path_hash);
+    }
+
+    if (!valid)
+    {
+        // Treated as empty, and replaced by TomlCacheClose
+        g_toml_internal_callbacks.UnmapFile(data, size);
+        return;
+    }
+
+    cache->data    = data;
+    cache->size    = size;
+    cache->entries = (TomlCacheEntry*)(data + sizeof(TomlCacheHeader));
+    cache->count   = header->count;
+    if (cache->count)
+    {
+        cache->relocated = (uint8_t*)g_toml_internal_callbacks.Alloc(cache->count);
+        memset(cache->relocated, 0, cache->count);
+    }
 }
 
-static void* 
-TomlAlloc_Internal(uint64_t size)
+// Merges the documents of the mapping with the pending ones into a new cache file. A pending
+// document replaces the one of the mapping with the same path hash.
+static void
+TomlCacheSave(TomlCache *cache)
 {
-    return malloc(size);
+    struct TomlCacheSource
+    {
+        uint64_t    path_hash;
+        const char *data;
+        uint64_t    size;
+        bool        relocated;
+    };
+
+    qsort(cache->pending, cache->pending_count, sizeof(TomlCachePending), TomlCachePendingCmp);
+
+    uint64_t max_count = cache->count + cache->pending_count;
+    TomlCacheSource *sources = (TomlCacheSource*)g_toml_internal_callbacks.Alloc(max_count * sizeof(TomlCacheSource) + 1);
+
+    uint64_t count = 0;
+    uint64_t size  = sizeof(TomlCacheHeader);
+    uint64_t i = 0, j = 0;
+    while (i < cache->count || j < cache->pending_count)
+    {
+        TomlCacheSource source;
+        if (j < cache->pending_count && (i == cache->count || cache->pending[j].path_hash <= cache->entries[i].path_hash))
+        {
+            TomlCachePending *pending = cache->pending + j++;
+            while (i < cache->count && cache->entries[i].path_hash == pending->path_hash) ++i;
+            // A file loaded twice was compiled twice, either document is fine
+            while (j < cache->pending_count && cache->pending[j].path_hash == pending->path_hash) ++j;
+
+            source = { pending->path_hash, pending->data, pending->size, false };
+        }
+        else
+        {
+            TomlCacheEntry *entry = cache->entries + i;
+            source = { entry->path_hash, cache->data + entry->offset, entry->size, cache->relocated[i] != 0 };
+            ++i;
+        }
+
+        sources[count++] = source;
+        size += sizeof(TomlCacheEntry) + source.size;
+    }
+
+    char *data = (char*)g_toml_internal_callbacks.Alloc(size);
+
+    TomlCacheHeader header = {};
+    header.magic   = TOML_CACHE_MAGIC;
+    header.version = TOML_CACHE_VERSION;
+    header.count   = count;
+    header.size    = size;
+    memcpy(data, &header, sizeof(header));
+
+    TomlCacheEntry *entries = (TomlCacheEntry*)(data + sizeof(TomlCacheHeader));
+    uint64_t offset = sizeof(TomlCacheHeader) + count * sizeof(TomlCacheEntry);
+    for (uint64_t k = 0; k < count; ++k)
+    {
+        entries[k].path_hash = sources[k].path_hash;
+        entries[k].offset    = offset;
+        entries[k].size      = sources[k].size;
+
+        char *doc = data + offset;
+        memcpy(doc, sources[k].data, sources[k].size);
+        if (sources[k].relocated) TomlCacheRelocate(doc, 0 - (uint64_t)(uintptr_t)sources[k].data);
+        offset += sources[k].size;
+    }
+
+    // The mapping is a view of the file being written
+    if (cache->data)
+    {
+        g_toml_internal_callbacks.UnmapFile(cache->data, cache->size);
+        cache->data = NULL;
+    }
+    g_toml_internal_callbacks.WriteFile(cache->path, data, size);
+
+    g_toml_internal_callbacks.Free(data);
+    g_toml_internal_callbacks.Free(sources);
 }
 
-static void 
-TomlFree_Internal(void *ptr)
+static void
+TomlCacheClose(TomlCache *cache)
 {
-    free(ptr);
+    if (cache->dirty) TomlCacheSave(cache);
+    if (cache->data)  g_toml_internal_callbacks.UnmapFile(cache->data, cache->size);
+
+    for (uint64_t i = 0; i < cache->pending_count; ++i)
+    {
+        g_toml_internal_callbacks.Free(cache->pending[i].data);
+    }
+    if (cache->pending)   g_toml_internal_callbacks.Free(cache->pending);
+    if (cache->relocated) g_toml_internal_callbacks.Free(cache->relocated);
+    if (cache->path)      g_toml_internal_callbacks.Free(cache->path);
+    *cache = {};
 }
 
-static void 
-TomlLoadFile_Internal(const char* file_path, u8** buffer, int* size)
+//-----------------------------------------------------------------------------------------------//
+// Builder
+//
+// A Toml made with TomlCreate has no arena: its arrays are allocated with the Alloc callback
+// and grow by doubling, and TomlFree frees them one by one. Lookups are linear.
+
+// @returns the array, which moves when it grows
+static void*
+TomlHeapArrayPush(void *array, const void *elem, int elem_size)
 {
-    FILE *fp = fopen(file_path, "r");
-    TOML_ASSERT(fp);
-    
-    fseek(fp, 0, SEEK_END); // seek to end of file
-    uint64_t fsize = ftell(fp); // get current file pointer
-    fseek(fp, 0, SEEK_SET); // seek back to beginning of file
-    
-    *buffer = (u8*)g_toml_internal_callbacks.Alloc(fsize+1);
-    
-    uint64_t read = fread(*buffer, 1, fsize, fp);
-    TOML_ASSERT(read <= fsize);
-    
-    *size   = (int)read;
-    (*buffer)[read] = 0;
+    TomlArrayHeader *header = array ? (TomlArrayHeader*)array - 1 : NULL;
+    if (!header || header->len == header->cap)
+    {
+        int cap = header ? header->cap * 2 : 4;
+        TomlArrayHeader *tmp = (TomlArrayHeader*)g_toml_internal_callbacks.Alloc(sizeof(TomlArrayHeader) + (uint64_t)cap * elem_size);
+        tmp->len = 0;
+        if (header)
+        {
+            tmp->len = header->len;
+            memcpy(tmp + 1, header + 1, (uint64_t)header->len * elem_size);
+            g_toml_internal_callbacks.Free(header);
+        }
+        tmp->cap = cap;
+        header   = tmp;
+    }
+
+    memcpy((char*)(header + 1) + (uint64_t)header->len * elem_size, elem, elem_size);
+    header->len += 1;
+    return header + 1;
 }
 
-static void  
-TomlFreeFile_Internal(void *ptr)
+static void
+TomlHeapArrayFree(TomlData *data)
 {
-    g_toml_internal_callbacks.Free(ptr);
+    if (data->type != Toml_Array || !data->a) return;
+
+    for (int i = 0; i < TomlArrayLen(data->a); ++i)
+    {
+        TomlHeapArrayFree(&data->a[i]);
+    }
+    g_toml_internal_callbacks.Free((TomlArrayHeader*)data->a - 1);
+    data->a = NULL;
 }
 
+static char*
+TomlCopyKey(const char *name)
+{
+    uint64_t len = strlen(name);
+    char *result = (char*)g_toml_internal_callbacks.Alloc(len + 1);
+    memcpy(result, name, len + 1);
+    return result;
+}
 
-static Toml        
+static Toml
 TomlCreate()
 {
     Toml toml = {};
-    toml.title = 0;
-    toml.file_data = 0;
-    toml.table = 0;
-    sh_new_strdup(toml.table);
     return toml;
 }
 
-static TomlObject  
+static TomlObject
 TomlCreateObject()
 {
     TomlObject obj = {};
-    obj.data_table = 0;
-    sh_new_strdup(obj.data_table);
     return obj;
 }
 
-static TomlData    
+static TomlData
 TomlDataInt(int val)
 {
     TomlData data = {};
@@ -1251,7 +1631,7 @@ TomlDataInt(int val)
     return data;
 }
 
-static TomlData    
+static TomlData
 TomlDataBool(bool val)
 {
     TomlData data = {};
@@ -1260,7 +1640,7 @@ TomlDataBool(bool val)
     return data;
 }
 
-static TomlData    
+static TomlData
 TomlDataFloat(float val)
 {
     TomlData data = {};
@@ -1269,7 +1649,7 @@ TomlDataFloat(float val)
     return data;
 }
 
-static TomlData    
+static TomlData
 TomlDataString(char *str, int len)
 {
     TomlData data = {};
@@ -1279,7 +1659,7 @@ TomlDataString(char *str, int len)
     return data;
 }
 
-static TomlData    
+static TomlData
 TomlDataArray()
 {
     TomlData data = {};
@@ -1288,119 +1668,136 @@ TomlDataArray()
     return data;
 }
 
-static void        
+static void
 TomlArrayAddInt(TomlData *data, int val)
 {
-    TOML_ASSERT(data->type == Toml_Array);
     TomlData v = TomlDataInt(val);
-    if (arrlen(data->a) > 0) TOML_ASSERT(data->a[0].type == Toml_Int);
-    arrput(data->a, v);
+    TomlArrayAddInt(data, &v);
 }
 
-static void        
+static void
 TomlArrayAddBool(TomlData *data, bool val)
 {
-    TOML_ASSERT(data->type == Toml_Array);
     TomlData v = TomlDataBool(val);
-    if (arrlen(data->a) > 0) TOML_ASSERT(data->a[0].type == Toml_Bool);
-    arrput(data->a, v);
+    TomlArrayAddBool(data, &v);
 }
 
-static void        
+static void
 TomlArrayAddFloat(TomlData *data, float val)
 {
-    TOML_ASSERT(data->type == Toml_Array);
     TomlData v = TomlDataFloat(val);
-    if (arrlen(data->a) > 0) TOML_ASSERT(data->a[0].type == Toml_Float);
-    arrput(data->a, v);
+    TomlArrayAddFloat(data, &v);
 }
 
-static void        
+static void
 TomlArrayAddString(TomlData *data, char *str, int len)
 {
-    TOML_ASSERT(data->type == Toml_Array);
     TomlData v = TomlDataString(str, len);
-    if (arrlen(data->a) > 0) TOML_ASSERT(data->a[0].type == Toml_String);
-    arrput(data->a, v);
+    TomlArrayAddString(data, &v);
 }
 
-static void        
+static void
 TomlArrayAddArray(TomlData *data, TomlData *array)
 {
     TOML_ASSERT(data->type == Toml_Array);
-    if (arrlen(data->a) > 0) 
+    if (TOMLDATA_ARRAY_LEN(data->a) > 0)
         TOML_ASSERT(data->a[0].type == Toml_Array);
-    
+
     TomlData cpy = TomlDataArray();
-    for (int i = 0; i < arrlen(array->a); ++i)
+    for (int i = 0; i < TOMLDATA_ARRAY_LEN(array->a); ++i)
     {
         switch (array->a[i].type)
         {
-            case Toml_String: TomlArrayAddString(&cpy, array->a[i].s, array[i].sl);  break;
-            case Toml_Int:    TomlArrayAddInt(&cpy, array->a[i].i);                  break;
-            case Toml_Bool:   TomlArrayAddBool(&cpy, array->a[i].b);                 break;
-            case Toml_Float:  TomlArrayAddFloat(&cpy, array->a[i].f);                break;
-            case Toml_Array:  TomlArrayAddArray(&cpy, array->a[i].a);                break;
-            case Toml_Table: 
+            case Toml_String: TomlArrayAddString(&cpy, array->a[i].s, array->a[i].sl); break;
+            case Toml_Int:    TomlArrayAddInt(&cpy, array->a[i].i);                     break;
+            case Toml_Bool:   TomlArrayAddBool(&cpy, array->a[i].b);                    break;
+            case Toml_Float:  TomlArrayAddFloat(&cpy, array->a[i].f);                   break;
+            case Toml_Array:  TomlArrayAddArray(&cpy, &array->a[i]);                    break;
+            case Toml_Table:
             default: break;
         }
     }
-    
-    arrput(data->a, cpy);
+
+    data->a = (TomlData*)TomlHeapArrayPush(data->a, &cpy, sizeof(cpy));
 }
 
-static void        
+static void
 TomlArrayAddInt(TomlData *data, TomlData *i)
 {
     TOML_ASSERT(data->type == Toml_Array);
-    if (arrlen(data->a) > 0) TOML_ASSERT(data->a[0].type == Toml_Int);
-    arrput(data->a, *i);
+    if (TOMLDATA_ARRAY_LEN(data->a) > 0) TOML_ASSERT(data->a[0].type == Toml_Int);
+    data->a = (TomlData*)TomlHeapArrayPush(data->a, i, sizeof(*i));
 }
 
-static void        
+static void
 TomlArrayAddBool(TomlData *data, TomlData *b)
 {
     TOML_ASSERT(data->type == Toml_Array);
-    if (arrlen(data->a) > 0) TOML_ASSERT(data->a[0].type == Toml_Bool);
-    arrput(data->a, *b);
+    if (TOMLDATA_ARRAY_LEN(data->a) > 0) TOML_ASSERT(data->a[0].type == Toml_Bool);
+    data->a = (TomlData*)TomlHeapArrayPush(data->a, b, sizeof(*b));
 }
 
-static void        
+static void
 TomlArrayAddFloat(TomlData *data, TomlData *f)
 {
     TOML_ASSERT(data->type == Toml_Array);
-    if (arrlen(data->a) > 0) TOML_ASSERT(data->a[0].type == Toml_Float);
-    arrput(data->a, *f);
+    if (TOMLDATA_ARRAY_LEN(data->a) > 0) TOML_ASSERT(data->a[0].type == Toml_Float);
+    data->a = (TomlData*)TomlHeapArrayPush(data->a, f, sizeof(*f));
 }
 
-static void        
+static void
 TomlArrayAddString(TomlData *data, TomlData *s)
 {
     TOML_ASSERT(data->type == Toml_Array);
-    if (arrlen(data->a) > 0) TOML_ASSERT(data->a[0].type == Toml_String);
-    arrput(data->a, *s);
+    if (TOMLDATA_ARRAY_LEN(data->a) > 0) TOML_ASSERT(data->a[0].type == Toml_String);
+    data->a = (TomlData*)TomlHeapArrayPush(data->a, s, sizeof(*s));
 }
 
-static void        
+static void
 TomlObjectAddData(TomlObject *obj, TomlData *data, char *name)
 {
+    uint32_t hash = TomlHash(name, (int)strlen(name));
+
+    TomlKeyValue *existing = TomlFindKey(obj->data_table, obj->index, obj->index_mask, name, hash);
+    if (existing)
+    {
+        TomlHeapArrayFree(&existing->value);
+        existing->value = *data;
+        return;
+    }
+
     TomlKeyValue key_val = {};
-    key_val.key   = name;
+    key_val.key   = TomlCopyKey(name);
+    key_val.hash  = hash;
     key_val.value = *data;
-    shputs_len(obj->data_table, key_val, strlen(name));
+    obj->data_table = (TomlKeyValue*)TomlHeapArrayPush(obj->data_table, &key_val, sizeof(key_val));
 }
 
-static void        
+static void
 TomlAddObject(Toml *toml, TomlObject *obj, char *name)
 {
+    TOML_ASSERT(!toml->arena && "Objects can only be added to a Toml made with TomlCreate");
+    uint32_t hash = TomlHash(name, (int)strlen(name));
+
+    TomlObjectKeyValue *existing = TomlFindKey(toml->table, toml->index, toml->index_mask, name, hash);
+    if (existing)
+    {
+        existing->value = *obj;
+        return;
+    }
+
     TomlObjectKeyValue key_val = {};
-    key_val.key   = name;
+    key_val.key   = TomlCopyKey(name);
+    key_val.hash  = hash;
     key_val.value = *obj;
-    shputs_len(toml->table, key_val, strlen(name));
+    toml->table = (TomlObjectKeyValue*)TomlHeapArrayPush(toml->table, &key_val, sizeof(key_val));
 }
 
-static void 
-TomlBufferInit(TomlBuffer *buffer, int initial_size) 
+//-----------------------------------------------------------------------------------------------//
+// Writer
+
+static void
+TomlBufferInit(TomlBuffer *buffer, int initial_size)
 {
 	buffer->start = 0;
 	if (initial_size > 0) buffer->start = (char*)g_toml_internal_callbacks.Alloc(initial_size);
@@ -1408,8 +1805,8 @@ TomlBufferInit(TomlBuffer *buffer, int initial_size)
 	buffer->cap = initial_size;
 }
 
-static void 
-TomlBufferFree(TomlBuffer *buffer) 
+static void
+TomlBufferFree(TomlBuffer *buffer)
 {
 	if (buffer->start) g_toml_internal_callbacks.Free(buffer->start);
 	buffer->start = 0;
@@ -1417,47 +1814,47 @@ TomlBufferFree(TomlBuffer *buffer)
 	buffer->cap = 0;
 }
 
-static int 
-__TomlFormatString(char *buf, int len, char *fmt, va_list list) 
+static int
+__TomlFormatString(char *buf, int len, char *fmt, va_list list)
 {
 	va_list cpy;
 	va_copy(cpy, list);
 	int needed_chars = vsnprintf(NULL, 0, fmt, cpy);
 	va_end(cpy);
-    
+
 	if (buf && needed_chars < len) {
 		needed_chars = vsnprintf(buf, len, fmt, list);
 	}
 	return needed_chars;
 }
 
-static void 
-TomlWrite(TomlBuffer *buffer, char *fmt, ...) 
+static void
+TomlWrite(TomlBuffer *buffer, char *fmt, ...)
 {
 	va_list args;
 	va_start(args, fmt);
-    
+
 	// Check to see if we need to resize the buffer
     i64 chars_needed = __TomlFormatString(NULL, 0, fmt, args);
-	if (chars_needed + (buffer->current - buffer->start) > buffer->cap) {
+	if (chars_needed + (buffer->current - buffer->start) >= buffer->cap) {
         i64 offset = buffer->current - buffer->start;
-		i64 min_size = chars_needed + offset;
+		i64 min_size = chars_needed + offset + 1;
 		buffer->cap = (i32)min_size * 2;
-		
+
         void *tmp = (char*)g_toml_internal_callbacks.Alloc(buffer->cap);
-		memcpy(tmp, buffer->start, buffer->cap);
+		memcpy(tmp, buffer->start, offset);
         g_toml_internal_callbacks.Free(buffer->start);
         buffer->start = (char*)tmp;
-        
+
         buffer->current = buffer->start + offset;
 	}
-    
+
     u64 leftover = buffer->cap - (buffer->current - buffer->start);
 	chars_needed = __TomlFormatString(buffer->current, (i32)leftover, fmt, args);
-    
+
 	buffer->size += (i32)chars_needed;
 	buffer->current += chars_needed;
-    
+
 	va_end(args);
 }
 
@@ -1465,18 +1862,18 @@ static void
 TomlWriteArray(TomlBuffer *writer, TomlData *data)
 {
     TomlWrite(writer, "[");
-    
-    if (arrlen(data) > 0)
+
+    if (TOMLDATA_ARRAY_LEN(data) > 0)
     {
         TomlWriteData(writer, &data[0], NULL);
     }
-    
-    for (int k = 1; k < arrlen(data); ++k)
+
+    for (int k = 1; k < TOMLDATA_ARRAY_LEN(data); ++k)
     {
         TomlWrite(writer, ", ");
         TomlWriteData(writer, &data[k], NULL);
     }
-    
+
     TomlWrite(writer, "]");
 }
 
@@ -1484,11 +1881,11 @@ static void
 TomlWriteData(TomlBuffer *writer, TomlData *data, const char *name)
 {
     if (name) TomlWrite(writer, "%s = ", name);
-    
+
     switch (data->type)
     {
         case Toml_Array:  TomlWriteArray(writer, data->a); break;
-        case Toml_String: TomlWrite(writer, "\"%s\"", data->s); break;
+        case Toml_String: TomlWrite(writer, "\"%.*s\"", data->sl, data->s ? data->s : ""); break;
         case Toml_Int:    TomlWrite(writer, "%d", data->i); break;
         case Toml_Bool:
         {
@@ -1501,43 +1898,43 @@ TomlWriteData(TomlBuffer *writer, TomlData *data, const char *name)
     }
 }
 
-static void        
+static void
 TomlToString(Toml *toml, char **str, int *len)
 {
     TomlBuffer writer = {};
     TomlBufferInit(&writer, _KB(1));
-    
+
     if (toml->title)
         TomlWrite(&writer, "title = \"%s\"\n\n", toml->title);
-    
-    for (int i = 0; i < (int)shlen(toml->table); ++i)
+
+    for (int i = 0; i < TomlArrayLen(toml->table); ++i)
     {
         TomlObject *obj = &toml->table[i].value;
         TomlWrite(&writer, "[%s]\n", toml->table[i].key);
-        
-        for (int j = 0; j < (int)shlen(obj->data_table); ++j)
+
+        for (int j = 0; j < TomlArrayLen(obj->data_table); ++j)
         {
             TomlData *data = &obj->data_table[j].value;
             TomlWriteData(&writer, data, obj->data_table[j].key);
             TomlWrite(&writer, "\n");
         }
-        
+
         TomlWrite(&writer, "\n");
     }
-    
+
     *str = writer.start;
     *len = (int)(writer.current - writer.start);
 }
 
 // Free a string allocated by the fn call to TomlToString
-static void        
+static void
 TomlFreeString(char **str)
 {
     g_toml_internal_callbacks.Free(*str);
     *str = 0;
 }
 
-static void        
+static void
 TomlSetCallbacks(TomlCallbacks *callbacks)
 {
     if (callbacks->Alloc && callbacks->Free)
@@ -1545,10 +1942,21 @@ TomlSetCallbacks(TomlCallbacks *callbacks)
         g_toml_internal_callbacks.Alloc = callbacks->Alloc;
         g_toml_internal_callbacks.Free  = callbacks->Free;
     }
-    
+
     if (callbacks->LoadFile && callbacks->FreeFile)
     {
         g_toml_internal_callbacks.LoadFile = callbacks->LoadFile;
         g_toml_internal_callbacks.FreeFile = callbacks->FreeFile;
     }
+
+    if (callbacks->GetFileInfo) g_toml_internal_callbacks.GetFileInfo = callbacks->GetFileInfo;
+    if (callbacks->WriteFile)   g_toml_internal_callbacks.WriteFile   = callbacks->WriteFile;
+
+    if (callbacks->MapFile && callbacks->UnmapFile)
+    {
+        g_toml_internal_callbacks.MapFile   = callbacks->MapFile;
+        g_toml_internal_callbacks.UnmapFile = callbacks->UnmapFile;
+    }
 }
+
+#undef TOML_SSE2
@@ -9,7 +9,40 @@
 // TODO(Dustin): 
 // - (BUG) Spaces should be allowed in object names 
 // - (Inline) Table support
-// - (MAYBE) - custom array and hashtable to remove stb_ds as a depedency
+
+//
+// TomlLoad parses a file in a single pass over the file buffer. Strings, keys and object names
+// are views into the file buffer: the parser writes a NULL terminator over the character that
+// ends each of them (the closing quote of a string, the space, '=' or ']' after a name), so
+// they can be used as C strings until TomlFree. The objects, key/values and arrays are
+// allocated from an arena owned by the Toml, and TomlFree gives the whole arena back at once.
+//
+// The LoadFile callback must NULL terminate the buffer (buffer[size] == 0).
+//
+// Arrays are a TomlArrayHeader followed by the elements, a NULL array is empty. Objects and
+// files with more than TOML_INDEX_MIN_COUNT keys get a hash index, smaller ones are searched
+// linearly. A key that appears twice in an object keeps its first position and last value.
+//
+// A TomlCache is one file that holds the compiled form of many files: for each of them, the
+// tables of the Toml laid out as they are in memory, with offsets in place of pointers and a
+// list of the pointers to relocate. The documents are sorted by the hash of their path.
+// TomlCacheOpen maps the cache. TomlLoadCached checks the checksum of a document the first
+// time it is used, and relocates it if it is valid, otherwise the file is parsed and compiled
+// again as if it was not in the cache. Then:
+//   - the write time and size of the file match the ones of the document: the document is
+//     used, the file is not read
+//   - they differ: the file is read and hashed. With the hash of the document only the time
+//     of the document is updated, otherwise the file is parsed and compiled again.
+// TomlCacheClose rewrites the cache if anything changed.
+//
+// Documents are never evicted, the ones of deleted files stay until the cache is deleted.
+//
+
+#define TOML_INDEX_MIN_COUNT 16
+
+#define TOML_CACHE_MAGIC   0x434C4D54 // "TMLC"
+// The cache stores pointers, so it is not shared between 32 and 64-bit builds
+#define TOML_CACHE_VERSION (0x200 | (uint32_t)sizeof(void*))
 
 enum TomlType
 {
@@ -36,23 +69,35 @@ struct TomlData
     };
 };
 
+struct TomlArrayHeader
+{
+    int len;
+    int cap;
+};
+
 struct TomlKeyValue
 {
     char     *key;
+    uint32_t  hash;
     TomlData  value;
 };
 
 struct TomlObject
 {
-    TomlKeyValue *data_table;
+    TomlKeyValue *data_table; // array (see TomlArrayHeader), in the order of the file
+    uint32_t     *index;      // hash index of data_table, NULL to search it linearly
+    uint32_t      index_mask;
 };
 
 struct TomlObjectKeyValue
 {
     char       *key;
+    uint32_t    hash;
     TomlObject  value;
 };
 
+struct TomlArena;
+
 struct TomlCallbacks
 {
     void* (*Alloc)(uint64_t size);
@@ -60,16 +105,87 @@ struct TomlCallbacks
     
     void  (*LoadFile)(const char* file_path, u8** buffer, int* size);
     void  (*FreeFile)(void *ptr);
+    
+    // Used by TomlLoadCached. The default ones use stat and stdio, and read the cache instead
+    // of mapping it.
+    // @returns false if the file does not exist
+    bool  (*GetFileInfo)(const char* file_path, uint64_t* write_time, uint64_t* size);
+    // Copy-on-write view of the file, the relocation writes to it. NULL if the file does not exist.
+    void* (*MapFile)(const char* file_path, uint64_t* size);
+    void  (*UnmapFile)(void *ptr, uint64_t size);
+    void  (*WriteFile)(const char* file_path, const void* buffer, uint64_t size);
+};
+
+// Start of a cache file, followed by the entries and the documents
+struct TomlCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t count;        // of entries
+    uint64_t size;         // of the cache file, header included
+};
+
+// Sorted by path_hash
+struct TomlCacheEntry
+{
+    uint64_t path_hash;    // FNV-1a of the path given to TomlLoadCached
+    uint64_t offset;       // of the document, from the start of the cache file
+    uint64_t size;
+};
+
+// Start of the document of a file. Offsets are from the start of the document.
+struct TomlCacheDocument
+{
+    uint64_t checksum;     // of the document after source_time, which is updated in place
+    uint64_t source_time;  // write time of the source file when it was last checked
+    uint64_t source_hash;  // FNV-1a of the source file
+    uint64_t source_size;
+    uint64_t size;         // of the document, header included
+    uint64_t path;         // offset of the path of the source file
+    // Offsets 0 for NULL. They are pointers once the document is relocated.
+    uint64_t title;
+    uint64_t table;
+    uint64_t index;
+    uint32_t index_mask;
+    uint32_t reloc_count;
+    uint64_t relocs;       // offset of "reloc_count" offsets of the pointers in the document
+};
+
+// A document compiled since the cache was opened
+struct TomlCachePending
+{
+    uint64_t  path_hash;
+    char     *data;
+    uint64_t  size;
+};
+
+struct TomlCache
+{
+    char             *path;
+    char             *data;       // mapping of the cache file, NULL if there was none
+    uint64_t          size;
+    TomlCacheEntry   *entries;    // in the mapping
+    uint64_t          count;
+    uint8_t          *relocated;  // per entry, 1 once its document is relocated
+    TomlCachePending *pending;
+    uint64_t          pending_count;
+    uint64_t          pending_cap;
+    bool              dirty;
 };
 
 struct Toml
 {
     char               *title;
-    TomlObjectKeyValue *table;
-    // NOTE(Dustin): Should we store the data after parsing the file?
-    // - Reasons keeping data: strings are persistent as long as the 
-    //   data is held in memory. Can just point to their loc in 
+    TomlObjectKeyValue *table;      // array (see TomlArrayHeader), in the order of the file
+    uint32_t           *index;      // hash index of table, NULL to search it linearly
+    uint32_t            index_mask;
+    // The strings point into the file data, so it is kept until TomlFree
     void               *file_data;
+    // Blocks the parsed tables are allocated from. NULL for a Toml made with TomlCreate,
+    // which allocates every array with the Alloc callback.
+    TomlArena          *arena;
+    // Cache the tables point into, when TomlLoadCached loaded them from it
+    TomlCache          *cache;
 };
 
 enum TomlResult
@@ -85,11 +201,24 @@ enum TomlResult
 };
 
 static TomlResult  TomlLoad(Toml *toml, const char *filepath);
+// Loads a file through its compiled form in the cache (see the top of the file), or with
+// TomlLoad if "cache" is NULL. The Toml points into the cache, free it before closing the cache.
+static TomlResult  TomlLoadCached(Toml *toml, const char *filepath, TomlCache *cache);
+// Maps the cache file, which does not have to exist
+static void        TomlCacheOpen(TomlCache *cache, const char *cache_path);
+// Writes the cache file if files were compiled or their time changed, and unmaps it
+static void        TomlCacheClose(TomlCache *cache);
 static void        TomlFree(Toml *toml);
 static void        TomlSetCallbacks(TomlCallbacks *callbacks);
 
 /* Read Object API */
 static TomlObject  TomlGetObject(Toml *toml, const char *name);
+/* Objects in the order of the file */
+static int         TomlGetObjectCount(Toml *toml);
+static TomlObject  TomlGetObjectAt(Toml *toml, int idx);
+static const char* TomlGetObjectName(Toml *toml, int idx);
+/* Returns NULL if the object has no value called "name" */
+static TomlData*   TomlGetData(TomlObject *obj, const char *name);
 /* Read Basic Data Types API */
 static int         TomlGetInt(TomlObject *obj, const char *name);
 static bool        TomlGetBool(TomlObject *obj, const char *name);
@@ -0,0 +1,298 @@
+#ifndef _STR_BUILDER_H
+#define _STR_BUILDER_H
+
+//
+// Builds a string piece by piece, without allocating a string for every piece the way
+// StrAdd does. Pieces are appended to a buffer that starts inside the builder and doubles
+// when it runs out, taking the memory from an arena when the builder has one and from
+// SysAlloc otherwise. Finishing the string allocates it once: StrBuilderToStr makes a Str
+// (which does not allocate at all if it fits the small string storage), StrBuilderToStrId
+// interns it in the StrPool.
+//
+//     StrBuilder sb;
+//     StrBuilderInit(&sb);
+//     StrBuilderAppendFormat(&sb, "%s###%s", title, name);
+//     _title = StrBuilderToStr(&sb);
+//     StrBuilderReset(&sb);             // reuse the buffer for the next string
+//     ...
+//     StrBuilderFree(&sb);
+//
+// - The buffer is always NULL terminated, so StrBuilderGet can be handed to C APIs.
+// - The builder points into itself until it grows, so it must not be copied.
+// - Arena memory is not given back by StrBuilderFree, pop the arena instead. The buffer
+//   grows in place while it is the last allocation of the arena.
+//
+
+#define STR_BUILDER_INLINE_SIZE 128
+
+enum class StrBuilderStorage : u8
+{
+    Inline,
+    Arena,
+    Heap,
+};
+
+struct StrBuilder
+{
+    char             *ptr;
+    u64               len;
+    u64               cap;   // bytes of ptr, including the NULL terminator
+    arena_t           arena; // NULL to grow with SysAlloc
+    StrBuilderStorage storage;
+    char              inline_buffer[STR_BUILDER_INLINE_SIZE];
+};
+
+static void   StrBuilderInit(StrBuilder *sb, arena_t arena = NULL);
+static void   StrBuilderFree(StrBuilder *sb);
+// Empties the string, keeping the buffer
+static void   StrBuilderReset(StrBuilder *sb);
+// Makes room for "len" more characters
+static void   StrBuilderReserve(StrBuilder *sb, u64 len);
+
+static char*  StrBuilderGet(StrBuilder *sb);
+static u64    StrBuilderLen(StrBuilder *sb);
+
+static void   StrBuilderAppend(StrBuilder *sb, const char *str, u64 len);
+static void   StrBuilderAppend(StrBuilder *sb, const char *cstr);
+static void   StrBuilderAppend(StrBuilder *sb, char c);
+static void   StrBuilderAppend(StrBuilder *sb, Str *str);
+static void   StrBuilderAppend(StrBuilder *sb, STR_ID sid);
+static void   StrBuilderAppendInt(StrBuilder *sb, i64 value);
+static void   StrBuilderAppendUInt(StrBuilder *sb, u64 value);
+static void   StrBuilderAppendFloat(StrBuilder *sb, r64 value, u32 precision = 3);
+static void   StrBuilderAppendFormat(StrBuilder *sb, const char *fmt, ...);
+// Appends a path component, with a '/' between it and the string if neither has one
+static void   StrBuilderAppendPath(StrBuilder *sb, const char *path, u64 len);
+static void   StrBuilderAppendPath(StrBuilder *sb, const char *path);
+
+// The builder keeps its string, call StrBuilderReset or StrBuilderFree when done
+static Str    StrBuilderToStr(StrBuilder *sb);
+static STR_ID StrBuilderToStrId(StrBuilder *sb);
+
+#endif //_STR_BUILDER_H
+
+#if defined(MAPLE_STR_BUILDER_IMPLEMENTATION)
+
+static void
+StrBuilderInit(StrBuilder *sb, arena_t arena)
+{
+    sb->ptr     = sb->inline_buffer;
+    sb->len     = 0;
+    sb->cap     = STR_BUILDER_INLINE_SIZE;
+    sb->arena   = arena;
+    sb->storage = StrBuilderStorage::Inline;
+    sb->ptr[0]  = 0;
+}
+
+static void
+StrBuilderFree(StrBuilder *sb)
+{
+    if (sb->storage == StrBuilderStorage::Heap) SysFree(sb->ptr);
+
+    sb->ptr     = sb->inline_buffer;
+    sb->len     = 0;
+    sb->cap     = STR_BUILDER_INLINE_SIZE;
+    sb->storage = StrBuilderStorage::Inline;
+    sb->ptr[0]  = 0;
+}
+
+static void
+StrBuilderReset(StrBuilder *sb)
+{
+    sb->len    = 0;
+    sb->ptr[0] = 0;
+}
+
+static void
+StrBuilderReserve(StrBuilder *sb, u64 len)
+{
+    u64 needed = sb->len + len + 1;
+    if (needed <= sb->cap) return;
+
+    u64 cap = sb->cap * 2;
+    if (cap < needed) cap = needed;
+
+    char *result = NULL;
+    if (sb->arena)
+    {
+        if (sb->storage == StrBuilderStorage::Arena)
+        {
+            result = (char*)arena_realloc(sb->arena, sb->ptr, sb->cap, cap, 1);
+        }
+        else
+        {
+            result = (char*)arena_alloc(sb->arena, cap, 1);
+            if (result) memcpy(result, sb->ptr, sb->len + 1);
+        }
+
+        if (result)
+        {
+            sb->storage = StrBuilderStorage::Arena;
+        }
+        else
+        {
+            // The arena is full, keep going on the heap
+            LogWarn("StrBuilder: arena is full, falling back to the heap.\n");
+            sb->arena = NULL;
+        }
+    }
+
+    if (!result)
+    {
+        if (sb->storage == StrBuilderStorage::Heap)
+        {
+            result = SysRealloc(sb->ptr, cap);
+        }
+        else
+        {
+            result = (char*)SysAlloc(cap);
+            memcpy(result, sb->ptr, sb->len + 1);
+        }
+        sb->storage = StrBuilderStorage::Heap;
+    }
+
+    sb->ptr = result;
+    sb->cap = cap;
+}
+
+static char*
+StrBuilderGet(StrBuilder *sb)
+{
+    return sb->ptr;
+}
+
+static u64
+StrBuilderLen(StrBuilder *sb)
+{
+    return sb->len;
+}
+
+static void
+StrBuilderAppend(StrBuilder *sb, const char *str, u64 len)
+{
+    StrBuilderReserve(sb, len);
+    memcpy(sb->ptr + sb->len, str, len);
+    sb->len += len;
+    sb->ptr[sb->len] = 0;
+}
+
+static void
+StrBuilderAppend(StrBuilder *sb, const char *cstr)
+{
+    StrBuilderAppend(sb, cstr, strlen(cstr));
+}
+
+static void
+StrBuilderAppend(StrBuilder *sb, char c)
+{
+    StrBuilderReserve(sb, 1);
+    sb->ptr[sb->len++] = c;
+    sb->ptr[sb->len]   = 0;
+}
+
+static void
+StrBuilderAppend(StrBuilder *sb, Str *str)
+{
+    StrBuilderAppend(sb, StrGetString(str), StrLen(str));
+}
+
+static void
+StrBuilderAppend(StrBuilder *sb, STR_ID sid)
+{
+    if (IsStrIdValid(sid)) StrBuilderAppend(sb, StrToString(sid), StrLen(sid));
+}
+
+static void
+StrBuilderAppendUInt(StrBuilder *sb, u64 value)
+{
+    // Digits are written back to front, u64 has at most 20
+    char  digits[20];
+    char *iter = digits + sizeof(digits);
+    do
+    {
+        *--iter = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+
+    StrBuilderAppend(sb, iter, (u64)(digits + sizeof(digits) - iter));
+}
+
+static void
+StrBuilderAppendInt(StrBuilder *sb, i64 value)
+{
+    u64 magnitude = (u64)value;
+    if (value < 0)
+    {
+        StrBuilderAppend(sb, '-');
+        magnitude = 0 - magnitude;
+    }
+    StrBuilderAppendUInt(sb, magnitude);
+}
+
+static void
+StrBuilderAppendFloat(StrBuilder *sb, r64 value, u32 precision)
+{
+    StrBuilderAppendFormat(sb, "%.*f", (int)precision, value);
+}
+
+static void
+StrBuilderAppendFormat(StrBuilder *sb, const char *fmt, ...)
+{
+    va_list args, retry;
+    va_start(args, fmt);
+    va_copy(retry, args);
+
+    // Format straight into the buffer, and again after growing it if it was too small
+    u64 avail = sb->cap - sb->len;
+    int len   = vsnprintf(sb->ptr + sb->len, avail, fmt, args);
+    if (len >= 0 && (u64)len >= avail)
+    {
+        StrBuilderReserve(sb, (u64)len);
+        vsnprintf(sb->ptr + sb->len, (u64)len + 1, fmt, retry);
+    }
+
+    if (len > 0) sb->len += (u64)len;
+    sb->ptr[sb->len] = 0;
+
+    va_end(retry);
+    va_end(args);
+}
+
+static void
+StrBuilderAppendPath(StrBuilder *sb, const char *path, u64 len)
+{
+    bool has_separator = sb->len && (sb->ptr[sb->len - 1] == '/' || sb->ptr[sb->len - 1] == '\\');
+    bool path_has_separator = len && (path[0] == '/' || path[0] == '\\');
+
+    if (has_separator && path_has_separator)
+    {
+        path += 1;
+        len  -= 1;
+    }
+    else if (sb->len && len && !has_separator && !path_has_separator)
+    {
+        StrBuilderAppend(sb, '/');
+    }
+
+    StrBuilderAppend(sb, path, len);
+}
+
+static void
+StrBuilderAppendPath(StrBuilder *sb, const char *path)
+{
+    StrBuilderAppendPath(sb, path, strlen(path));
+}
+
+static Str
+StrBuilderToStr(StrBuilder *sb)
+{
+    return StrInit(sb->len, sb->ptr);
+}
+
+static STR_ID
+StrBuilderToStrId(StrBuilder *sb)
+{
+    return StrInit(sb->ptr, (u32)sb->len);
+}
+
+#endif // MAPLE_STR_BUILDER_IMPLEMENTATION
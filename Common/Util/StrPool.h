@@ -1,6 +1,8 @@
 #ifndef _STR_POOL_H
 #define _STR_POOL_H
 
+#include <atomic>
+
 // TODO(Dustin):
 // - Add UTF-16 support
 
@@ -48,31 +50,50 @@ operator!=(STR_ID left, STR_ID right)
 // a free-list type allocator. The allocator manages string allocations, while the
 // pool will manage intializing string memory. The underlying memory can be acquired
 // by calling "Str{16}ToString" - be aware: you are recieving the actual storage pointer, not
-// a copy of the string so be careful if you choose to edit the string memory!
+// a copy of the string, and it is shared by every STR_ID of that string (see interning below).
 //
 // A few notes on the String Allocations:
 // - A String will have the following memory footprint:
 //
-// | ---- String Memory ---- | - Footer (32 bits) - |
+// | ---- String Memory ---- | - Footer (64 bits) - |
 //
-// The 32bit Footer has the layout:
+// The 64bit Footer has the layout:
 //
-// |--------|------------|
-// | Bit    | Purpose    |
-// |--------|------------|
-// | 0 - 7  | NULL Bit   |
-// |--------|------------|
-// | 8 - 31 | Str Length |
-// |--------|------------|
+// |---------|------------|
+// | Bit     | Purpose    |
+// |---------|------------|
+// | 0 - 7   | NULL Bit   |
+// |---------|------------|
+// | 8 - 31  | Str Length |
+// |---------|------------|
+// | 32 - 63 | Str Hash   |
+// |---------|------------|
 //
 // The full size of any given allocation will be:
 //
-// Total Size = String Length + sizeof(uint32_t)
+// Total Size = String Length + sizeof(StrFooter)
 //
 // - Strings are considered immutable, and will require reallocations if the size is updated.
 //   This is imporant to be aware of because strings are not optimized for concatenation,
 //   even though this functionality is supported.
 //
+// - Strings are interned: the pool stores every distinct string once, and creating a string
+//   that is already in the pool returns the STR_ID it already has. Two STR_IDs are equal if
+//   and only if their strings are, so comparing strings is comparing the ids. Since the
+//   storage is shared, the memory returned by "StrToString" must never be written to.
+//
+//   The intern table is open addressed (linear probing) and keyed on a 64-bit hash of the
+//   string. A lookup only compares the bytes of entries with the same hash and length, so
+//   strings with colliding hashes stay distinct. Every entry counts its references, and the
+//   string is released when the last one is freed with "StrFree".
+//
+// - Allocations are lock-striped so threads creating and freeing strings rarely wait on each
+//   other. Strings of up to 256 bytes (footer included) live in slab pages: every slab page
+//   holds blocks of one size class, and each size class has its own lock, free list and
+//   slab it carves new blocks from, so a short string is allocated or freed in O(1).
+//   Longer strings go to segregated-fit pages under one lock, which skip pages without
+//   enough free bytes. The intern table is split into shards by hash, each with its own lock.
+//
 // - Strings are NOT NULL terminated. Instead, the null bit is embedded into the first bit of
 //   the length in the footer.
 //
@@ -105,12 +126,38 @@ operator!=(STR_ID left, STR_ID right)
 #define STR_POOL_LOCK(name)        CRITICAL_SECTION name
 #define STR_POOL_LOCK_INIT(lock)   InitializeCriticalSectionAndSpinCount(&(lock), 1024)
 #define STR_POOL_LOCK_FREE(lock)   DeleteCriticalSection(&(lock))
-#define STR_POOL_LOCK_LOCK(lock)   EnterCriticalSection(&(lock))
+// Counts the acquisitions that had to wait (StrPoolStats::lock_waits)
+#define STR_POOL_LOCK_LOCK(lock)                                                             \
+    do {                                                                                     \
+        if (!TryEnterCriticalSection(&(lock)))                                               \
+        {                                                                                    \
+            g_str_pool.lock_waits.fetch_add(1, std::memory_order_relaxed);                   \
+            EnterCriticalSection(&(lock));                                                   \
+        }                                                                                    \
+    } while (0)
 #define STR_POOL_LOCK_UNLOCK(lock) LeaveCriticalSection(&(lock))
 
+#elif defined(__linux__) || defined(__APPLE__)
+
+#include <pthread.h>
+
+#define STR_POOL_LOCK(name)        pthread_mutex_t name
+#define STR_POOL_LOCK_INIT(lock)   pthread_mutex_init(&(lock), NULL)
+#define STR_POOL_LOCK_FREE(lock)   pthread_mutex_destroy(&(lock))
+// Counts the acquisitions that had to wait (StrPoolStats::lock_waits)
+#define STR_POOL_LOCK_LOCK(lock)                                                             \
+    do {                                                                                     \
+        if (pthread_mutex_trylock(&(lock)) != 0)                                             \
+        {                                                                                    \
+            g_str_pool.lock_waits.fetch_add(1, std::memory_order_relaxed);                   \
+            pthread_mutex_lock(&(lock));                                                     \
+        }                                                                                    \
+    } while (0)
+#define STR_POOL_LOCK_UNLOCK(lock) pthread_mutex_unlock(&(lock))
+
 #else
 
-#pragma message (__FILE__ "[" STRING(__LINE__) "]: StrPool only supports Win32 for synchronization. Sync primitives will be turned off.")
+#pragma message (__FILE__ "[" STRING(__LINE__) "]: StrPool only supports Win32 and pthreads for synchronization. Sync primitives will be turned off.")
 
 #define STR_POOL_LOCK(name)
 #define STR_POOL_LOCK_INIT(lock)
@@ -137,27 +184,91 @@ union StrFooter
 
 #define STR_POOL_NULL_BIT 0x00
 
+#define STR_POOL_MAX_PAGES           256  // STR_ID::index is 8 bits
+#define STR_POOL_INTERN_MIN_CAPACITY 256  // entries per shard, a power of two
+#define STR_POOL_INTERN_SHARDS       16   // a power of two
+#define STR_POOL_INTERN_SHARD_SHIFT  28   // shard = bits 28 - 31 of the hash
+#define STR_POOL_SIZE_CLASSES        9
+#define STR_POOL_LARGE_PAGE          0    // Page::block_size of pages that are not slabs
+
+// Block sizes of the slab pages, footers included. Larger strings go to the large pages.
+static const u32 g_str_pool_block_sizes[STR_POOL_SIZE_CLASSES] = { 16, 24, 32, 48, 64, 96, 128, 192, 256 };
+
+struct StrPoolStats
+{
+    u64 strings;      // distinct strings in the pool
+    u64 references;   // live STR_IDs, every StrInit or StrAdd adds one and StrFree removes one
+    u64 bytes_stored; // bytes of the distinct strings, footers included
+    u64 bytes_saved;  // bytes the references to strings that were already interned would have taken
+    u64 lookups;      // strings created
+    u64 hits;         // strings created that were already interned
+    u64 lock_waits;   // times a thread found one of the pool's locks taken and had to wait
+};
+
 struct StrPool
 {
     struct Page
     {
         void    *backing;
-        memory_t allocator;
+        memory_t allocator;  // large pages only
+        u32      block_size; // STR_POOL_LARGE_PAGE, or the block size of a slab
+        u32      fail_size;  // large pages: smallest size that did not fit since the last release
+    };
+
+    // Slabs of one block size. Freed blocks go on a free list that is linked through the
+    // first 4 bytes of the blocks (the STR_ID of the next free block).
+    struct alignas(64) SizeClass
+    {
+        STR_ID free_list;
+        u32    page;        // slab blocks are carved from, STR_POOL_MAX_PAGES if there is none
+        u32    page_offset; // next uncarved block of "page"
+        STR_POOL_LOCK(lock);
     };
 
-    Page         *pages = 0;
-    STR_POOL_LOCK(cs_lock); // define synchronization lock w/ name "cs_lock"
+    // Intern table entry, the slot is empty when refs is 0
+    struct Entry
+    {
+        u64    hash;
+        STR_ID sid;  // offset points to the footer
+        u32    len;
+        u32    refs;
+    };
+
+    struct alignas(64) Shard
+    {
+        Entry        *entries;
+        u32           capacity; // power of two, at most half full
+        StrPoolStats  stats;
+        STR_POOL_LOCK(lock);
+    };
+
+    // Pages are never moved or freed before StrPoolFree, so STR_IDs resolve without a lock
+    Page              pages[STR_POOL_MAX_PAGES];
+    std::atomic<u32>  page_count{0};
+    STR_POOL_LOCK(page_lock);   // creating pages
+
+    SizeClass         classes[STR_POOL_SIZE_CLASSES];
+    u32              *large_pages = 0; // stb_ds array of page indices
+    u32               large_hint  = 0; // index into large_pages of the last page allocated from
+    STR_POOL_LOCK(large_lock);
+
+    Shard             shards[STR_POOL_INTERN_SHARDS];
+
+    std::atomic<u64>  lock_waits{0};
 };
 
 static void     StrPoolInit();
 static void     StrPoolFree();
 static void     StrPoolAlloc(void **mem, STR_ID *sid, u32 size);
 static void     StrPoolRelease(STR_ID sid);
+static void     StrPoolGetStats(StrPoolStats *stats);
 
+// Returns the STR_ID of the string, interning it if it is not in the pool yet. Every
+// StrInit has to be matched by a StrFree.
 static STR_ID   StrInit(const char *str, u32 len);
-static STR_ID   StrInit(u32 capactiy);
 static void     StrFree(STR_ID sid);
 
+// Strings are interned, so this is the same as left == right
 static bool     StrCmp(STR_ID left, STR_ID right);
 
 static STR_ID   StrAdd(STR_ID left, STR_ID right);
@@ -172,11 +283,9 @@ static wchar_t* Str16ToString(STR_ID sid);
 static u32      StrLen(STR_ID sid);
 static u32      Str16Len(STR_ID sid);
 
-// Calculate a string hash value. This is automatically called when a string
-// is initialized with data, or when a String OP occurs. If a user manually
-// sets the storage data, then it is the user's responsibility to update
-// a string's hash value.
-static void     StrHash(STR_ID sid);
+// 64-bit hash the intern table is keyed on (MurmurHash64A)
+static u64      StrHash64(const char *str, u32 len);
+// Low 32 bits of the string's hash, stored in its footer
 static u32      StrGetHash(STR_ID sid);
 
 #define StrLogTrace(...) StrLog(LOG_TRACE, __FILE__, __LINE__, __VA_ARGS__)
@@ -191,183 +300,505 @@ static void StrLog(int level, const char* file, int line, STR_ID sid);
 
 #if defined(MAPLE_STR_POOL_IMPLEMENTATION)
 
-static StrPool g_str_pool = {};
+static StrPool g_str_pool;
 
 static void
 StrPoolInit()
 {
-    // Create a single page and add it to the page list
-    StrPool::Page page = {};
-    page.backing = PlatformVirtualAlloc(_2MB);
-    memory_init(&page.allocator, _2MB, page.backing);
-    arrput(g_str_pool.pages, page);
+    g_str_pool.page_count.store(0);
+    g_str_pool.lock_waits.store(0);
+    STR_POOL_LOCK_INIT(g_str_pool.page_lock);
 
-    // Initialize the sync primitves
-    STR_POOL_LOCK_INIT(g_str_pool.cs_lock);
+    for (u32 i = 0; i < STR_POOL_SIZE_CLASSES; ++i)
+    {
+        StrPool::SizeClass *size_class = g_str_pool.classes + i;
+        size_class->free_list.mask = INVALID_STR_ID;
+        size_class->page           = STR_POOL_MAX_PAGES;
+        size_class->page_offset    = 0;
+        STR_POOL_LOCK_INIT(size_class->lock);
+    }
+
+    g_str_pool.large_pages = 0;
+    g_str_pool.large_hint  = 0;
+    STR_POOL_LOCK_INIT(g_str_pool.large_lock);
+
+    for (u32 i = 0; i < STR_POOL_INTERN_SHARDS; ++i)
+    {
+        StrPool::Shard *shard = g_str_pool.shards + i;
+
+        // Virtual allocations are zeroed, so every slot starts out empty
+        shard->entries  = (StrPool::Entry*)PlatformVirtualAlloc(STR_POOL_INTERN_MIN_CAPACITY * sizeof(StrPool::Entry));
+        shard->capacity = STR_POOL_INTERN_MIN_CAPACITY;
+        shard->stats    = {};
+        STR_POOL_LOCK_INIT(shard->lock);
+    }
 }
 
 static void
 StrPoolFree()
 {
+    // NOTE(Dustin): Not synchronized, no other thread may use the pool while it is freed
 
-    STR_POOL_LOCK_LOCK(g_str_pool.cs_lock);
+    for (u32 i = 0; i < STR_POOL_INTERN_SHARDS; ++i)
+    {
+        StrPool::Shard *shard = g_str_pool.shards + i;
+        PlatformVirtualFree(shard->entries);
+        shard->entries  = 0;
+        shard->capacity = 0;
+        STR_POOL_LOCK_FREE(shard->lock);
+    }
 
-    for (u32 i = 0; i < (u32)arrlen(g_str_pool.pages); ++i)
+    u32 page_count = g_str_pool.page_count.load();
+    for (u32 i = 0; i < page_count; ++i)
     {
         StrPool::Page *page = g_str_pool.pages + i;
-        memory_free(&page->allocator);
+        if (page->allocator) memory_free(&page->allocator);
         PlatformVirtualFree(page->backing);
+        *page = {};
     }
+    g_str_pool.page_count.store(0);
 
-    STR_POOL_LOCK_UNLOCK(g_str_pool.cs_lock);
+    for (u32 i = 0; i < STR_POOL_SIZE_CLASSES; ++i)
+        STR_POOL_LOCK_FREE(g_str_pool.classes[i].lock);
 
-    arrfree(g_str_pool.pages);
-    STR_POOL_LOCK_FREE(g_str_pool.cs_lock);
+    arrfree(g_str_pool.large_pages);
+    STR_POOL_LOCK_FREE(g_str_pool.large_lock);
+    STR_POOL_LOCK_FREE(g_str_pool.page_lock);
 }
 
+static void*
+StrPoolGetPtr(STR_ID sid)
+{
+    void *result = 0;
+    if (IsStrIdValid(sid)) result = (char*)g_str_pool.pages[sid.index].backing + sid.offset;
+    return result;
+}
 
-static void
-StrPoolAlloc(void **mem, STR_ID *sid, u32 size)
+// Returns the index of the new page, or STR_POOL_MAX_PAGES if the pool is full
+static u32
+StrPoolNewPage(u32 block_size)
 {
-    assert(size <= _2MB);
+    STR_POOL_LOCK_LOCK(g_str_pool.page_lock);
 
-    u32 page_idx = 0;
-    u32 page_offset = 0;
-    void *result = NULL;
+    u32 result = g_str_pool.page_count.load(std::memory_order_relaxed);
+    if (result < STR_POOL_MAX_PAGES)
+    {
+        StrPool::Page *page = g_str_pool.pages + result;
+        page->backing    = PlatformVirtualAlloc(_2MB);
+        page->allocator  = 0;
+        page->block_size = block_size;
+        page->fail_size  = U32_MAX;
 
-    STR_POOL_LOCK_LOCK(g_str_pool.cs_lock);
+        if (block_size == STR_POOL_LARGE_PAGE)
+            memory_init(&page->allocator, _2MB, page->backing, MemoryMode_Segregated);
 
-    for (u32 i = 0; i < (u32)arrlen(g_str_pool.pages); ++i)
+        g_str_pool.page_count.store(result + 1, std::memory_order_release);
+    }
+    else
     {
-        StrPool::Page *page = g_str_pool.pages + i;
-        result = memory_alloc(page->allocator, size);
-        if (result)
+        LogError("StrPool: out of pages!\n");
+    }
+
+    STR_POOL_LOCK_UNLOCK(g_str_pool.page_lock);
+    return result;
+}
+
+// Returns STR_POOL_SIZE_CLASSES if the size needs a large page
+static u32
+StrPoolSizeClass(u32 size)
+{
+    for (u32 i = 0; i < STR_POOL_SIZE_CLASSES; ++i)
+    {
+        if (size <= g_str_pool_block_sizes[i]) return i;
+    }
+    return STR_POOL_SIZE_CLASSES;
+}
+
+static STR_ID
+StrPoolAllocSlab(u32 class_idx)
+{
+    StrPool::SizeClass *size_class = g_str_pool.classes + class_idx;
+    u32 block_size = g_str_pool_block_sizes[class_idx];
+
+    STR_ID result;
+    result.mask = INVALID_STR_ID;
+
+    STR_POOL_LOCK_LOCK(size_class->lock);
+
+    if (IsStrIdValid(size_class->free_list))
+    {
+        result = size_class->free_list;
+        memcpy(&size_class->free_list, StrPoolGetPtr(result), sizeof(STR_ID));
+    }
+    else
+    {
+        if (size_class->page == STR_POOL_MAX_PAGES || size_class->page_offset + block_size > _2MB)
         {
-            page_idx = i;
-            page_offset = (u32)((char*)result - (char*)page->backing);
-            break;
+            size_class->page        = StrPoolNewPage(block_size);
+            size_class->page_offset = 0;
+        }
+
+        if (size_class->page != STR_POOL_MAX_PAGES)
+        {
+            result.index  = size_class->page;
+            result.offset = size_class->page_offset;
+            size_class->page_offset += block_size;
         }
     }
 
-    if (!result)
+    STR_POOL_LOCK_UNLOCK(size_class->lock);
+    return result;
+}
+
+static STR_ID
+StrPoolAllocLarge(u32 size)
+{
+    STR_ID result;
+    result.mask = INVALID_STR_ID;
+
+    STR_POOL_LOCK_LOCK(g_str_pool.large_lock);
+
+    // Start at the page the last string came from, and skip the pages that do not have
+    // enough free bytes or already failed to fit a string this size
+    u32 count = (u32)arrlen(g_str_pool.large_pages);
+    for (u32 i = 0; i < count; ++i)
     {
-        StrPool::Page page = {};
-        page.backing = PlatformVirtualAlloc(_2MB);
-        memory_init(&page.allocator, _2MB, page.backing);
-        arrput(g_str_pool.pages, page);
+        u32 j = (g_str_pool.large_hint + i) % count;
+        StrPool::Page *page = g_str_pool.pages + g_str_pool.large_pages[j];
+
+        if (size >= page->fail_size || page->allocator->Size - page->allocator->UsedMemory < size)
+            continue;
+
+        void *mem = memory_alloc(page->allocator, size);
+        if (mem)
+        {
+            result.index  = g_str_pool.large_pages[j];
+            result.offset = (u32)((char*)mem - (char*)page->backing);
+            g_str_pool.large_hint = j;
+            break;
+        }
 
-        page_idx = (u32)arrlen(g_str_pool.pages)-1;
-        result = memory_alloc(g_str_pool.pages[page_idx].allocator, size);
-        page_offset = (u32)((char*)result - (char*)g_str_pool.pages[page_idx].allocator);
+        page->fail_size = size;
     }
 
-    STR_POOL_LOCK_UNLOCK(g_str_pool.cs_lock);
+    if (!IsStrIdValid(result))
+    {
+        u32 page_idx = StrPoolNewPage(STR_POOL_LARGE_PAGE);
+        if (page_idx != STR_POOL_MAX_PAGES)
+        {
+            arrput(g_str_pool.large_pages, page_idx);
+            g_str_pool.large_hint = (u32)arrlen(g_str_pool.large_pages) - 1;
+
+            StrPool::Page *page = g_str_pool.pages + page_idx;
+            void *mem = memory_alloc(page->allocator, size);
+            if (mem)
+            {
+                result.index  = page_idx;
+                result.offset = (u32)((char*)mem - (char*)page->backing);
+            }
+        }
+    }
+
+    STR_POOL_LOCK_UNLOCK(g_str_pool.large_lock);
+    return result;
+}
+
+static void
+StrPoolAlloc(void **mem, STR_ID *sid, u32 size)
+{
+    assert(size <= _2MB);
+
+    u32 class_idx = StrPoolSizeClass(size);
+    *sid = (class_idx < STR_POOL_SIZE_CLASSES) ? StrPoolAllocSlab(class_idx) : StrPoolAllocLarge(size);
+    *mem = StrPoolGetPtr(*sid);
+}
+
+static void
+StrPoolRelease(STR_ID sid)
+{
+    if (!IsStrIdValid(sid)) return;
+
+    StrPool::Page *page = g_str_pool.pages + sid.index;
+    void *mem = (char*)page->backing + sid.offset;
 
-    if (result)
+    if (page->block_size != STR_POOL_LARGE_PAGE)
     {
-        *mem = result;
-        sid->offset = page_offset;
-        sid->index  = page_idx;
+        StrPool::SizeClass *size_class = g_str_pool.classes + StrPoolSizeClass(page->block_size);
+
+        STR_POOL_LOCK_LOCK(size_class->lock);
+        memcpy(mem, &size_class->free_list, sizeof(STR_ID));
+        size_class->free_list = sid;
+        STR_POOL_LOCK_UNLOCK(size_class->lock);
     }
     else
     {
-        *mem = NULL;
-        sid->mask = INVALID_STR_ID;
+        STR_POOL_LOCK_LOCK(g_str_pool.large_lock);
+        memory_release(page->allocator, mem);
+        page->fail_size = U32_MAX;
+        STR_POOL_LOCK_UNLOCK(g_str_pool.large_lock);
     }
 }
 
 static void
-StrPoolRelease(STR_ID sid)
+StrPoolGetStats(StrPoolStats *stats)
 {
-    if (!IsStrIdValid(sid)) return;
+    *stats = {};
+    for (u32 i = 0; i < STR_POOL_INTERN_SHARDS; ++i)
+    {
+        StrPool::Shard *shard = g_str_pool.shards + i;
+
+        STR_POOL_LOCK_LOCK(shard->lock);
+        stats->strings      += shard->stats.strings;
+        stats->references   += shard->stats.references;
+        stats->bytes_stored += shard->stats.bytes_stored;
+        stats->bytes_saved  += shard->stats.bytes_saved;
+        stats->lookups      += shard->stats.lookups;
+        stats->hits         += shard->stats.hits;
+        STR_POOL_LOCK_UNLOCK(shard->lock);
+    }
+    stats->lock_waits = g_str_pool.lock_waits.load(std::memory_order_relaxed);
+}
+
+// The footer keeps the low 32 bits of the hash, which pick both the shard and the home slot
+FORCE_INLINE StrPool::Shard*
+StrPoolGetShard(u64 hash)
+{
+    return g_str_pool.shards + (((u32)hash >> STR_POOL_INTERN_SHARD_SHIFT) & (STR_POOL_INTERN_SHARDS - 1));
+}
 
-    u32 page_idx = sid.index;
-    u32 page_offset = sid.offset;
+// The "Locked" functions expect the caller to hold the shard's lock
 
-    STR_POOL_LOCK_LOCK(g_str_pool.cs_lock);
+// Returns the slot holding the string, or the empty slot it would be inserted at
+static u32
+StrPoolFindLocked(StrPool::Shard *shard, u64 hash, const char *str, u32 len)
+{
+    u32 mask = shard->capacity - 1;
+    u32 slot = (u32)hash & mask;
 
-    StrPool::Page *page = g_str_pool.pages + page_idx;
-    void *mem = (char*)page->backing + page_offset;
-    memory_release(page->allocator, mem);
+    for (;;)
+    {
+        StrPool::Entry *entry = shard->entries + slot;
+        if (entry->refs == 0) break;
 
-    STR_POOL_LOCK_UNLOCK(g_str_pool.cs_lock);
+        if (entry->hash == hash && entry->len == len &&
+            memcmp((char*)StrPoolGetPtr(entry->sid) - len, str, len) == 0)
+        {
+            break;
+        }
+
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
 }
 
-static void*
-StrPoolGetPtr(STR_ID sid)
+static void
+StrPoolGrowLocked(StrPool::Shard *shard)
 {
-    void *result = 0;
-    if (IsStrIdValid(sid)) result = (char*)g_str_pool.pages[sid.index].backing + sid.offset;
-    return result;
+    StrPool::Entry *old_entries  = shard->entries;
+    u32             old_capacity = shard->capacity;
+
+    shard->capacity = old_capacity * 2;
+    shard->entries  = (StrPool::Entry*)PlatformVirtualAlloc(shard->capacity * sizeof(StrPool::Entry));
+
+    u32 mask = shard->capacity - 1;
+    for (u32 i = 0; i < old_capacity; ++i)
+    {
+        if (old_entries[i].refs == 0) continue;
+
+        u32 slot = (u32)old_entries[i].hash & mask;
+        while (shard->entries[slot].refs) slot = (slot + 1) & mask;
+        shard->entries[slot] = old_entries[i];
+    }
+
+    PlatformVirtualFree(old_entries);
 }
 
+// Writes the footer of a new string and adds it to the table. "slot" is the empty slot
+// returned by StrPoolFindLocked.
 static STR_ID
-StrInit(const char *cstr, u32 len)
+StrPoolInsertLocked(StrPool::Shard *shard, u32 slot, u64 hash, char *str, STR_ID sid, u32 len)
 {
-    STR_ID result;
-    char*  str;
+    // Instead of having the offset be from the start of
+    // the string, the offset should become the start of the
+    // footer. This allows for the string's length to quickly
+    // be determined.
+    sid.offset += len;
+
+    StrFooter *footer = (StrFooter*)(str + len);
+    footer->null_bit = STR_POOL_NULL_BIT;
+    footer->len      = len;
+    footer->hash     = (u32)hash;
+
+    StrPool::Entry *entry = shard->entries + slot;
+    entry->hash = hash;
+    entry->sid  = sid;
+    entry->len  = len;
+    entry->refs = 1;
+
+    shard->stats.strings      += 1;
+    shard->stats.references   += 1;
+    shard->stats.bytes_stored += len + sizeof(StrFooter);
+
+    // Keep the table at most half full, so probes stay short
+    if (shard->stats.strings * 2 > shard->capacity)
+        StrPoolGrowLocked(shard);
+
+    return sid;
+}
 
-    StrPoolAlloc((void**)&str, &result, len + sizeof(u32));
+static STR_ID
+StrPoolAddRefLocked(StrPool::Shard *shard, u32 slot)
+{
+    StrPool::Entry *entry = shard->entries + slot;
+    entry->refs += 1;
 
-    if (str)
-    {
-        // Instead of having the offset be from the start of
-        // the string, the offset should become the start of the
-        // footer. This allows for the string's length to quickly
-        // be determined.
-        result.offset += len;
+    shard->stats.hits        += 1;
+    shard->stats.references  += 1;
+    shard->stats.bytes_saved += entry->len + sizeof(StrFooter);
 
-        StrFooter *footer = (StrFooter*)(str + len);
-        footer->null_bit = STR_POOL_NULL_BIT;
-        footer->len = len;
-        memcpy(str, cstr, len);
+    return entry->sid;
+}
+
+// Interns a string that was built in place in a pool allocation of len + sizeof(StrFooter)
+// bytes. If the string is already interned, the allocation is released.
+static STR_ID
+StrPoolCommit(char *str, STR_ID sid, u32 len)
+{
+    if (!str) return sid;
+
+    u64 hash = StrHash64(str, len);
+    StrPool::Shard *shard = StrPoolGetShard(hash);
+
+    STR_POOL_LOCK_LOCK(shard->lock);
+
+    shard->stats.lookups += 1;
+
+    STR_ID result;
+    bool   duplicate = false;
+    u32 slot = StrPoolFindLocked(shard, hash, str, len);
+    if (shard->entries[slot].refs)
+    {
+        result    = StrPoolAddRefLocked(shard, slot);
+        duplicate = true;
     }
+    else
+    {
+        result = StrPoolInsertLocked(shard, slot, hash, str, sid, len);
+    }
+
+    STR_POOL_LOCK_UNLOCK(shard->lock);
 
-    StrHash(result);
+    if (duplicate) StrPoolRelease(sid);
     return result;
 }
 
+// Allocates a pool block for a string of "len" characters that is not interned yet
+static char*
+StrPoolAllocStr(STR_ID *sid, u32 len)
+{
+    char *str;
+    StrPoolAlloc((void**)&str, sid, len + sizeof(StrFooter));
+    return str;
+}
+
 static STR_ID
-StrInit(u32 capacity)
+StrInit(const char *cstr, u32 len)
 {
-    STR_ID result;
-    char*  str;
+    u64 hash = StrHash64(cstr, len);
+    StrPool::Shard *shard = StrPoolGetShard(hash);
 
-    StrPoolAlloc((void**)&str, &result, capacity + sizeof(u32));
+    STR_POOL_LOCK_LOCK(shard->lock);
 
-    if (str)
-    {
-        // Instead of having the offset be from the start of
-        // the string, the offset should become the start of the
-        // footer. This allows for the string's length to quickly
-        // be determined.
-        result.offset += capacity;
+    shard->stats.lookups += 1;
 
-        StrFooter *footer = (StrFooter*)(str + capacity);
-        footer->null_bit = STR_POOL_NULL_BIT;
-        footer->len = capacity;
+    STR_ID result;
+    u32 slot = StrPoolFindLocked(shard, hash, cstr, len);
+    if (shard->entries[slot].refs)
+    {
+        result = StrPoolAddRefLocked(shard, slot);
+    }
+    else
+    {
+        char *str = StrPoolAllocStr(&result, len);
+        if (str)
+        {
+            memcpy(str, cstr, len);
+            result = StrPoolInsertLocked(shard, slot, hash, str, result, len);
+        }
     }
 
+    STR_POOL_LOCK_UNLOCK(shard->lock);
     return result;
 }
 
 static void
 StrFree(STR_ID sid)
 {
-    // Adjust the offset so that it points to the start of
-    // the allocation, instead of the footer.
+    if (!IsStrIdValid(sid)) return;
+
     StrFooter *footer = (StrFooter*)StrPoolGetPtr(sid);
-    sid.offset -= (u32)footer->len;
+    StrPool::Shard *shard = StrPoolGetShard(footer->hash);
+
+    STR_POOL_LOCK_LOCK(shard->lock);
+
+    u32 mask = shard->capacity - 1;
+    u32 slot = (u32)footer->hash & mask;
+    while (shard->entries[slot].sid.mask != sid.mask)
+    {
+        assert(shard->entries[slot].refs && "StrFree: string is not in the pool");
+        slot = (slot + 1) & mask;
+    }
+
+    StrPool::Entry *entry = shard->entries + slot;
+    u32  size    = entry->len + sizeof(StrFooter);
+    bool release = false;
+
+    shard->stats.references -= 1;
+    entry->refs -= 1;
+
+    if (entry->refs)
+    {
+        shard->stats.bytes_saved -= size;
+    }
+    else
+    {
+        shard->stats.strings      -= 1;
+        shard->stats.bytes_stored -= size;
+
+        // Adjust the offset so that it points to the start of
+        // the allocation, instead of the footer.
+        sid.offset -= entry->len;
+        release = true;
+
+        // Backward shift deletion: move the entries after the slot back into the hole,
+        // unless that would put them before their home slot.
+        u32 hole = slot;
+        u32 next = (slot + 1) & mask;
+        while (shard->entries[next].refs)
+        {
+            u32 home = (u32)shard->entries[next].hash & mask;
+            if (((next - home) & mask) >= ((next - hole) & mask))
+            {
+                shard->entries[hole] = shard->entries[next];
+                hole = next;
+            }
+            next = (next + 1) & mask;
+        }
+
+        shard->entries[hole] = {};
+    }
+
+    STR_POOL_LOCK_UNLOCK(shard->lock);
 
-    StrPoolRelease(sid);
+    // The entry is gone, so no other thread can reach the string anymore
+    if (release) StrPoolRelease(sid);
 }
 
 static bool
 StrCmp(STR_ID left, STR_ID right)
 {
-    StrFooter *left_footer  = (StrFooter*)StrPoolGetPtr(left);
-    StrFooter *right_footer = (StrFooter*)StrPoolGetPtr(right);
-    return left_footer->hash == right_footer->hash;
+    return left.mask == right.mask;
 }
 
 static STR_ID
@@ -380,11 +811,9 @@ StrAdd(STR_ID left, STR_ID right)
     u32 right_len = (right_footer) ? (u32)right_footer->len : 0;
     u32 new_len   = left_len + right_len;
 
-    STR_ID result = StrInit(new_len);
-
-    StrFooter *result_footer = (StrFooter*)StrPoolGetPtr(result);
-    assert(result_footer);
-    void *result_ptr = (char*)result_footer - result_footer->len;
+    STR_ID result;
+    char *result_ptr = StrPoolAllocStr(&result, new_len);
+    assert(result_ptr);
 
     u32 offset = 0;
     if (left_footer)
@@ -400,8 +829,7 @@ StrAdd(STR_ID left, STR_ID right)
         memcpy((char*)result_ptr + offset, right_ptr, right_footer->len);
     }
 
-    StrHash(result);
-    return result;
+    return StrPoolCommit(result_ptr, result, new_len);
 }
 
 static STR_ID
@@ -413,11 +841,9 @@ StrAdd(STR_ID left, char right)
     u32 right_len = 1;
     u32 new_len   = left_len + right_len;
 
-    STR_ID result = StrInit(new_len);
-
-    StrFooter *result_footer = (StrFooter*)StrPoolGetPtr(result);
-    assert(result_footer);
-    void *result_ptr = (char*)result_footer - result_footer->len;
+    STR_ID result;
+    char *result_ptr = StrPoolAllocStr(&result, new_len);
+    assert(result_ptr);
 
     u32 offset = 0;
     if (left_footer)
@@ -430,8 +856,7 @@ StrAdd(STR_ID left, char right)
     // Copy the character over
     ((char*)result_ptr)[offset] = right;
 
-    StrHash(result);
-    return result;
+    return StrPoolCommit(result_ptr, result, new_len);
 }
 
 static STR_ID
@@ -443,11 +868,9 @@ StrAdd(STR_ID left, const char* right, u32 len)
     u32 right_len = len;
     u32 new_len   = left_len + right_len;
 
-    STR_ID result = StrInit(new_len);
-
-    StrFooter *result_footer = (StrFooter*)StrPoolGetPtr(result);
-    assert(result_footer);
-    void *result_ptr = (char*)result_footer - result_footer->len;
+    STR_ID result;
+    char *result_ptr = StrPoolAllocStr(&result, new_len);
+    assert(result_ptr);
 
     u32 offset = 0;
     if (left_footer)
@@ -462,8 +885,7 @@ StrAdd(STR_ID left, const char* right, u32 len)
         memcpy((char*)result_ptr + offset, right, len);
     }
 
-    StrHash(result);
-    return result;
+    return StrPoolCommit(result_ptr, result, new_len);
 }
 
 static STR_ID
@@ -475,11 +897,9 @@ StrPrepend(STR_ID left, const char* cstr_to_prepend, u32 len)
     u32 right_len = len;
     u32 new_len   = left_len + right_len;
 
-    STR_ID result = StrInit(new_len);
-
-    StrFooter *result_footer = (StrFooter*)StrPoolGetPtr(result);
-    assert(result_footer);
-    void *result_ptr = (char*)result_footer - result_footer->len;
+    STR_ID result;
+    char *result_ptr = StrPoolAllocStr(&result, new_len);
+    assert(result_ptr);
 
     u32 offset = 0;
     if (cstr_to_prepend)
@@ -494,19 +914,17 @@ StrPrepend(STR_ID left, const char* cstr_to_prepend, u32 len)
         memcpy((char*)result_ptr + offset, left_ptr, left_footer->len);
     }
 
-    StrHash(result);
-    return result;
+    return StrPoolCommit(result_ptr, result, new_len);
 }
 
 static STR_ID
 StrAdd(const char *left, u32 left_len, const char *right, u32 right_len)
 {
     u32 new_len   = left_len + right_len;
-    STR_ID result = StrInit(new_len);
 
-    StrFooter *result_footer = (StrFooter*)StrPoolGetPtr(result);
-    assert(result_footer);
-    void *result_ptr = (char*)result_footer - result_footer->len;
+    STR_ID result;
+    char *result_ptr = StrPoolAllocStr(&result, new_len);
+    assert(result_ptr);
 
     u32 offset = 0;
     if (left)
@@ -520,8 +938,7 @@ StrAdd(const char *left, u32 left_len, const char *right, u32 right_len)
         memcpy((char*)result_ptr + offset, right, right_len);
     }
 
-    StrHash(result);
-    return result;
+    return StrPoolCommit(result_ptr, result, new_len);
 }
 
 static char*
@@ -533,7 +950,9 @@ StrToString(STR_ID sid)
 
 static wchar_t*
 Str16ToString(STR_ID sid)
-{}
+{
+    return NULL; // TODO(Dustin): UTF-16
+}
 
 static u32
 StrLen(STR_ID sid)
@@ -544,7 +963,9 @@ StrLen(STR_ID sid)
 
 static u32
 Str16Len(STR_ID sid)
-{}
+{
+    return 0; // TODO(Dustin): UTF-16
+}
 
 static void
 StrLog(int level, const char *file, int line, STR_ID sid)
@@ -553,92 +974,49 @@ StrLog(int level, const char *file, int line, STR_ID sid)
     PlatformLog(level, file, line, ptr);
 }
 
-#if 0
-FORCE_INLINE uint32_t
-getblock32(const uint32_t * p, int i)
-{
-  return p[i];
-}
-
-FORCE_INLINE uint32_t
-fmix32(uint32_t h)
+// MurmurHash64A, by Austin Appleby
+static u64
+StrHash64(const char *str, u32 len)
 {
-  h ^= h >> 16;
-  h *= 0x85ebca6b;
-  h ^= h >> 13;
-  h *= 0xc2b2ae35;
-  h ^= h >> 16;
+    const u64 seed = 23216551321ull;
+    const u64 m = 0xc6a4a7935bd1e995ull;
+    const int r = 47;
 
-  return h;
-}
-#endif
-
-static void
-StrHash(STR_ID sid)
-{
-#define ROTL32(x,y) _rotl(x,y)
-#define getblock32(p, i) ((const uint32_t*)(p))[(int)(i)]
-#define fmix32(h)        \
-  h ^= h >> 16;          \
-  h *= 0x85ebca6b;       \
-  h ^= h >> 13;          \
-  h *= 0xc2b2ae35;       \
-  h ^= h >> 16;
-
-    static uint32_t seed = (uint32_t)23216551321;
-    const char *key = StrToString(sid);
-    StrFooter *footer = (StrFooter*)StrPoolGetPtr(sid);
-    int len = (int)footer->len;
-
-    const uint8_t * data = (const uint8_t*)key;
-    const int nblocks = len / 4;
-
-    uint32_t h1 = seed;
+    u64 h = seed ^ (len * m);
 
-    const uint32_t c1 = 0xcc9e2d51;
-    const uint32_t c2 = 0x1b873593;
+    const u8 *data = (const u8*)str;
+    const u8 *end  = data + (len & ~7u);
 
-    //----------
-    // body
-
-    const uint32_t * blocks = (const uint32_t *)(data + nblocks*4);
-
-    for(int i = -nblocks; i; i++)
+    for (; data != end; data += 8)
     {
-        uint32_t k1 = getblock32(blocks,i);
+        u64 k;
+        memcpy(&k, data, sizeof(k));
 
-        k1 *= c1;
-        k1 = ROTL32(k1,15);
-        k1 *= c2;
+        k *= m;
+        k ^= k >> r;
+        k *= m;
 
-        h1 ^= k1;
-        h1 = ROTL32(h1,13);
-        h1 = h1*5+0xe6546b64;
+        h ^= k;
+        h *= m;
     }
 
-    //----------
-    // tail
-
-    const uint8_t * tail = (const uint8_t*)(data + nblocks*4);
-
-    uint32_t k1 = 0;
-
-    switch(len & 3)
+    switch (len & 7)
     {
-    case 3: k1 ^= tail[2] << 16;
-    case 2: k1 ^= tail[1] << 8;
-    case 1: k1 ^= tail[0];
-          k1 *= c1; k1 = ROTL32(k1,15); k1 *= c2; h1 ^= k1;
+    case 7: h ^= (u64)data[6] << 48;
+    case 6: h ^= (u64)data[5] << 40;
+    case 5: h ^= (u64)data[4] << 32;
+    case 4: h ^= (u64)data[3] << 24;
+    case 3: h ^= (u64)data[2] << 16;
+    case 2: h ^= (u64)data[1] << 8;
+    case 1: h ^= (u64)data[0];
+            h *= m;
     };
 
-    //----------
-    // finalization
-
-    h1 ^= len;
-
-    h1 = fmix32(h1);
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
 
-    footer->hash = h1;
+    return h;
 }
 
 static u32
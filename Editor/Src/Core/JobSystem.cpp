@@ -0,0 +1,538 @@
+
+#if defined(MAPLE_JOB_SYSTEM_STD_THREAD)
+#define JOB_BACKEND_STD
+#elif defined(_WIN32)
+#define JOB_BACKEND_WIN32
+#elif defined(__linux__) || defined(__APPLE__)
+#define JOB_BACKEND_PTHREAD
+#else
+#define JOB_BACKEND_STD
+#endif
+
+#if defined(JOB_BACKEND_WIN32)
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include "Windows.h"
+
+#define JOB_LOCK(name)             CRITICAL_SECTION name
+#define JOB_LOCK_INIT(lock)        InitializeCriticalSectionAndSpinCount(&(lock), 1024)
+#define JOB_LOCK_FREE(lock)        DeleteCriticalSection(&(lock))
+#define JOB_LOCK_LOCK(lock)        EnterCriticalSection(&(lock))
+#define JOB_LOCK_UNLOCK(lock)      LeaveCriticalSection(&(lock))
+
+#define JOB_COND(name)             CONDITION_VARIABLE name
+#define JOB_COND_INIT(cond)        InitializeConditionVariable(&(cond))
+#define JOB_COND_FREE(cond)
+#define JOB_COND_WAIT(cond, lock)  SleepConditionVariableCS(&(cond), &(lock), INFINITE)
+#define JOB_COND_WAKE_ONE(cond)    WakeConditionVariable(&(cond))
+#define JOB_COND_WAKE_ALL(cond)    WakeAllConditionVariable(&(cond))
+
+#define JOB_THREAD                 HANDLE
+#define JOB_THREAD_YIELD()         SwitchToThread()
+
+#elif defined(JOB_BACKEND_PTHREAD)
+
+#include <pthread.h>
+#include <sched.h>
+
+#define JOB_LOCK(name)             pthread_mutex_t name
+#define JOB_LOCK_INIT(lock)        pthread_mutex_init(&(lock), NULL)
+#define JOB_LOCK_FREE(lock)        pthread_mutex_destroy(&(lock))
+#define JOB_LOCK_LOCK(lock)        pthread_mutex_lock(&(lock))
+#define JOB_LOCK_UNLOCK(lock)      pthread_mutex_unlock(&(lock))
+
+#define JOB_COND(name)             pthread_cond_t name
+#define JOB_COND_INIT(cond)        pthread_cond_init(&(cond), NULL)
+#define JOB_COND_FREE(cond)        pthread_cond_destroy(&(cond))
+#define JOB_COND_WAIT(cond, lock)  pthread_cond_wait(&(cond), &(lock))
+#define JOB_COND_WAKE_ONE(cond)    pthread_cond_signal(&(cond))
+#define JOB_COND_WAKE_ALL(cond)    pthread_cond_broadcast(&(cond))
+
+#define JOB_THREAD                 pthread_t
+#define JOB_THREAD_YIELD()         sched_yield()
+
+#else
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// NOTE(Dustin): condition_variable_any is used so the condition can wait directly
+// on the std::mutex rather than a unique_lock.
+#define JOB_LOCK(name)             std::mutex name
+#define JOB_LOCK_INIT(lock)
+#define JOB_LOCK_FREE(lock)
+#define JOB_LOCK_LOCK(mutex)       (mutex).lock()
+#define JOB_LOCK_UNLOCK(mutex)     (mutex).unlock()
+
+#define JOB_COND(name)             std::condition_variable_any name
+#define JOB_COND_INIT(cond)
+#define JOB_COND_FREE(cond)
+#define JOB_COND_WAIT(cond, lock)  (cond).wait(lock)
+#define JOB_COND_WAKE_ONE(cond)    (cond).notify_one()
+#define JOB_COND_WAKE_ALL(cond)    (cond).notify_all()
+
+#define JOB_THREAD                 std::thread*
+#define JOB_THREAD_YIELD()         std::this_thread::yield()
+
+#endif
+
+#define JOB_DEQUE_CAPACITY 4096 // must be a power of 2
+#define JOB_SPIN_COUNT     64   // failed searches before a worker goes to sleep
+
+struct Job
+{
+    PFN_JobTask  task;
+    PFN_JobRange range;
+    void        *args;
+    u32          begin;
+    u32          end;
+    JobCounter  *counter;
+    Job         *next; // injection queue link
+};
+
+// Chase-Lev work-stealing deque. See "Correct and Efficient Work-Stealing for
+// Weak Memory Models" (Le, Pop, Cohen, Nardelli) for the memory orderings.
+struct JobDeque
+{
+    alignas(64) std::atomic<i64> top;
+    alignas(64) std::atomic<i64> bottom;
+    std::atomic<Job*>            jobs[JOB_DEQUE_CAPACITY];
+};
+
+struct JobWorker
+{
+    JobDeque   deque;
+    JOB_THREAD thread;
+    u32        index;
+    u32        steal_seed;
+};
+
+struct JobSystem
+{
+    void             *backing;
+    JobWorker        *workers;
+    u32               worker_count; // includes the thread that called JobSystemInit
+
+    // Jobs submitted from threads without a deque
+    Job              *inject_head;
+    Job              *inject_tail;
+    // Written under inject_lock, read without it to skip the lock when the queue is empty
+    std::atomic<i32>  inject_count;
+    JOB_LOCK(inject_lock);
+
+    // Sleeping workers. "queued" is the number of jobs that have been pushed but
+    // not yet taken, and is checked against "sleepers" to avoid lost wakeups.
+    std::atomic<i32>  queued;
+    std::atomic<i32>  sleepers;
+    i32               wake_tokens;
+    b8                shutdown;
+    JOB_LOCK(sleep_lock);
+    JOB_COND(sleep_cond);
+};
+
+file_global JobSystem g_job_system = {};
+file_global thread_local JobWorker *t_job_worker = 0;
+
+file_internal bool JobDequePush(JobDeque *deque, Job *job);
+file_internal Job* JobDequePop(JobDeque *deque);
+file_internal Job* JobDequeSteal(JobDeque *deque);
+file_internal void JobPush(Job *job);
+file_internal Job* JobFind(JobWorker *worker);
+file_internal void JobExecute(Job *job);
+file_internal void JobWorkerLoop(JobWorker *worker);
+
+#if defined(JOB_BACKEND_WIN32)
+file_internal DWORD WINAPI JobWorkerThread(LPVOID lp_param)
+{
+    JobWorkerLoop((JobWorker*)lp_param);
+    return 0;
+}
+#elif defined(JOB_BACKEND_PTHREAD)
+file_internal void* JobWorkerThread(void *param)
+{
+    JobWorkerLoop((JobWorker*)param);
+    return NULL;
+}
+#endif
+
+void JobSystemInit(u32 worker_count)
+{
+    g_job_system.worker_count = worker_count + 1;
+    // The deques are cache line aligned, so align the worker array as well
+    g_job_system.backing = SysAlloc(sizeof(JobWorker) * g_job_system.worker_count + 63);
+    g_job_system.workers = (JobWorker*)memory_align((uptr)g_job_system.backing, 64);
+    g_job_system.inject_head = 0;
+    g_job_system.inject_tail = 0;
+    g_job_system.inject_count = 0;
+    g_job_system.queued = 0;
+    g_job_system.sleepers = 0;
+    g_job_system.wake_tokens = 0;
+    g_job_system.shutdown = false;
+
+    JOB_LOCK_INIT(g_job_system.inject_lock);
+    JOB_LOCK_INIT(g_job_system.sleep_lock);
+    JOB_COND_INIT(g_job_system.sleep_cond);
+
+    JobWorker *workers = g_job_system.workers;
+    for (u32 i = 0; i < g_job_system.worker_count; ++i)
+    {
+        JobWorker *worker = workers + i;
+        worker->deque.top = 0;
+        worker->deque.bottom = 0;
+        worker->thread = 0;
+        worker->index = i;
+        worker->steal_seed = i * 2654435761u + 1;
+    }
+
+    // Slot 0 belongs to the calling thread
+    t_job_worker = workers;
+
+    for (u32 i = 1; i < g_job_system.worker_count; ++i)
+    {
+#if defined(JOB_BACKEND_WIN32)
+        workers[i].thread = CreateThread(NULL, 0, JobWorkerThread, (void*)(workers + i), 0, NULL);
+        if (workers[i].thread == NULL)
+        {
+            LogError("JobSystem::Init::Failed to create worker thread %d!", i);
+        }
+#elif defined(JOB_BACKEND_PTHREAD)
+        if (pthread_create(&workers[i].thread, NULL, JobWorkerThread, (void*)(workers + i)) != 0)
+        {
+            workers[i].thread = 0;
+            LogError("JobSystem::Init::Failed to create worker thread %d!", i);
+        }
+#else
+        workers[i].thread = new std::thread(JobWorkerLoop, workers + i);
+#endif
+    }
+}
+
+void JobSystemFree()
+{
+    JobWorker *workers = g_job_system.workers;
+
+    // Finish whatever is still queued before shutting down
+    while (Job *job = JobFind(t_job_worker))
+    {
+        JobExecute(job);
+    }
+
+    JOB_LOCK_LOCK(g_job_system.sleep_lock);
+    g_job_system.shutdown = true;
+    JOB_LOCK_UNLOCK(g_job_system.sleep_lock);
+    JOB_COND_WAKE_ALL(g_job_system.sleep_cond);
+
+    for (u32 i = 1; i < g_job_system.worker_count; ++i)
+    {
+        if (!workers[i].thread) continue;
+
+#if defined(JOB_BACKEND_WIN32)
+        WaitForSingleObject(workers[i].thread, INFINITE);
+        CloseHandle(workers[i].thread);
+#elif defined(JOB_BACKEND_PTHREAD)
+        pthread_join(workers[i].thread, NULL);
+#else
+        workers[i].thread->join();
+        delete workers[i].thread;
+#endif
+        workers[i].thread = 0;
+    }
+
+    JOB_COND_FREE(g_job_system.sleep_cond);
+    JOB_LOCK_FREE(g_job_system.sleep_lock);
+    JOB_LOCK_FREE(g_job_system.inject_lock);
+
+    SysFree(g_job_system.backing);
+    g_job_system.workers = 0;
+    g_job_system.worker_count = 0;
+    t_job_worker = 0;
+}
+
+u32 JobSystemGetThreadCount()
+{
+    return g_job_system.worker_count;
+}
+
+void JobSystemSubmit(PFN_JobTask fn, void *args, JobCounter *counter)
+{
+    if (!fn) return;
+
+    Job *job = (Job*)SysAlloc(sizeof(Job));
+    job->task    = fn;
+    job->range   = NULL;
+    job->args    = args;
+    job->begin   = 0;
+    job->end     = 0;
+    job->counter = counter;
+    job->next    = NULL;
+
+    if (counter) counter->value.fetch_add(1, std::memory_order_relaxed);
+
+    JobPush(job);
+}
+
+void JobSystemWait(JobCounter *counter)
+{
+    if (!counter) return;
+
+    while (counter->value.load(std::memory_order_acquire) > 0)
+    {
+        Job *job = JobFind(t_job_worker);
+        if (job) JobExecute(job);
+        else     JOB_THREAD_YIELD();
+    }
+}
+
+void JobSystemParallelFor(u32 count, u32 grain, PFN_JobRange fn, void *args)
+{
+    if (!fn || count == 0) return;
+    if (grain == 0) grain = 1;
+
+    JobCounter counter;
+    for (u32 begin = 0; begin < count; begin += grain)
+    {
+        Job *job = (Job*)SysAlloc(sizeof(Job));
+        job->task    = NULL;
+        job->range   = fn;
+        job->args    = args;
+        job->begin   = begin;
+        job->end     = (count - begin > grain) ? begin + grain : count;
+        job->counter = &counter;
+        job->next    = NULL;
+
+        counter.value.fetch_add(1, std::memory_order_relaxed);
+        JobPush(job);
+    }
+
+    JobSystemWait(&counter);
+}
+
+file_internal bool
+JobDequePush(JobDeque *deque, Job *job)
+{
+    i64 b = deque->bottom.load(std::memory_order_relaxed);
+    i64 t = deque->top.load(std::memory_order_acquire);
+    if (b - t >= JOB_DEQUE_CAPACITY) return false;
+
+    deque->jobs[b & (JOB_DEQUE_CAPACITY - 1)].store(job, std::memory_order_release);
+    deque->bottom.store(b + 1, std::memory_order_release);
+    return true;
+}
+
+file_internal Job*
+JobDequePop(JobDeque *deque)
+{
+    i64 b = deque->bottom.load(std::memory_order_relaxed) - 1;
+    deque->bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    i64 t = deque->top.load(std::memory_order_relaxed);
+
+    Job *result = NULL;
+    if (t <= b)
+    {
+        result = deque->jobs[b & (JOB_DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (t == b)
+        {
+            // Last job in the deque, race the thieves for it
+            if (!deque->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                result = NULL;
+            deque->bottom.store(b + 1, std::memory_order_relaxed);
+        }
+    }
+    else
+    {
+        deque->bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return result;
+}
+
+file_internal Job*
+JobDequeSteal(JobDeque *deque)
+{
+    i64 t = deque->top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    i64 b = deque->bottom.load(std::memory_order_acquire);
+
+    Job *result = NULL;
+    if (t < b)
+    {
+        result = deque->jobs[t & (JOB_DEQUE_CAPACITY - 1)].load(std::memory_order_acquire);
+        if (!deque->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            result = NULL;
+    }
+    return result;
+}
+
+file_internal void
+JobPush(Job *job)
+{
+    JobWorker *worker = t_job_worker;
+    if (worker)
+    {
+        if (!JobDequePush(&worker->deque, job))
+        {
+            // Deque is full. Rather than dropping the job, run it right away.
+            JobExecute(job);
+            return;
+        }
+    }
+    else
+    {
+        JOB_LOCK_LOCK(g_job_system.inject_lock);
+        if (g_job_system.inject_tail) g_job_system.inject_tail->next = job;
+        else                          g_job_system.inject_head = job;
+        g_job_system.inject_tail = job;
+        g_job_system.inject_count.fetch_add(1, std::memory_order_relaxed);
+        JOB_LOCK_UNLOCK(g_job_system.inject_lock);
+    }
+
+    g_job_system.queued.fetch_add(1, std::memory_order_seq_cst);
+
+    // Only wake a single worker, and only if one is asleep
+    if (g_job_system.sleepers.load(std::memory_order_seq_cst) > 0)
+    {
+        JOB_LOCK_LOCK(g_job_system.sleep_lock);
+        if (g_job_system.wake_tokens < g_job_system.sleepers.load(std::memory_order_relaxed))
+            g_job_system.wake_tokens++;
+        JOB_LOCK_UNLOCK(g_job_system.sleep_lock);
+        JOB_COND_WAKE_ONE(g_job_system.sleep_cond);
+    }
+}
+
+file_internal Job*
+JobFind(JobWorker *worker)
+{
+    Job *result = NULL;
+
+    if (worker) result = JobDequePop(&worker->deque);
+
+    if (!result && g_job_system.inject_count.load(std::memory_order_relaxed) > 0)
+    {
+        JOB_LOCK_LOCK(g_job_system.inject_lock);
+        result = g_job_system.inject_head;
+        if (result)
+        {
+            g_job_system.inject_head = result->next;
+            if (!g_job_system.inject_head) g_job_system.inject_tail = NULL;
+            g_job_system.inject_count.fetch_sub(1, std::memory_order_relaxed);
+        }
+        JOB_LOCK_UNLOCK(g_job_system.inject_lock);
+    }
+
+    if (!result && g_job_system.worker_count > 1)
+    {
+        // Start stealing from a random victim so thieves spread out
+        JobWorker *workers = g_job_system.workers;
+        u32 start = 0;
+        if (worker)
+        {
+            worker->steal_seed ^= worker->steal_seed << 13;
+            worker->steal_seed ^= worker->steal_seed >> 17;
+            worker->steal_seed ^= worker->steal_seed << 5;
+            start = worker->steal_seed;
+        }
+
+        for (u32 i = 0; i < g_job_system.worker_count && !result; ++i)
+        {
+            JobWorker *victim = workers + ((start + i) % g_job_system.worker_count);
+            if (victim != worker) result = JobDequeSteal(&victim->deque);
+        }
+    }
+
+    if (result) g_job_system.queued.fetch_sub(1, std::memory_order_relaxed);
+    return result;
+}
+
+file_internal void
+JobExecute(Job *job)
+{
+    if (job->task) job->task(job->args);
+    else           job->range(job->begin, job->end, job->args);
+
+    JobCounter *counter = job->counter;
+    SysFree(job);
+
+    if (counter) counter->value.fetch_sub(1, std::memory_order_release);
+}
+
+file_internal void
+JobWorkerLoop(JobWorker *worker)
+{
+    t_job_worker = worker;
+
+    u32 spin = 0;
+    for (;;)
+    {
+        Job *job = JobFind(worker);
+        if (job)
+        {
+            JobExecute(job);
+            spin = 0;
+            continue;
+        }
+
+        if (++spin < JOB_SPIN_COUNT)
+        {
+            JOB_THREAD_YIELD();
+            continue;
+        }
+        spin = 0;
+
+        JOB_LOCK_LOCK(g_job_system.sleep_lock);
+        g_job_system.sleepers.fetch_add(1, std::memory_order_seq_cst);
+        while (!g_job_system.shutdown && g_job_system.wake_tokens == 0 &&
+               g_job_system.queued.load(std::memory_order_seq_cst) == 0)
+        {
+            JOB_COND_WAIT(g_job_system.sleep_cond, g_job_system.sleep_lock);
+        }
+        if (g_job_system.wake_tokens > 0) g_job_system.wake_tokens--;
+        g_job_system.sleepers.fetch_sub(1, std::memory_order_seq_cst);
+        b8 shutdown = g_job_system.shutdown;
+        JOB_LOCK_UNLOCK(g_job_system.sleep_lock);
+
+        if (shutdown) break;
+    }
+
+    t_job_worker = 0;
+    SysMemoryThreadFlush();
+}
+
+//-------------------------------------------------------------------------------------------------
+// Platform Threading API
+
+void PlatformAsyncTask(void (*fn)(void*), void *args, JobCounter *counter)
+{
+    JobSystemSubmit(fn, args, counter);
+}
+
+void PlatformWaitForCounter(JobCounter *counter)
+{
+    JobSystemWait(counter);
+}
+
+void PlatformParallelFor(u32 count, u32 grain, void (*fn)(u32 begin, u32 end, void *args), void *args)
+{
+    JobSystemParallelFor(count, grain, fn, args);
+}
+
+#undef JOB_SPIN_COUNT
+#undef JOB_DEQUE_CAPACITY
+#undef JOB_THREAD_YIELD
+#undef JOB_THREAD
+#undef JOB_COND_WAKE_ALL
+#undef JOB_COND_WAKE_ONE
+#undef JOB_COND_WAIT
+#undef JOB_COND_FREE
+#undef JOB_COND_INIT
+#undef JOB_COND
+#undef JOB_LOCK_UNLOCK
+#undef JOB_LOCK_LOCK
+#undef JOB_LOCK_FREE
+#undef JOB_LOCK_INIT
+#undef JOB_LOCK
+#undef JOB_BACKEND_PTHREAD
+#undef JOB_BACKEND_WIN32
+#undef JOB_BACKEND_STD
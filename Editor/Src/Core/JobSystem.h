@@ -0,0 +1,42 @@
+#ifndef _JOB_SYSTEM_H
+#define _JOB_SYSTEM_H
+
+#include <atomic>
+
+//
+// Work-stealing job scheduler. Every worker thread (and the thread that called
+// JobSystemInit) owns a Chase-Lev deque: the owner pushes and pops jobs from the
+// bottom, and idle workers steal from the top of other deques. Threads that are
+// not part of the system submit into a shared injection queue.
+//
+// Completion is tracked with a JobCounter. Each job submitted with a counter
+// increments it, and decrements it when the job finishes. JobSystemWait does not
+// block the calling thread while the counter is non-zero, it executes other
+// jobs instead, so it is safe to wait from within a job.
+//
+// The threading backend is Win32 on Windows and pthreads on Linux/macOS. Define
+// MAPLE_JOB_SYSTEM_STD_THREAD to use std::thread on any platform.
+//
+
+struct JobCounter
+{
+    std::atomic<i32> value{0};
+};
+
+typedef void (*PFN_JobTask)(void *args);
+typedef void (*PFN_JobRange)(u32 begin, u32 end, void *args);
+
+// @param worker_count: number of threads to spawn, in addition to the calling thread
+void JobSystemInit(u32 worker_count);
+void JobSystemFree();
+
+u32  JobSystemGetThreadCount();
+
+void JobSystemSubmit(PFN_JobTask fn, void *args, JobCounter *counter = NULL);
+void JobSystemWait(JobCounter *counter);
+
+// Splits [0, count) into ranges of at most "grain" elements, runs them across
+// the workers, and returns once all ranges have finished.
+void JobSystemParallelFor(u32 count, u32 grain, PFN_JobRange fn, void *args);
+
+#endif //_JOB_SYSTEM_H
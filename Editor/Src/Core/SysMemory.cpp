@@ -1,27 +1,356 @@
 
-file_global memory_t g_app_memory = 0;
+// NOTE(Dustin): memory_t is not thread safe. All requests to the global heap are
+// serialized with a lock, and small allocations are served from per-thread caches
+// so worker threads only touch the lock when a cache needs to be refilled or flushed.
+//
+// Every allocation is prefixed with an 8 byte tag:
+//
+// | ---- Tag (64 bits) ---- | ---- User Memory ---- |
+//
+// For small allocations, the tag is the address of the owning thread cache with
+// (size class + 1) stored in the bottom bits. Thread caches are 64 byte aligned, so
+// the bottom 6 bits are free. Large allocations have a tag of 0 and go straight to
+// the global heap.
+
+#if defined(_WIN32)
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include "Windows.h"
+
+#define SYS_MEMORY_LOCK(name)        CRITICAL_SECTION name
+#define SYS_MEMORY_LOCK_INIT(lock)   InitializeCriticalSectionAndSpinCount(&(lock), 1024)
+#define SYS_MEMORY_LOCK_FREE(lock)   DeleteCriticalSection(&(lock))
+#define SYS_MEMORY_LOCK_LOCK(lock)   EnterCriticalSection(&(lock))
+#define SYS_MEMORY_LOCK_UNLOCK(lock) LeaveCriticalSection(&(lock))
+
+#elif defined(__linux__) || defined(__APPLE__)
+
+#include <pthread.h>
+
+#define SYS_MEMORY_LOCK(name)        pthread_mutex_t name
+#define SYS_MEMORY_LOCK_INIT(lock)   pthread_mutex_init(&(lock), NULL)
+#define SYS_MEMORY_LOCK_FREE(lock)   pthread_mutex_destroy(&(lock))
+#define SYS_MEMORY_LOCK_LOCK(lock)   pthread_mutex_lock(&(lock))
+#define SYS_MEMORY_LOCK_UNLOCK(lock) pthread_mutex_unlock(&(lock))
+
+#else
+
+#error SysMemory synchronization is not supported on this platform!
+
+#endif
+
+#define SYS_MEMORY_TAG_SIZE      sizeof(u64)
+#define SYS_MEMORY_CLASS_MASK    0x3F
+#define SYS_MEMORY_CLASS_COUNT   6    // 16, 32, 64, 128, 256, 512 bytes
+#define SYS_MEMORY_MIN_CLASS     4    // log2 of the smallest class
+#define SYS_MEMORY_MAX_SMALL     512
+#define SYS_MEMORY_MAGAZINE_SIZE 64
+#define SYS_MEMORY_BATCH_SIZE    32   // blocks moved between a cache and the global heap at once
+
+struct SysThreadCache
+{
+    void           *magazines[SYS_MEMORY_CLASS_COUNT][SYS_MEMORY_MAGAZINE_SIZE];
+    u32             counts[SYS_MEMORY_CLASS_COUNT];
+    // Lock-free stack of blocks released by other threads. Other threads only push,
+    // the owning thread takes the entire list at once, so there is no ABA problem.
+    void * volatile remote_free;
+    void           *backing; // unaligned allocation the cache lives in
+    SysThreadCache *next;
+};
+
+struct SysMemory
+{
+    memory_t        heap;
+    SysThreadCache *caches; // every cache created, so they can be flushed at shutdown
+    SYS_MEMORY_LOCK(cs_lock);
+};
+
+file_global SysMemory                    g_app_memory = {};
+file_global thread_local SysThreadCache *t_thread_cache = 0;
+
+file_internal u32             SysMemorySizeToClass(u64 size);
+file_internal SysThreadCache* SysMemoryGetThreadCache();
+file_internal void            SysMemoryDrainRemote(SysThreadCache *cache);
+file_internal void            SysMemoryRefill(SysThreadCache *cache, u32 size_class);
+file_internal void            SysMemoryFlushClass(SysThreadCache *cache, u32 size_class, u32 count);
+file_internal void            SysMemoryFlushCache(SysThreadCache *cache);
 
 void SysMemoryInit(void *ptr, u64 size)
 {
-    memory_init(&g_app_memory, size, ptr);
+    SYS_MEMORY_LOCK_INIT(g_app_memory.cs_lock);
+    memory_init(&g_app_memory.heap, size, ptr, MemoryMode_Segregated);
+    g_app_memory.caches = 0;
 }
 
 void SysMemoryFree()
 {
-    memory_free(&g_app_memory);
+    // Return every cached block to the heap before tearing it down. It is
+    // expected that all worker threads have finished by now.
+    SYS_MEMORY_LOCK_LOCK(g_app_memory.cs_lock);
+
+    SysThreadCache *cache = g_app_memory.caches;
+    while (cache)
+    {
+        SysThreadCache *next = cache->next;
+        SysMemoryFlushCache(cache);
+        memory_release(g_app_memory.heap, cache->backing);
+        cache = next;
+    }
+    g_app_memory.caches = 0;
+    t_thread_cache = 0;
+
+    SYS_MEMORY_LOCK_UNLOCK(g_app_memory.cs_lock);
+
+    memory_free(&g_app_memory.heap);
+    SYS_MEMORY_LOCK_FREE(g_app_memory.cs_lock);
+}
+
+void SysMemoryThreadFlush()
+{
+    if (t_thread_cache)
+    {
+        SYS_MEMORY_LOCK_LOCK(g_app_memory.cs_lock);
+        SysMemoryFlushCache(t_thread_cache);
+        SYS_MEMORY_LOCK_UNLOCK(g_app_memory.cs_lock);
+    }
 }
 
 void* SysMemoryAlloc(u64 size)
 {
-    return memory_alloc(g_app_memory, size);
+    if (size == 0) return NULL;
+
+    u64 *tag = NULL;
+
+    if (size <= SYS_MEMORY_MAX_SMALL)
+    {
+        u32 size_class = SysMemorySizeToClass(size);
+        SysThreadCache *cache = SysMemoryGetThreadCache();
+        if (cache)
+        {
+            if (cache->counts[size_class] == 0) SysMemoryDrainRemote(cache);
+            if (cache->counts[size_class] == 0) SysMemoryRefill(cache, size_class);
+
+            if (cache->counts[size_class] > 0)
+            {
+                tag = (u64*)cache->magazines[size_class][--cache->counts[size_class]];
+                *tag = (u64)cache | (u64)(size_class + 1);
+            }
+        }
+    }
+
+    // Large allocations, and small ones the thread cache could not serve
+    if (!tag)
+    {
+        SYS_MEMORY_LOCK_LOCK(g_app_memory.cs_lock);
+        tag = (u64*)memory_alloc(g_app_memory.heap, size + SYS_MEMORY_TAG_SIZE);
+        SYS_MEMORY_LOCK_UNLOCK(g_app_memory.cs_lock);
+
+        if (tag) *tag = 0;
+    }
+
+    return (tag) ? (void*)(tag + 1) : NULL;
 }
 
 void SysMemoryRelease(void *ptr)
 {
-    memory_release(g_app_memory, ptr);
+    if (!ptr) return;
+
+    u64 *tag = (u64*)ptr - 1;
+    u32 size_class = (u32)(*tag & SYS_MEMORY_CLASS_MASK);
+
+    if (size_class == 0)
+    {
+        SYS_MEMORY_LOCK_LOCK(g_app_memory.cs_lock);
+        memory_release(g_app_memory.heap, tag);
+        SYS_MEMORY_LOCK_UNLOCK(g_app_memory.cs_lock);
+        return;
+    }
+
+    size_class -= 1;
+    SysThreadCache *owner = (SysThreadCache*)(*tag & ~(u64)SYS_MEMORY_CLASS_MASK);
+
+    if (owner == t_thread_cache)
+    {
+        if (owner->counts[size_class] == SYS_MEMORY_MAGAZINE_SIZE)
+        {
+            SYS_MEMORY_LOCK_LOCK(g_app_memory.cs_lock);
+            SysMemoryFlushClass(owner, size_class, SYS_MEMORY_BATCH_SIZE);
+            SYS_MEMORY_LOCK_UNLOCK(g_app_memory.cs_lock);
+        }
+
+        owner->magazines[size_class][owner->counts[size_class]++] = tag;
+    }
+    else
+    {
+        // Block belongs to another thread, hand it back through the owner's
+        // remote free list. The user memory stores the next link. The head is only read
+        // through the exchange, a failed one returns the current head to retry with.
+        void *head = NULL;
+        for (;;)
+        {
+            *(void**)ptr = head;
+            void *seen = PlatformAtomicCompareExchangePtr(&owner->remote_free, tag, head);
+            if (seen == head) break;
+            head = seen;
+        }
+    }
 }
 
 void* SysMemoryRealloc(void *ptr, u64 size)
 {
-    return memory_realloc(g_app_memory, ptr, size);
+    if (!ptr) return SysMemoryAlloc(size);
+
+    u64 *tag = (u64*)ptr - 1;
+    u32 size_class = (u32)(*tag & SYS_MEMORY_CLASS_MASK);
+
+    void *result = NULL;
+    if (size_class == 0)
+    {
+        SYS_MEMORY_LOCK_LOCK(g_app_memory.cs_lock);
+        tag = (u64*)memory_realloc(g_app_memory.heap, tag, size + SYS_MEMORY_TAG_SIZE);
+        SYS_MEMORY_LOCK_UNLOCK(g_app_memory.cs_lock);
+
+        result = (tag) ? (void*)(tag + 1) : NULL;
+    }
+    else
+    {
+        u64 class_size = 1ULL << (size_class - 1 + SYS_MEMORY_MIN_CLASS);
+        if (size <= class_size)
+        {
+            result = ptr;
+        }
+        else
+        {
+            // The block is kept when the allocation fails, like the heap path
+            result = SysMemoryAlloc(size);
+            if (result)
+            {
+                memcpy(result, ptr, class_size);
+                SysMemoryRelease(ptr);
+            }
+        }
+    }
+
+    return result;
+}
+
+file_internal u32
+SysMemorySizeToClass(u64 size)
+{
+    u32 result = 0;
+    u64 class_size = 1ULL << SYS_MEMORY_MIN_CLASS;
+    while (class_size < size)
+    {
+        class_size <<= 1;
+        ++result;
+    }
+    return result;
+}
+
+file_internal SysThreadCache*
+SysMemoryGetThreadCache()
+{
+    if (!t_thread_cache)
+    {
+        SYS_MEMORY_LOCK_LOCK(g_app_memory.cs_lock);
+
+        void *backing = memory_alloc(g_app_memory.heap, sizeof(SysThreadCache) + SYS_MEMORY_CLASS_MASK);
+        SysThreadCache *cache = NULL;
+        if (backing)
+        {
+            cache = (SysThreadCache*)memory_align((uptr)backing, SYS_MEMORY_CLASS_MASK + 1);
+            memset(cache, 0, sizeof(SysThreadCache));
+            cache->backing = backing;
+
+            cache->next = g_app_memory.caches;
+            g_app_memory.caches = cache;
+        }
+
+        SYS_MEMORY_LOCK_UNLOCK(g_app_memory.cs_lock);
+
+        // Without a cache the thread allocates from the heap, and tries again next time
+        t_thread_cache = cache;
+    }
+    return t_thread_cache;
+}
+
+file_internal void
+SysMemoryDrainRemote(SysThreadCache *cache)
+{
+    void *iter = PlatformAtomicExchangePtr(&cache->remote_free, NULL);
+    if (!iter) return;
+
+    SYS_MEMORY_LOCK_LOCK(g_app_memory.cs_lock);
+
+    while (iter)
+    {
+        u64 *tag = (u64*)iter;
+        void *next = *(void**)(tag + 1);
+        u32 size_class = (u32)(*tag & SYS_MEMORY_CLASS_MASK) - 1;
+
+        if (cache->counts[size_class] < SYS_MEMORY_MAGAZINE_SIZE)
+            cache->magazines[size_class][cache->counts[size_class]++] = tag;
+        else
+            memory_release(g_app_memory.heap, tag);
+
+        iter = next;
+    }
+
+    SYS_MEMORY_LOCK_UNLOCK(g_app_memory.cs_lock);
+}
+
+file_internal void
+SysMemoryRefill(SysThreadCache *cache, u32 size_class)
+{
+    u64 block_size = (1ULL << (size_class + SYS_MEMORY_MIN_CLASS)) + SYS_MEMORY_TAG_SIZE;
+
+    SYS_MEMORY_LOCK_LOCK(g_app_memory.cs_lock);
+
+    for (u32 i = 0; i < SYS_MEMORY_BATCH_SIZE; ++i)
+    {
+        void *block = memory_alloc(g_app_memory.heap, block_size);
+        if (!block) break;
+        cache->magazines[size_class][cache->counts[size_class]++] = block;
+    }
+
+    SYS_MEMORY_LOCK_UNLOCK(g_app_memory.cs_lock);
 }
+
+// Caller is expected to hold the global lock
+file_internal void
+SysMemoryFlushClass(SysThreadCache *cache, u32 size_class, u32 count)
+{
+    count = (count < cache->counts[size_class]) ? count : cache->counts[size_class];
+    for (u32 i = 0; i < count; ++i)
+    {
+        memory_release(g_app_memory.heap, cache->magazines[size_class][--cache->counts[size_class]]);
+    }
+}
+
+// Caller is expected to hold the global lock
+file_internal void
+SysMemoryFlushCache(SysThreadCache *cache)
+{
+    void *iter = PlatformAtomicExchangePtr(&cache->remote_free, NULL);
+    while (iter)
+    {
+        void *next = *(void**)((u64*)iter + 1);
+        memory_release(g_app_memory.heap, iter);
+        iter = next;
+    }
+
+    for (u32 i = 0; i < SYS_MEMORY_CLASS_COUNT; ++i)
+    {
+        SysMemoryFlushClass(cache, i, SYS_MEMORY_MAGAZINE_SIZE);
+    }
+}
+
+#undef SYS_MEMORY_BATCH_SIZE
+#undef SYS_MEMORY_MAGAZINE_SIZE
+#undef SYS_MEMORY_MAX_SMALL
+#undef SYS_MEMORY_MIN_CLASS
+#undef SYS_MEMORY_CLASS_COUNT
+#undef SYS_MEMORY_CLASS_MASK
+#undef SYS_MEMORY_TAG_SIZE
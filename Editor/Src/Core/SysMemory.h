@@ -11,6 +11,16 @@
 #define SysRealloc(p, s) realloc((p), (s))
 #endif
 
+void SysMemoryInit(void *ptr, u64 size);
+void SysMemoryFree();
+// Returns the calling thread's cached blocks to the global heap. Worker threads
+// should call this before exiting.
+void SysMemoryThreadFlush();
+
+void* SysMemoryAlloc(u64 size);
+void  SysMemoryRelease(void *ptr);
+void* SysMemoryRealloc(void *ptr, u64 size);
+
 #ifdef __cplusplus
 
 template<typename T> T* SysReallocWrapperT(T* ptr, u64 size)
@@ -22,11 +32,4 @@ template<typename T> T* SysReallocWrapperT(T* ptr, u64 size)
 #define SysReallocWrapperT(p, s) ((p) = SysMemoryRealloc((p), (s)))
 #endif
 
-void SysMemoryInit(void *ptr, u64 size);
-void SysMemoryFree();
-
-void* SysMemoryAlloc(u64 size);
-void  SysMemoryRelease(void *ptr);
-void* SysMemoryRealloc(void *ptr, u64 size);
-
 #endif // _SYS_MEMORY_H
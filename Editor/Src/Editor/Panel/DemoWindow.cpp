@@ -17,13 +17,11 @@ DemoWindow::OnInit(const char *name)
     u64 name_len = strlen(name);
     _name = StrInit(name_len, name);
     
-    {
-        u64 offset = 0;
-        u64 len = name_len + strlen(c_dockspace_name);
-        _dockspace_name = StrInit(len, NULL);
-        char *ptr = StrGetString(&_dockspace_name);
-        ImFormatString(ptr, len, "%s%s", name, c_dockspace_name);
-    }
+    StrBuilder sb;
+    StrBuilderInit(&sb);
+    StrBuilderAppendFormat(&sb, "%s%s", name, c_dockspace_name);
+    _dockspace_name = StrBuilderToStr(&sb);
+    StrBuilderFree(&sb);
 }
 
 void 
@@ -47,37 +47,27 @@ void MainViewportWindow::OnInit(const char *name)
     u64 name_len = strlen(name);
     _name = StrInit(name_len, name);
     
-    {
-        u64 offset = 0;
-        u64 len = name_len + strlen(c_dockspace_name);
-        _dockspace_name = StrInit(len, NULL);
-        char *ptr = StrGetString(&_dockspace_name);
-        ImFormatString(ptr, len, "%s%s", name, c_dockspace_name);
-    }
+    // One builder makes all the names, each name is a single allocation
+    StrBuilder sb;
+    StrBuilderInit(&sb);
     
-    {
-        u64 offset = 0;
-        u64 len = name_len + 3 + 2*strlen(c_scene_name);
-        _scene_wnd_name = StrInit(len, NULL);
-        char *ptr = StrGetString(&_scene_wnd_name);
-        ImFormatString(ptr, len, "%s###%s%s", c_scene_name, name, c_scene_name);
-    }
+    StrBuilderAppendFormat(&sb, "%s%s", name, c_dockspace_name);
+    _dockspace_name = StrBuilderToStr(&sb);
+    StrBuilderReset(&sb);
     
-    {
-        u64 offset = 0;
-        u64 len = name_len + 3 + 2*strlen(c_content_browser_name);
-        _content_browser_wnd_name = StrInit(len, NULL);
-        char *ptr = StrGetString(&_content_browser_wnd_name);
-        ImFormatString(ptr, len, "%s###%s%s", c_content_browser_name, name, c_content_browser_name);
-    }
+    StrBuilderAppendFormat(&sb, "%s###%s%s", c_scene_name, name, c_scene_name);
+    _scene_wnd_name = StrBuilderToStr(&sb);
+    StrBuilderReset(&sb);
     
-    {
-        u64 offset = 0;
-        u64 len = name_len + 3 + 2*strlen(c_viewport_name);
-        _viewport_wnd_name = StrInit(len, NULL);
-        char *ptr = StrGetString(&_viewport_wnd_name);
-        ImFormatString(ptr, len, "%s###%s%s", c_viewport_name, name, c_viewport_name);
-    }
+    StrBuilderAppendFormat(&sb, "%s###%s%s", c_content_browser_name, name, c_content_browser_name);
+    _content_browser_wnd_name = StrBuilderToStr(&sb);
+    StrBuilderReset(&sb);
+    
+    StrBuilderAppendFormat(&sb, "%s###%s%s", c_viewport_name, name, c_viewport_name);
+    _viewport_wnd_name = StrBuilderToStr(&sb);
+    StrBuilderReset(&sb);
+    
+    StrBuilderFree(&sb);
     
     //-------------------------------------------------------------------------------------------//
     // Setup the dockspace
@@ -151,6 +141,7 @@ void MainViewportWindow::OnInit(const char *name)
     g_terrain_sim.lacunarity = 2.0f;
     g_terrain_sim.decay      = 0.5f;
     g_terrain_sim.threshold  = -1.0f;
+    g_terrain_sim.fractal    = terrain::Fractal_FBm;
     
     //terrain::ExecuteFunction(terrain::Function_Perlin, &g_terrain_sim, command_list, g_heightmap);
     //g_hm_downsampler.Downsample(command_list, g_heightmap, g_downsampled_heightmap);
@@ -1,5 +1,17 @@
 
 namespace ed = ax::NodeEditor;
+
+// Ids of the terrain graph in the node editor. Ids can't be 0, so node i is (i + 1) << 4 and
+// its pins and links are offsets from it.
+#define TERRAIN_GRAPH_ID_SHIFT  4
+#define TERRAIN_GRAPH_ID_INPUT  1  // + input slot
+#define TERRAIN_GRAPH_ID_OUTPUT 8
+#define TERRAIN_GRAPH_ID_LINK   12 // + input slot
+
+static const char *g_terrain_graph_results[] = {
+    "Success", "Invalid node", "Missing input", "Cycle", "File error",
+};
+
 struct TerrainGenWindow : public WindowInterface
 {
     static constexpr char *c_dockspace_name  = "Dockspace";
@@ -18,6 +30,15 @@ struct TerrainGenWindow : public WindowInterface
     
     ed::EditorContext     *_editor_context = 0;
     
+    terrain::TerrainGraph      _graph;
+    u32                        _selected_node;
+    bool                       _auto_evaluate;
+    bool                       _graph_changed;
+    bool                       _graph_layout;   // node positions are set on the first draw
+    terrain::TerrainGraphResult _graph_result;
+    terrain::TerrainGraphStats  _graph_stats;
+    r32                        _graph_ms;
+    
     ViewportCamera     _camera;
     ImGuiID            _viewport_id;
     
@@ -34,7 +55,10 @@ struct TerrainGenWindow : public WindowInterface
     virtual bool ButtonPressCallback(input_layer::Event event, void *args);
     virtual bool ButtonReleaseCallback(input_layer::Event event, void *args);
     
+    void BuildDefaultGraph();
+    void EvaluateTerrainGraph();
     void DrawTerrainGraph();
+    void DrawTerrainNodeSettings();
     
 };
 
@@ -44,45 +68,31 @@ TerrainGenWindow::OnInit(const char *name)
     u64 name_len = strlen(name);
     _name = StrInit(name_len, name);
     
-    {
-        u64 offset = 0;
-        u64 len = name_len + strlen(c_dockspace_name);
-        _dockspace_name = StrInit(len, NULL);
-        char *ptr = StrGetString(&_dockspace_name);
-        ImFormatString(ptr, len, "%s%s", name, c_dockspace_name);
-    }
+    // One builder makes all the names, each name is a single allocation
+    StrBuilder sb;
+    StrBuilderInit(&sb);
     
-    {
-        u64 offset = 0;
-        u64 len = name_len + 3 + 2*strlen(c_settings_name);
-        _settings_name = StrInit(len, NULL);
-        char *ptr = StrGetString(&_settings_name);
-        ImFormatString(ptr, len, "%s###%s%s", c_settings_name, name, c_settings_name);
-    }
+    StrBuilderAppendFormat(&sb, "%s%s", name, c_dockspace_name);
+    _dockspace_name = StrBuilderToStr(&sb);
+    StrBuilderReset(&sb);
     
-    {
-        u64 offset = 0;
-        u64 len = name_len + 3 + 2*strlen(c_console_name);
-        _console_name = StrInit(len, NULL);
-        char *ptr = StrGetString(&_console_name);
-        ImFormatString(ptr, len, "%s###%s%s", c_console_name, name, c_console_name);
-    }
+    StrBuilderAppendFormat(&sb, "%s###%s%s", c_settings_name, name, c_settings_name);
+    _settings_name = StrBuilderToStr(&sb);
+    StrBuilderReset(&sb);
     
-    {
-        u64 offset = 0;
-        u64 len = name_len + 3 + 2*strlen(c_viewport_name);
-        _viewport_name = StrInit(len, NULL);
-        char *ptr = StrGetString(&_viewport_name);
-        ImFormatString(ptr, len, "%s###%s%s", c_viewport_name, name, c_viewport_name);
-    }
+    StrBuilderAppendFormat(&sb, "%s###%s%s", c_console_name, name, c_console_name);
+    _console_name = StrBuilderToStr(&sb);
+    StrBuilderReset(&sb);
     
-    {
-        u64 offset = 0;
-        u64 len = name_len + 3 + 2*strlen(c_graph_name);
-        _graph_name = StrInit(len, NULL);
-        char *ptr = StrGetString(&_graph_name);
-        ImFormatString(ptr, len, "%s###%s%s", c_graph_name, name, c_graph_name);
-    }
+    StrBuilderAppendFormat(&sb, "%s###%s%s", c_viewport_name, name, c_viewport_name);
+    _viewport_name = StrBuilderToStr(&sb);
+    StrBuilderReset(&sb);
+    
+    StrBuilderAppendFormat(&sb, "%s###%s%s", c_graph_name, name, c_graph_name);
+    _graph_name = StrBuilderToStr(&sb);
+    StrBuilderReset(&sb);
+    
+    StrBuilderFree(&sb);
     
     ImGuiWindowFlags window_flags = ImGuiWindowFlags_MenuBar | ImGuiWindowFlags_NoDocking;
     _dockspace_flags = ImGuiDockNodeFlags_PassthruCentralNode;
@@ -96,11 +106,67 @@ TerrainGenWindow::OnInit(const char *name)
     _camera.Init(eye_pos, up_dir);
     
     _editor_context = ed::CreateEditor();
+    
+    BuildDefaultGraph();
 }
 
 void 
 TerrainGenWindow::OnClose()
 {
+    terrain::TerrainGraphFree(&_graph);
+    ed::DestroyEditor(_editor_context);
+}
+
+void 
+TerrainGenWindow::BuildDefaultGraph()
+{
+    using namespace terrain;
+    
+    TerrainGraphInit(&_graph, 1024, 1024);
+    
+    u32 base = TerrainGraphAddNode(&_graph, TerrainNodeType::Noise, "base");
+    
+    u32 ridges = TerrainGraphAddNode(&_graph, TerrainNodeType::Noise, "ridges");
+    _graph.nodes[ridges].noise.cb.scale   = 0.008f;
+    _graph.nodes[ridges].noise.cb.octaves = 4;
+    _graph.nodes[ridges].noise.cb.fractal = Fractal_Ridged;
+    
+    u32 mix = TerrainGraphAddNode(&_graph, TerrainNodeType::Combine, "mix");
+    _graph.nodes[mix].combine.weight = 0.5f;
+    TerrainGraphConnect(&_graph, base,   mix, 0);
+    TerrainGraphConnect(&_graph, ridges, mix, 1);
+    
+    u32 shaped = TerrainGraphAddNode(&_graph, TerrainNodeType::Remap, "shaped");
+    _graph.nodes[shaped].remap.in_min   = -1.0f;
+    _graph.nodes[shaped].remap.in_max   =  1.5f;
+    _graph.nodes[shaped].remap.exponent =  1.5f;
+    TerrainGraphConnect(&_graph, mix, shaped, 0);
+    
+    u32 eroded = TerrainGraphAddNode(&_graph, TerrainNodeType::Erode, "eroded");
+    _graph.nodes[eroded].erode.hydraulic.droplets_per_sample = 0.25f;
+    TerrainGraphConnect(&_graph, shaped, eroded, 0);
+    
+    u32 output = TerrainGraphAddNode(&_graph, TerrainNodeType::Clamp, "output");
+    TerrainGraphConnect(&_graph, eroded, output, 0);
+    _graph.output = output;
+    
+    _selected_node = TERRAIN_GRAPH_NONE;
+    _auto_evaluate = false;
+    _graph_changed = true;
+    _graph_layout  = true;
+    _graph_result  = TerrainGraphResult::Success;
+    _graph_stats   = {};
+    _graph_ms      = 0.0f;
+}
+
+void 
+TerrainGenWindow::EvaluateTerrainGraph()
+{
+    Timer timer;
+    TimerBegin(&timer);
+    _graph_result  = terrain::TerrainGraphEvaluate(&_graph, _graph.output, &_graph_stats);
+    _graph_ms      = TimerMiliSecondsElapsed(&timer);
+    _graph_changed = false;
 }
 
 void 
@@ -140,8 +206,18 @@ TerrainGenWindow::OnRender()
     
     ImGui::Begin(StrGetString(&_settings_name));
     {
-        ImGui::Text("Hello, settings!");
-        ImGui::Value("Viewport \"Settings\" ID: ", ImGui::GetWindowViewport()->ID);
+        if (ImGui::Button("Evaluate") || (_auto_evaluate && _graph_changed))
+        {
+            EvaluateTerrainGraph();
+        }
+        ImGui::SameLine();
+        ImGui::Checkbox("Auto", &_auto_evaluate);
+        
+        ImGui::Text("%s: %u nodes evaluated, %u cached, %.2f ms", g_terrain_graph_results[(u32)_graph_result],
+                    _graph_stats.nodes_evaluated, _graph_stats.nodes_cached, _graph_ms);
+        ImGui::Separator();
+        
+        DrawTerrainNodeSettings();
     }
     ImGui::End();
     
@@ -162,24 +238,231 @@ TerrainGenWindow::OnRender()
 void 
 TerrainGenWindow::DrawTerrainGraph()
 {
+    using namespace terrain;
+    
     ed::SetCurrentEditor(_editor_context);
-    ed::Begin("My Editor", ImVec2(0.0, 0.0f));
-    int uniqueId = 1;
-    // Start drawing nodes.
-    ed::BeginNode(uniqueId++);
-    ImGui::Text("Node A");
-    ed::BeginPin(uniqueId++, ed::PinKind::Input);
-    ImGui::Text("-> In");
-    ed::EndPin();
-    ImGui::SameLine();
-    ed::BeginPin(uniqueId++, ed::PinKind::Output);
-    ImGui::Text("Out ->");
-    ed::EndPin();
-    ed::EndNode();
+    ed::Begin("Terrain Graph", ImVec2(0.0, 0.0f));
+    
+    u32 node_count = (u32)arrlen(_graph.nodes);
+    for (u32 i = 0; i < node_count; ++i)
+    {
+        TerrainNode *node = &_graph.nodes[i];
+        u32 id = (i + 1) << TERRAIN_GRAPH_ID_SHIFT;
+        
+        if (_graph_layout)
+        {
+            ed::SetNodePosition(id, ImVec2(220.0f * i, 80.0f * (i % 2)));
+        }
+        
+        ed::BeginNode(id);
+        ImGui::Text("%s (%s)%s", node->name, g_terrain_node_names[(u32)node->type], (i == _graph.output) ? " *" : "");
+        
+        u32 input_count = TerrainNodeInputCount(node->type);
+        for (u32 k = 0; k < input_count; ++k)
+        {
+            ed::BeginPin(id + TERRAIN_GRAPH_ID_INPUT + k, ed::PinKind::Input);
+            ImGui::Text("-> %s", (input_count > 1) ? ((k == 0) ? "a" : "b") : "In");
+            ed::EndPin();
+        }
+        
+        ed::BeginPin(id + TERRAIN_GRAPH_ID_OUTPUT, ed::PinKind::Output);
+        ImGui::Text("Out ->");
+        ed::EndPin();
+        ed::EndNode();
+    }
+    _graph_layout = false;
+    
+    for (u32 i = 0; i < node_count; ++i)
+    {
+        TerrainNode *node = &_graph.nodes[i];
+        u32 id = (i + 1) << TERRAIN_GRAPH_ID_SHIFT;
+        for (u32 k = 0; k < TerrainNodeInputCount(node->type); ++k)
+        {
+            if (node->inputs[k] >= node_count) continue;
+            u32 from = (node->inputs[k] + 1) << TERRAIN_GRAPH_ID_SHIFT;
+            ed::Link(id + TERRAIN_GRAPH_ID_LINK + k, from + TERRAIN_GRAPH_ID_OUTPUT, id + TERRAIN_GRAPH_ID_INPUT + k);
+        }
+    }
+    
+    // Links are dragged from an output to an input, or the other way around. Cycles are
+    // reported when the graph is evaluated.
+    if (ed::BeginCreate())
+    {
+        ed::PinId start_pin, end_pin;
+        if (ed::QueryNewLink(&start_pin, &end_pin) && start_pin && end_pin)
+        {
+            u32 output = (u32)start_pin.Get();
+            u32 input  = (u32)end_pin.Get();
+            if ((input & ((1 << TERRAIN_GRAPH_ID_SHIFT) - 1)) == TERRAIN_GRAPH_ID_OUTPUT)
+            {
+                u32 swap = output; output = input; input = swap;
+            }
+            
+            u32 from = (output >> TERRAIN_GRAPH_ID_SHIFT) - 1;
+            u32 to   = (input  >> TERRAIN_GRAPH_ID_SHIFT) - 1;
+            u32 slot = (input & ((1 << TERRAIN_GRAPH_ID_SHIFT) - 1)) - TERRAIN_GRAPH_ID_INPUT;
+            
+            bool valid = (output & ((1 << TERRAIN_GRAPH_ID_SHIFT) - 1)) == TERRAIN_GRAPH_ID_OUTPUT &&
+                from != to && to < node_count && slot < TerrainNodeInputCount(_graph.nodes[to].type);
+            if (!valid)
+            {
+                ed::RejectNewItem(ImVec4(1, 0, 0, 1), 2.0f);
+            }
+            else if (ed::AcceptNewItem())
+            {
+                TerrainGraphConnect(&_graph, from, to, slot);
+                _graph_changed = true;
+            }
+        }
+    }
+    ed::EndCreate();
+    
+    // Removing a node would renumber the nodes after it, so only links can be deleted
+    if (ed::BeginDelete())
+    {
+        ed::LinkId link;
+        while (ed::QueryDeletedLink(&link))
+        {
+            if (ed::AcceptDeletedItem())
+            {
+                u32 id = (u32)link.Get();
+                u32 to = (id >> TERRAIN_GRAPH_ID_SHIFT) - 1;
+                TerrainGraphConnect(&_graph, TERRAIN_GRAPH_NONE, to, (id & ((1 << TERRAIN_GRAPH_ID_SHIFT) - 1)) - TERRAIN_GRAPH_ID_LINK);
+                _graph_changed = true;
+            }
+        }
+        
+        ed::NodeId node;
+        while (ed::QueryDeletedNode(&node))
+        {
+            ed::RejectDeletedItem();
+        }
+    }
+    ed::EndDelete();
+    
+    ed::Suspend();
+    if (ed::ShowBackgroundContextMenu())
+    {
+        ImGui::OpenPopup("Add Terrain Node");
+    }
+    if (ImGui::BeginPopup("Add Terrain Node"))
+    {
+        for (u32 type = 0; type < (u32)TerrainNodeType::Count; ++type)
+        {
+            if (ImGui::MenuItem(g_terrain_node_names[type]))
+            {
+                // Names have to be unique, nodes refer to their inputs by name in the graph files
+                char name[TERRAIN_GRAPH_NAME_LEN];
+                u32 suffix = node_count;
+                do
+                {
+                    ImFormatString(name, TERRAIN_GRAPH_NAME_LEN, "%s%u", g_terrain_node_names[type], suffix++);
+                } while (TerrainGraphFindNode(&_graph, name) != TERRAIN_GRAPH_NONE);
+                u32 node = TerrainGraphAddNode(&_graph, (TerrainNodeType)type, name);
+                ed::SetNodePosition((node + 1) << TERRAIN_GRAPH_ID_SHIFT, ed::ScreenToCanvas(ImGui::GetMousePosOnOpeningCurrentPopup()));
+            }
+        }
+        ImGui::EndPopup();
+    }
+    ed::Resume();
+    
+    ed::NodeId selected;
+    _selected_node = (ed::GetSelectedNodes(&selected, 1) == 1) ? (u32)(selected.Get() >> TERRAIN_GRAPH_ID_SHIFT) - 1 : TERRAIN_GRAPH_NONE;
+    
     ed::End();
     ed::SetCurrentEditor(nullptr);
 }
 
+void 
+TerrainGenWindow::DrawTerrainNodeSettings()
+{
+    using namespace terrain;
+    
+    if (_selected_node >= (u32)arrlen(_graph.nodes))
+    {
+        ImGui::Text("Select a node to edit it.");
+        return;
+    }
+    
+    TerrainNode *node = &_graph.nodes[_selected_node];
+    ImGui::Text("%s (%s)", node->name, g_terrain_node_names[(u32)node->type]);
+    if (_selected_node != _graph.output && ImGui::Button("Set as output"))
+    {
+        _graph.output  = _selected_node;
+        _graph_changed = true;
+    }
+    
+    // Evaluation only re-runs the nodes whose parameters changed and the nodes after them
+    bool changed = false;
+    switch (node->type)
+    {
+        case TerrainNodeType::Noise:
+        {
+            Noise_CB *cb = &node->noise.cb;
+            int function = (int)node->noise.function;
+            changed |= ImGui::Combo("Function", &function, g_terrain_noise_names, Function_Count);
+            changed |= ImGui::Combo("Fractal", &cb->fractal, g_terrain_fractal_names, Fractal_Count);
+            changed |= ImGui::DragFloat("Scale", &cb->scale, 0.0001f, 0.0f, 1.0f, "%.5f");
+            changed |= ImGui::InputScalar("Seed", ImGuiDataType_U64, &cb->seed);
+            changed |= ImGui::SliderInt("Octaves", &cb->octaves, 1, 16);
+            changed |= ImGui::DragFloat("Lacunarity", &cb->lacunarity, 0.01f, 1.0f, 4.0f);
+            changed |= ImGui::DragFloat("Decay", &cb->decay, 0.01f, 0.0f, 1.0f);
+            changed |= ImGui::DragFloat("Threshold", &cb->threshold, 0.01f, 0.0f, 1.0f);
+            node->noise.function = (ComputeFunction)function;
+        } break;
+        
+        case TerrainNodeType::Combine:
+        {
+            int op = (int)node->combine.op;
+            changed |= ImGui::Combo("Op", &op, g_terrain_combine_names, (int)TerrainCombineOp::Count);
+            changed |= ImGui::DragFloat("Weight", &node->combine.weight, 0.01f);
+            node->combine.op = (TerrainCombineOp)op;
+        } break;
+        
+        case TerrainNodeType::Remap:
+        {
+            changed |= ImGui::DragFloat("In Min",   &node->remap.in_min,  0.01f);
+            changed |= ImGui::DragFloat("In Max",   &node->remap.in_max,  0.01f);
+            changed |= ImGui::DragFloat("Out Min",  &node->remap.out_min, 0.01f);
+            changed |= ImGui::DragFloat("Out Max",  &node->remap.out_max, 0.01f);
+            changed |= ImGui::DragFloat("Exponent", &node->remap.exponent, 0.01f, 0.01f, 16.0f);
+        } break;
+        
+        case TerrainNodeType::Erode:
+        {
+            HydraulicErosionDesc *hydraulic = &node->erode.hydraulic;
+            ThermalErosionDesc   *thermal   = &node->erode.thermal;
+            int lifetime   = (int)hydraulic->max_lifetime;
+            int radius     = (int)hydraulic->radius;
+            int iterations = (int)thermal->iterations;
+            changed |= ImGui::DragFloat("Droplets", &hydraulic->droplets_per_sample, 0.01f, 0.0f, 8.0f);
+            changed |= ImGui::SliderInt("Lifetime", &lifetime, 1, 128);
+            changed |= ImGui::SliderInt("Radius", &radius, 1, 8);
+            changed |= ImGui::DragFloat("Inertia", &hydraulic->inertia, 0.01f, 0.0f, 1.0f);
+            changed |= ImGui::DragFloat("Capacity", &hydraulic->sediment_capacity, 0.1f, 0.0f, 32.0f);
+            changed |= ImGui::DragFloat("Erode Speed", &hydraulic->erode_speed, 0.01f, 0.0f, 1.0f);
+            changed |= ImGui::DragFloat("Deposit Speed", &hydraulic->deposit_speed, 0.01f, 0.0f, 1.0f);
+            changed |= ImGui::DragFloat("Evaporate Speed", &hydraulic->evaporate_speed, 0.001f, 0.0f, 1.0f);
+            changed |= ImGui::SliderInt("Thermal Iterations", &iterations, 0, 500);
+            changed |= ImGui::DragFloat("Talus", &thermal->talus, 0.001f, 0.0f, 1.0f, "%.4f");
+            changed |= ImGui::DragFloat("Thermal Rate", &thermal->rate, 0.01f, 0.01f, 0.5f);
+            hydraulic->max_lifetime = (u32)lifetime;
+            hydraulic->radius       = (u32)radius;
+            thermal->iterations     = (u32)iterations;
+        } break;
+        
+        case TerrainNodeType::Clamp:
+        {
+            changed |= ImGui::DragFloat("Min", &node->clamp.min, 0.01f);
+            changed |= ImGui::DragFloat("Max", &node->clamp.max, 0.01f);
+        } break;
+        
+        default: break;
+    }
+    
+    _graph_changed |= changed;
+}
+
 bool 
 TerrainGenWindow::KeyPressCallback(input_layer::Event event, void *args)
 {
@@ -203,3 +486,8 @@ TerrainGenWindow::ButtonReleaseCallback(input_layer::Event event, void *args)
 {
     return false;
 }
+
+#undef TERRAIN_GRAPH_ID_LINK
+#undef TERRAIN_GRAPH_ID_OUTPUT
+#undef TERRAIN_GRAPH_ID_INPUT
+#undef TERRAIN_GRAPH_ID_SHIFT
@@ -60,7 +60,22 @@ struct ViewportCamera
     {
         return m4_look_at(_position, v3_add(_position, _front), _up);
     }
-    
+
+    // View for the terrain LOD selection, _zoom is the vertical fov of the projection
+    // @param proj_view:        Projection - View Matrix the terrain is drawn with
+    // @param viewport_height:  height of the viewport in pixels
+    // @param max_screen_error: pixels a terrain tile may be off by
+    terrain::TerrainLodView GetTerrainLodView(m4 proj_view, r32 viewport_height, r32 max_screen_error = 2.0f)
+    {
+        terrain::TerrainLodView result = {};
+        result.position         = _position;
+        result.proj_view        = proj_view;
+        result.viewport_height  = viewport_height;
+        result.fov              = _zoom;
+        result.max_screen_error = max_screen_error;
+        return result;
+    }
+
     void OnMouseButtonPress(int button)
     {
         BIT32_TOGGLE_1(_mouse_press_mask, button);
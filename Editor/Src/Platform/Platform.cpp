@@ -28,12 +28,37 @@
 #include "Win32/Win32File.cpp"
 #include "Win32/Win32FileManager.cpp"
 #include "Win32/Win32CoreUtils.cpp"
-#include "Win32/Win32ThreadPool.cpp"
 //#include "Win32/Win32DllEntry.cpp"
 #include "Win32/Win32Window.cpp"
 #include "Win32/Win32Imgui.cpp"
 #include "Win32/Win32Main.cpp"
 
+#elif defined(__linux__) || defined(__APPLE__)
+
+// NOTE(Dustin): The renderer, terrain and editor sources depend on D3D12, so the
+// Posix build only contains the core systems and runs headless.
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "Posix/PosixTimer.cpp"
+#include "Posix/PosixLogger.cpp"
+#include "Posix/PosixFile.cpp"
+#include "Posix/PosixFileManager.cpp"
+#include "Posix/PosixCoreUtils.cpp"
+// Benchmarks, run with -bench
+#include "Tests/Tests.h"
+#include "Tests/Tests.cpp"
+
+#include "Posix/PosixMain.cpp"
+
 #else
 #error Platform Not Supported!
 #endif
@@ -17,9 +17,19 @@ void PlatformGetWindowDims(u32 *width, u32 *height);
 //------------------------------------------------------------------------------------
 // Threading API 
 
-void PlatformAsyncTask(void (*fn)(void*), void *args);
+// Implemented by the job system (Core/JobSystem.cpp). A counter passed to
+// PlatformAsyncTask can be waited on with PlatformWaitForCounter. 
+struct JobCounter;
+
+void PlatformAsyncTask(void (*fn)(void*), void *args, JobCounter *counter = NULL);
+void PlatformWaitForCounter(JobCounter *counter);
+// Runs fn over [0, count) in ranges of at most "grain" elements and waits for completion
+void PlatformParallelFor(u32 count, u32 grain, void (*fn)(u32 begin, u32 end, void *args), void *args);
 void PlatformAtomicInc(volatile u32*);
 void PlatformAtomicDec(volatile u32*);
+// Returns the initial value of dst
+void* PlatformAtomicCompareExchangePtr(void * volatile *dst, void *exchange, void *comparand);
+void* PlatformAtomicExchangePtr(void * volatile *dst, void *exchange);
 
 //------------------------------------------------------------------------------------
 // FILE API 
@@ -87,6 +97,24 @@ typedef enum
 
 PlatformErrorType PlatformReadFileToBuffer(const char* file_path, u8** buffer, u32* size);
 PlatformErrorType PlatformWriteBufferToFile(const char* file_path, u8* buffer, u64 size, bool append = false);
+// @param write_time: (output) last write time, in the units of the OS. Only compare it for equality.
+PlatformErrorType PlatformGetFileInfo(const char* file_path, u64 *write_time, u64 *size);
+
+// Read-only view of an entire file. Pages are read from disk the first time they are touched.
+struct PlatformMappedFile
+{
+    u8   *data;
+    u64   size;
+    void *handle; // Win32 file mapping object
+};
+
+// @param copy_on_write: the view can be written to, the writes are private to the process
+//                       and never reach the file
+PlatformErrorType PlatformMapFile(const char* file_path, PlatformMappedFile *file, bool copy_on_write = false);
+void              PlatformUnmapFile(PlatformMappedFile *file);
+// Lets the OS drop the pages of [offset, offset + size) from memory, they are read from the
+// file again when touched
+void              PlatformReleaseMappedRange(PlatformMappedFile *file, u64 offset, u64 size);
 
 // TODO(Matt): Replace these params with enums.
 // Defaults 0, -1
@@ -0,0 +1,183 @@
+
+struct PosixProcessorInfo
+{
+    u32 logical_processor_count = 0;
+};
+
+static bool       g_posix_invalid_guid_first_time = true;
+static MAPLE_GUID g_posix_invalid_guid;
+
+// mmap does not remember the size of a mapping, so PlatformVirtualAlloc reserves
+// one extra page in front of the user memory to store it. This keeps the returned
+// pointer page aligned, same as VirtualAlloc.
+struct PosixVirtualAllocHeader
+{
+    u64 size; // size of the entire mapping, including the header page
+};
+
+void
+PosixGetProcessorInfo(PosixProcessorInfo *info)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    if (count < 1)
+    {
+        LogError("sysconf(_SC_NPROCESSORS_ONLN) failed, assuming a single processor.");
+        count = 1;
+    }
+    info->logical_processor_count = (u32)count;
+}
+
+void
+PlatformAtomicInc(volatile u32* v)
+{
+    __atomic_add_fetch(v, 1, __ATOMIC_SEQ_CST);
+}
+
+void
+PlatformAtomicDec(volatile u32* v)
+{
+    __atomic_sub_fetch(v, 1, __ATOMIC_SEQ_CST);
+}
+
+void*
+PlatformAtomicCompareExchangePtr(void * volatile *dst, void *exchange, void *comparand)
+{
+    __atomic_compare_exchange_n(dst, &comparand, exchange, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return comparand;
+}
+
+void*
+PlatformAtomicExchangePtr(void * volatile *dst, void *exchange)
+{
+    return __atomic_exchange_n(dst, exchange, __ATOMIC_SEQ_CST);
+}
+
+// Generates a random (version 4) GUID from /dev/urandom
+static MAPLE_GUID
+PlatformGenerateGuid()
+{
+    MAPLE_GUID result = {};
+
+    int fd = open("/dev/urandom", O_RDONLY);
+    if (fd < 0 || read(fd, &result, sizeof(result)) != (ssize_t)sizeof(result))
+    {
+        PlatformFatalError("Unable to read /dev/urandom to generate a GUID!\n");
+    }
+    close(fd);
+
+    result.Data3    = (result.Data3 & 0x0FFF) | 0x4000;
+    result.Data4[0] = (result.Data4[0] & 0x3F) | 0x80;
+    return result;
+}
+
+static bool
+PlatformGuidCmp(MAPLE_GUID *left, MAPLE_GUID *right)
+{
+    return memcmp(left, right, sizeof(MAPLE_GUID)) == 0;
+}
+
+static bool
+PlatformIsGuidValid(MAPLE_GUID guid)
+{
+    if (g_posix_invalid_guid_first_time)
+    {
+        g_posix_invalid_guid_first_time = false;
+        g_posix_invalid_guid = PlatformGenerateGuid();
+    }
+    return !PlatformGuidCmp(&guid, &g_posix_invalid_guid);
+}
+
+static MAPLE_GUID
+PlatformGetInvalidGuid()
+{
+    if (g_posix_invalid_guid_first_time)
+    {
+        g_posix_invalid_guid_first_time = false;
+        g_posix_invalid_guid = PlatformGenerateGuid();
+    }
+    return g_posix_invalid_guid;
+}
+
+static Str
+PlatformGuidToString(MAPLE_GUID guid)
+{
+    i32 req = snprintf(NULL, 0, "%08X-%04hX-%04hX-%02hhX%02hhX-%02hhX%02hhX%02hhX%02hhX%02hhX%02hhX",
+                       guid.Data1, guid.Data2, guid.Data3,
+                       guid.Data4[0], guid.Data4[1], guid.Data4[2], guid.Data4[3],
+                       guid.Data4[4], guid.Data4[5], guid.Data4[6], guid.Data4[7]);
+
+    Str result = StrInit(req);
+    req = snprintf(StrGetString(&result), req + 1, "%08X-%04hX-%04hX-%02hhX%02hhX-%02hhX%02hhX%02hhX%02hhX%02hhX%02hhX",
+                   guid.Data1, guid.Data2, guid.Data3,
+                   guid.Data4[0], guid.Data4[1], guid.Data4[2], guid.Data4[3],
+                   guid.Data4[4], guid.Data4[5], guid.Data4[6], guid.Data4[7]);
+
+    return result;
+}
+
+static MAPLE_GUID
+PlatformStringToGuid(const char* guid_str)
+{
+    MAPLE_GUID result = {};
+
+    int res = sscanf(guid_str, "%08X-%04hX-%04hX-%02hhX%02hhX-%02hhX%02hhX%02hhX%02hhX%02hhX%02hhX",
+                     &result.Data1, &result.Data2, &result.Data3,
+                     &result.Data4[0], &result.Data4[1], &result.Data4[2], &result.Data4[3],
+                     &result.Data4[4], &result.Data4[5], &result.Data4[6], &result.Data4[7]);
+
+    return result;
+}
+
+void*
+PlatformVirtualAlloc(u64 Size)
+{
+    u64 PageSize   = (u64)sysconf(_SC_PAGESIZE);
+    u64 ActualSize = ((Size + PageSize - 1) & ~(PageSize - 1)) + PageSize;
+
+    void *Base = mmap(NULL, ActualSize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if (Base == MAP_FAILED) return NULL;
+
+    PosixVirtualAllocHeader *Header = (PosixVirtualAllocHeader*)Base;
+    Header->size = ActualSize;
+
+    return (char*)Base + PageSize;
+}
+
+void
+PlatformVirtualFree(void *Ptr)
+{
+    if (!Ptr) return;
+
+    u64 PageSize = (u64)sysconf(_SC_PAGESIZE);
+    PosixVirtualAllocHeader *Header = (PosixVirtualAllocHeader*)((char*)Ptr - PageSize);
+
+    if (munmap(Header, Header->size) != 0)
+    {
+        PlatformFatalError("Unable to free a mmap allocation!\n\tError: %d\n", errno);
+    }
+}
+
+u32
+PlatformClz(u32 Value)
+{
+    return (Value) ? (u32)__builtin_clz(Value) : 32;
+}
+
+u32
+PlatformCtz(u32 Value)
+{
+    // NOTE(Dustin): Matches the Win32 implementation, which returns 0 for 0
+    return (Value) ? (u32)__builtin_ctz(Value) : 0;
+}
+
+u32
+PlatformCtzl(u64 Value)
+{
+    return (Value) ? (u32)__builtin_ctzll(Value) : 64;
+}
+
+u32
+PlatformClzl(u64 Value)
+{
+    return (Value) ? (u32)__builtin_clzll(Value) : 64;
+}
@@ -0,0 +1,245 @@
+static Str PlatformNormalizePath(const char* path);
+
+Str PlatformGetFullExecutablePath()
+{
+    char buf[PATH_MAX];
+    if (!getcwd(buf, PATH_MAX)) return {};
+    
+    Str result = StrInit((u32)strlen(buf), buf);
+    return result;
+}
+
+PlatformErrorType 
+PlatformReadFileToBuffer(const char* file_path, u8** buffer, u32* size)
+{
+    PlatformErrorType result = PlatformError_Success;
+    
+    *size = 0;
+    *buffer = 0;
+    int fd = open(file_path, O_RDONLY);
+    
+    if (fd < 0) 
+    {
+        return (errno == ENOENT) ? PlatformError_FileNotFound : PlatformError_FileOpenFailure;
+    }
+    
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || (u64)file_stat.st_size >= U32_MAX)
+    {
+        close(fd);
+        return PlatformError_FileOpenFailure;
+    }
+    else *size = (u32)file_stat.st_size;
+    
+#if defined(__linux__)
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    
+    *buffer = (u8*)SysAlloc(*size + 1);
+    
+    // read() may return fewer bytes than requested, so loop until the file is consumed
+    u32 offset = 0;
+    while (offset < *size)
+    {
+        ssize_t bytes = read(fd, *buffer + offset, *size - offset);
+        if (bytes < 0 && errno == EINTR) continue;
+        if (bytes <= 0)
+        {
+            close(fd);
+            SysFree(*buffer);
+            *buffer = 0;
+            *size = 0;
+            return PlatformError_FileReadFailure;
+        }
+        offset += (u32)bytes;
+    }
+    close(fd);
+    
+    (*buffer)[*size] = 0;
+    
+    return result;
+}
+
+PlatformErrorType 
+PlatformWriteBufferToFile(const char* file_path, u8* buffer, u64 size, bool append)
+{
+    PlatformErrorType result = PlatformError_Success;
+    Str long_path = PlatformNormalizePath(file_path);
+    
+    int flags = O_WRONLY | O_CREAT | ((append) ? O_APPEND : O_TRUNC);
+    int fd = open(StrGetString(&long_path), flags, 0644);
+    StrFree(&long_path);
+    
+    if (fd < 0) return PlatformError_FileOpenFailure;
+    
+    u64 offset = 0;
+    while (offset < size)
+    {
+        ssize_t bytes = write(fd, buffer + offset, size - offset);
+        if (bytes < 0 && errno == EINTR) continue;
+        if (bytes <= 0)
+        {
+            result = (offset > 0) ? PlatformError_FilePartialeWrite : PlatformError_FileWriteFailure;
+            break;
+        }
+        offset += (u64)bytes;
+    }
+    
+    close(fd);
+    return result;
+}
+
+PlatformErrorType 
+PlatformGetFileInfo(const char* file_path, u64 *write_time, u64 *size)
+{
+    struct stat file_stat;
+    if (stat(file_path, &file_stat) != 0)
+    {
+        return (errno == ENOENT) ? PlatformError_FileNotFound : PlatformError_FileOpenFailure;
+    }
+    
+#if defined(__APPLE__)
+    *write_time = (u64)file_stat.st_mtimespec.tv_sec * 1000000000ull + (u64)file_stat.st_mtimespec.tv_nsec;
+#else
+    *write_time = (u64)file_stat.st_mtim.tv_sec * 1000000000ull + (u64)file_stat.st_mtim.tv_nsec;
+#endif
+    *size = (u64)file_stat.st_size;
+    return PlatformError_Success;
+}
+
+PlatformErrorType 
+PlatformMapFile(const char* file_path, PlatformMappedFile *file, bool copy_on_write)
+{
+    *file = {};
+    int fd = open(file_path, O_RDONLY);
+    
+    if (fd < 0) 
+    {
+        return (errno == ENOENT) ? PlatformError_FileNotFound : PlatformError_FileOpenFailure;
+    }
+    
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0)
+    {
+        close(fd);
+        return PlatformError_FileOpenFailure;
+    }
+    
+    // MAP_PRIVATE already makes writes copy-on-write, they only need to be allowed
+    int protection = (copy_on_write) ? PROT_READ | PROT_WRITE : PROT_READ;
+    void *data = mmap(NULL, (size_t)file_stat.st_size, protection, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file
+    close(fd);
+    
+    if (data == MAP_FAILED) return PlatformError_FileReadFailure;
+    
+    file->data = (u8*)data;
+    file->size = (u64)file_stat.st_size;
+    return PlatformError_Success;
+}
+
+void 
+PlatformUnmapFile(PlatformMappedFile *file)
+{
+    if (file->data) munmap(file->data, (size_t)file->size);
+    *file = {};
+}
+
+void 
+PlatformReleaseMappedRange(PlatformMappedFile *file, u64 offset, u64 size)
+{
+    u64 page_size = (u64)sysconf(_SC_PAGESIZE);
+    u64 begin = offset & ~(page_size - 1);
+    u64 end   = (offset + size < file->size) ? offset + size : file->size;
+    if (end > begin) madvise(file->data + begin, (size_t)(end - begin), MADV_DONTNEED);
+}
+
+static Str 
+PlatformNormalizePath(const char* path)
+{
+    // If the string is null or has length < 2, just return an empty one.
+    if (!path || !path[0] || !path[1]) 
+    {
+        Str err = {};
+        return err;
+    }
+    
+    Str result = StrInit((u32)strlen(path), path);
+    
+    char *tmp = StrGetString(&result);
+    u64 result_len = StrLen(&result);
+    
+    // Swap any back slashes for forward slashes.
+    for (u32 i = 0; i < (u32)result_len; ++i) if (tmp[i] == '\\') tmp[i] = '/';
+    
+    // Strip double separators.
+    for (u32 i = 0; i < (u32)result_len - 1; ++i)
+    {
+        if (tmp[i] == '/' && tmp[i + 1] == '/')
+        {
+            for (u32 j = i; j < (u32)result_len; ++j) tmp[j] = tmp[j + 1];
+            --result_len;
+            --i;
+        }
+    }
+    
+    // Evaluate any relative specifiers (./).
+    if (tmp[0] == '.' && tmp[1] == '/')
+    {
+        for (u32 i = 0; i < (u32)result_len - 1; ++i) tmp[i] = tmp[i + 2];
+        result_len -= 2;
+    }
+    for (u32 i = 0; i < (u32)result_len - 1; ++i)
+    {
+        if (tmp[i] != '.' && tmp[i + 1] == '.' && tmp[i + 2] == '/')
+        {
+            for (u32 j = i + 1; tmp[j + 1]; ++j) tmp[j] = tmp[j + 2];
+            result_len -= 2;
+        }
+    }
+    
+    // Evaluate any parent specifiers (../).
+    u32 last_separator = 0;
+    for (u32 i = 0; (i < (u32)result_len - 1); ++i)
+    {
+        if (tmp[i] == '.' && tmp[i + 1] == '.' && tmp[i + 2] == '/')
+        {
+            u32 base = i + 2;
+            u32 count = (u32)result_len - base;
+            
+            for (u32 j = 0; j <= count; ++j)
+            {
+                tmp[last_separator + j] = tmp[base + j];
+            }
+            
+            result_len -= base - last_separator;
+            i = last_separator;
+            
+            if (i > 0)
+            {
+                bool has_separator = false;
+                for (i32 j = last_separator - 1; j >= 0; --j)
+                {
+                    if (tmp[j] == '/')
+                    {
+                        last_separator = j;
+                        has_separator = true;
+                        break;
+                    }
+                }
+                if (!has_separator) 
+                {
+                    Str r = {};
+                    return r;
+                }
+            }
+        }
+        if (i > 0 && tmp[i - 1] == '/') last_separator = i - 1;
+    }
+    
+    // Update length of the string
+    StrSetLen(&result, result_len);
+    
+    return result;
+}
+
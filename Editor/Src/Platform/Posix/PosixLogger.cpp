@@ -0,0 +1,169 @@
+file_global const char *g_log_level_strings[] = {
+    "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"
+};
+
+// ANSI escape codes, same colors as the Win32 console
+file_global const char *g_log_level_colors[] = {
+    "\x1b[94m", // Trace: blue
+    "\x1b[92m", // Debug: Green
+    "\x1b[97m", // Info: White
+    "\x1b[93m", // Warn: Yellow
+    "\x1b[91m", // Error: Red
+    "\x1b[31m"  // Fatal: Dark Red
+};
+file_global const char *g_log_color_reset = "\x1b[0m";
+
+typedef struct
+{
+    FILE *handle;
+    bool  is_terminal; // False if redirected to a file or pipe, colors are skipped
+} PosixStandardStream;
+
+constexpr int SCRATCH_SIZE = 4096;
+struct PosixVirtualConsole
+{
+    char scratch_buffer[SCRATCH_SIZE];
+    char message_buffer[SCRATCH_SIZE];
+
+    PosixStandardStream output_stream;
+    PosixStandardStream error_stream;
+
+    pthread_mutex_t lock;
+};
+
+static PosixVirtualConsole g_virtual_console;
+
+file_internal long PosixGetThreadId();
+file_internal PosixStandardStream PosixGetStandardStream(FILE *handle);
+file_internal void PosixPrintToStream(const char* message, PosixStandardStream stream, const char *color);
+
+void
+PlatformLoggerInit()
+{
+    g_virtual_console.output_stream = PosixGetStandardStream(stdout);
+    g_virtual_console.error_stream  = PosixGetStandardStream(stderr);
+
+    pthread_mutex_init(&g_virtual_console.lock, NULL);
+}
+
+void
+PlatformLoggerFree()
+{
+    fflush(stdout);
+    fflush(stderr);
+    pthread_mutex_destroy(&g_virtual_console.lock);
+}
+
+file_internal long
+PosixGetThreadId()
+{
+#if defined(__linux__)
+    return (long)syscall(SYS_gettid);
+#else
+    return (long)(uptr)pthread_self();
+#endif
+}
+
+file_internal PosixStandardStream
+PosixGetStandardStream(FILE *handle)
+{
+    PosixStandardStream result = {};
+    result.handle      = handle;
+    result.is_terminal = isatty(fileno(handle)) != 0;
+    return result;
+}
+
+file_internal void
+PosixPrintToStream(const char* message, PosixStandardStream stream, const char *color)
+{
+    if (stream.is_terminal)
+    {
+        fprintf(stream.handle, "%s%s%s", color, message, g_log_color_reset);
+    }
+    else
+    {
+        fputs(message, stream.handle);
+    }
+}
+
+// Variadic version of the function
+void PosixVLog(int level, const char *file, int line, const char *fmt, va_list args)
+{
+    // TID [SEVERITY] FILE:LINE:
+    const char *log_header = "%ld\t[%s]\t %s:%d: ";
+
+    pthread_mutex_lock(&g_virtual_console.lock);
+
+    snprintf(g_virtual_console.scratch_buffer, ARRAYCOUNT(g_virtual_console.scratch_buffer),
+             log_header, PosixGetThreadId(), g_log_level_strings[level], file, line);
+
+    // Messages longer than the scratch buffer are truncated
+    char *message = g_virtual_console.message_buffer;
+    int written = vsnprintf(message, SCRATCH_SIZE - 1, fmt, args);
+    if (written < 0) written = 0;
+    if (written > SCRATCH_SIZE - 2) written = SCRATCH_SIZE - 2;
+    message[written]     = '\n';
+    message[written + 1] = 0;
+
+    PosixStandardStream stream = (level < LOG_ERROR) ? g_virtual_console.output_stream : g_virtual_console.error_stream;
+    PosixPrintToStream(g_virtual_console.scratch_buffer, stream, g_log_level_colors[level]);
+    PosixPrintToStream(message, stream, g_log_level_colors[level]);
+
+    pthread_mutex_unlock(&g_virtual_console.lock);
+
+    if (level == LOG_FATAL)
+    {
+        if (PlatformShowAssertDialog(message, __FILE__, (u32)line)) DebugBreak();
+    }
+}
+
+void
+PlatformLog(int level, const char *file, int line, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    PosixVLog(level, file, line, fmt, args);
+    va_end(args);
+}
+
+// There is no dialog when running headless. A failed assertion is logged and
+// the process aborts, so test runs fail loudly instead of hanging on a prompt.
+bool PlatformShowAssertDialog(const char* message, const char* file, u32 line)
+{
+    char scratch[1024];
+    snprintf(scratch, sizeof(scratch),
+             "Assertion Failed!\n"
+             "    File: %s\n"
+             "    Line: %u\n"
+             "    Statement: ASSERT(%s)\n",
+             file, line, message);
+
+    pthread_mutex_lock(&g_virtual_console.lock);
+    PosixPrintToStream(scratch, g_virtual_console.error_stream, g_log_level_colors[LOG_FATAL]);
+    fflush(stderr);
+    pthread_mutex_unlock(&g_virtual_console.lock);
+
+    abort();
+    return false;
+}
+
+void PlatformShowErrorDialog(const char* message)
+{
+    pthread_mutex_lock(&g_virtual_console.lock);
+    PosixPrintToStream(message, g_virtual_console.error_stream, g_log_level_colors[LOG_ERROR]);
+    fputc('\n', stderr);
+    pthread_mutex_unlock(&g_virtual_console.lock);
+}
+
+void PlatformFatalError(const char* message, ...)
+{
+    pthread_mutex_lock(&g_virtual_console.lock);
+    va_list args;
+    va_start (args, message);
+    vsnprintf(g_virtual_console.scratch_buffer, ARRAYCOUNT(g_virtual_console.scratch_buffer), message, args);
+    PosixPrintToStream(g_virtual_console.scratch_buffer, g_virtual_console.error_stream, g_log_level_colors[LOG_FATAL]);
+    fflush(stderr);
+    va_end(args);
+    pthread_mutex_unlock(&g_virtual_console.lock);
+    exit(-1);
+}
@@ -0,0 +1,206 @@
+
+// NOTE(Dustin): The Posix build is headless. There is no window, renderer or editor,
+// only the core systems (memory, jobs, strings, toml, file manager), so they can be
+// run, profiled and tested on Linux machines.
+
+static const u64        g_internal_mem_sz = _MB(512);
+static void            *g_internal_mem    = 0;
+
+// Startup information
+struct MapleProject
+{
+    Str name;
+    Str filepath;
+};
+
+static const char   *g_engine_startup_file = "startup.toml";
+// Compiled form of the startup and project files, see TomlLoadCached
+static const char   *g_toml_cache_file     = "startup.tomlcache";
+static Str           g_engine_content_dir;
+static MapleProject *g_known_projects;
+static u32           g_active_project;
+
+void PlatformCloseApplication()
+{
+}
+
+static void
+LoadProjectFile(MapleProject *project, TomlCache *cache)
+{
+    const char *filename = "/maple.project";
+    Str project_path = StrAdd(&project->filepath, filename, strlen(filename));
+
+    Toml toml;
+    TomlResult result = TomlLoadCached(&toml, StrGetString(&project_path), cache);
+    Assert(result == TomlResult_Success);
+
+    project->name = StrInit(strlen(toml.title), toml.title);
+
+    TomlFree(&toml);
+    StrFree(&project_path);
+}
+
+static void
+LoadStartupFile(const char *startup, TomlCache *cache)
+{
+    Toml toml;
+    TomlResult result = TomlLoadCached(&toml, startup, cache);
+    Assert(result == TomlResult_Success);
+
+    TomlObject obj = TomlGetObject(&toml, "EngineStartup");
+
+    g_engine_content_dir = StrInit(TomlGetStringLen(&obj, "engine_assets"),
+                                   TomlGetString(&obj, "engine_assets"));
+
+    TomlData* proj_array = TomlGetArray(&obj, "known_projects");
+    int len = TomlGetArrayLen(proj_array);
+    for (int i = 0; i < len; ++i)
+    {
+        MapleProject project = {};
+        project.filepath = StrInit(TomlGetStringLenArrayElem(proj_array, i),
+                                   TomlGetStringArrayElem(proj_array, i));
+
+        LoadProjectFile(&project, cache);
+
+        arrput(g_known_projects, project);
+    }
+
+    g_active_project = TomlGetInt(&obj, "last_active_project");
+
+    TomlFree(&toml);
+}
+
+static void
+PosixReadFileToBuffer_Wrapper(const char* file_path, u8** buffer, int* size)
+{
+    PlatformReadFileToBuffer(file_path, buffer, (u32*)size);
+}
+
+static bool
+PosixGetFileInfo_Wrapper(const char* file_path, uint64_t* write_time, uint64_t* size)
+{
+    return PlatformGetFileInfo(file_path, (u64*)write_time, (u64*)size) == PlatformError_Success;
+}
+
+static void*
+PosixMapFile_Wrapper(const char* file_path, uint64_t* size)
+{
+    PlatformMappedFile file;
+    if (PlatformMapFile(file_path, &file, true) != PlatformError_Success) return NULL;
+
+    *size = file.size;
+    return file.data;
+}
+
+static void
+PosixUnmapFile_Wrapper(void *ptr, uint64_t size)
+{
+    PlatformMappedFile file = {};
+    file.data = (u8*)ptr;
+    file.size = size;
+    PlatformUnmapFile(&file);
+}
+
+static void
+PosixWriteFile_Wrapper(const char* file_path, const void* buffer, uint64_t size)
+{
+    PlatformWriteBufferToFile(file_path, (u8*)buffer, size);
+}
+
+// @param argv[1]: optional startup file, defaults to "startup.toml"
+//                 or "-bake <graph.toml> <terrain file>" to bake a terrain graph (TerrainGraph.h) and exit
+//                 or "-bench [name]" to run a benchmark (Tests/Tests.h) and exit
+//                 or "-selftest [name]" to run the self tests (Tests/Tests.h) and exit
+int
+main(int argc, char **argv)
+{
+    PlatformLoggerInit();
+    GlobalTimerSetup();
+    PlatformGetInvalidGuid(); // init the global invalid guid
+
+    Timer startup_timer;
+    TimerBegin(&startup_timer);
+
+    g_internal_mem = PlatformVirtualAlloc(g_internal_mem_sz);
+    SysMemoryInit(g_internal_mem, g_internal_mem_sz);
+    StrPoolInit();
+
+    {
+        // Leave a core for the main thread, which also participates in the job system
+        PosixProcessorInfo processor_info = {};
+        PosixGetProcessorInfo(&processor_info);
+        u32 worker_count = (processor_info.logical_processor_count > 1) ? processor_info.logical_processor_count - 1 : 1;
+        JobSystemInit(worker_count);
+    }
+
+    {
+        TomlCallbacks callbacks = {};
+        callbacks.Alloc       = SysMemoryAlloc;
+        callbacks.Free        = SysMemoryRelease;
+        callbacks.LoadFile    = PosixReadFileToBuffer_Wrapper;
+        callbacks.FreeFile    = SysMemoryRelease;
+        callbacks.GetFileInfo = PosixGetFileInfo_Wrapper;
+        callbacks.MapFile     = PosixMapFile_Wrapper;
+        callbacks.UnmapFile   = PosixUnmapFile_Wrapper;
+        callbacks.WriteFile   = PosixWriteFile_Wrapper;
+        TomlSetCallbacks(&callbacks);
+    }
+
+    int exit_code = 0;
+    if (argc > 1 && strcmp(argv[1], "-bake") == 0)
+    {
+        if (argc < 4)
+        {
+            LogError("Usage: -bake <graph.toml> <terrain file>");
+            exit_code = 1;
+        }
+        else
+        {
+            terrain::TerrainGraphResult result = terrain::TerrainGraphBake(argv[2], argv[3]);
+            if (result != terrain::TerrainGraphResult::Success)
+            {
+                LogError("Failed to bake terrain graph \"%s\" (error %d).", argv[2], (int)result);
+                exit_code = 1;
+            }
+            else
+            {
+                LogInfo("Baked \"%s\" to \"%s\" in %f ms (%d job threads).", argv[2], argv[3],
+                        TimerMiliSecondsElapsed(&startup_timer), JobSystemGetThreadCount());
+            }
+        }
+    }
+    else if (argc > 1 && strcmp(argv[1], "-bench") == 0)
+    {
+        exit_code = RunBench((argc > 2) ? argv[2] : NULL);
+    }
+    else if (argc > 1 && strcmp(argv[1], "-selftest") == 0)
+    {
+        exit_code = RunSelfTests((argc > 2) ? argv[2] : NULL);
+    }
+    else
+    {
+        const char *startup_file = (argc > 1) ? argv[1] : g_engine_startup_file;
+        TomlCache toml_cache;
+        TomlCacheOpen(&toml_cache, g_toml_cache_file);
+        LoadStartupFile(startup_file, &toml_cache);
+        TomlCacheClose(&toml_cache);
+
+        file_manager::Init();
+        file_manager::MountFile("engine",  StrGetString(&g_engine_content_dir));
+        if (g_active_project < (u32)arrlen(g_known_projects))
+        {
+            file_manager::MountFile("project", StrGetString(&g_known_projects[g_active_project].filepath));
+        }
+
+        LogInfo("Headless startup finished in %f ms (%d job threads).",
+                TimerMiliSecondsElapsed(&startup_timer), JobSystemGetThreadCount());
+    }
+
+    JobSystemFree();
+    StrPoolFree();
+    SysMemoryFree();
+    PlatformVirtualFree(g_internal_mem);
+    PlatformLoggerFree();
+
+    return (exit_code);
+}
@@ -0,0 +1,45 @@
+
+// NOTE(Dustin): CLOCK_MONOTONIC is reported in nanoseconds, so Timer::start is a
+// nanosecond count rather than a tick count like QueryPerformanceCounter.
+file_global i64 g_performance_frequency;
+
+file_internal u64
+PosixGetTimeNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ULL + (u64)ts.tv_nsec;
+}
+
+void 
+GlobalTimerSetup()
+{
+    g_performance_frequency = 1000000000;
+}
+
+void 
+TimerBegin(Timer *timer)
+{
+    timer->start = PosixGetTimeNs();
+}
+
+r32 
+TimerSecondsElapsed(Timer *timer)
+{
+    r32 Result = ((r32)(PosixGetTimeNs() - timer->start) / (r32)g_performance_frequency);
+    return(Result);
+}
+
+r32 
+TimerMiliSecondsElapsed(Timer *timer)
+{
+    r32 Result = ((r32)(PosixGetTimeNs() - timer->start) * 1000 / (r32)g_performance_frequency);
+    return(Result);
+}
+
+r32 
+TimerNanoSecondsElapsed(Timer *timer)
+{
+    r32 Result = (r32)(PosixGetTimeNs() - timer->start);
+    return(Result);
+}
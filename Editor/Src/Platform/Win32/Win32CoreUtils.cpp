@@ -118,6 +118,18 @@ PlatformAtomicDec(volatile u32* v)
     _InterlockedDecrement(v);
 }
 
+void* 
+PlatformAtomicCompareExchangePtr(void * volatile *dst, void *exchange, void *comparand)
+{
+    return InterlockedCompareExchangePointer(dst, exchange, comparand);
+}
+
+void* 
+PlatformAtomicExchangePtr(void * volatile *dst, void *exchange)
+{
+    return InterlockedExchangePointer(dst, exchange);
+}
+
 static MAPLE_GUID 
 PlatformGenerateGuid()
 {
@@ -143,7 +155,7 @@ PlatformIsGuidValid(MAPLE_GUID guid)
         g_win32_invalid_guid_first_time = false;
         g_win32_invalid_guid = PlatformGenerateGuid();
     }
-    return PlatformGuidCmp(&guid, &g_win32_invalid_guid);
+    return !PlatformGuidCmp(&guid, &g_win32_invalid_guid);
 }
 
 static MAPLE_GUID 
@@ -120,6 +120,73 @@ PlatformWriteBufferToFile(const char* file_path, u8* buffer, u64 size, bool appe
     return result;
 }
 
+PlatformErrorType 
+PlatformGetFileInfo(const char* file_path, u64 *write_time, u64 *size)
+{
+    WIN32_FILE_ATTRIBUTE_DATA info;
+    if (!GetFileAttributesExA(file_path, GetFileExInfoStandard, &info))
+    {
+        DWORD error = GetLastError();
+        return (error == ERROR_FILE_NOT_FOUND || error == ERROR_PATH_NOT_FOUND) ? PlatformError_FileNotFound : PlatformError_FileOpenFailure;
+    }
+    
+    *write_time = ((u64)info.ftLastWriteTime.dwHighDateTime << 32) | (u64)info.ftLastWriteTime.dwLowDateTime;
+    *size       = ((u64)info.nFileSizeHigh << 32) | (u64)info.nFileSizeLow;
+    return PlatformError_Success;
+}
+
+PlatformErrorType 
+PlatformMapFile(const char* file_path, PlatformMappedFile *file, bool copy_on_write)
+{
+    *file = {};
+    HANDLE handle = CreateFileA(file_path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, 0);
+    
+    if (handle == INVALID_HANDLE_VALUE) 
+    {
+        return (GetLastError() == ERROR_FILE_NOT_FOUND) ? PlatformError_FileNotFound : PlatformError_FileOpenFailure;
+    }
+    
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(handle);
+        return PlatformError_FileOpenFailure;
+    }
+    
+    HANDLE mapping = CreateFileMappingA(handle, 0, (copy_on_write) ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, 0);
+    // The mapping keeps its own reference to the file
+    CloseHandle(handle);
+    if (!mapping) return PlatformError_FileReadFailure;
+    
+    void *data = MapViewOfFile(mapping, (copy_on_write) ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+    if (!data)
+    {
+        CloseHandle(mapping);
+        return PlatformError_FileReadFailure;
+    }
+    
+    file->data   = (u8*)data;
+    file->size   = (u64)size.QuadPart;
+    file->handle = mapping;
+    return PlatformError_Success;
+}
+
+void 
+PlatformUnmapFile(PlatformMappedFile *file)
+{
+    if (file->data)   UnmapViewOfFile(file->data);
+    if (file->handle) CloseHandle((HANDLE)file->handle);
+    *file = {};
+}
+
+void 
+PlatformReleaseMappedRange(PlatformMappedFile *file, u64 offset, u64 size)
+{
+    // NOTE(Dustin): Unlocking pages that are not locked removes them from the working set
+    u64 end = (offset + size < file->size) ? offset + size : file->size;
+    if (end > offset) VirtualUnlock(file->data + offset, (SIZE_T)(end - offset));
+}
+
 static Str 
 Win32GetExeFilepath()
 {
@@ -4,7 +4,6 @@ static const u32        g_window_width   = 1920;
 static const u32        g_window_height  = 1080;
 static bool             g_is_running = false; 
 
-static Win32ThreadPool *g_thread_pool    = 0;
 static const u64        g_internal_mem_sz = _MB(512);
 static void            *g_internal_mem    = 0;
 static bool             g_needs_resize = false;
@@ -19,6 +18,8 @@ struct MapleProject
 };
 
 static const char   *g_engine_startup_file = "startup.toml";
+// Compiled form of the startup and project files, see TomlLoadCached
+static const char   *g_toml_cache_file     = "startup.tomlcache";
 static Str           g_engine_content_dir;
 static MapleProject *g_known_projects;
 static u32           g_active_project;
@@ -42,13 +43,13 @@ void PlatformCloseApplication()
 }
 
 static void 
-LoadProjectFile(MapleProject *project)
+LoadProjectFile(MapleProject *project, TomlCache *cache)
 {
     const char *filename = "/maple.project";
     Str project_path = StrAdd(&project->filepath, filename, strlen(filename));
     
     Toml toml;
-    TomlResult result = TomlLoad(&toml, StrGetString(&project_path));
+    TomlResult result = TomlLoadCached(&toml, StrGetString(&project_path), cache);
     Assert(result == TomlResult_Success);
     
     project->name = StrInit(strlen(toml.title), toml.title);
@@ -58,10 +59,10 @@ LoadProjectFile(MapleProject *project)
 }
 
 static void
-LoadStartupFile(const char *startup)
+LoadStartupFile(const char *startup, TomlCache *cache)
 {
     Toml toml;
-    TomlResult result = TomlLoad(&toml, startup);
+    TomlResult result = TomlLoadCached(&toml, startup, cache);
     Assert(result == TomlResult_Success);
     
     TomlObject obj = TomlGetObject(&toml, "EngineStartup");
@@ -77,7 +78,7 @@ LoadStartupFile(const char *startup)
         project.filepath = StrInit(TomlGetStringLenArrayElem(proj_array, i), 
                                    TomlGetStringArrayElem(proj_array, i));
         
-        LoadProjectFile(&project);
+        LoadProjectFile(&project, cache);
         
         arrput(g_known_projects, project);
     }
@@ -93,6 +94,40 @@ Win32ReadFileToBuffer_Wrapper(const char* file_path, u8** buffer, int* size)
     PlatformReadFileToBuffer(file_path, buffer, (u32*)size);
 }
 
+static bool
+Win32GetFileInfo_Wrapper(const char* file_path, uint64_t* write_time, uint64_t* size)
+{
+    return PlatformGetFileInfo(file_path, (u64*)write_time, (u64*)size) == PlatformError_Success;
+}
+
+static void*
+Win32MapFile_Wrapper(const char* file_path, uint64_t* size)
+{
+    PlatformMappedFile file;
+    if (PlatformMapFile(file_path, &file, true) != PlatformError_Success) return NULL;
+    
+    // The view keeps the mapping alive, so the handle is not needed to unmap it
+    CloseHandle((HANDLE)file.handle);
+    
+    *size = file.size;
+    return file.data;
+}
+
+static void
+Win32UnmapFile_Wrapper(void *ptr, uint64_t size)
+{
+    PlatformMappedFile file = {};
+    file.data = (u8*)ptr;
+    file.size = size;
+    PlatformUnmapFile(&file);
+}
+
+static void
+Win32WriteFile_Wrapper(const char* file_path, const void* buffer, uint64_t size)
+{
+    PlatformWriteBufferToFile(file_path, (u8*)buffer, size);
+}
+
 
 INT WINAPI 
 WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, INT nCmdShow)
@@ -103,17 +138,33 @@ WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, INT nCmdSh
     
     g_internal_mem = PlatformVirtualAlloc(g_internal_mem_sz);
     SysMemoryInit(g_internal_mem, g_internal_mem_sz);
+    StrPoolInit();
+    
+    {
+        // Leave a core for the main thread, which also participates in the job system
+        Win32ProcessorInfo processor_info = {};
+        Win32GetProcessorInfo(&processor_info);
+        u32 worker_count = (processor_info.logical_processor_count > 1) ? processor_info.logical_processor_count - 1 : 1;
+        JobSystemInit(worker_count);
+    }
     
     {
         TomlCallbacks callbacks = {};
-        callbacks.Alloc    = SysMemoryAlloc;
-        callbacks.Free     = SysMemoryRelease;
-        callbacks.LoadFile = Win32ReadFileToBuffer_Wrapper;
-        callbacks.FreeFile = SysMemoryRelease;
+        callbacks.Alloc       = SysMemoryAlloc;
+        callbacks.Free        = SysMemoryRelease;
+        callbacks.LoadFile    = Win32ReadFileToBuffer_Wrapper;
+        callbacks.FreeFile    = SysMemoryRelease;
+        callbacks.GetFileInfo = Win32GetFileInfo_Wrapper;
+        callbacks.MapFile     = Win32MapFile_Wrapper;
+        callbacks.UnmapFile   = Win32UnmapFile_Wrapper;
+        callbacks.WriteFile   = Win32WriteFile_Wrapper;
         TomlSetCallbacks(&callbacks);
     }
     
-    LoadStartupFile(g_engine_startup_file);
+    TomlCache toml_cache;
+    TomlCacheOpen(&toml_cache, g_toml_cache_file);
+    LoadStartupFile(g_engine_startup_file, &toml_cache);
+    TomlCacheClose(&toml_cache);
     
     // initialize file manager
     file_manager::Init();
@@ -269,6 +320,8 @@ WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, INT nCmdSh
     RendererFree();
     HostWndFree(g_root_wnd);
     
+    JobSystemFree();
+    StrPoolFree();
     SysMemoryFree();
     PlatformVirtualFree(g_internal_mem);
     PlatformLoggerFree();
@@ -472,6 +472,10 @@ ToDXGIFormat(GfxFormat format)
         result = DXGI_FORMAT_D32_FLOAT;
     else if (format == GfxFormat::R8G8B8A8_Unorm)
         result = DXGI_FORMAT_R8G8B8A8_UNORM;
+    else if (format == GfxFormat::R16G16_UInt)
+        result = DXGI_FORMAT_R16G16_UINT;
+    else if (format == GfxFormat::R32_UInt)
+        result = DXGI_FORMAT_R32_UINT;
     //else if (format == GfxFormat::Swapchain_DSV)
     //result = depth_buffer_format;
     else
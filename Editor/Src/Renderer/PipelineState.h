@@ -60,6 +60,8 @@ enum class GfxFormat : u8
     R32G32B32_Float,
     R32G32B32A32_Float,
     R8G8B8A8_Unorm,
+    R16G16_UInt,
+    R32_UInt,
     
     // TODO(Dustin): Others on a as-needed basis
     
@@ -85,6 +85,10 @@ static Swapchain           g_swapchain{};      // @INTERNAL
 // TODO(Dustin): When moving to a multithreaded renderer,
 // should set a single command list for each thread
 static CommandList *g_frame_command_list = 0;
+// Transient CPU memory, one arena per in-flight frame. An arena is reset when
+// its frame index comes back around in RendererBeginFrame.
+static const u64    g_frame_arena_size = _64MB;
+static arena_t      g_frame_arenas[DXGI_MAX_SWAP_CHAIN_BUFFERS] = {};
 
 // Predfined functions
 
@@ -108,6 +112,11 @@ RendererInit(RendererInitInfo *info)
     
     CommandQueue *present_queue = device::GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT);
     g_swapchain.Init((HWND)info->wnd, present_queue, info->wnd_width, info->wnd_height);
+    
+    for (u32 i = 0; i < back_buffer_count; ++i)
+    {
+        arena_init(&g_frame_arenas[i], g_frame_arena_size, PlatformVirtualAlloc(g_frame_arena_size));
+    }
 }
 
 static void
@@ -118,6 +127,13 @@ RendererFree()
     g_swapchain.Free();
     FreeGlobalResourceState();
     
+    for (u32 i = 0; i < back_buffer_count; ++i)
+    {
+        void *backing = g_frame_arenas[i];
+        arena_free(&g_frame_arenas[i]);
+        PlatformVirtualFree(backing);
+    }
+    
     device::FreeDevice();
     device::ReportLiveObjects();
 }
@@ -139,6 +155,10 @@ RendererBeginFrame()
         g_frame_command_list = command_queue->GetCommandList();
     }
     
+    // Swapchain::Present waits on the fence for the new back buffer, so the
+    // previous frame that used this arena has finished on the GPU.
+    arena_reset(g_frame_arenas[g_swapchain._frame_index]);
+    
     // Clear the current swapchain's render target
     RenderTarget *swap_rt = g_swapchain.GetRenderTarget();
     r32 clear_color[] = { 0.0f, 0.0f, 0.0f, 1.0f };
@@ -157,6 +177,12 @@ RendererEndFrame()
     g_frame_command_list = 0;
 }
 
+static arena_t
+RendererGetFrameArena()
+{
+    return g_frame_arenas[g_swapchain._frame_index];
+}
+
 static void 
 RendererPresentFrame()
 {
@@ -74,6 +74,8 @@ static void RendererFree();
 static void RendererBeginFrame();
 static void RendererEndFrame();
 static struct CommandList* RendererGetActiveCommandList();
+// Transient memory that is valid until the current frame index is reused
+static arena_t RendererGetFrameArena();
 
 //RENDERER_INTERFACE RenderError RendererInit(RendererInitInfo *info);
 //RENDERER_INTERFACE RenderError RendererFree();
@@ -9,18 +9,10 @@
 #include "TerrainFunctions.cpp"
 #include "HeightmapDownSampler.cpp"
 
-enum class TerrainMeshType : u8
-{
-    Standard,      // simple mesh generation
-    TriangleStrip, // optimized for low poly count
-    Pizza,         // optmized for low poly count for DLOD
-    LowPoly,       // optimized for low poly normals with low memory overhead
-    TIN,           // optimizaed for mesh detail
-};
-
 struct TerrainTileInfo
 {
     TerrainMeshType meshing_strategy;
+    TerrainVertexFormat vertex_format = TerrainVertexFormat::Full;
     u32 tile_x = 0;            // # of tiles in the x direction
     u32 tile_y = 0;            // # of tiles in the y direction
     u32 vertex_x = 0;          // # of vertices in the x direction
@@ -29,18 +21,27 @@ struct TerrainTileInfo
     r32 texture_tiling = 0.0f; // Heightmap tiling on a tile
 };
 
+// Index buffer shared by every tile with the same topology
+struct TerrainIndexBuffer
+{
+    TerrainMeshType       meshing_strategy;
+    u32                   vertex_x;
+    u32                   vertex_y;
+    terrain::MeshTopology topology;
+    IndexBuffer           ibuffer;
+};
+
 struct TerrainTile
 {
     // NOTE(Dustin): With the exception of the TIN mesh
     // tiles can be drawn in instances, so they don't need
-    // to store unique vertex/index buffers
-    
-    VertexBuffer _vbuffer;
-    IndexBuffer  _ibuffer;
-    TEXTURE_ID   _heightmap_texture;
-    m4           _model;
+    // to store unique vertex/index buffers. The buffers are
+    // owned by the Terrain.
     
-    void Free();
+    VertexBuffer *_vbuffer;
+    IndexBuffer  *_ibuffer;
+    TEXTURE_ID    _heightmap_texture;
+    m4            _model;
     
     // @param pos:   x,z position on the terrain grid
     // @param scale: x,z scale for the tile
@@ -49,8 +50,6 @@ struct TerrainTile
     // @param use_as_texture: a flag to determine if the hightmap is sampled in the shader
     //  or in is the height embedded into the vertex.
     void AttachTexture(TEXTURE_ID heightmap_texture, bool use_as_texture = true);
-    void GenMesh(CommandList *command_list, TerrainMeshType meshing_strategy, 
-                 u32 width, u32 height, r32 tiling, r32 scale);
     
     void Render(CommandList *command_list);
 };
@@ -69,28 +68,50 @@ struct Terrain
     // @param proj_view:    Porjection - View Matrix
     void Render(CommandList *command_list, m4 proj_view, TEXTURE_ID heightmap);
     
+    // Builds the LOD quadtree and the tile mesh used by RenderLod
+    // @param desc: the heightmap should hold the same values as the texture passed to RenderLod
+    void GenerateLod(CommandList *command_list, terrain::TerrainLodDesc *desc);
+    
+    // Draws the tiles the quadtree selects for "view", instead of the fixed tile grid
+    void RenderLod(CommandList *command_list, terrain::TerrainLodView *view, TEXTURE_ID heightmap);
+    
     RootSignature       _root_signature;
-    PipelineStateObject _pso_solid;
-    PipelineStateObject _pso_wireframe;
+    // Per TerrainVertexFormat
+    PipelineStateObject _pso_solid[(u32)TerrainVertexFormat::Count];
+    PipelineStateObject _pso_wireframe[(u32)TerrainVertexFormat::Count];
     // Render with wireframe
     bool                _wireframe_mode;
     /* Maximum amount of tiles in x & y direction */
     TerrainTileInfo     _tile_info;
     TerrainTile        *_tiles = 0;
     
+    // Every tile in the grid has the same vertices, the height is sampled from
+    // the heightmap in the vertex shader. _vbuffer_info is the tile info the
+    // vertex buffer was generated with, so it is only rebuilt when it changes.
+    VertexBuffer        _vbuffer;
+    TerrainTileInfo     _vbuffer_info;
+    // Index buffers are cached per (meshing_strategy, vertex_x, vertex_y), stb_ds array
+    TerrainIndexBuffer *_index_buffers = 0;
+    // Topology of the current tile meshes
+    terrain::MeshTopology _topology;
+    
+    // Chunked LOD. Every tile is drawn with the same grid vertices and one of the index
+    // buffers, picked by the edges that meet a coarser tile.
+    terrain::TerrainQuadtree _quadtree;
+    terrain::TerrainLodNode *_lod_nodes = 0; // stb_ds array, tiles selected for the last frame
+    VertexBuffer             _lod_vbuffer;
+    IndexBuffer              _lod_ibuffers[terrain::Edge_All + 1];
+    
+    void FreeLod();
+    
+    TerrainIndexBuffer* GetIndexBuffer(CommandList *command_list, TerrainMeshType meshing_strategy, 
+                                       u32 vertex_x, u32 vertex_y);
+    
     void SetWireframe(bool set) { _wireframe_mode = set; }
 };
 
 namespace terrain
 {
-    // Terrain vertex that does not include the height componenet
-    struct TerrainVertex
-    {
-        v2 pos;   // position (x,z)
-        v3 norms; // normals
-        v2 uvs;   // tex coords
-    };
-    
     // Terrain vertex that does include the height componenet
     struct TerrainVertexWithHeight
     {
@@ -99,22 +120,26 @@ namespace terrain
         v2 uvs;   // tex coords
     };
     
-    struct TerrainGenInfo
-    {
-        u32 width;
-        u32 height;
-        // texture tiling on a mesh tile
-        r32 tiling;
-    };
-    
     enum RootParameters
     {
-        MatrixCB,
+        TileCB,
         HeightmapTexture,
         NumParams,
     };
     
-    static wchar_t *g_vertex_shader = L"shaders/TerrainVertex.cso";
+    // Must match TerrainTile in TerrainVertex.hlsl
+    struct TerrainTileConstants
+    {
+        m4  mvp;
+        v4  uv_transform; // xy: scale, zw: offset into the heightmap
+        v4  grid;         // compact vertices, xy: tile units per half cell (0.5 / vertices), z: texture tiling
+        r32 height_scale;
+    };
+    
+    static wchar_t *g_vertex_shaders[] = {
+        L"shaders/TerrainVertex.cso",        // Full
+        L"shaders/TerrainVertexCompact.cso", // Compact
+    };
     static wchar_t *g_pixel_shader  = L"shaders/TerrainPixel.cso";
     
     static GfxInputElementDesc g_vertex_no_height_input_desc[] = {
@@ -123,22 +148,25 @@ namespace terrain
         { "TEXCOORD", 0, GfxFormat::R32G32_Float,    0, D3D12_APPEND_ALIGNED_ELEMENT, GfxInputClass::PerVertex, 0 }
     };
     
+    static GfxInputElementDesc g_vertex_compact_input_desc[] = {
+        { "POSITION", 0, GfxFormat::R16G16_UInt, 0, D3D12_APPEND_ALIGNED_ELEMENT, GfxInputClass::PerVertex, 0 },
+        { "NORMAL",   0, GfxFormat::R32_UInt,    0, D3D12_APPEND_ALIGNED_ELEMENT, GfxInputClass::PerVertex, 0 }
+    };
+    
     static GfxInputElementDesc g_vertex_height_input_desc[] = {
         { "POSITION", 0, GfxFormat::R32G32B32_Float, 0, D3D12_APPEND_ALIGNED_ELEMENT, GfxInputClass::PerVertex, 0 },
         { "NORMAL",   0, GfxFormat::R32G32B32_Float, 0, D3D12_APPEND_ALIGNED_ELEMENT, GfxInputClass::PerVertex, 0 },
         { "TEXCOORD", 0, GfxFormat::R32G32_Float,    0, D3D12_APPEND_ALIGNED_ELEMENT, GfxInputClass::PerVertex, 0 }
     };
     
-    // @param vtx_buffer: (output) final vertex buffer
-    // @param idx_buffer: (output) final index buffer
-    static void GenerateSimpleGrid(VertexBuffer *vtx_buffer, IndexBuffer *idx_buffer,
-                                   CommandList *command_list, TerrainGenInfo *gen_info);
+    static void* AllocMeshScratch(arena_t frame_arena, u64 size, bool *from_arena);
     
-    static void GenerateTriangleStripGrid(VertexBuffer *vtx_buffer, IndexBuffer *idx_buffer,
-                                          CommandList *command_list, TerrainGenInfo *gen_info);
-    
-    static void GenerateLowPolyGrid();
-    static void GeneratePizzaGrid();
+    // Builds the tile mesh with the CPU mesher for desc->meshing_strategy and uploads it
+    // @param vtx_buffer: (output) final vertex buffer, NULL to skip the vertices
+    // @param idx_buffer: (output) final index buffer, NULL to skip the indices
+    // @param topology:   (output) topology of the mesh, can be NULL
+    static void GenerateTileMesh(VertexBuffer *vtx_buffer, IndexBuffer *idx_buffer, MeshTopology *topology,
+                                 CommandList *command_list, TerrainMeshDesc *desc);
     
 }
 
@@ -148,15 +176,15 @@ Terrain::Init()
     //---------------------------------------------------------------------------------------------
     // Create Root Signature
     
-    D3D12_ROOT_PARAMETER1 matrix_param = d3d::root_param1::InitAsConstant(sizeof(m4) / 4, 0, 0,
-                                                                          D3D12_SHADER_VISIBILITY_VERTEX);
+    D3D12_ROOT_PARAMETER1 tile_param = d3d::root_param1::InitAsConstant(sizeof(terrain::TerrainTileConstants) / 4, 0, 0,
+                                                                        D3D12_SHADER_VISIBILITY_VERTEX);
     
     D3D12_DESCRIPTOR_RANGE1 texture_range = d3d::GetDescriptorRange1(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
     D3D12_ROOT_PARAMETER1 height_param = d3d::root_param1::InitAsDescriptorTable(1, &texture_range, 
                                                                                  D3D12_SHADER_VISIBILITY_VERTEX);
     
     D3D12_ROOT_PARAMETER1 root_params[terrain::RootParameters::NumParams];
-    root_params[terrain::RootParameters::MatrixCB]         = matrix_param;
+    root_params[terrain::RootParameters::TileCB]           = tile_param;
     root_params[terrain::RootParameters::HeightmapTexture] = height_param;
     
     // Diffuse texture sampler
@@ -173,28 +201,40 @@ Terrain::Init()
     //---------------------------------------------------------------------------------------------
     // Create Pipeline State object
     
-    GfxShaderModules shader_modules;
-    shader_modules.vertex = LoadShaderModule(terrain::g_vertex_shader);
-    shader_modules.pixel  = LoadShaderModule(terrain::g_pixel_shader);
-    
-    GfxPipelineStateDesc pso_desc{};
-    pso_desc.root_signature      = &_root_signature;
-    pso_desc.shader_modules      = shader_modules;
-    pso_desc.blend               = GetBlendState(BlendState::Disabled);
-    pso_desc.depth               = GetDepthStencilState(DepthStencilState::ReadWrite);
-    pso_desc.rasterizer          = GetRasterizerState(RasterState::Default);
-    pso_desc.input_layouts       = &terrain::g_vertex_no_height_input_desc[0];
-    pso_desc.input_layouts_count = _countof(terrain::g_vertex_no_height_input_desc);
-    pso_desc.topology            = GfxTopology::Triangle;
-    pso_desc.sample_desc.count   = 1;
-    // @FIXME probably should grab the swapchain manually like this...
-    pso_desc.rtv_formats         = g_swapchain.GetRenderTarget()->GetRenderTargetFormats();
-    pso_desc.dsv_format          = GfxFormat::D32_Float;
-    
-    _pso_solid.Init(&pso_desc);
-    
-    pso_desc.rasterizer.FillMode = D3D12_FILL_MODE_WIREFRAME;
-    _pso_wireframe.Init(&pso_desc);
+    GfxInputElementDesc *input_layouts[] = {
+        terrain::g_vertex_no_height_input_desc, // Full
+        terrain::g_vertex_compact_input_desc,   // Compact
+    };
+    u32 input_layout_counts[] = {
+        _countof(terrain::g_vertex_no_height_input_desc),
+        _countof(terrain::g_vertex_compact_input_desc),
+    };
+    
+    for (u32 format = 0; format < (u32)TerrainVertexFormat::Count; ++format)
+    {
+        GfxShaderModules shader_modules;
+        shader_modules.vertex = LoadShaderModule(terrain::g_vertex_shaders[format]);
+        shader_modules.pixel  = LoadShaderModule(terrain::g_pixel_shader);
+        
+        GfxPipelineStateDesc pso_desc{};
+        pso_desc.root_signature      = &_root_signature;
+        pso_desc.shader_modules      = shader_modules;
+        pso_desc.blend               = GetBlendState(BlendState::Disabled);
+        pso_desc.depth               = GetDepthStencilState(DepthStencilState::ReadWrite);
+        pso_desc.rasterizer          = GetRasterizerState(RasterState::Default);
+        pso_desc.input_layouts       = input_layouts[format];
+        pso_desc.input_layouts_count = input_layout_counts[format];
+        pso_desc.topology            = GfxTopology::Triangle;
+        pso_desc.sample_desc.count   = 1;
+        // @FIXME probably should grab the swapchain manually like this...
+        pso_desc.rtv_formats         = g_swapchain.GetRenderTarget()->GetRenderTargetFormats();
+        pso_desc.dsv_format          = GfxFormat::D32_Float;
+        
+        _pso_solid[format].Init(&pso_desc);
+        
+        pso_desc.rasterizer.FillMode = D3D12_FILL_MODE_WIREFRAME;
+        _pso_wireframe[format].Init(&pso_desc);
+    }
     
     //---------------------------------------------------------------------------------------------
     // Finish up...
@@ -204,54 +244,112 @@ Terrain::Init()
     // has been a set of tiles allocated yet
     _tiles = 0;
     _wireframe_mode = true;
+    
+    _vbuffer       = {};
+    _vbuffer_info  = {};
+    _index_buffers = 0;
+    _topology      = terrain::MeshTopology::TriangleStrip;
+    
+    _quadtree  = {};
+    _lod_nodes = 0;
 }
 
 void 
 Terrain::Free()
 {
-    _pso_solid.Free();
-    _pso_wireframe.Free();
+    for (u32 format = 0; format < (u32)TerrainVertexFormat::Count; ++format)
+    {
+        _pso_solid[format].Free();
+        _pso_wireframe[format].Free();
+    }
     _root_signature.Free();
     
-    u32 tile_count = _tile_info.tile_x * _tile_info.tile_y;
     if (_tiles)
     {
-        for (u32 i = 0; i < tile_count; ++i)
-            _tiles[i].Free();
+        SysFree(_tiles);
+        _tiles = 0;
+    }
+    
+    if (_vbuffer_info.vertex_x > 0)
+    {
+        _vbuffer.Free();
+        _vbuffer_info = {};
+    }
+    
+    for (u32 i = 0; i < (u32)arrlen(_index_buffers); ++i)
+    {
+        _index_buffers[i].ibuffer.Free();
     }
+    arrfree(_index_buffers);
+    
+    FreeLod();
 }
 
-// @param meshing_strategy: type of meshing that will be used to generate each tile mesh
-// @param heightmap_list:   list of heightmaps (_tile_x_count * _tile_y_count) in size
-//                          it is expected that the heightmaps are organized in row-major order
 void
-Terrain::Generate(CommandList *command_list, TerrainTileInfo *tile_info, TEXTURE_ID *heightmap_list)
+Terrain::FreeLod()
 {
-    if (_tiles)
+    if (_quadtree.levels > 0)
     {
-        for (u32 j = 0; j < _tile_info.tile_y; ++j)
+        _lod_vbuffer.Free();
+        for (u32 i = 0; i < ARRAYCOUNT(_lod_ibuffers); ++i)
         {
-            TerrainTile *row = _tiles + (j * _tile_info.tile_x);
-            for (u32 i = 0; i < _tile_info.tile_x; ++i)
-            {
-                row[i].Free();
-            }
+            _lod_ibuffers[i].Free();
         }
+        terrain::QuadtreeFree(&_quadtree);
     }
-    
+    arrfree(_lod_nodes);
+}
+
+// @param meshing_strategy: type of meshing that will be used to generate each tile mesh
+// @param heightmap_list:   list of heightmaps (_tile_x_count * _tile_y_count) in size
+//                          it is expected that the heightmaps are organized in row-major order
+void
+Terrain::Generate(CommandList *command_list, TerrainTileInfo *tile_info, TEXTURE_ID *heightmap_list)
+{
     tile_info->tile_x = fast_max(tile_info->tile_x, 1);
     tile_info->tile_y = fast_max(tile_info->tile_y, 1);
     u32 tile_count = tile_info->tile_x * tile_info->tile_y;
     
+    // TODO(Dustin): TIN meshes are built from the heightmap values, but the heightmaps
+    // only live on the GPU. Read them back (or generate them with terrain::GenerateHeightmap)
+    // and give every tile its own TIN mesh.
+    assert(tile_info->meshing_strategy != TerrainMeshType::TIN && 
+           "TIN tiles need CPU heightmaps, see terrain::BuildMesh");
+    
+    // The vertex buffer only depends on the meshing strategy, vertex format, vertex counts
+    // and texture tiling
+    if (_vbuffer_info.meshing_strategy != tile_info->meshing_strategy ||
+        _vbuffer_info.vertex_format    != tile_info->vertex_format    ||
+        _vbuffer_info.vertex_x         != tile_info->vertex_x         ||
+        _vbuffer_info.vertex_y         != tile_info->vertex_y         ||
+        _vbuffer_info.texture_tiling   != tile_info->texture_tiling)
+    {
+        if (_vbuffer_info.vertex_x > 0) _vbuffer.Free();
+        
+        terrain::TerrainMeshDesc desc{};
+        desc.meshing_strategy = tile_info->meshing_strategy;
+        desc.width            = tile_info->vertex_x;
+        desc.height           = tile_info->vertex_y;
+        desc.tiling           = tile_info->texture_tiling;
+        desc.vertex_format    = tile_info->vertex_format;
+        terrain::GenerateTileMesh(&_vbuffer, NULL, NULL, command_list, &desc);
+        
+        _vbuffer_info = *tile_info;
+    }
+    
+    // NOTE(Dustin): The pointer is into the _index_buffers array, so it is only valid
+    // until the next index buffer is added. Every tile is reassigned below.
+    TerrainIndexBuffer *index_entry = GetIndexBuffer(command_list, tile_info->meshing_strategy,
+                                                     tile_info->vertex_x, tile_info->vertex_y);
+    IndexBuffer *ibuffer = &index_entry->ibuffer;
+    _topology = index_entry->topology;
+    
     _tiles = (TerrainTile*)SysRealloc(_tiles, sizeof(TerrainTile) * tile_count);
     
     for (u32 i = 0; i < tile_count; ++i)
     {
-        _tiles[i].GenMesh(command_list, tile_info->meshing_strategy, 
-                          tile_info->vertex_x, 
-                          tile_info->vertex_y, 
-                          tile_info->texture_tiling, 
-                          tile_info->scale);
+        _tiles[i]._vbuffer = &_vbuffer;
+        _tiles[i]._ibuffer = ibuffer;
         
         r32 pos_x = (r32)(i % tile_info->tile_x);
         r32 pos_z = (r32)(i / tile_info->tile_x);
@@ -262,8 +360,8 @@ Terrain::Generate(CommandList *command_list, TerrainTileInfo *tile_info, TEXTURE
         // of -0.5, (0.5 - step_rate). The following two lines
         // adjust for this.
         //
-        // NOTE(Dustin): This might not work w/ meshing algorithms
-        // other than triangle strip!
+        // NOTE(Dustin): Every mesher places its vertices on the same
+        // grid, so this holds for all meshing strategies.
         
         pos_x -= pos_x * (1.0f / tile_info->vertex_x);
         pos_z -= pos_z * (1.0f / tile_info->vertex_y);
@@ -274,15 +372,43 @@ Terrain::Generate(CommandList *command_list, TerrainTileInfo *tile_info, TEXTURE
     _tile_info = *tile_info;
 }
 
+TerrainIndexBuffer*
+Terrain::GetIndexBuffer(CommandList *command_list, TerrainMeshType meshing_strategy, u32 vertex_x, u32 vertex_y)
+{
+    for (u32 i = 0; i < (u32)arrlen(_index_buffers); ++i)
+    {
+        TerrainIndexBuffer *entry = &_index_buffers[i];
+        if (entry->meshing_strategy == meshing_strategy && entry->vertex_x == vertex_x && entry->vertex_y == vertex_y)
+        {
+            return entry;
+        }
+    }
+    
+    TerrainIndexBuffer entry = {};
+    entry.meshing_strategy = meshing_strategy;
+    entry.vertex_x         = vertex_x;
+    entry.vertex_y         = vertex_y;
+    
+    terrain::TerrainMeshDesc desc{};
+    desc.meshing_strategy = meshing_strategy;
+    desc.width            = vertex_x;
+    desc.height           = vertex_y;
+    terrain::GenerateTileMesh(NULL, &entry.ibuffer, &entry.topology, command_list, &desc);
+    
+    arrput(_index_buffers, entry);
+    return &_index_buffers[arrlen(_index_buffers) - 1];
+}
+
 // @param command_list: command list to record commands into
 // @param proj_view:    Porjection - View Matrix
 void 
 Terrain::Render(CommandList *command_list, m4 proj_view, TEXTURE_ID heightmap)
 {
+    u32 format = (u32)_vbuffer_info.vertex_format;
     if (_wireframe_mode)
-        command_list->SetPipelineState(_pso_wireframe._handle);
+        command_list->SetPipelineState(_pso_wireframe[format]._handle);
     else
-        command_list->SetPipelineState(_pso_solid._handle);
+        command_list->SetPipelineState(_pso_solid[format]._handle);
     
     command_list->SetGraphicsRootSignature(&_root_signature);
     
@@ -290,26 +416,106 @@ Terrain::Render(CommandList *command_list, m4 proj_view, TEXTURE_ID heightmap)
     for (u32 i = 0; i < tile_count; ++i)
     {
         // Set root parameters
-        m4 mvp = m4_mul(proj_view, _tiles[i]._model);
-        command_list->SetGraphics32BitConstants(terrain::MatrixCB, &mvp);
+        terrain::TerrainTileConstants constants = {};
+        constants.mvp          = m4_mul(proj_view, _tiles[i]._model);
+        constants.uv_transform = { 1.0f, 1.0f, 0.0f, 0.0f };
+        constants.grid         = { 0.5f / (r32)_vbuffer_info.vertex_x, 0.5f / (r32)_vbuffer_info.vertex_y,
+            _vbuffer_info.texture_tiling, 0.0f };
+        constants.height_scale = 5.0f;
+        command_list->SetGraphics32BitConstants(terrain::TileCB, &constants);
         
         //tile[i]._heightmap_texture;
         // TODO(Dustin): Actually set the hightmap texture
         command_list->SetShaderResourceView(terrain::HeightmapTexture, 0, heightmap);
         
-        command_list->SetVertexBuffer(0, &_tiles[i]._vbuffer);
-        command_list->SetIndexBuffer(&_tiles[i]._ibuffer);
-        // TODO(Dustin): Set topology based on the meshing strategy
-        command_list->SetTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-        command_list->DrawIndexedInstanced((UINT)_tiles[i]._ibuffer._count);
+        command_list->SetVertexBuffer(0, _tiles[i]._vbuffer);
+        command_list->SetIndexBuffer(_tiles[i]._ibuffer);
+        if (_topology == terrain::MeshTopology::TriangleStrip)
+            command_list->SetTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+        else
+            command_list->SetTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        command_list->DrawIndexedInstanced((UINT)_tiles[i]._ibuffer->_count);
+    }
+}
+
+void
+Terrain::GenerateLod(CommandList *command_list, terrain::TerrainLodDesc *desc)
+{
+    FreeLod();
+    
+    if (!terrain::QuadtreeInit(&_quadtree, desc))
+    {
+        LogError("Terrain LOD: a %d heightmap can not be split into tiles of %d vertices.",
+                 desc->heightmap_size, desc->tile_vertices);
+        return;
+    }
+    
+    terrain::TerrainMeshDesc mesh_desc{};
+    mesh_desc.meshing_strategy = TerrainMeshType::Standard;
+    mesh_desc.width            = desc->tile_vertices;
+    mesh_desc.height           = desc->tile_vertices;
+    mesh_desc.tiling           = 1.0f;
+    terrain::GenerateTileMesh(&_lod_vbuffer, NULL, NULL, command_list, &mesh_desc);
+    
+    for (u32 edges = 0; edges < ARRAYCOUNT(_lod_ibuffers); ++edges)
+    {
+        mesh_desc.stitch_edges = edges;
+        terrain::GenerateTileMesh(NULL, &_lod_ibuffers[edges], NULL, command_list, &mesh_desc);
     }
 }
 
 void
-TerrainTile::Free()
+Terrain::RenderLod(CommandList *command_list, terrain::TerrainLodView *view, TEXTURE_ID heightmap)
 {
-    _vbuffer.Free();
-    _ibuffer.Free();
+    if (_quadtree.levels == 0) return;
+    
+    terrain::QuadtreeSelect(&_quadtree, view, &_lod_nodes);
+    
+    // The LOD tiles use full vertices
+    if (_wireframe_mode)
+        command_list->SetPipelineState(_pso_wireframe[(u32)TerrainVertexFormat::Full]._handle);
+    else
+        command_list->SetPipelineState(_pso_solid[(u32)TerrainVertexFormat::Full]._handle);
+    
+    command_list->SetGraphicsRootSignature(&_root_signature);
+    command_list->SetShaderResourceView(terrain::HeightmapTexture, 0, heightmap);
+    command_list->SetVertexBuffer(0, &_lod_vbuffer);
+    command_list->SetTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    
+    // NOTE(Dustin): The tile grid spans [-0.5, 0.5 - 1/n] with uvs in [0, (n-1)/n] (see the
+    // @HACK in Generate), so both are stretched by n/(n-1) to cover the node exactly. The uvs
+    // are then moved onto the heightmap texel centers.
+    r32 n            = (r32)_quadtree.tile_vertices;
+    r32 grid_extent  = (n - 1.0f) / n;
+    r32 texel_scale  = (r32)(_quadtree.heightmap_size - 1) / (r32)_quadtree.heightmap_size;
+    r32 texel_offset = 0.5f / (r32)_quadtree.heightmap_size;
+    
+    for (u32 i = 0; i < (u32)arrlen(_lod_nodes); ++i)
+    {
+        terrain::TerrainLodNode *node = &_lod_nodes[i];
+        
+        v3 min, max;
+        terrain::QuadtreeNodeBounds(&_quadtree, node, &min, &max);
+        
+        r32 size  = max.x - min.x;
+        r32 scale = size / grid_extent;
+        m4 model  = m4_mul(m4_translate({ min.x + 0.5f * scale, 0.0f, min.z + 0.5f * scale }),
+                           m4_scale(scale, 1.0f, scale));
+        
+        r32 uv_scale = (size / _quadtree.world_size) / grid_extent;
+        
+        terrain::TerrainTileConstants constants = {};
+        constants.mvp          = m4_mul(view->proj_view, model);
+        constants.uv_transform = { uv_scale * texel_scale, uv_scale * texel_scale,
+            (min.x / _quadtree.world_size) * texel_scale + texel_offset,
+            (min.z / _quadtree.world_size) * texel_scale + texel_offset };
+        constants.height_scale = _quadtree.height_scale;
+        command_list->SetGraphics32BitConstants(terrain::TileCB, &constants);
+        
+        IndexBuffer *ibuffer = &_lod_ibuffers[node->stitch_edges];
+        command_list->SetIndexBuffer(ibuffer);
+        command_list->DrawIndexedInstanced((UINT)ibuffer->_count);
+    }
 }
 
 // @param pos:   x,z position on the terrain grid
@@ -331,29 +537,6 @@ TerrainTile::AttachTexture(TEXTURE_ID heightmap_texture, bool use_as_texture)
 {
 }
 
-void 
-TerrainTile::GenMesh(CommandList *command_list, TerrainMeshType meshing_strategy, 
-                     u32 width, u32 height, r32 tiling, r32 scale)
-{
-    
-    terrain::TerrainGenInfo info{};
-    info.width = width;
-    info.height = height;
-    info.tiling = tiling;
-    
-    if (TerrainMeshType::Standard == meshing_strategy)
-        terrain::GenerateSimpleGrid(&_vbuffer, &_ibuffer, command_list, &info);
-    else if (TerrainMeshType::TriangleStrip == meshing_strategy)
-        terrain::GenerateTriangleStripGrid(&_vbuffer, &_ibuffer, command_list, &info);
-    else if (TerrainMeshType::Pizza == meshing_strategy)
-        assert(false && "Not implemented");
-    else if (TerrainMeshType::LowPoly == meshing_strategy)
-        assert(false && "Not implemented");
-    else if (TerrainMeshType::TIN == meshing_strategy)
-        assert(false && "Not implemented");
-    
-}
-
 void 
 TerrainTile::Render(CommandList *command_list)
 {
@@ -362,124 +545,54 @@ TerrainTile::Render(CommandList *command_list)
 //-------------------------------------------------------------------------------------------------
 // Mesh Generation
 
-// @param vtx_buffer: (output) final vertex buffer
-// @param idx_buffer: (output) final index buffer
-static void
-terrain::GenerateSimpleGrid(VertexBuffer *vtx_buffer, IndexBuffer *idx_buffer,
-                            CommandList *command_list, TerrainGenInfo *gen_info)
+// The mesh data is copied into upload buffers before the generate functions return,
+// so it only needs to live in the frame arena for the scope of the call. Meshes too
+// large for the arena fall back to a virtual allocation.
+static void*
+terrain::AllocMeshScratch(arena_t frame_arena, u64 size, bool *from_arena)
 {
-    assert(false && "Not implemented");
+    void *result = arena_alloc(frame_arena, size);
+    *from_arena = (result != NULL);
+    if (!result)
+    {
+        result = PlatformVirtualAlloc(size);
+    }
+    return result;
 }
 
-// @param vtx_buffer: (output) final vertex buffer
-// @param idx_buffer: (output) final index buffer
-static void 
-terrain::GenerateTriangleStripGrid(VertexBuffer *vtx_buffer, IndexBuffer *idx_buffer,
-                                   CommandList *command_list, TerrainGenInfo *gen_info)
+// @param vtx_buffer: (output) final vertex buffer, NULL to skip the vertices
+// @param idx_buffer: (output) final index buffer, NULL to skip the indices
+// @param topology:   (output) topology of the mesh, can be NULL
+static void
+terrain::GenerateTileMesh(VertexBuffer *vtx_buffer, IndexBuffer *idx_buffer, MeshTopology *topology,
+                          CommandList *command_list, TerrainMeshDesc *desc)
 {
-    const r32 min_x = -0.5f;
-    const r32 max_x =  0.5f;
-    
-    const r32 min_z = -0.5f;
-    const r32 max_z =  0.5f;
-    
-    const r32 step_x = (r32)(max_x - min_x) / (r32)gen_info->width;
-    const r32 step_z = (r32)(max_z - min_z) / (r32)gen_info->height;
-    
-    u32 vertex_count = gen_info->width * gen_info->height * 3;
-    u32 index_count = (gen_info->width * gen_info->height) + (gen_info->width - 1) * (gen_info->height - 2);
-    
-#if 0
-    
-    TerrainVertex *vertices = (TerrainVertex*)SysAlloc(sizeof(TerrainVertex) * vertex_count);
-    u32 *indices = (u32*)SysAlloc(sizeof(u32) * index_count);
-    
-#else
-    
-    u64 vertex_size = sizeof(TerrainVertex) * vertex_count;
-    u64 index_size = sizeof(u32) * index_count;
-    
-    void *terrain_data_ptr = PlatformVirtualAlloc(vertex_size + index_size);
-    TerrainVertex *vertices = (TerrainVertex*)((char*)terrain_data_ptr);
-    u32 *indices = (u32*)((char*)terrain_data_ptr + vertex_size);
-    
-#endif
-    
-    
-    // Generate the grid information
-    for (u32 r = 0; r < gen_info->height; ++r)
-    {
-        u32 base = r * gen_info->width;
-        for (u32 c = 0; c < gen_info->width; ++c)
-        {
-            // Calculate the UVs
-            
-            r32 uvx = gen_info->tiling * (c / (r32)gen_info->width);
-            r32 uvz = gen_info->tiling * (r / (r32)gen_info->height);
-            
-            vertices[base + c].uvs.x = (r32)(uvx - (i32)uvx);
-            vertices[base + c].uvs.y = (r32)(uvz - (i32)uvz);
-            
-            // Calculate the Position
-            
-            vertices[base + c].pos.x = min_x + (r32)c * step_x;
-            vertices[base + c].pos.y = min_z + (r32)r * step_z;
-            
-            // Zero Normals for now...
-            
-            vertices[base + c].norms = V3_ZERO;
-        }
-    }
-    
-    // Create the indices list
-    u32 i = 0;
-    for (u32 r = 0; r < gen_info->height - 1; r++)
-    {
-        if ((r & 1) == 0)
-        { // even rows
-            for (u32 c = 0; c < gen_info->width; c++)
-            {
-                indices[i++] = (r + 0) * gen_info->width + c;
-                indices[i++] = (r + 1) * gen_info->width + c;
-            }
-        }
-        else
-        {
-            for (u32 c = gen_info->width - 1; c > 0; c--)
-            {
-                indices[i++] = c + (r + 1) * gen_info->width;
-                indices[i++] = c - 1 + (r + 0) * gen_info->width;
-            }
-        }
-        
-        if ((gen_info->height & 1) && gen_info->height > 2)
-        {
-            indices[i++] = (gen_info->height - 1) * gen_info->width;
-        }
-    }
+    u32 max_vertices, max_indices;
+    GetMeshCapacity(desc, &max_vertices, &max_indices);
     
-    command_list->CopyVertexBuffer(vtx_buffer, vertex_count, sizeof(TerrainVertex), vertices);
-    command_list->CopyIndexBuffer(idx_buffer, index_count, sizeof(u32), indices);
+    arena_t frame_arena = RendererGetFrameArena();
+    arena_scope scratch(frame_arena);
     
-#if 0
+    bool vertices_from_arena = true;
+    bool indices_from_arena  = true;
     
-    SysFree(vertices);
-    SysFree(indices);
+    u32 vertex_size = GetVertexSize(desc->vertex_format);
     
-#else
+    TerrainMesh mesh = {};
+    if (vtx_buffer)
+        mesh.vertices = AllocMeshScratch(frame_arena, (u64)vertex_size * max_vertices, &vertices_from_arena);
+    if (idx_buffer)
+        mesh.indices  = (u32*)AllocMeshScratch(frame_arena, sizeof(u32) * max_indices, &indices_from_arena);
     
-    PlatformVirtualFree(terrain_data_ptr);
+    BuildMesh(desc, &mesh);
     
-#endif
+    if (vtx_buffer)
+        command_list->CopyVertexBuffer(vtx_buffer, mesh.vertex_count, vertex_size, mesh.vertices);
+    if (idx_buffer)
+        command_list->CopyIndexBuffer(idx_buffer, mesh.index_count, sizeof(u32), mesh.indices);
+    if (topology)
+        *topology = mesh.topology;
     
+    if (!vertices_from_arena) PlatformVirtualFree(mesh.vertices);
+    if (!indices_from_arena)  PlatformVirtualFree(mesh.indices);
 }
-
-static void 
-terrain::GenerateLowPolyGrid()
-{
-}
-
-static void
-terrain::GeneratePizzaGrid()
-{
-}
\ No newline at end of file
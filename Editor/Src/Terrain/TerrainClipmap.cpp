@@ -0,0 +1,312 @@
+// NOTE(Dustin): Level L is centered on the camera snapped to every other sample of the level,
+// so its origin is always even and lines up with a sample of level L + 1. Inside level L + 1
+// that leaves a border of (size - 1) / 4 cells on one side of the hole and one more on the
+// other, depending on which half of a coarse cell the camera is in.
+//
+// The coarse heights follow the triangulation of the Standard mesher: a vertex in the middle
+// of a coarse cell lies on the top right - bottom left diagonal.
+
+#define CLIPMAP_MAX_LEVELS ARRAYCOUNT(((TerrainClipmap*)0)->level)
+
+namespace terrain
+{
+    FORCE_INLINE u32
+    ClipmapWrap(i32 v, u32 size)
+    {
+        i32 result = v % (i32)size;
+        return (u32)((result < 0) ? result + (i32)size : result);
+    }
+
+    FORCE_INLINE r32
+    ClipmapAt(TerrainClipmap *clipmap, r32 *buffer, i32 x, i32 y)
+    {
+        return buffer[ClipmapWrap(y, clipmap->size) * clipmap->size + ClipmapWrap(x, clipmap->size)];
+    }
+
+    // Origin of a level for a camera position, see the note above
+    file_internal void
+    ClipmapTargetOrigin(TerrainClipmap *clipmap, u32 level, v3 camera, i32 *origin_x, i32 *origin_y)
+    {
+        r32 cell = clipmap->grid_spacing * (r32)(1u << (level + 1));
+        i32 half = (i32)(clipmap->size - 1) / 2;
+
+        *origin_x = 2 * (i32)floorf(camera.x / cell) - half;
+        *origin_y = 2 * (i32)floorf(camera.z / cell) - half;
+    }
+
+    // Heights of the next coarser level at samples [x, x + width) x [y, y + height) of "level"
+    file_internal void
+    ClipmapUpdateCoarse(TerrainClipmap *clipmap, u32 level, i32 x, i32 y, u32 width, u32 height)
+    {
+        ClipmapLevel *fine = clipmap->level + level;
+        u32 size = clipmap->size;
+
+        if (level + 1 == clipmap->levels)
+        {
+            // Nothing coarser, the coarsest ring does not blend
+            for (u32 j = 0; j < height; ++j)
+            {
+                for (u32 i = 0; i < width; ++i)
+                {
+                    u32 idx = ClipmapWrap(y + j, size) * size + ClipmapWrap(x + i, size);
+                    fine->coarse_heights[idx] = fine->heights[idx];
+                }
+            }
+            return;
+        }
+
+        r32 *coarse = clipmap->level[level + 1].heights;
+        for (u32 j = 0; j < height; ++j)
+        {
+            i32 sy = y + (i32)j;
+            i32 cy = sy >> 1;
+            bool odd_y = sy & 1;
+
+            for (u32 i = 0; i < width; ++i)
+            {
+                i32 sx = x + (i32)i;
+                i32 cx = sx >> 1;
+                bool odd_x = sx & 1;
+
+                r32 h;
+                if (odd_x && odd_y)
+                    h = 0.5f * (ClipmapAt(clipmap, coarse, cx + 1, cy) + ClipmapAt(clipmap, coarse, cx, cy + 1));
+                else if (odd_x)
+                    h = 0.5f * (ClipmapAt(clipmap, coarse, cx, cy) + ClipmapAt(clipmap, coarse, cx + 1, cy));
+                else if (odd_y)
+                    h = 0.5f * (ClipmapAt(clipmap, coarse, cx, cy) + ClipmapAt(clipmap, coarse, cx, cy + 1));
+                else
+                    h = ClipmapAt(clipmap, coarse, cx, cy);
+
+                fine->coarse_heights[ClipmapWrap(sy, size) * size + ClipmapWrap(sx, size)] = h;
+            }
+        }
+    }
+
+    // Fetches samples [x, x + width) x [y, y + height) of a level and writes them to the level
+    // buffer. The region wraps around the buffer at most once per axis, so it lands in up to
+    // four rectangles of the buffer.
+    file_internal void
+    ClipmapFetch(TerrainClipmap *clipmap, u32 level, i32 x, i32 y, u32 width, u32 height)
+    {
+        if (width == 0 || height == 0) return;
+
+        u32 size = clipmap->size;
+        assert(width <= size && height <= size);
+
+        clipmap->source(clipmap->user, level, x, y, width, height, clipmap->scratch);
+
+        u32 bx = ClipmapWrap(x, size);
+        u32 by = ClipmapWrap(y, size);
+
+        // The part before the wrap, and the part after it
+        u32 width0  = fast_min(width,  size - bx);
+        u32 height0 = fast_min(height, size - by);
+        u32 widths[2]  = { width0,  width  - width0  };
+        u32 heights[2] = { height0, height - height0 };
+
+        u32 src_y = 0;
+        for (u32 ry = 0; ry < 2; ++ry)
+        {
+            u32 src_x = 0;
+            for (u32 rx = 0; rx < 2; ++rx)
+            {
+                if (widths[rx] > 0 && heights[ry] > 0)
+                {
+                    ClipmapRegion region = {};
+                    region.level  = level;
+                    region.x      = (rx == 0) ? bx : 0;
+                    region.y      = (ry == 0) ? by : 0;
+                    region.width  = widths[rx];
+                    region.height = heights[ry];
+                    arrput(clipmap->dirty, region);
+
+                    for (u32 j = 0; j < region.height; ++j)
+                    {
+                        r32 *dst = clipmap->level[level].heights + (region.y + j) * size + region.x;
+                        r32 *src = clipmap->scratch + (src_y + j) * width + src_x;
+                        memcpy(dst, src, sizeof(r32) * region.width);
+                    }
+                }
+                src_x += widths[rx];
+            }
+            src_y += heights[ry];
+        }
+
+        ClipmapUpdateCoarse(clipmap, level, x, y, width, height);
+    }
+
+    // Samples a level has to fetch to move to (origin_x, origin_y)
+    file_internal u64
+    ClipmapUpdateCost(TerrainClipmap *clipmap, ClipmapLevel *level, i32 origin_x, i32 origin_y)
+    {
+        u64 size = clipmap->size;
+        u64 dx = (u64)abs(origin_x - level->origin_x);
+        u64 dy = (u64)abs(origin_y - level->origin_y);
+
+        if (!level->valid || dx >= size || dy >= size)
+            return size * size;
+
+        return dx * size + dy * (size - dx);
+    }
+
+    file_internal void
+    ClipmapMoveLevel(TerrainClipmap *clipmap, u32 index, i32 origin_x, i32 origin_y, TerrainClipmapStats *stats)
+    {
+        ClipmapLevel *level = clipmap->level + index;
+        u32 size = clipmap->size;
+
+        i32 dx = origin_x - level->origin_x;
+        i32 dy = origin_y - level->origin_y;
+
+        if (!level->valid || (u32)abs(dx) >= size || (u32)abs(dy) >= size)
+        {
+            ClipmapFetch(clipmap, index, origin_x, origin_y, size, size);
+            stats->levels_refreshed += 1;
+        }
+        else
+        {
+            // Columns that scrolled into view, over every row of the new window
+            u32 columns = (u32)abs(dx);
+            i32 column_x = (dx > 0) ? level->origin_x + (i32)size : origin_x;
+            ClipmapFetch(clipmap, index, column_x, origin_y, columns, size);
+
+            // Rows that scrolled into view, without the columns fetched above
+            u32 rows = (u32)abs(dy);
+            i32 row_y = (dy > 0) ? level->origin_y + (i32)size : origin_y;
+            i32 row_x = (dx > 0) ? origin_x : origin_x + (i32)columns;
+            ClipmapFetch(clipmap, index, row_x, row_y, size - columns, rows);
+        }
+
+        level->origin_x = origin_x;
+        level->origin_y = origin_y;
+        level->valid    = true;
+        stats->levels_updated += 1;
+    }
+
+}; // terrain
+
+bool terrain::ClipmapInit(TerrainClipmap *clipmap, TerrainClipmapDesc *desc)
+{
+    *clipmap = {};
+
+    if (desc->levels == 0 || desc->levels > CLIPMAP_MAX_LEVELS) return false;
+    if (desc->size < 9 || !IsPowerOfTwo(desc->size - 1)) return false;
+    if (!desc->source) return false;
+
+    clipmap->levels        = desc->levels;
+    clipmap->size          = desc->size;
+    clipmap->grid_spacing  = desc->grid_spacing;
+    clipmap->sample_budget = desc->sample_budget;
+    clipmap->source        = desc->source;
+    clipmap->user          = desc->user;
+    clipmap->finest_level  = desc->levels; // nothing to draw until the first update
+
+    u32 samples = desc->size * desc->size;
+    for (u32 i = 0; i < desc->levels; ++i)
+    {
+        clipmap->level[i].heights        = (r32*)SysAlloc(sizeof(r32) * samples);
+        clipmap->level[i].coarse_heights = (r32*)SysAlloc(sizeof(r32) * samples);
+    }
+    clipmap->scratch = (r32*)SysAlloc(sizeof(r32) * samples);
+
+    return true;
+}
+
+void terrain::ClipmapFree(TerrainClipmap *clipmap)
+{
+    for (u32 i = 0; i < clipmap->levels; ++i)
+    {
+        if (clipmap->level[i].heights)        SysFree(clipmap->level[i].heights);
+        if (clipmap->level[i].coarse_heights) SysFree(clipmap->level[i].coarse_heights);
+    }
+    if (clipmap->scratch) SysFree(clipmap->scratch);
+    arrfree(clipmap->dirty);
+    *clipmap = {};
+}
+
+void terrain::ClipmapUpdate(TerrainClipmap *clipmap, v3 camera, TerrainClipmapStats *stats)
+{
+    TerrainClipmapStats local_stats = {};
+    if (!stats) stats = &local_stats;
+    *stats = {};
+
+    arrsetlen(clipmap->dirty, 0);
+
+    // Coarse to fine: a level blends towards the level above it, and a finer level can only
+    // be drawn if every coarser level is in place around it.
+    clipmap->finest_level = 0;
+    for (u32 index = clipmap->levels; index-- > 0;)
+    {
+        ClipmapLevel *level = clipmap->level + index;
+
+        i32 origin_x, origin_y;
+        ClipmapTargetOrigin(clipmap, index, camera, &origin_x, &origin_y);
+        if (level->valid && level->origin_x == origin_x && level->origin_y == origin_y) continue;
+
+        u64 cost = ClipmapUpdateCost(clipmap, level, origin_x, origin_y);
+        if (clipmap->sample_budget > 0 && stats->samples_fetched > 0 &&
+            stats->samples_fetched + cost > clipmap->sample_budget)
+        {
+            // Out of budget, this level and the finer ones stay where they are and are
+            // caught up by later updates.
+            stats->levels_skipped = index + 1;
+            clipmap->finest_level = index + 1;
+            break;
+        }
+
+        ClipmapMoveLevel(clipmap, index, origin_x, origin_y, stats);
+        stats->samples_fetched += cost;
+    }
+}
+
+r32 terrain::ClipmapSample(TerrainClipmap *clipmap, u32 level, i32 x, i32 y)
+{
+    assert(level < clipmap->levels && clipmap->level[level].valid);
+    assert(x >= clipmap->level[level].origin_x && x < clipmap->level[level].origin_x + (i32)clipmap->size);
+    assert(y >= clipmap->level[level].origin_y && y < clipmap->level[level].origin_y + (i32)clipmap->size);
+    return ClipmapAt(clipmap, clipmap->level[level].heights, x, y);
+}
+
+void terrain::ClipmapLevelMeshDesc(TerrainClipmap *clipmap, u32 level, TerrainMeshDesc *desc)
+{
+    *desc = {};
+    desc->meshing_strategy = TerrainMeshType::Clipmap;
+    desc->width            = clipmap->size;
+    desc->height           = clipmap->size;
+    desc->tiling           = 1.0f;
+
+    if (level > clipmap->finest_level && level < clipmap->levels)
+    {
+        ClipmapLevel *coarse = clipmap->level + level;
+        ClipmapLevel *fine   = clipmap->level + level - 1;
+
+        desc->hole_x    = (u32)(fine->origin_x / 2 - coarse->origin_x);
+        desc->hole_y    = (u32)(fine->origin_y / 2 - coarse->origin_y);
+        desc->hole_size = (clipmap->size - 1) / 2;
+    }
+}
+
+void terrain::ClipmapSampleHeightmap(void *user, u32 level, i32 x, i32 y, u32 width, u32 height, r32 *dst)
+{
+    ClipmapHeightmapSource *source = (ClipmapHeightmapSource*)user;
+    i64 step = 1LL << level;
+    i64 max_x = (i64)source->width  - 1;
+    i64 max_y = (i64)source->height - 1;
+
+    for (u32 j = 0; j < height; ++j)
+    {
+        i64 sy = ((i64)y + j) * step;
+        sy = (sy < 0) ? 0 : (sy > max_y) ? max_y : sy;
+
+        const r32 *row = source->heightmap + sy * source->width;
+        for (u32 i = 0; i < width; ++i)
+        {
+            i64 sx = ((i64)x + i) * step;
+            sx = (sx < 0) ? 0 : (sx > max_x) ? max_x : sx;
+            dst[j * width + i] = row[sx];
+        }
+    }
+}
+
+#undef CLIPMAP_MAX_LEVELS
@@ -0,0 +1,115 @@
+#ifndef _TERRAIN_CLIPMAP_H
+#define _TERRAIN_CLIPMAP_H
+
+//
+// Geometry clipmaps. The terrain around the camera is drawn as nested square grids of
+// size x size vertices, where level L has a vertex spacing of grid_spacing * 2^L. Level 0
+// is drawn as a full grid, every other level as a ring around the level inside of it
+// (TerrainMeshType::Clipmap with the hole from ClipmapLevelMeshDesc).
+//
+// Each level keeps its heights in a size x size buffer addressed toroidally: sample (x, y)
+// lives at [y mod size][x mod size]. When the camera moves, a level only fetches the rows
+// and columns that scrolled into view and writes them over the ones that scrolled out, so
+// the work per frame depends on how far the camera moved, not on the size of the world.
+// sample_budget caps that work, levels that do not fit are skipped until a later update.
+//
+// Each level also keeps the heights of the next coarser level interpolated at its own
+// vertices. Blending towards those heights near the outer edge of a ring hides the
+// seams between levels.
+//
+// The heights are pulled from a PFN_ClipmapSource, so this runs headless against any CPU
+// heightmap (see ClipmapHeightmapSource) and the renderer only needs to upload the
+// dirty regions of the level buffers.
+//
+
+namespace terrain
+{
+    // Fills dst with the heights of the width x height samples starting at (x, y) of "level",
+    // row-major. Sample (x, y) of level L sits at world (x, y) * grid_spacing * 2^L.
+    typedef void (*PFN_ClipmapSource)(void *user, u32 level, i32 x, i32 y, u32 width, u32 height, r32 *dst);
+
+    struct TerrainClipmapDesc
+    {
+        u32 levels;              // nested grids, at most 16
+        u32 size;                // vertices on a side of a level, 2^n + 1 with n >= 3
+        r32 grid_spacing;        // world units between the vertices of level 0
+        u32 sample_budget;       // samples fetched per update, 0 for no limit
+
+        PFN_ClipmapSource source;
+        void             *user;  // passed to source
+    };
+
+    struct ClipmapLevel
+    {
+        r32 *heights;            // size * size, toroidal
+        r32 *coarse_heights;     // size * size, toroidal, heights of level + 1 at these samples
+        i32  origin_x;           // sample of the level at vertex (0, 0) of its grid
+        i32  origin_y;
+        bool valid;              // heights hold the samples at the origin
+    };
+
+    // Rectangle of a level buffer written by the last update, in buffer (wrapped) coordinates
+    struct ClipmapRegion
+    {
+        u32 level;
+        u32 x;
+        u32 y;
+        u32 width;
+        u32 height;
+    };
+
+    struct TerrainClipmap
+    {
+        u32 levels;
+        u32 size;
+        r32 grid_spacing;
+        u32 sample_budget;
+
+        PFN_ClipmapSource source;
+        void             *user;
+
+        ClipmapLevel   level[16];
+        u32            finest_level;  // finest level that is up to date, levels below it are not drawn
+        ClipmapRegion *dirty;         // stb_ds array, rebuilt by every ClipmapUpdate
+        r32           *scratch;       // size * size
+    };
+
+    struct TerrainClipmapStats
+    {
+        u32 levels_updated;
+        u32 levels_refreshed;    // levels that were fetched in full
+        u32 levels_skipped;      // levels that did not fit in the sample budget
+        u64 samples_fetched;
+    };
+
+    // Returns false if the size or level count is not supported
+    bool ClipmapInit(TerrainClipmap *clipmap, TerrainClipmapDesc *desc);
+    void ClipmapFree(TerrainClipmap *clipmap);
+
+    // Moves the levels to be centered on the camera and fetches the samples that came into view.
+    // The first level that needs work is always updated, even if it is over the sample budget.
+    // @param camera: world position, only x and z are used
+    // @param stats:  (output) optional
+    void ClipmapUpdate(TerrainClipmap *clipmap, v3 camera, TerrainClipmapStats *stats = NULL);
+
+    // Height of sample (x, y) of a level, the sample has to be inside the level
+    r32 ClipmapSample(TerrainClipmap *clipmap, u32 level, i32 x, i32 y);
+
+    // Mesh of a level: a full grid for the finest level, otherwise a ring around the hole
+    // covered by the next finer level.
+    void ClipmapLevelMeshDesc(TerrainClipmap *clipmap, u32 level, TerrainMeshDesc *desc);
+
+    // CPU heightmap source, level L takes every 2^L-th sample and clamps at the borders
+    struct ClipmapHeightmapSource
+    {
+        const r32 *heightmap;    // width x height samples, row-major
+        u32 width;
+        u32 height;
+    };
+
+    // PFN_ClipmapSource for a ClipmapHeightmapSource passed as "user"
+    void ClipmapSampleHeightmap(void *user, u32 level, i32 x, i32 y, u32 width, u32 height, r32 *dst);
+
+}; // terrain
+
+#endif //_TERRAIN_CLIPMAP_H
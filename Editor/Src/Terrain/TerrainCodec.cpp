@@ -0,0 +1,438 @@
+// NOTE(Dustin): Encoded layout
+//     u8  mode                  CodecMode
+//     raw:  u16 samples[width * height]
+//     rans: CodecHeader, rANS bytes (rans_size), extra bits (LSB first) up to the end
+//
+// rANS follows ryg_rans "rans_word": 32 bit states, renormalization by 16 bit words and 12
+// bit probabilities, so a decode step reads at most one word and renormalizes without a
+// branch. Sample k is coded with state k & 3. The encoder runs backwards, so the decoder
+// reads both the rANS words and the extra bits front to back.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CODEC_SSE2
+#endif
+
+#define CODEC_TOKENS    17          // bit length of a zigzagged residual, 0 - 16
+#define CODEC_PROB_BITS 12
+#define CODEC_PROB_ONE  (1u << CODEC_PROB_BITS)
+#define CODEC_STATES    4           // interleaved rANS states
+#define CODEC_RANS_L    (1u << 16)  // lower bound of a normalized rANS state
+
+namespace terrain
+{
+    enum CodecMode : u8
+    {
+        CodecMode_Raw,
+        CodecMode_Rans,
+    };
+
+    #pragma pack(push, 1)
+    struct CodecHeader
+    {
+        u8  mode;
+        u8  pad;
+        u16 freqs[CODEC_TOKENS];    // sum to CODEC_PROB_ONE
+        u32 rans_size;              // bytes, CODEC_STATES initial states then 16 bit words
+    };
+    #pragma pack(pop)
+
+    struct CodecBitWriter
+    {
+        u8  *ptr;
+        u64  acc;
+        u32  count;
+    };
+
+    struct CodecBitReader
+    {
+        const u8 *ptr;
+        const u8 *end;
+        u64       acc;
+        u32       count;
+        u32       padding;       // zero bits appended past the end
+    };
+
+    FORCE_INLINE u32
+    CodecTokenOf(u16 z)
+    {
+        return (z == 0) ? 0 : 32 - PlatformClz((u32)z);
+    }
+
+    FORCE_INLINE u16
+    CodecZigzag(u16 r)
+    {
+        return (u16)(((u32)r << 1) ^ (u32)(i32)((i16)r >> 15));
+    }
+
+    FORCE_INLINE u16
+    CodecUnzigzag(u32 z)
+    {
+        return (u16)((z >> 1) ^ (0u - (z & 1)));
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // Bits
+
+    FORCE_INLINE void
+    CodecPutBits(CodecBitWriter *writer, u32 value, u32 bits)
+    {
+        writer->acc |= (u64)value << writer->count;
+        writer->count += bits;
+        while (writer->count >= 8)
+        {
+            *writer->ptr++ = (u8)writer->acc;
+            writer->acc >>= 8;
+            writer->count -= 8;
+        }
+    }
+
+    FORCE_INLINE void
+    CodecFlushBits(CodecBitWriter *writer)
+    {
+        if (writer->count > 0) *writer->ptr++ = (u8)writer->acc;
+        writer->acc   = 0;
+        writer->count = 0;
+    }
+
+    // Fills the reader up to at least 56 bits, past the end it reads zeros
+    FORCE_INLINE void
+    CodecRefill(CodecBitReader *reader)
+    {
+        if (reader->end - reader->ptr >= 8)
+        {
+            u64 bytes;
+            memcpy(&bytes, reader->ptr, sizeof(u64));
+            reader->acc |= bytes << reader->count;
+            reader->ptr += (63 - reader->count) >> 3;
+            reader->count |= 56;
+        }
+        else
+        {
+            while (reader->count <= 56)
+            {
+                u64 byte = 0;
+                if (reader->ptr < reader->end) byte = *reader->ptr++;
+                else reader->padding += 8;
+
+                reader->acc |= byte << reader->count;
+                reader->count += 8;
+            }
+        }
+    }
+
+    // The reader has to hold at least "bits" bits
+    FORCE_INLINE u32
+    CodecGetBits(CodecBitReader *reader, u32 bits)
+    {
+        u32 result = (u32)reader->acc & ((1u << bits) - 1);
+        reader->acc >>= bits;
+        reader->count -= bits;
+        return result;
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // rANS
+
+    FORCE_INLINE u16
+    CodecLoad16(const u8 *ptr)
+    {
+        u16 result;
+        memcpy(&result, ptr, sizeof(u16));
+        return result;
+    }
+
+    FORCE_INLINE void
+    CodecRansPut(u32 *state, u16 **ptr, u32 start, u32 freq)
+    {
+        u32 x = *state;
+        // 64 bit, a frequency of CODEC_PROB_ONE would overflow
+        u64 x_max = ((u64)(CODEC_RANS_L >> CODEC_PROB_BITS) << 16) * freq;
+        if (x >= x_max)
+        {
+            *--(*ptr) = (u16)(x & 0xFFFF);
+            x >>= 16;
+        }
+        *state = ((x / freq) << CODEC_PROB_BITS) + (x % freq) + start;
+    }
+
+    FORCE_INLINE void
+    CodecRansFlush(u32 state, u16 **ptr)
+    {
+        *ptr -= 2;
+        (*ptr)[0] = (u16)(state >>  0);
+        (*ptr)[1] = (u16)(state >> 16);
+    }
+
+    // Scales the token counts to sum to CODEC_PROB_ONE, every token that occurs keeps a frequency
+    file_internal void
+    CodecNormalize(const u32 *counts, u32 total, u16 *freqs)
+    {
+        u32 sum = 0;
+        u32 largest = 0;
+        for (u32 t = 0; t < CODEC_TOKENS; ++t)
+        {
+            u32 freq = 0;
+            if (counts[t] > 0)
+            {
+                freq = (u32)(((u64)counts[t] * CODEC_PROB_ONE) / total);
+                if (freq == 0) freq = 1;
+            }
+            freqs[t] = (u16)freq;
+            sum += freq;
+            if (counts[t] > counts[largest]) largest = t;
+        }
+        // The most common token is at least 1/17th of the samples, so it can absorb the rounding
+        freqs[largest] = (u16)(freqs[largest] + CODEC_PROB_ONE - sum);
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // Prediction
+
+    // Plane predictor residuals, see the header
+    file_internal void
+    CodecResiduals(const u16 *samples, u32 width, u32 height, u16 *residuals)
+    {
+        for (u32 r = 0; r < height; ++r)
+        {
+            const u16 *row = samples + r * width;
+            const u16 *up  = row - width;
+            u16 *dst = residuals + r * width;
+
+            if (r == 0)
+            {
+                dst[0] = row[0];
+                for (u32 c = 1; c < width; ++c) dst[c] = (u16)(row[c] - row[c - 1]);
+            }
+            else
+            {
+                dst[0] = (u16)(row[0] - up[0]);
+                for (u32 c = 1; c < width; ++c) dst[c] = (u16)(row[c] - row[c - 1] - up[c] + up[c - 1]);
+            }
+        }
+    }
+
+    // row[i] = up[i] + row[0] + ... + row[i], up may be NULL for the first row
+    file_internal void
+    CodecReconstructRow(u16 *row, const u16 *up, u32 width)
+    {
+        u32 c = 0;
+        u16 carry = 0;
+
+#if defined(CODEC_SSE2)
+        __m128i sum = _mm_setzero_si128();
+        for (; c + 8 <= width; c += 8)
+        {
+            __m128i v = _mm_loadu_si128((__m128i*)(row + c));
+            v = _mm_add_epi16(v, _mm_slli_si128(v, 2));
+            v = _mm_add_epi16(v, _mm_slli_si128(v, 4));
+            v = _mm_add_epi16(v, _mm_slli_si128(v, 8));
+            v = _mm_add_epi16(v, sum);
+
+            // Broadcast the last lane as the carry into the next 8 samples
+            sum = _mm_shufflehi_epi16(v, _MM_SHUFFLE(3, 3, 3, 3));
+            sum = _mm_unpackhi_epi64(sum, sum);
+
+            if (up) v = _mm_add_epi16(v, _mm_loadu_si128((__m128i*)(up + c)));
+            _mm_storeu_si128((__m128i*)(row + c), v);
+        }
+        carry = (u16)_mm_cvtsi128_si32(sum);
+#endif
+
+        for (; c < width; ++c)
+        {
+            carry = (u16)(carry + row[c]);
+            row[c] = up ? (u16)(carry + up[c]) : carry;
+        }
+    }
+
+}; // terrain
+
+u32 terrain::HeightCodecBound(u32 width, u32 height)
+{
+    return 4 + sizeof(u16) * width * height;
+}
+
+u32 terrain::HeightCodecEncode(const u16 *samples, u32 width, u32 height, u8 *dst)
+{
+    u32 count = width * height;
+    u32 raw_size = HeightCodecBound(width, height);
+
+    u16 *residuals = (u16*)SysAlloc(sizeof(u16) * count);
+    CodecResiduals(samples, width, height, residuals);
+
+    u32 counts[CODEC_TOKENS] = {};
+    for (u32 i = 0; i < count; ++i)
+    {
+        residuals[i] = CodecZigzag(residuals[i]);
+        counts[CodecTokenOf(residuals[i])] += 1;
+    }
+
+    CodecHeader header = {};
+    header.mode = CodecMode_Rans;
+    CodecNormalize(counts, count, header.freqs);
+
+    u32 starts[CODEC_TOKENS];
+    starts[0] = 0;
+    for (u32 t = 1; t < CODEC_TOKENS; ++t) starts[t] = starts[t - 1] + header.freqs[t - 1];
+
+    // rANS emits at most one word per token, and the extra bits are at most 15 per sample
+    u32 rans_capacity = count + 2 * CODEC_STATES;
+    u8 *scratch = (u8*)SysAlloc(sizeof(u16) * rans_capacity + 2 * count + 8);
+
+    u16 *rans_end = (u16*)scratch + rans_capacity;
+    u16 *rans_ptr = rans_end;
+    u32 states[CODEC_STATES];
+    for (u32 s = 0; s < CODEC_STATES; ++s) states[s] = CODEC_RANS_L;
+
+    for (u32 i = count; i-- > 0;)
+    {
+        u32 token = CodecTokenOf(residuals[i]);
+        CodecRansPut(&states[i % CODEC_STATES], &rans_ptr, starts[token], header.freqs[token]);
+    }
+    for (u32 s = CODEC_STATES; s-- > 0;) CodecRansFlush(states[s], &rans_ptr);
+    header.rans_size = (u32)(sizeof(u16) * (rans_end - rans_ptr));
+
+    CodecBitWriter bits = {};
+    bits.ptr = (u8*)rans_end;
+    for (u32 i = 0; i < count; ++i)
+    {
+        u32 token = CodecTokenOf(residuals[i]);
+        if (token >= 2) CodecPutBits(&bits, residuals[i] & ((1u << (token - 1)) - 1), token - 1);
+    }
+    CodecFlushBits(&bits);
+    u32 bits_size = (u32)(bits.ptr - (u8*)rans_end);
+
+    u32 result = sizeof(CodecHeader) + header.rans_size + bits_size;
+    if (result < raw_size)
+    {
+        memcpy(dst, &header, sizeof(CodecHeader));
+        memcpy(dst + sizeof(CodecHeader), rans_ptr, header.rans_size + bits_size);
+    }
+    else
+    {
+        // Noise does not compress, store it as it is
+        result = raw_size;
+        dst[0] = CodecMode_Raw;
+        dst[1] = dst[2] = dst[3] = 0;
+        memcpy(dst + 4, samples, sizeof(u16) * count);
+    }
+
+    SysFree(scratch);
+    SysFree(residuals);
+    return result;
+}
+
+bool terrain::HeightCodecDecode(const u8 *src, u32 size, u32 width, u32 height, u16 *dst)
+{
+    u32 count = width * height;
+    if (size < 4 || count == 0) return false;
+
+    if (src[0] == CodecMode_Raw)
+    {
+        if (size != HeightCodecBound(width, height)) return false;
+        memcpy(dst, src + 4, sizeof(u16) * count);
+        return true;
+    }
+
+    CodecHeader header;
+    if (src[0] != CodecMode_Rans || size < sizeof(CodecHeader)) return false;
+    memcpy(&header, src, sizeof(CodecHeader));
+    if (header.rans_size < 4 * CODEC_STATES || header.rans_size % 2 != 0 ||
+        header.rans_size > size - sizeof(CodecHeader)) return false;
+
+    // Per slot: freq (13 bits), slot - start (12 bits) and the token (5 bits)
+    u32 table[CODEC_PROB_ONE];
+    u32 start = 0;
+    for (u32 t = 0; t < CODEC_TOKENS; ++t)
+    {
+        u32 freq = header.freqs[t];
+        if (start + freq > CODEC_PROB_ONE) return false;
+        for (u32 i = 0; i < freq; ++i) table[start + i] = freq | (i << 13) | (t << 25);
+        start += freq;
+    }
+    if (start != CODEC_PROB_ONE) return false;
+
+    // Pass 1: tokens. They are stored in the upper half of dst, which pass 2 only overwrites
+    // after it has read them (sample k is written to bytes [2k, 2k + 2) after token k is read
+    // from byte count + k).
+    u8 *tokens = (u8*)dst + count;
+
+    const u8 *ptr = src + sizeof(CodecHeader);
+    const u8 *end = ptr + header.rans_size;
+
+    u32 x[CODEC_STATES];
+    for (u32 s = 0; s < CODEC_STATES; ++s)
+    {
+        x[s] = (u32)CodecLoad16(ptr) | ((u32)CodecLoad16(ptr + 2) << 16);
+        ptr += 4;
+    }
+
+    // "word" is read even if the state does not need it, so there is no branch on the state
+    #define CODEC_RANS_GET(x, out, word)                                     \
+    {                                                                        \
+        u32 entry = table[x & (CODEC_PROB_ONE - 1)];                         \
+        x = (entry & 0x1FFF) * (x >> CODEC_PROB_BITS) + ((entry >> 13) & 0xFFF); \
+        bool renormalize = x < CODEC_RANS_L;                                 \
+        x = renormalize ? (x << 16) | (word) : x;                            \
+        ptr += renormalize ? 2 : 0;                                          \
+        out = (u8)(entry >> 25);                                             \
+    }
+
+    u32 x0 = x[0], x1 = x[1], x2 = x[2], x3 = x[3];
+    u32 i = 0;
+    // Four tokens read at most four words
+    for (; i + CODEC_STATES <= count && end - ptr >= 8; i += CODEC_STATES)
+    {
+        CODEC_RANS_GET(x0, tokens[i + 0], CodecLoad16(ptr));
+        CODEC_RANS_GET(x1, tokens[i + 1], CodecLoad16(ptr));
+        CODEC_RANS_GET(x2, tokens[i + 2], CodecLoad16(ptr));
+        CODEC_RANS_GET(x3, tokens[i + 3], CodecLoad16(ptr));
+    }
+    // Close to the end of the words, past it a renormalization reads 0 and the stream fails
+    // the final check
+    for (; i < count; ++i)
+    {
+        u32 *state = (i % CODEC_STATES == 0) ? &x0 : (i % CODEC_STATES == 1) ? &x1 : (i % CODEC_STATES == 2) ? &x2 : &x3;
+        CODEC_RANS_GET(*state, tokens[i], (ptr < end) ? CodecLoad16(ptr) : 0);
+    }
+
+    #undef CODEC_RANS_GET
+
+    if (ptr != end) return false;
+
+    // Pass 2: residuals, then rows
+    CodecBitReader bits = {};
+    bits.ptr = end;
+    bits.end = src + size;
+
+    for (u32 r = 0; r < height; ++r)
+    {
+        u16 *row = dst + r * width;
+        const u8 *row_tokens = tokens + r * width;
+
+        for (u32 c = 0; c < width; ++c)
+        {
+            u32 token = row_tokens[c];
+            u32 extra = (token < 2) ? 0 : token - 1;
+
+            if (bits.count < 16) CodecRefill(&bits);
+            u32 low = CodecGetBits(&bits, extra);
+
+            u32 z = (token < 2) ? token : (1u << extra) | low;
+            row[c] = CodecUnzigzag(z);
+        }
+
+        CodecReconstructRow(row, (r > 0) ? row - width : NULL, width);
+    }
+
+    // Zero bits past the end were read
+    return bits.count >= bits.padding;
+}
+
+#undef CODEC_RANS_L
+#undef CODEC_STATES
+#undef CODEC_PROB_ONE
+#undef CODEC_PROB_BITS
+#undef CODEC_TOKENS
+#undef CODEC_SSE2
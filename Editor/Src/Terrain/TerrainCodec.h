@@ -0,0 +1,32 @@
+#ifndef _TERRAIN_CODEC_H
+#define _TERRAIN_CODEC_H
+
+//
+// Lossless codec for 16-bit heightmaps (the quantized tiles of a terrain file).
+//
+// Every sample is predicted from its neighbours with the plane predictor
+// left + up - up_left, which is exact on any slope, and only the residual is stored.
+// Residuals are split into a bit length token, coded with rANS using a frequency table
+// per heightmap, and the bits below the leading one, stored as they are.
+//
+// With the plane predictor a row decodes as "row above + running sum of the residuals",
+// so reconstruction is a prefix sum, done 8 samples at a time with SSE2. Four interleaved
+// rANS states hide the latency of the entropy decoder.
+//
+
+namespace terrain
+{
+    // Largest encoded size of a width x height heightmap. Never more than 4 bytes over raw storage.
+    u32 HeightCodecBound(u32 width, u32 height);
+
+    // @param dst: at least HeightCodecBound(width, height) bytes
+    // Returns the encoded size
+    u32 HeightCodecEncode(const u16 *samples, u32 width, u32 height, u8 *dst);
+
+    // @param dst: width x height samples
+    // Returns false if "src" is not a valid encoding of a width x height heightmap
+    bool HeightCodecDecode(const u8 *src, u32 size, u32 width, u32 height, u16 *dst);
+
+}; // terrain
+
+#endif //_TERRAIN_CODEC_H
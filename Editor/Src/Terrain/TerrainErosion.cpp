@@ -0,0 +1,649 @@
+
+// NOTE(Dustin): The droplet model is the one from Hans Theobald Beyer, "Implementation of a method
+// for hydraulic erosion" (2015). The height and gradient under a droplet are interpolated
+// bilinearly, sediment is deposited on the 4 samples around the droplet and picked up with a
+// brush of "radius" samples, so single samples do not turn into pits.
+//
+// A tile simulates the droplets spawned within the reach of its samples (max_lifetime + radius),
+// in the order of their spawn blocks, on a copy of its window. The window extends twice the reach
+// past the tile, so the droplets of the neighbours see the same terrain they start on. Every tile
+// reads the heightmap as it was before the erosion, which is what makes the result independent of
+// the order the tiles run in.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define EROSION_SSE2
+#endif
+
+#define EROSION_SPAWN_BLOCK           16     // droplets are spawned per block of 16x16 samples
+#define EROSION_MAX_RADIUS            8
+#define EROSION_BRUSH_SIZE            ((2 * EROSION_MAX_RADIUS + 1) * (2 * EROSION_MAX_RADIUS + 1))
+#define EROSION_ROWS_PER_JOB_SAMPLES  16384  // rough number of samples each thermal job updates
+
+namespace terrain
+{
+    struct ErosionBrush
+    {
+        u32 count;
+        i32 radius;
+        i32 dx[EROSION_BRUSH_SIZE];
+        i32 dy[EROSION_BRUSH_SIZE];
+        r32 weight[EROSION_BRUSH_SIZE];
+    };
+
+    struct HydraulicJob
+    {
+        HydraulicErosionDesc *desc;
+        const r32            *src;        // heightmap before the erosion
+        r32                  *dst;
+        u32                   width;
+        u32                   height;
+        u32                   tiles_x;
+        ErosionStats         *tile_stats; // per tile
+    };
+
+    struct ThermalJob
+    {
+        const r32 *heights;               // previous iteration
+        r32       *scale;                 // per sample, fraction of each excess that moves out
+        r32       *result;                // next iteration
+        u32        width;
+        u32        height;
+        r32        rate;
+        r32        talus[8];              // per neighbour
+    };
+
+    // Neighbours, in the order of ThermalJob::talus
+    static const i32 g_thermal_dx[8] = { -1, 0, 1, -1, 1, -1, 0, 1 };
+    static const i32 g_thermal_dy[8] = { -1, -1, -1, 0, 0, 1, 1, 1 };
+
+    // lowbias32 by Chris Wellons
+    FORCE_INLINE u32
+    ErosionHash(u32 x)
+    {
+        x ^= x >> 16;
+        x *= 0x7FEB352D;
+        x ^= x >> 15;
+        x *= 0x846CA68B;
+        x ^= x >> 16;
+        return x;
+    }
+
+    // [0, 1)
+    FORCE_INLINE r32
+    ErosionRandom(u32 key, u32 n)
+    {
+        return (r32)(ErosionHash(key + n) >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Samples from where a droplet can still change a sample
+    FORCE_INLINE u32
+    HydraulicReach(HydraulicErosionDesc *desc)
+    {
+        return desc->max_lifetime + desc->radius + 1;
+    }
+
+    file_internal void
+    BuildErosionBrush(ErosionBrush *brush, u32 radius)
+    {
+        i32 r = (i32)((radius < EROSION_MAX_RADIUS) ? radius : EROSION_MAX_RADIUS);
+        brush->count  = 0;
+        brush->radius = r;
+
+        r32 sum = 0.0f;
+        for (i32 dy = -r; dy <= r; ++dy)
+        {
+            for (i32 dx = -r; dx <= r; ++dx)
+            {
+                r32 weight = (r32)r - sqrtf((r32)(dx * dx + dy * dy));
+                // A radius of 0 erodes the sample under the droplet only
+                if (r == 0) weight = 1.0f;
+                if (weight <= 0.0f) continue;
+
+                brush->dx[brush->count]     = dx;
+                brush->dy[brush->count]     = dy;
+                brush->weight[brush->count] = weight;
+                brush->count++;
+                sum += weight;
+            }
+        }
+
+        for (u32 i = 0; i < brush->count; ++i) brush->weight[i] /= sum;
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // Hydraulic
+
+    // Bilinear height and gradient at (x, y), which must be inside the last row and column
+    FORCE_INLINE r32
+    HeightAndGradient(const r32 *map, u32 width, r32 x, r32 y, r32 *gradient_x, r32 *gradient_y)
+    {
+        u32 node_x = (u32)x;
+        u32 node_y = (u32)y;
+        r32 u = x - (r32)node_x;
+        r32 v = y - (r32)node_y;
+
+        const r32 *node = map + (u64)node_y * width + node_x;
+        r32 h00 = node[0];
+        r32 h10 = node[1];
+        r32 h01 = node[width];
+        r32 h11 = node[width + 1];
+
+        *gradient_x = (h10 - h00) * (1.0f - v) + (h11 - h01) * v;
+        *gradient_y = (h01 - h00) * (1.0f - u) + (h11 - h10) * u;
+        return h00 * (1.0f - u) * (1.0f - v) + h10 * u * (1.0f - v) + h01 * (1.0f - u) * v + h11 * u * v;
+    }
+
+    // Runs a droplet from (x, y) until it evaporates or leaves the map
+    file_internal void
+    SimulateDroplet(HydraulicErosionDesc *desc, ErosionBrush *brush, r32 *map, u32 width, u32 height, r32 x, r32 y)
+    {
+        // The map writes could alias the parameters, keep them in registers
+        u32 max_lifetime          = desc->max_lifetime;
+        r32 inertia               = desc->inertia;
+        r32 sediment_capacity     = desc->sediment_capacity;
+        r32 min_sediment_capacity = desc->min_sediment_capacity;
+        r32 erode_speed           = desc->erode_speed;
+        r32 deposit_speed         = desc->deposit_speed;
+        r32 evaporation           = 1.0f - desc->evaporate_speed;
+        r32 gravity               = desc->gravity;
+
+        r32 dir_x    = 0.0f;
+        r32 dir_y    = 0.0f;
+        r32 speed    = desc->initial_speed;
+        r32 water    = desc->initial_water;
+        r32 sediment = 0.0f;
+
+        r32 max_x = (r32)(width  - 1);
+        r32 max_y = (r32)(height - 1);
+        u32 r     = (u32)brush->radius;
+
+        for (u32 step = 0; step < max_lifetime; ++step)
+        {
+            u32 node_x = (u32)x;
+            u32 node_y = (u32)y;
+            r32 u = x - (r32)node_x;
+            r32 v = y - (r32)node_y;
+
+            r32 gradient_x, gradient_y;
+            r32 h = HeightAndGradient(map, width, x, y, &gradient_x, &gradient_y);
+
+            dir_x = dir_x * inertia - gradient_x * (1.0f - inertia);
+            dir_y = dir_y * inertia - gradient_y * (1.0f - inertia);
+            r32 len = sqrtf(dir_x * dir_x + dir_y * dir_y);
+            // Stuck in a pit or on flat ground
+            if (len == 0.0f) break;
+            r32 inv_len = 1.0f / len;
+            dir_x *= inv_len;
+            dir_y *= inv_len;
+
+            x += dir_x;
+            y += dir_y;
+            if (x < 0.0f || x >= max_x || y < 0.0f || y >= max_y) break;
+
+            r32 unused_x, unused_y;
+            r32 delta = HeightAndGradient(map, width, x, y, &unused_x, &unused_y) - h;
+
+            r32 capacity = -delta * speed * water * sediment_capacity;
+            if (capacity < min_sediment_capacity) capacity = min_sediment_capacity;
+
+            r32 *node = map + (u64)node_y * width + node_x;
+            if (sediment > capacity || delta > 0.0f)
+            {
+                // Uphill, fill the pit behind the droplet at most, otherwise drop the excess
+                r32 deposit = (delta > 0.0f) ? ((delta < sediment) ? delta : sediment)
+                                             : (sediment - capacity) * deposit_speed;
+                sediment -= deposit;
+
+                node[0]         += deposit * (1.0f - u) * (1.0f - v);
+                node[1]         += deposit * u * (1.0f - v);
+                node[width]     += deposit * (1.0f - u) * v;
+                node[width + 1] += deposit * u * v;
+            }
+            else
+            {
+                // Never erode more than the height drop, that would dig a pit behind the droplet
+                r32 erode = (capacity - sediment) * erode_speed;
+                if (erode > -delta) erode = -delta;
+
+                bool clipped = node_x < r || node_y < r || node_x + r >= width || node_y + r >= height;
+                for (u32 i = 0; i < brush->count; ++i)
+                {
+                    i32 sx = (i32)node_x + brush->dx[i];
+                    i32 sy = (i32)node_y + brush->dy[i];
+                    if (clipped && (sx < 0 || sy < 0 || sx >= (i32)width || sy >= (i32)height)) continue;
+
+                    r32 *sample = map + (i64)sy * width + sx;
+                    r32 amount  = erode * brush->weight[i];
+                    // Heights do not go under 0
+                    if (*sample < amount) amount = *sample;
+                    *sample  -= amount;
+                    sediment += amount;
+                }
+            }
+
+            r32 speed_sq = speed * speed + delta * gravity;
+            speed  = (speed_sq > 0.0f) ? sqrtf(speed_sq) : 0.0f;
+            water *= evaporation;
+        }
+    }
+
+    // Erodes "chunk" with the window around it. src and dst point at the first sample of the
+    // window and of the chunk.
+    file_internal void
+    ErodeHydraulicRect(HydraulicErosionDesc *desc, const r32 *src, u32 src_stride, ErosionRect *window,
+                       ErosionRect *chunk, r32 *dst, u32 dst_stride, ErosionStats *stats)
+    {
+        assert(chunk->x >= window->x && chunk->x + chunk->width  <= window->x + window->width &&
+               chunk->y >= window->y && chunk->y + chunk->height <= window->y + window->height &&
+               "The erosion window has to contain the chunk");
+
+        u32 width  = window->width;
+        u32 height = window->height;
+
+        r32 *map = (r32*)SysAlloc(sizeof(r32) * width * height);
+        for (u32 y = 0; y < height; ++y)
+        {
+            memcpy(map + (u64)y * width, src + (u64)y * src_stride, sizeof(r32) * width);
+        }
+
+        ErosionStats result = {};
+        if (width > 1 && height > 1)
+        {
+            ErosionBrush brush;
+            BuildErosionBrush(&brush, desc->radius);
+
+            // Droplets start within the reach of the chunk, in window coordinates. Their
+            // position has to be inside the last row and column of the window.
+            i32 reach = (i32)HydraulicReach(desc);
+            i32 chunk_x0 = (i32)(chunk->x - window->x);
+            i32 chunk_y0 = (i32)(chunk->y - window->y);
+            i32 chunk_x1 = chunk_x0 + (i32)chunk->width;
+            i32 chunk_y1 = chunk_y0 + (i32)chunk->height;
+
+            i32 spawn_x0 = (chunk_x0 - reach > 0) ? chunk_x0 - reach : 0;
+            i32 spawn_y0 = (chunk_y0 - reach > 0) ? chunk_y0 - reach : 0;
+            i32 spawn_x1 = (chunk_x1 + reach < (i32)width  - 1) ? chunk_x1 + reach : (i32)width  - 1;
+            i32 spawn_y1 = (chunk_y1 + reach < (i32)height - 1) ? chunk_y1 + reach : (i32)height - 1;
+
+            // Spawn blocks are laid out on the heightmap, not the window
+            u32 block_x0 = (window->x + spawn_x0) / EROSION_SPAWN_BLOCK;
+            u32 block_y0 = (window->y + spawn_y0) / EROSION_SPAWN_BLOCK;
+            u32 block_x1 = (window->x + spawn_x1 - 1) / EROSION_SPAWN_BLOCK;
+            u32 block_y1 = (window->y + spawn_y1 - 1) / EROSION_SPAWN_BLOCK;
+
+            u32 per_block = (u32)(desc->droplets_per_sample * (EROSION_SPAWN_BLOCK * EROSION_SPAWN_BLOCK) + 0.5f);
+            u32 seed_key  = ErosionHash(desc->seed);
+
+            for (u32 block_y = block_y0; block_y <= block_y1; ++block_y)
+            {
+                for (u32 block_x = block_x0; block_x <= block_x1; ++block_x)
+                {
+                    u32 key = ErosionHash(ErosionHash(seed_key ^ block_x) ^ block_y);
+                    r32 base_x = (r32)((i32)(block_x * EROSION_SPAWN_BLOCK) - (i32)window->x);
+                    r32 base_y = (r32)((i32)(block_y * EROSION_SPAWN_BLOCK) - (i32)window->y);
+
+                    for (u32 i = 0; i < per_block; ++i)
+                    {
+                        r32 x = base_x + ErosionRandom(key, 2 * i + 0) * EROSION_SPAWN_BLOCK;
+                        r32 y = base_y + ErosionRandom(key, 2 * i + 1) * EROSION_SPAWN_BLOCK;
+                        if (x < (r32)spawn_x0 || x >= (r32)spawn_x1 || y < (r32)spawn_y0 || y >= (r32)spawn_y1) continue;
+
+                        result.droplets_simulated++;
+                        if (x >= (r32)chunk_x0 && x < (r32)chunk_x1 && y >= (r32)chunk_y0 && y < (r32)chunk_y1)
+                        {
+                            result.droplets++;
+                        }
+
+                        SimulateDroplet(desc, &brush, map, width, height, x, y);
+                    }
+                }
+            }
+        }
+
+        const r32 *eroded = map + (u64)(chunk->y - window->y) * width + (chunk->x - window->x);
+        for (u32 y = 0; y < chunk->height; ++y)
+        {
+            memcpy(dst + (u64)y * dst_stride, eroded + (u64)y * width, sizeof(r32) * chunk->width);
+        }
+
+        SysFree(map);
+        if (stats) *stats = result;
+    }
+
+    // Job callback, erodes tiles [begin, end)
+    file_internal void
+    ErodeHydraulicTiles(u32 begin, u32 end, void *args)
+    {
+        HydraulicJob *job = (HydraulicJob*)args;
+        u32 tile_size = job->desc->tile_size;
+        u32 halo      = GetHydraulicErosionHalo(job->desc);
+
+        for (u32 tile = begin; tile < end; ++tile)
+        {
+            ErosionRect chunk;
+            chunk.x      = (tile % job->tiles_x) * tile_size;
+            chunk.y      = (tile / job->tiles_x) * tile_size;
+            chunk.width  = (job->width  - chunk.x < tile_size) ? job->width  - chunk.x : tile_size;
+            chunk.height = (job->height - chunk.y < tile_size) ? job->height - chunk.y : tile_size;
+
+            ErosionRect window;
+            window.x      = (chunk.x > halo) ? chunk.x - halo : 0;
+            window.y      = (chunk.y > halo) ? chunk.y - halo : 0;
+            window.width  = ((job->width  - chunk.x - chunk.width  > halo) ? chunk.x + chunk.width  + halo : job->width)  - window.x;
+            window.height = ((job->height - chunk.y - chunk.height > halo) ? chunk.y + chunk.height + halo : job->height) - window.y;
+
+            ErodeHydraulicRect(job->desc, job->src + (u64)window.y * job->width + window.x, job->width, &window,
+                               &chunk, job->dst + (u64)chunk.y * job->width + chunk.x, job->width,
+                               &job->tile_stats[tile]);
+        }
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // Thermal
+
+    // Fraction of the excess of each lower neighbour that moves out of (x, y), so the sample
+    // loses rate * (largest excess) in total. Skips the neighbours outside of the map.
+    file_internal r32
+    ThermalScaleAt(ThermalJob *job, u32 x, u32 y)
+    {
+        const r32 *sample = job->heights + (u64)y * job->width + x;
+        r32 h = *sample;
+
+        r32 max_excess = 0.0f;
+        r32 sum_excess = 0.0f;
+        for (u32 k = 0; k < 8; ++k)
+        {
+            i32 nx = (i32)x + g_thermal_dx[k];
+            i32 ny = (i32)y + g_thermal_dy[k];
+            if (nx < 0 || nx >= (i32)job->width || ny < 0 || ny >= (i32)job->height) continue;
+
+            r32 excess = (h - sample[g_thermal_dy[k] * (i64)job->width + g_thermal_dx[k]]) - job->talus[k];
+            excess      = (excess > 0.0f) ? excess : 0.0f;
+            sum_excess += excess;
+            max_excess  = (excess > max_excess) ? excess : max_excess;
+        }
+
+        return (sum_excess > 0.0f) ? job->rate * max_excess / sum_excess : 0.0f;
+    }
+
+    // Height of (x, y) after the material moved out to its lower neighbours and in from its
+    // higher ones. Each flow is evaluated the same way on both sides, so no material is lost.
+    file_internal r32
+    ThermalFlowAt(ThermalJob *job, u32 x, u32 y)
+    {
+        u64 index = (u64)y * job->width + x;
+        const r32 *sample = job->heights + index;
+        const r32 *scale  = job->scale + index;
+        r32 h = *sample;
+
+        r32 out_excess = 0.0f;
+        r32 in_flow    = 0.0f;
+        for (u32 k = 0; k < 8; ++k)
+        {
+            i32 nx = (i32)x + g_thermal_dx[k];
+            i32 ny = (i32)y + g_thermal_dy[k];
+            if (nx < 0 || nx >= (i32)job->width || ny < 0 || ny >= (i32)job->height) continue;
+
+            i64 offset = g_thermal_dy[k] * (i64)job->width + g_thermal_dx[k];
+            r32 out = (h - sample[offset]) - job->talus[k];
+            r32 in  = (sample[offset] - h) - job->talus[k];
+            out_excess += (out > 0.0f) ? out : 0.0f;
+            in_flow    += scale[offset] * ((in > 0.0f) ? in : 0.0f);
+        }
+
+        return h - *scale * out_excess + in_flow;
+    }
+
+    // NOTE(Dustin): The interior of a row runs 4 samples at a time. The SIMD path adds the
+    // neighbours in the same order as ThermalScaleAt/ThermalFlowAt, and a neighbour without
+    // excess adds exactly 0, so both give the same bits and the result does not depend on
+    // where a sample falls in a row.
+
+    // Interior samples [1, width - 1) of row y, which must not be the first or last row.
+    // Returns the first sample left to the scalar path.
+    file_internal u32
+    ThermalScaleInterior(ThermalJob *job, u32 y)
+    {
+        u32 x = 1;
+#if defined(EROSION_SSE2)
+        u32 width = job->width;
+        const r32 *rows[3] = {
+            job->heights + (u64)(y - 1) * width,
+            job->heights + (u64)y * width,
+            job->heights + (u64)(y + 1) * width,
+        };
+        r32 *dst = job->scale + (u64)y * width;
+
+        __m128 zero = _mm_setzero_ps();
+        __m128 rate = _mm_set1_ps(job->rate);
+        __m128 talus[8];
+        for (u32 k = 0; k < 8; ++k) talus[k] = _mm_set1_ps(job->talus[k]);
+
+        for (; x + 4 <= width - 1; x += 4)
+        {
+            __m128 h = _mm_loadu_ps(rows[1] + x);
+
+            __m128 max_excess = zero;
+            __m128 sum_excess = zero;
+            for (u32 k = 0; k < 8; ++k)
+            {
+                __m128 n      = _mm_loadu_ps(rows[1 + g_thermal_dy[k]] + x + g_thermal_dx[k]);
+                __m128 excess = _mm_max_ps(_mm_sub_ps(_mm_sub_ps(h, n), talus[k]), zero);
+                sum_excess = _mm_add_ps(sum_excess, excess);
+                max_excess = _mm_max_ps(max_excess, excess);
+            }
+
+            // 0 / 0 lanes are masked out
+            __m128 scale = _mm_div_ps(_mm_mul_ps(rate, max_excess), sum_excess);
+            _mm_storeu_ps(dst + x, _mm_and_ps(scale, _mm_cmpgt_ps(sum_excess, zero)));
+        }
+#endif
+        return x;
+    }
+
+    // Same as ThermalScaleInterior, for the next iteration
+    file_internal u32
+    ThermalFlowInterior(ThermalJob *job, u32 y)
+    {
+        u32 x = 1;
+#if defined(EROSION_SSE2)
+        u32 width = job->width;
+        u64 row   = (u64)y * width;
+        const r32 *rows[3]   = { job->heights + row - width, job->heights + row, job->heights + row + width };
+        const r32 *scales[3] = { job->scale + row - width,   job->scale + row,   job->scale + row + width   };
+        r32 *dst = job->result + row;
+
+        __m128 zero = _mm_setzero_ps();
+        __m128 talus[8];
+        for (u32 k = 0; k < 8; ++k) talus[k] = _mm_set1_ps(job->talus[k]);
+
+        for (; x + 4 <= width - 1; x += 4)
+        {
+            __m128 h = _mm_loadu_ps(rows[1] + x);
+
+            __m128 out_excess = zero;
+            __m128 in_flow    = zero;
+            for (u32 k = 0; k < 8; ++k)
+            {
+                u32 r = 1 + g_thermal_dy[k];
+                u32 c = x + g_thermal_dx[k];
+                __m128 n   = _mm_loadu_ps(rows[r] + c);
+                __m128 out = _mm_max_ps(_mm_sub_ps(_mm_sub_ps(h, n), talus[k]), zero);
+                __m128 in  = _mm_max_ps(_mm_sub_ps(_mm_sub_ps(n, h), talus[k]), zero);
+                out_excess = _mm_add_ps(out_excess, out);
+                in_flow    = _mm_add_ps(in_flow, _mm_mul_ps(_mm_loadu_ps(scales[r] + c), in));
+            }
+
+            __m128 scale = _mm_loadu_ps(scales[1] + x);
+            _mm_storeu_ps(dst + x, _mm_add_ps(_mm_sub_ps(h, _mm_mul_ps(scale, out_excess)), in_flow));
+        }
+#endif
+        return x;
+    }
+
+    // Job callback, scale of rows [begin, end)
+    file_internal void
+    ThermalScaleRows(u32 begin, u32 end, void *args)
+    {
+        ThermalJob *job = (ThermalJob*)args;
+        for (u32 y = begin; y < end; ++y)
+        {
+            r32 *row = job->scale + (u64)y * job->width;
+            u32 x = 0;
+            if (y > 0 && y < job->height - 1 && job->width > 2)
+            {
+                row[0] = ThermalScaleAt(job, 0, y);
+                x = ThermalScaleInterior(job, y);
+            }
+            for (; x < job->width; ++x) row[x] = ThermalScaleAt(job, x, y);
+        }
+    }
+
+    // Job callback, next iteration of rows [begin, end)
+    file_internal void
+    ThermalFlowRows(u32 begin, u32 end, void *args)
+    {
+        ThermalJob *job = (ThermalJob*)args;
+        for (u32 y = begin; y < end; ++y)
+        {
+            r32 *row = job->result + (u64)y * job->width;
+            u32 x = 0;
+            if (y > 0 && y < job->height - 1 && job->width > 2)
+            {
+                row[0] = ThermalFlowAt(job, 0, y);
+                x = ThermalFlowInterior(job, y);
+            }
+            for (; x < job->width; ++x) row[x] = ThermalFlowAt(job, x, y);
+        }
+    }
+
+    // Runs the thermal iterations on a width x height map, in place
+    file_internal void
+    ThermalRelax(ThermalErosionDesc *desc, r32 *heights, u32 width, u32 height)
+    {
+        if (desc->iterations == 0 || width == 0 || height == 0) return;
+
+        u64 samples = (u64)width * height;
+        r32 *scratch = (r32*)SysAlloc(sizeof(r32) * samples * 2);
+
+        ThermalJob job = {};
+        job.scale  = scratch + samples;
+        job.width  = width;
+        job.height = height;
+        job.rate   = desc->rate;
+        for (u32 k = 0; k < 8; ++k)
+        {
+            bool diagonal = g_thermal_dx[k] != 0 && g_thermal_dy[k] != 0;
+            job.talus[k] = diagonal ? desc->talus * 1.41421356f : desc->talus;
+        }
+
+        u32 rows_per_job = (width < EROSION_ROWS_PER_JOB_SAMPLES) ? EROSION_ROWS_PER_JOB_SAMPLES / width : 1;
+
+        r32 *current = heights;
+        r32 *next    = scratch;
+        for (u32 i = 0; i < desc->iterations; ++i)
+        {
+            job.heights = current;
+            job.result  = next;
+            JobSystemParallelFor(height, rows_per_job, ThermalScaleRows, &job);
+            JobSystemParallelFor(height, rows_per_job, ThermalFlowRows, &job);
+
+            r32 *tmp = current;
+            current  = next;
+            next     = tmp;
+        }
+
+        if (current != heights) memcpy(heights, current, sizeof(r32) * samples);
+        SysFree(scratch);
+    }
+
+}; // terrain
+
+u32 terrain::GetHydraulicErosionHalo(HydraulicErosionDesc *desc)
+{
+    // Droplets start up to the reach away from the chunk and travel the reach again
+    return 2 * HydraulicReach(desc);
+}
+
+u32 terrain::GetThermalErosionHalo(ThermalErosionDesc *desc)
+{
+    // An iteration reads the heights 2 samples away (through the scale of the neighbours)
+    return 2 * desc->iterations;
+}
+
+void terrain::ErodeHydraulic(HydraulicErosionDesc *desc, r32 *heightmap, u32 width, u32 height, ErosionStats *stats)
+{
+    assert(desc->tile_size > 0 && "Hydraulic erosion needs a tile size");
+    if (stats) *stats = {};
+    if (width < 2 || height < 2) return;
+
+    u64 samples = (u64)width * height;
+    r32 *src = (r32*)SysAlloc(sizeof(r32) * samples);
+    memcpy(src, heightmap, sizeof(r32) * samples);
+
+    u32 tiles_x    = (width  + desc->tile_size - 1) / desc->tile_size;
+    u32 tiles_y    = (height + desc->tile_size - 1) / desc->tile_size;
+    u32 tile_count = tiles_x * tiles_y;
+
+    HydraulicJob job = {};
+    job.desc       = desc;
+    job.src        = src;
+    job.dst        = heightmap;
+    job.width      = width;
+    job.height     = height;
+    job.tiles_x    = tiles_x;
+    job.tile_stats = (ErosionStats*)SysAlloc(sizeof(ErosionStats) * tile_count);
+
+    JobSystemParallelFor(tile_count, 1, ErodeHydraulicTiles, &job);
+
+    if (stats)
+    {
+        for (u32 tile = 0; tile < tile_count; ++tile)
+        {
+            stats->droplets           += job.tile_stats[tile].droplets;
+            stats->droplets_simulated += job.tile_stats[tile].droplets_simulated;
+        }
+    }
+
+    SysFree(job.tile_stats);
+    SysFree(src);
+}
+
+void terrain::ErodeThermal(ThermalErosionDesc *desc, r32 *heightmap, u32 width, u32 height)
+{
+    ThermalRelax(desc, heightmap, width, height);
+}
+
+void terrain::ErodeHydraulicChunk(HydraulicErosionDesc *desc, const r32 *src, ErosionRect *window, ErosionRect *chunk,
+                                  r32 *dst, ErosionStats *stats)
+{
+    ErodeHydraulicRect(desc, src, window->width, window, chunk, dst, chunk->width, stats);
+}
+
+void terrain::ErodeThermalChunk(ThermalErosionDesc *desc, const r32 *src, ErosionRect *window, ErosionRect *chunk, r32 *dst)
+{
+    assert(chunk->x >= window->x && chunk->x + chunk->width  <= window->x + window->width &&
+           chunk->y >= window->y && chunk->y + chunk->height <= window->y + window->height &&
+           "The erosion window has to contain the chunk");
+
+    u64 samples = (u64)window->width * window->height;
+    r32 *map = (r32*)SysAlloc(sizeof(r32) * samples);
+    memcpy(map, src, sizeof(r32) * samples);
+
+    ThermalRelax(desc, map, window->width, window->height);
+
+    const r32 *eroded = map + (u64)(chunk->y - window->y) * window->width + (chunk->x - window->x);
+    for (u32 y = 0; y < chunk->height; ++y)
+    {
+        memcpy(dst + (u64)y * chunk->width, eroded + (u64)y * window->width, sizeof(r32) * chunk->width);
+    }
+
+    SysFree(map);
+}
+
+#undef EROSION_ROWS_PER_JOB_SAMPLES
+#undef EROSION_BRUSH_SIZE
+#undef EROSION_MAX_RADIUS
+#undef EROSION_SPAWN_BLOCK
+#undef EROSION_SSE2
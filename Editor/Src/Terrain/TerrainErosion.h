@@ -0,0 +1,99 @@
+#ifndef _TERRAIN_EROSION_H
+#define _TERRAIN_EROSION_H
+
+//
+// Erosion of CPU heightmaps, run on the heights from the noise (see TerrainNoise.h).
+//
+// Hydraulic erosion rolls water droplets down the heightmap. A droplet follows the slope
+// with some inertia, picks up sediment while it runs downhill and drops it where it slows
+// down or climbs, and evaporates over its lifetime. This carves gullies and fills valleys.
+//
+// Thermal erosion relaxes the slopes steeper than the talus: every iteration, material of
+// a sample slides to its lower neighbours by the amount the height differences exceed the
+// talus, so cliffs crumble into scree slopes.
+//
+// Heights are in heightmap units and distances in samples, so the parameters depend on the
+// height range of the heightmap but not on its size.
+//
+// Both are deterministic: the result only depends on the heightmap and the parameters, not
+// on the thread count. Hydraulic erosion runs square tiles in parallel. A tile reads the
+// heightmap around it (its halo) and only writes its own samples. Droplets are spawned per
+// 16x16 block of samples from the seed and the block position, so a tile also replays the
+// droplets of its neighbours that can reach it, and the tiles meet without seams. Thermal
+// erosion runs the whole heightmap in row bands, each iteration only reads the previous one.
+//
+// Large worlds can be eroded in chunks (ErodeHydraulicChunk, ErodeThermalChunk). A chunk
+// reads a window of the heightmap that extends the halo past the chunk, and gets the same
+// heights as eroding the whole heightmap at once, as long as the hydraulic chunks are laid
+// out on the tile_size grid.
+//
+
+namespace terrain
+{
+    struct HydraulicErosionDesc
+    {
+        u32 seed                  = 0;
+        r32 droplets_per_sample   = 1.0f;
+        u32 max_lifetime          = 30;     // steps of a droplet, each step moves it one sample
+        r32 inertia               = 0.05f;  // 0: droplets follow the slope, 1: they keep their direction
+        r32 sediment_capacity     = 4.0f;   // sediment carried per unit of speed, water and height drop
+        r32 min_sediment_capacity = 0.01f;  // so droplets on flat ground still carry some sediment
+        r32 erode_speed           = 0.3f;   // fraction of the free capacity picked up in a step
+        r32 deposit_speed         = 0.3f;   // fraction of the excess sediment dropped in a step
+        r32 evaporate_speed       = 0.01f;  // fraction of the water lost in a step
+        r32 gravity               = 4.0f;
+        r32 initial_water         = 1.0f;
+        r32 initial_speed         = 1.0f;
+        u32 radius                = 3;      // samples a droplet erodes around itself, at most 8
+        u32 tile_size             = 256;    // samples on a side of the tiles run in parallel
+    };
+
+    struct ThermalErosionDesc
+    {
+        u32 iterations            = 50;
+        r32 talus                 = 0.01f;  // largest stable height difference between neighbouring
+                                            // samples, sqrt(2) times as much for diagonal neighbours
+        r32 rate                  = 0.25f;  // fraction of the excess moved in an iteration, (0, 0.5]. Higher
+                                            // rates settle faster but can overshoot into pits.
+    };
+
+    // Rectangle of a heightmap, in samples
+    struct ErosionRect
+    {
+        u32 x;
+        u32 y;
+        u32 width;
+        u32 height;
+    };
+
+    struct ErosionStats
+    {
+        u64 droplets;             // droplets spawned on the eroded samples
+        u64 droplets_simulated;   // including the droplets of the neighbouring tiles replayed in the halos
+    };
+
+    // Samples a chunk window has to extend past the chunk, where the heightmap goes on
+    u32 GetHydraulicErosionHalo(HydraulicErosionDesc *desc);
+    u32 GetThermalErosionHalo(ThermalErosionDesc *desc);
+
+    // Erodes a row-major width x height heightmap in place.
+    // @param stats: (output) optional
+    void ErodeHydraulic(HydraulicErosionDesc *desc, r32 *heightmap, u32 width, u32 height, ErosionStats *stats = NULL);
+    void ErodeThermal(ThermalErosionDesc *desc, r32 *heightmap, u32 width, u32 height);
+
+    // Erodes a chunk of a larger heightmap, so large worlds can be streamed through a chunk at a
+    // time. Safe to call from jobs.
+    // @param src:    window->width x window->height samples of the heightmap, row-major. The window
+    //                contains the chunk and extends the halo past it, unless it reaches the edge
+    //                of the heightmap.
+    // @param window: position of src in the heightmap
+    // @param chunk:  samples to erode, in the heightmap
+    // @param dst:    (output) chunk->width x chunk->height eroded samples, row-major
+    // @param stats:  (output) optional
+    void ErodeHydraulicChunk(HydraulicErosionDesc *desc, const r32 *src, ErosionRect *window, ErosionRect *chunk,
+                             r32 *dst, ErosionStats *stats = NULL);
+    void ErodeThermalChunk(ThermalErosionDesc *desc, const r32 *src, ErosionRect *window, ErosionRect *chunk, r32 *dst);
+
+}; // terrain
+
+#endif //_TERRAIN_EROSION_H
@@ -0,0 +1,560 @@
+// NOTE(Dustin): A decoded tile mip lives in the cache and its pages in the mapping are released
+// right after decoding, so the memory of the file itself never grows with the camera path. The
+// OS reads the pages from disk (or its file cache) again if the tile is paged in again.
+
+#define TERRAIN_FILE_EMPTY U32_MAX
+
+namespace terrain
+{
+    struct TerrainFilePageIn
+    {
+        u32 key;
+        u32 slot;
+    };
+
+    struct TerrainFileWriteJob
+    {
+        TerrainFileHeader   *header;
+        TerrainFileTile     *tiles;
+        u8                 **blocks;  // per tile, the encoded tile data
+        const r32           *heightmap;
+        TerrainTileEncoding  encoding;
+    };
+
+    struct TerrainFileDecodeJob
+    {
+        TerrainFile       *file;
+        TerrainFilePageIn *page_ins;
+    };
+
+    FORCE_INLINE u64
+    TerrainFileAlign(u64 offset)
+    {
+        return (offset + TERRAIN_FILE_ALIGN - 1) & ~((u64)TERRAIN_FILE_ALIGN - 1);
+    }
+
+    FORCE_INLINE u32
+    TerrainFileMipSamples(u32 tile_size, u32 mip)
+    {
+        u32 side = ((tile_size - 1) >> mip) + 1;
+        return side * side;
+    }
+
+    // Offset of a mip from the start of its tile, in bytes
+    file_internal u64
+    TerrainFileMipOffset(u32 tile_size, u32 mip)
+    {
+        u64 result = 0;
+        for (u32 i = 0; i < mip; ++i) result += sizeof(u16) * TerrainFileMipSamples(tile_size, i);
+        return result;
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // Writing
+
+    // Job callback, bounds and quantized mips of tiles [begin, end)
+    file_internal void
+    TerrainFileWriteTiles(u32 begin, u32 end, void *args)
+    {
+        TerrainFileWriteJob *job = (TerrainFileWriteJob*)args;
+        TerrainFileHeader *header = job->header;
+        u32 cells = header->tile_size - 1;
+
+        for (u32 tile = begin; tile < end; ++tile)
+        {
+            u32 base_x = (tile % header->tiles_x) * cells;
+            u32 base_y = (tile / header->tiles_x) * cells;
+
+            // Samples past the heightmap repeat its last row and column
+            #define TILE_SAMPLE(x, y) \
+                job->heightmap[fast_min(base_y + (y), header->height - 1) * header->width + fast_min(base_x + (x), header->width - 1)]
+
+            // NOTE(Dustin): fast_minf/fast_maxf are not exact, and against a R32_MAX sentinel they
+            // return 0, so the bounds are seeded with a sample and compared directly.
+            r32 min_height = TILE_SAMPLE(0, 0);
+            r32 max_height = min_height;
+            for (u32 y = 0; y <= cells; ++y)
+            {
+                for (u32 x = 0; x <= cells; ++x)
+                {
+                    r32 h = TILE_SAMPLE(x, y);
+                    if (h < min_height) min_height = h;
+                    if (h > max_height) max_height = h;
+                }
+            }
+
+            TerrainFileTile *entry = job->tiles + tile;
+            entry->min_height = min_height;
+            entry->max_height = max_height;
+            entry->encoding   = job->encoding;
+
+            r32 range = max_height - min_height;
+            r32 scale = (range > 0.0f) ? 65535.0f / range : 0.0f;
+
+            u32 raw_size = (u32)TerrainFileMipOffset(header->tile_size, header->mip_count);
+            u16 *quantized = (u16*)SysAlloc(raw_size);
+
+            u16 *dst = quantized;
+            for (u32 mip = 0; mip < header->mip_count; ++mip)
+            {
+                for (u32 y = 0; y <= cells; y += 1 << mip)
+                {
+                    for (u32 x = 0; x <= cells; x += 1 << mip)
+                    {
+                        r32 q = (TILE_SAMPLE(x, y) - min_height) * scale + 0.5f;
+                        *dst++ = (u16)((q < 65535.0f) ? q : 65535.0f);
+                    }
+                }
+            }
+
+            if (job->encoding == TerrainTileEncoding_Quantized16)
+            {
+                entry->size = raw_size;
+                job->blocks[tile] = (u8*)quantized;
+            }
+            else
+            {
+                // u32 size per mip, followed by the encoded mips
+                u32 table_size = sizeof(u32) * header->mip_count;
+                u32 capacity = table_size;
+                for (u32 mip = 0; mip < header->mip_count; ++mip)
+                {
+                    u32 side = ((header->tile_size - 1) >> mip) + 1;
+                    capacity += HeightCodecBound(side, side);
+                }
+
+                u8 *block = (u8*)SysAlloc(capacity);
+                u32 *mip_sizes = (u32*)block;
+                u32 size = table_size;
+                for (u32 mip = 0; mip < header->mip_count; ++mip)
+                {
+                    u32 side = ((header->tile_size - 1) >> mip) + 1;
+                    const u16 *samples = quantized + TerrainFileMipOffset(header->tile_size, mip) / sizeof(u16);
+                    mip_sizes[mip] = HeightCodecEncode(samples, side, side, block + size);
+                    size += mip_sizes[mip];
+                }
+
+                entry->size = size;
+                job->blocks[tile] = block;
+                SysFree(quantized);
+            }
+
+            #undef TILE_SAMPLE
+        }
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // Tile cache
+
+    file_internal void
+    TerrainFileDecode(TerrainFile *file, u32 key, u32 slot)
+    {
+        u32 mip = key % file->header->mip_count;
+        TerrainFileTile *tile = file->tiles + key / file->header->mip_count;
+
+        u32 side    = TerrainFileMipSize(file, mip);
+        u32 samples = side * side;
+        r32 *dst = file->cache + (u64)slot * file->slot_samples;
+        r32 scale = (tile->max_height - tile->min_height) / 65535.0f;
+
+        u64 offset;
+        u32 size;
+        if (tile->encoding == TerrainTileEncoding_Quantized16)
+        {
+            offset = tile->offset + TerrainFileMipOffset(file->header->tile_size, mip);
+            size   = sizeof(u16) * samples;
+
+            const u16 *src = (const u16*)(file->mapping.data + offset);
+            for (u32 i = 0; i < samples; ++i)
+            {
+                dst[i] = tile->min_height + (r32)src[i] * scale;
+            }
+        }
+        else
+        {
+            const u32 *mip_sizes = (const u32*)(file->mapping.data + tile->offset);
+            offset = tile->offset + sizeof(u32) * file->header->mip_count;
+            for (u32 i = 0; i < mip; ++i) offset += mip_sizes[i];
+            size = mip_sizes[mip];
+
+            u16 *decoded = (u16*)SysAlloc(sizeof(u16) * samples);
+            if (!HeightCodecDecode(file->mapping.data + offset, size, side, side, decoded))
+            {
+                LogError("Terrain tile %d (mip %d) failed to decode.", key / file->header->mip_count, mip);
+                memset(decoded, 0, sizeof(u16) * samples);
+            }
+
+            for (u32 i = 0; i < samples; ++i)
+            {
+                dst[i] = tile->min_height + (r32)decoded[i] * scale;
+            }
+            SysFree(decoded);
+        }
+
+        PlatformReleaseMappedRange(&file->mapping, offset, size);
+    }
+
+    // Job callback, decodes page-ins [begin, end)
+    file_internal void
+    TerrainFileDecodeRange(u32 begin, u32 end, void *args)
+    {
+        TerrainFileDecodeJob *job = (TerrainFileDecodeJob*)args;
+        for (u32 i = begin; i < end; ++i)
+        {
+            TerrainFileDecode(job->file, job->page_ins[i].key, job->page_ins[i].slot);
+        }
+    }
+
+    // Least recently used slot that was not used with the current stamp, evicting its tile.
+    // Returns TERRAIN_FILE_EMPTY if every slot is in use.
+    file_internal u32
+    TerrainFileAcquireSlot(TerrainFile *file, u32 key, TerrainFileStats *stats)
+    {
+        u32 result = TERRAIN_FILE_EMPTY;
+        u64 oldest = file->stamp;
+        for (u32 slot = 0; slot < file->cache_slots; ++slot)
+        {
+            if (file->slot_used[slot] < oldest)
+            {
+                oldest = file->slot_used[slot];
+                result = slot;
+            }
+        }
+
+        if (result != TERRAIN_FILE_EMPTY)
+        {
+            if (file->slot_key[result] != TERRAIN_FILE_EMPTY)
+            {
+                file->resident[file->slot_key[result]] = TERRAIN_FILE_EMPTY;
+                if (stats) stats->tiles_evicted += 1;
+            }
+
+            file->slot_key[result]  = key;
+            file->slot_used[result] = file->stamp;
+            file->resident[key]     = result;
+        }
+
+        return result;
+    }
+
+    file_internal bool
+    TerrainFileValidate(TerrainFile *file, const char *path)
+    {
+        PlatformMappedFile *mapping = &file->mapping;
+        if (mapping->size < sizeof(TerrainFileHeader))
+        {
+            LogError("Terrain file %s is too small for its header.", path);
+            return false;
+        }
+
+        TerrainFileHeader *header = (TerrainFileHeader*)mapping->data;
+        if (header->magic != TERRAIN_FILE_MAGIC || header->version != TERRAIN_FILE_VERSION)
+        {
+            LogError("%s is not a terrain file of version %d.", path, TERRAIN_FILE_VERSION);
+            return false;
+        }
+
+        u32 cells = header->tile_size - 1;
+        if (header->tile_size < 3 || !IsPowerOfTwo(cells) || header->width < 2 || header->height < 2 ||
+            header->tiles_x != (header->width  - 2) / cells + 1 ||
+            header->tiles_y != (header->height - 2) / cells + 1 ||
+            header->mip_count != PlatformCtz(cells) + 1)
+        {
+            LogError("Terrain file %s has an invalid tile layout.", path);
+            return false;
+        }
+
+        u64 tile_count = (u64)header->tiles_x * header->tiles_y;
+        if (header->index_offset + tile_count * sizeof(TerrainFileTile) > mapping->size)
+        {
+            LogError("Terrain file %s is truncated.", path);
+            return false;
+        }
+
+        u64 raw_size = TerrainFileMipOffset(header->tile_size, header->mip_count);
+        TerrainFileTile *tiles = (TerrainFileTile*)(mapping->data + header->index_offset);
+        for (u64 i = 0; i < tile_count; ++i)
+        {
+            bool valid = tiles[i].offset % sizeof(u32) == 0 && tiles[i].offset + tiles[i].size <= mapping->size;
+            if (valid && tiles[i].encoding == TerrainTileEncoding_Quantized16)
+            {
+                valid = tiles[i].size == raw_size;
+            }
+            else if (valid && tiles[i].encoding == TerrainTileEncoding_Predicted16)
+            {
+                // The mip sizes have to add up to the tile
+                u64 size = sizeof(u32) * header->mip_count;
+                if (tiles[i].size >= size)
+                {
+                    const u32 *mip_sizes = (const u32*)(mapping->data + tiles[i].offset);
+                    for (u32 mip = 0; mip < header->mip_count; ++mip) size += mip_sizes[mip];
+                }
+                valid = size == tiles[i].size;
+            }
+            else
+            {
+                valid = false;
+            }
+
+            if (!valid)
+            {
+                LogError("Terrain file %s has an invalid tile %llu.", path, (unsigned long long)i);
+                return false;
+            }
+        }
+
+        file->header = header;
+        file->tiles  = tiles;
+        return true;
+    }
+
+}; // terrain
+
+bool terrain::TerrainFileWrite(const char *path, const r32 *heightmap, u32 width, u32 height, u32 tile_size,
+                               TerrainTileEncoding encoding)
+{
+    u32 cells = tile_size - 1;
+    if (tile_size < 3 || !IsPowerOfTwo(cells) || width < 2 || height < 2) return false;
+
+    TerrainFileHeader header = {};
+    header.magic      = TERRAIN_FILE_MAGIC;
+    header.version    = TERRAIN_FILE_VERSION;
+    header.width      = width;
+    header.height     = height;
+    header.tile_size  = tile_size;
+    header.tiles_x    = (width  - 2) / cells + 1;
+    header.tiles_y    = (height - 2) / cells + 1;
+    header.mip_count  = PlatformCtz(cells) + 1;
+    header.index_offset = sizeof(TerrainFileHeader);
+
+    u32 tile_count = header.tiles_x * header.tiles_y;
+    TerrainFileTile *tiles = (TerrainFileTile*)SysAlloc(sizeof(TerrainFileTile) * tile_count);
+    u8 **blocks = (u8**)SysAlloc(sizeof(u8*) * tile_count);
+
+    TerrainFileWriteJob job = {};
+    job.header    = &header;
+    job.tiles     = tiles;
+    job.blocks    = blocks;
+    job.heightmap = heightmap;
+    job.encoding  = encoding;
+    JobSystemParallelFor(tile_count, 1, TerrainFileWriteTiles, &job);
+
+    // Lay out the tiles now that their sizes are known
+    header.min_height = tiles[0].min_height;
+    header.max_height = tiles[0].max_height;
+    u64 file_size = TerrainFileAlign(header.index_offset + sizeof(TerrainFileTile) * tile_count);
+    for (u32 i = 0; i < tile_count; ++i)
+    {
+        if (tiles[i].min_height < header.min_height) header.min_height = tiles[i].min_height;
+        if (tiles[i].max_height > header.max_height) header.max_height = tiles[i].max_height;
+
+        tiles[i].offset = file_size;
+        file_size = TerrainFileAlign(file_size + tiles[i].size);
+    }
+
+    u8 *buffer = (u8*)SysAlloc(file_size);
+    memset(buffer, 0, file_size);
+    memcpy(buffer, &header, sizeof(TerrainFileHeader));
+    memcpy(buffer + header.index_offset, tiles, sizeof(TerrainFileTile) * tile_count);
+    for (u32 i = 0; i < tile_count; ++i)
+    {
+        memcpy(buffer + tiles[i].offset, blocks[i], tiles[i].size);
+        SysFree(blocks[i]);
+    }
+    SysFree(blocks);
+    SysFree(tiles);
+
+    PlatformErrorType err = PlatformWriteBufferToFile(path, buffer, file_size);
+    SysFree(buffer);
+
+    if (err != PlatformError_Success)
+    {
+        LogError("Failed to write terrain file %s.", path);
+        return false;
+    }
+    return true;
+}
+
+bool terrain::TerrainFileOpen(TerrainFile *file, const char *path, u32 cache_slots)
+{
+    *file = {};
+    if (cache_slots == 0) return false;
+
+    if (PlatformMapFile(path, &file->mapping) != PlatformError_Success)
+    {
+        LogError("Failed to map terrain file %s.", path);
+        return false;
+    }
+
+    if (!TerrainFileValidate(file, path))
+    {
+        PlatformUnmapFile(&file->mapping);
+        *file = {};
+        return false;
+    }
+
+    u32 mip_keys = file->header->tiles_x * file->header->tiles_y * file->header->mip_count;
+
+    file->cache_slots  = cache_slots;
+    file->slot_samples = file->header->tile_size * file->header->tile_size;
+    file->cache        = (r32*)SysAlloc(sizeof(r32) * file->slot_samples * cache_slots);
+    file->slot_key     = (u32*)SysAlloc(sizeof(u32) * cache_slots);
+    file->slot_used    = (u64*)SysAlloc(sizeof(u64) * cache_slots);
+    file->resident     = (u32*)SysAlloc(sizeof(u32) * mip_keys);
+    file->stamp        = 1;
+
+    memset(file->slot_key,  0xFF, sizeof(u32) * cache_slots);
+    memset(file->slot_used, 0,    sizeof(u64) * cache_slots);
+    memset(file->resident,  0xFF, sizeof(u32) * mip_keys);
+
+    return true;
+}
+
+void terrain::TerrainFileClose(TerrainFile *file)
+{
+    if (file->cache)     SysFree(file->cache);
+    if (file->slot_key)  SysFree(file->slot_key);
+    if (file->slot_used) SysFree(file->slot_used);
+    if (file->resident)  SysFree(file->resident);
+    PlatformUnmapFile(&file->mapping);
+    *file = {};
+}
+
+u32 terrain::TerrainFileMipSize(TerrainFile *file, u32 mip)
+{
+    return ((file->header->tile_size - 1) >> mip) + 1;
+}
+
+const r32* terrain::TerrainFileGetTile(TerrainFile *file, u32 tile_x, u32 tile_y, u32 mip)
+{
+    assert(tile_x < file->header->tiles_x && tile_y < file->header->tiles_y && mip < file->header->mip_count);
+
+    file->stamp += 1;
+    u32 key  = (tile_y * file->header->tiles_x + tile_x) * file->header->mip_count + mip;
+    u32 slot = file->resident[key];
+
+    if (slot == TERRAIN_FILE_EMPTY)
+    {
+        // Nothing is in use with a new stamp, so a slot is always available
+        slot = TerrainFileAcquireSlot(file, key, NULL);
+        TerrainFileDecode(file, key, slot);
+    }
+    file->slot_used[slot] = file->stamp;
+
+    return file->cache + (u64)slot * file->slot_samples;
+}
+
+void terrain::TerrainFileStream(TerrainFile *file, r32 x, r32 z, u32 radius, TerrainFileStats *stats)
+{
+    TerrainFileStats local_stats = {};
+    if (!stats) stats = &local_stats;
+    *stats = {};
+
+    TerrainFileHeader *header = file->header;
+    u32 cells = header->tile_size - 1;
+
+    i32 center_x = fast_clamp(0, (i32)header->tiles_x - 1, (i32)floorf(x / (r32)cells));
+    i32 center_y = fast_clamp(0, (i32)header->tiles_y - 1, (i32)floorf(z / (r32)cells));
+
+    i32 min_x = fast_max(center_x - (i32)radius, 0);
+    i32 min_y = fast_max(center_y - (i32)radius, 0);
+    i32 max_x = fast_min(center_x + (i32)radius, (i32)header->tiles_x - 1);
+    i32 max_y = fast_min(center_y + (i32)radius, (i32)header->tiles_y - 1);
+
+    file->stamp += 1;
+
+    // Mark the resident tiles first, so paging in the others does not evict them
+    for (i32 ty = min_y; ty <= max_y; ++ty)
+    {
+        for (i32 tx = min_x; tx <= max_x; ++tx)
+        {
+            u32 key = (ty * header->tiles_x + tx) * header->mip_count;
+            if (file->resident[key] != TERRAIN_FILE_EMPTY) file->slot_used[file->resident[key]] = file->stamp;
+            stats->tiles_requested += 1;
+        }
+    }
+
+    // Then page in the missing tiles, closest ring first
+    TerrainFilePageIn *page_ins = NULL;
+    bool cache_full = false;
+    for (i32 ring = 0; ring <= (i32)radius && !cache_full; ++ring)
+    {
+        for (i32 ty = min_y; ty <= max_y && !cache_full; ++ty)
+        {
+            for (i32 tx = min_x; tx <= max_x; ++tx)
+            {
+                if (fast_max(fast_abs(tx - center_x), fast_abs(ty - center_y)) != ring) continue;
+
+                u32 key = (ty * header->tiles_x + tx) * header->mip_count;
+                if (file->resident[key] != TERRAIN_FILE_EMPTY) continue;
+
+                TerrainFilePageIn page_in = {};
+                page_in.key  = key;
+                page_in.slot = TerrainFileAcquireSlot(file, key, stats);
+                if (page_in.slot == TERRAIN_FILE_EMPTY)
+                {
+                    cache_full = true;
+                    break;
+                }
+
+                arrput(page_ins, page_in);
+            }
+        }
+    }
+
+    stats->tiles_paged_in = (u32)arrlen(page_ins);
+
+    TerrainFileDecodeJob job = {};
+    job.file     = file;
+    job.page_ins = page_ins;
+    JobSystemParallelFor((u32)arrlen(page_ins), 1, TerrainFileDecodeRange, &job);
+
+    arrfree(page_ins);
+}
+
+void terrain::TerrainFileClipmapSource(void *user, u32 level, i32 x, i32 y, u32 width, u32 height, r32 *dst)
+{
+    TerrainFile *file = (TerrainFile*)user;
+    TerrainFileHeader *header = file->header;
+
+    u32 mip   = fast_min(level, header->mip_count - 1);
+    u32 shift = level - mip;
+    u32 cells_shift = PlatformCtz(header->tile_size - 1) - mip;
+    u32 side  = TerrainFileMipSize(file, mip);
+
+    // Last sample of the mip, past the heightmap the tiles repeat its edge
+    i64 max_x = (i64)header->tiles_x << cells_shift;
+    i64 max_y = (i64)header->tiles_y << cells_shift;
+
+    const r32 *tile = NULL;
+    u32 tile_x = U32_MAX;
+    u32 tile_y = U32_MAX;
+
+    for (u32 j = 0; j < height; ++j)
+    {
+        i64 sy = ((i64)y + j) * (1LL << shift);
+        sy = (sy < 0) ? 0 : (sy > max_y) ? max_y : sy;
+
+        u32 ty = fast_min((u32)(sy >> cells_shift), header->tiles_y - 1);
+        u32 ly = (u32)sy - (ty << cells_shift);
+
+        for (u32 i = 0; i < width; ++i)
+        {
+            i64 sx = ((i64)x + i) * (1LL << shift);
+            sx = (sx < 0) ? 0 : (sx > max_x) ? max_x : sx;
+
+            u32 tx = fast_min((u32)(sx >> cells_shift), header->tiles_x - 1);
+            u32 lx = (u32)sx - (tx << cells_shift);
+
+            if (tx != tile_x || ty != tile_y)
+            {
+                tile   = TerrainFileGetTile(file, tx, ty, mip);
+                tile_x = tx;
+                tile_y = ty;
+            }
+            dst[j * width + i] = tile[ly * side + lx];
+        }
+    }
+}
+
+#undef TERRAIN_FILE_EMPTY
@@ -0,0 +1,114 @@
+#ifndef _TERRAIN_FILE_H
+#define _TERRAIN_FILE_H
+
+//
+// Tiled terrain file (.mterrain). The heightmap is cut into square tiles of tile_size
+// samples, where neighbouring tiles share their edge samples, so a tile can be meshed on
+// its own. Every tile stores its height bounds and a mip chain, mip m keeps every 2^m-th
+// sample of the tile, down to a single cell. The heights are quantized to 16 bits between
+// the bounds of their tile and, by default, compressed losslessly (see TerrainCodec.h).
+//
+// Layout, little endian:
+//     TerrainFileHeader
+//     TerrainFileTile[tiles_x * tiles_y]      tile index, row-major
+//     tile data                               each tile starts on a TERRAIN_FILE_ALIGN boundary,
+//                                             mips are stored one after the other
+//
+// A TerrainFile maps the file and keeps a fixed number of decoded tile mips resident in a
+// cache. Tiles are paged in when they are asked for and the least recently used tile is
+// evicted, so only the working set around the camera occupies memory, no matter how large
+// the file is. A TerrainFile is not thread-safe.
+//
+
+#define TERRAIN_FILE_MAGIC   0x4E525254 // "TRRN"
+#define TERRAIN_FILE_VERSION 1
+#define TERRAIN_FILE_ALIGN   4096       // tiles start on a page, so they can be released on their own
+
+namespace terrain
+{
+    enum TerrainTileEncoding : u32
+    {
+        TerrainTileEncoding_Quantized16, // u16 per sample, min_height + q * (max_height - min_height) / 65535
+        TerrainTileEncoding_Predicted16, // Quantized16 samples coded with TerrainCodec.h, the tile starts
+                                         // with the encoded size of each mip (u32)
+    };
+
+    struct TerrainFileHeader
+    {
+        u32 magic;
+        u32 version;
+        u32 width;             // heightmap samples in x
+        u32 height;            // heightmap samples in z
+        u32 tile_size;         // samples on a tile side, 2^n + 1
+        u32 tiles_x;
+        u32 tiles_y;
+        u32 mip_count;         // mip m of a tile has ((tile_size - 1) >> m) + 1 samples on a side
+        r32 min_height;
+        r32 max_height;
+        u64 index_offset;      // offset of the tile index
+    };
+
+    struct TerrainFileTile
+    {
+        u64 offset;            // offset of mip 0
+        u32 size;              // bytes of all mips
+        u32 encoding;          // TerrainTileEncoding
+        r32 min_height;
+        r32 max_height;
+    };
+
+    struct TerrainFileStats
+    {
+        u32 tiles_requested;
+        u32 tiles_paged_in;
+        u32 tiles_evicted;
+    };
+
+    struct TerrainFile
+    {
+        PlatformMappedFile  mapping;
+        TerrainFileHeader  *header;
+        TerrainFileTile    *tiles;
+
+        // Resident tile mips, slot s holds tile_size * tile_size samples at cache + s * slot_samples
+        u32   cache_slots;
+        u32   slot_samples;
+        r32  *cache;
+        u32  *slot_key;        // per slot, tile * mip_count + mip, U32_MAX if empty
+        u64  *slot_used;       // per slot, stamp of the last use
+        u32  *resident;        // per tile mip, slot or U32_MAX
+        u64   stamp;
+    };
+
+    // Writes a heightmap as a terrain file. The heightmap does not have to be a multiple of the
+    // tile size, the last tiles repeat the edge samples.
+    // @param tile_size: samples on a tile side, 2^n + 1
+    bool TerrainFileWrite(const char *path, const r32 *heightmap, u32 width, u32 height, u32 tile_size,
+                          TerrainTileEncoding encoding = TerrainTileEncoding_Predicted16);
+
+    // Maps a terrain file, nothing is read until tiles are asked for.
+    // @param cache_slots: tile mips that can be resident at once
+    bool TerrainFileOpen(TerrainFile *file, const char *path, u32 cache_slots);
+    void TerrainFileClose(TerrainFile *file);
+
+    // Samples on a side of a mip of a tile
+    u32 TerrainFileMipSize(TerrainFile *file, u32 mip);
+
+    // Heights of a tile mip, row-major with TerrainFileMipSize(file, mip) samples on a side.
+    // Pages the tile in if it is not resident, the pointer stays valid until the tile is evicted,
+    // which can happen on the next call that pages in a tile.
+    const r32* TerrainFileGetTile(TerrainFile *file, u32 tile_x, u32 tile_y, u32 mip);
+
+    // Pages in mip 0 of the tiles within "radius" tiles of a heightmap position, decoding them
+    // on the job system. Tiles that do not fit in the cache are left out.
+    // @param x, z:  position in heightmap samples
+    // @param stats: (output) optional
+    void TerrainFileStream(TerrainFile *file, r32 x, r32 z, u32 radius, TerrainFileStats *stats = NULL);
+
+    // PFN_ClipmapSource reading through the tile cache of a TerrainFile passed as "user".
+    // Clipmap level L reads mip L of the tiles (the last mip for the levels past it).
+    void TerrainFileClipmapSource(void *user, u32 level, i32 x, i32 y, u32 width, u32 height, r32 *dst);
+
+}; // terrain
+
+#endif //_TERRAIN_FILE_H
@@ -1,21 +1,6 @@
 
 namespace terrain
 {
-    enum ComputeFunction
-    {
-        Function_Checker,
-        Function_Discrete,
-        Function_LinearValue,
-        Function_FadedValue,
-        Function_CubicValue,
-        Function_Perlin,
-        Function_Simplex,
-        Function_Worley,
-        Function_Spots,
-        
-        Function_Count,
-    };
-    
     enum ComputeParameters
     {
         NoiseCB_CS,
@@ -24,16 +9,6 @@ namespace terrain
         NumParams_CS,
     };
     
-    struct Noise_CB
-    {
-        r32 scale;
-        i32 seed;
-        i32 octaves;
-        r32 lacunarity;
-        r32 decay;
-        r32 threshold; // for bounded noise
-    };
-    
     void LoadComputeFunctions();
     void ReleaseComputeFunctions();
     
@@ -42,6 +17,19 @@ namespace terrain
     RootSignature       g_compute_signature;
     PipelineStateObject g_compute_pso[Function_Count];
     
+    // Indexed by ComputeFunction
+    static const wchar_t *g_compute_shader_files[Function_Count] = {
+        L"shaders/CheckerNoise.cso",
+        L"shaders/DiscreteNoise.cso",
+        L"shaders/LinearValueNoise.cso",
+        L"shaders/FadedValueNoise.cso",
+        L"shaders/CubicValueNoise.cso",
+        L"shaders/PerlinNoise.cso",
+        L"shaders/SimplexNoise.cso",
+        L"shaders/WorleyNoise.cso",
+        L"shaders/SpotsNoise.cso",
+    };
+    
     static FORCE_INLINE ID3D12PipelineState*
         CreatePso(RootSignature *root_signature, ID3DBlob *blob)
     {
@@ -78,10 +66,10 @@ void terrain::LoadComputeFunctions()
     g_compute_signature = {};
     g_compute_signature.Init(ComputeParameters::NumParams_CS, root_parameters, 1, &linear_wrap_sampler);
     
-    // For now, just load the Perlin Compute Kernel
+    for (u32 fn = 0; fn < Function_Count; ++fn)
     {
-        ID3DBlob *cs = (ID3DBlob*)LoadShaderModule(L"shaders/PerlinNoise.cso");
-        g_compute_pso[Function_Perlin]._handle = CreatePso(&g_compute_signature, cs);
+        ID3DBlob *cs = (ID3DBlob*)LoadShaderModule((wchar_t*)g_compute_shader_files[fn]);
+        g_compute_pso[fn]._handle = CreatePso(&g_compute_signature, cs);
     }
     
 }
@@ -89,12 +77,15 @@ void terrain::LoadComputeFunctions()
 void terrain::ReleaseComputeFunctions()
 {
     g_compute_signature.Free();
-    g_compute_pso[Function_Perlin].Free();
+    for (u32 fn = 0; fn < Function_Count; ++fn)
+    {
+        g_compute_pso[fn].Free();
+    }
 }
 
 void terrain::ExecuteFunction(ComputeFunction fn, Noise_CB *cb, CommandList *command_list, TEXTURE_ID texture)
 {
-    assert(fn == Function_Perlin && "Only Perlin Noise is supported right now!");
+    assert(fn < Function_Count && "Unknown compute function!");
     
     D3D12_RESOURCE_DESC desc = texture::GetResourceDesc(texture);
     
@@ -0,0 +1,888 @@
+
+// NOTE(Dustin): An evaluation first walks the inputs of the requested node depth-first, which
+// gives the needed nodes in dependency order and finds cycles and missing inputs before anything
+// runs. The hashes are then computed in that order, and every node whose hash changed is marked
+// dirty along with the count of dirty inputs it waits on. The dirty nodes without dirty inputs are
+// submitted to the job system, and the job that finishes the last input of a node submits it. The
+// nodes split their own work over the job system as well, so a single long chain still uses
+// every thread.
+
+#define GRAPH_SAMPLES_PER_JOB 65536 // samples each job of a combine/remap/clamp node processes
+#define GRAPH_HASH_SEED       0xCBF29CE484222325ull
+
+namespace terrain
+{
+    const char *g_terrain_node_names[(u32)TerrainNodeType::Count] = {
+        "noise", "combine", "remap", "erode", "clamp",
+    };
+
+    const char *g_terrain_combine_names[(u32)TerrainCombineOp::Count] = {
+        "add", "subtract", "multiply", "min", "max", "lerp",
+    };
+
+    const char *g_terrain_noise_names[Function_Count] = {
+        "checker", "discrete", "linear_value", "faded_value", "cubic_value",
+        "perlin", "simplex", "worley", "spots",
+    };
+
+    const char *g_terrain_fractal_names[Fractal_Count] = {
+        "fbm", "ridged", "turbulence",
+    };
+
+    // Names of the inputs in the graph files
+    static const char *g_terrain_input_names[(u32)TerrainNodeType::Count][TERRAIN_GRAPH_MAX_INPUTS] = {
+        { NULL,    NULL },  // Noise
+        { "a",     "b"  },  // Combine
+        { "input", NULL },  // Remap
+        { "input", NULL },  // Erode
+        { "input", NULL },  // Clamp
+    };
+
+    struct TerrainGraphEval;
+
+    struct TerrainGraphTask
+    {
+        TerrainGraphEval *eval;
+        u32               node;
+    };
+
+    struct TerrainGraphEval
+    {
+        TerrainGraph     *graph;
+        u64              *hashes;          // per node, hash the node is evaluated with
+        u32              *dependents;      // dirty nodes reading each dirty node, starting at first_dependent
+        u32              *first_dependent; // per node, plus one past the last node
+        std::atomic<i32> *pending;         // per node, dirty inputs that have not run yet
+        TerrainGraphTask *tasks;           // per node
+        JobCounter        counter;
+    };
+
+    // Combine, remap and clamp nodes
+    struct TerrainPointJob
+    {
+        TerrainNode *node;
+        const r32   *a;
+        const r32   *b;
+        r32         *dst;
+        u64          samples;
+    };
+
+    // FNV-1a
+    FORCE_INLINE u64
+    GraphHash(u64 hash, const void *data, u64 size)
+    {
+        const u8 *bytes = (const u8*)data;
+        for (u64 i = 0; i < size; ++i)
+        {
+            hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+        }
+        return hash;
+    }
+
+    // Hash of the parameters of a node, the size of the graph and the hashes of the inputs
+    file_internal u64
+    HashTerrainNode(TerrainGraph *graph, TerrainNode *node, u64 *input_hashes)
+    {
+        u64 hash = GRAPH_HASH_SEED;
+        hash = GraphHash(hash, &node->type,    sizeof(node->type));
+        hash = GraphHash(hash, &graph->width,  sizeof(graph->width));
+        hash = GraphHash(hash, &graph->height, sizeof(graph->height));
+
+        // The parameter structs have no padding, except for noise and combine
+        switch (node->type)
+        {
+            case TerrainNodeType::Noise:
+            {
+                hash = GraphHash(hash, &node->noise.function, sizeof(node->noise.function));
+                hash = GraphHash(hash, &node->noise.cb,       sizeof(node->noise.cb));
+            } break;
+            case TerrainNodeType::Remap: hash = GraphHash(hash, &node->remap, sizeof(node->remap)); break;
+            case TerrainNodeType::Erode: hash = GraphHash(hash, &node->erode, sizeof(node->erode)); break;
+            case TerrainNodeType::Clamp: hash = GraphHash(hash, &node->clamp, sizeof(node->clamp)); break;
+            case TerrainNodeType::Combine:
+            {
+                hash = GraphHash(hash, &node->combine.op,     sizeof(node->combine.op));
+                hash = GraphHash(hash, &node->combine.weight, sizeof(node->combine.weight));
+            } break;
+            default: break;
+        }
+
+        u32 input_count = TerrainNodeInputCount(node->type);
+        for (u32 i = 0; i < input_count; ++i)
+        {
+            hash = GraphHash(hash, &input_hashes[i], sizeof(input_hashes[i]));
+        }
+        return hash;
+    }
+
+    file_internal bool
+    IsTerrainNodeValid(TerrainNode *node)
+    {
+        switch (node->type)
+        {
+            case TerrainNodeType::Noise:   return HasCpuFunction(node->noise.function) &&
+                                                  node->noise.cb.fractal >= 0 && node->noise.cb.fractal < Fractal_Count;
+            case TerrainNodeType::Combine: return node->combine.op < TerrainCombineOp::Count;
+            case TerrainNodeType::Erode:   return node->erode.hydraulic.tile_size > 0;
+            case TerrainNodeType::Remap:
+            case TerrainNodeType::Clamp:   return true;
+            default:                       return false;
+        }
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // Nodes
+
+    // Job callback, blocks of GRAPH_SAMPLES_PER_JOB samples [begin, end)
+    file_internal void
+    TerrainPointRange(u32 begin, u32 end, void *args)
+    {
+        TerrainPointJob *job = (TerrainPointJob*)args;
+        TerrainNode *node = job->node;
+
+        u64 first = (u64)begin * GRAPH_SAMPLES_PER_JOB;
+        u64 last  = (u64)end   * GRAPH_SAMPLES_PER_JOB;
+        if (last > job->samples) last = job->samples;
+
+        const r32 *a = job->a;
+        const r32 *b = job->b;
+        r32 *dst = job->dst;
+
+        switch (node->type)
+        {
+            case TerrainNodeType::Combine:
+            {
+                r32 weight = node->combine.weight;
+                switch (node->combine.op)
+                {
+                    case TerrainCombineOp::Add:      for (u64 i = first; i < last; ++i) dst[i] = a[i] + b[i] * weight;        break;
+                    case TerrainCombineOp::Subtract: for (u64 i = first; i < last; ++i) dst[i] = a[i] - b[i] * weight;        break;
+                    case TerrainCombineOp::Multiply: for (u64 i = first; i < last; ++i) dst[i] = a[i] * b[i];                 break;
+                    case TerrainCombineOp::Min:      for (u64 i = first; i < last; ++i) dst[i] = (b[i] < a[i]) ? b[i] : a[i]; break;
+                    case TerrainCombineOp::Max:      for (u64 i = first; i < last; ++i) dst[i] = (b[i] > a[i]) ? b[i] : a[i]; break;
+                    case TerrainCombineOp::Lerp:     for (u64 i = first; i < last; ++i) dst[i] = a[i] + (b[i] - a[i]) * weight; break;
+                    default: break;
+                }
+            } break;
+
+            case TerrainNodeType::Remap:
+            {
+                TerrainNodeRemap *remap = &node->remap;
+                r32 range = remap->in_max - remap->in_min;
+                r32 scale = (range != 0.0f) ? 1.0f / range : 0.0f;
+                r32 out_range = remap->out_max - remap->out_min;
+
+                for (u64 i = first; i < last; ++i)
+                {
+                    // An empty input range is a step at in_min
+                    r32 t = (range != 0.0f) ? (a[i] - remap->in_min) * scale : ((a[i] >= remap->in_min) ? 1.0f : 0.0f);
+                    t = (t > 0.0f) ? ((t < 1.0f) ? t : 1.0f) : 0.0f;
+                    if (remap->exponent != 1.0f) t = powf(t, remap->exponent);
+                    dst[i] = remap->out_min + out_range * t;
+                }
+            } break;
+
+            case TerrainNodeType::Clamp:
+            {
+                r32 min = node->clamp.min;
+                r32 max = node->clamp.max;
+                for (u64 i = first; i < last; ++i)
+                {
+                    r32 v = (a[i] > min) ? a[i] : min;
+                    dst[i] = (v < max) ? v : max;
+                }
+            } break;
+
+            default: break;
+        }
+    }
+
+    // Runs a node, its inputs must be up to date
+    file_internal void
+    RunTerrainNode(TerrainGraph *graph, u32 index)
+    {
+        TerrainNode *node = &graph->nodes[index];
+        u64 samples = (u64)graph->width * graph->height;
+        if (!node->output) node->output = (r32*)SysAlloc(sizeof(r32) * samples);
+
+        const r32 *a = (node->inputs[0] != TERRAIN_GRAPH_NONE) ? graph->nodes[node->inputs[0]].output : NULL;
+        const r32 *b = (node->inputs[1] != TERRAIN_GRAPH_NONE) ? graph->nodes[node->inputs[1]].output : NULL;
+
+        switch (node->type)
+        {
+            case TerrainNodeType::Noise:
+            {
+                GenerateHeightmap(node->noise.function, &node->noise.cb, node->output, graph->width, graph->height);
+            } break;
+
+            case TerrainNodeType::Erode:
+            {
+                memcpy(node->output, a, sizeof(r32) * samples);
+                if (node->erode.hydraulic.droplets_per_sample > 0.0f)
+                {
+                    ErodeHydraulic(&node->erode.hydraulic, node->output, graph->width, graph->height);
+                }
+                if (node->erode.thermal.iterations > 0)
+                {
+                    ErodeThermal(&node->erode.thermal, node->output, graph->width, graph->height);
+                }
+            } break;
+
+            default:
+            {
+                TerrainPointJob job = {};
+                job.node    = node;
+                job.a       = a;
+                job.b       = b;
+                job.dst     = node->output;
+                job.samples = samples;
+
+                u32 blocks = (u32)((samples + GRAPH_SAMPLES_PER_JOB - 1) / GRAPH_SAMPLES_PER_JOB);
+                JobSystemParallelFor(blocks, 1, TerrainPointRange, &job);
+            } break;
+        }
+    }
+
+    // Job callback, runs a dirty node and submits the dependents it was the last input of
+    file_internal void
+    TerrainGraphRunTask(void *args)
+    {
+        TerrainGraphTask *task = (TerrainGraphTask*)args;
+        TerrainGraphEval *eval = task->eval;
+
+        RunTerrainNode(eval->graph, task->node);
+        eval->graph->nodes[task->node].hash = eval->hashes[task->node];
+
+        for (u32 i = eval->first_dependent[task->node]; i < eval->first_dependent[task->node + 1]; ++i)
+        {
+            u32 dependent = eval->dependents[i];
+            if (eval->pending[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                JobSystemSubmit(TerrainGraphRunTask, &eval->tasks[dependent], &eval->counter);
+            }
+        }
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // Files
+
+    file_internal bool
+    GraphReadFloat(TomlObject *obj, const char *key, r32 *value)
+    {
+        TomlData *data = TomlGetData(obj, key);
+        if (!data) return true;
+
+        if      (data->type == Toml_Float) *value = data->f;
+        else if (data->type == Toml_Int)   *value = (r32)data->i;
+        else return false;
+        return true;
+    }
+
+    file_internal bool
+    GraphReadInt(TomlObject *obj, const char *key, i32 *value)
+    {
+        TomlData *data = TomlGetData(obj, key);
+        if (!data) return true;
+
+        if (data->type != Toml_Int) return false;
+        *value = data->i;
+        return true;
+    }
+
+    file_internal bool
+    GraphReadUint(TomlObject *obj, const char *key, u32 *value)
+    {
+        i32 v = (i32)*value;
+        if (!GraphReadInt(obj, key, &v) || v < 0) return false;
+        *value = (u32)v;
+        return true;
+    }
+
+    // Strings in a TOML object are not null terminated
+    file_internal bool
+    GraphStringEquals(TomlData *data, const char *str)
+    {
+        return (i32)strlen(str) == data->sl && strncmp(data->s, str, data->sl) == 0;
+    }
+
+    // Reads a string as the index of the matching name
+    file_internal bool
+    GraphReadEnum(TomlObject *obj, const char *key, const char **names, u32 count, u32 *value)
+    {
+        TomlData *data = TomlGetData(obj, key);
+        if (!data) return true;
+        if (data->type != Toml_String) return false;
+
+        for (u32 i = 0; i < count; ++i)
+        {
+            if (GraphStringEquals(data, names[i]))
+            {
+                *value = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Reads a node name as the index of the node
+    file_internal bool
+    GraphReadNode(TerrainGraph *graph, TomlObject *obj, const char *key, u32 *value)
+    {
+        TomlData *data = TomlGetData(obj, key);
+        if (!data) return true;
+        if (data->type != Toml_String || data->sl >= TERRAIN_GRAPH_NAME_LEN) return false;
+
+        char name[TERRAIN_GRAPH_NAME_LEN];
+        memcpy(name, data->s, data->sl);
+        name[data->sl] = 0;
+
+        *value = TerrainGraphFindNode(graph, name);
+        return *value != TERRAIN_GRAPH_NONE;
+    }
+
+    file_internal bool
+    ReadTerrainNode(TerrainGraph *graph, TerrainNode *node, TomlObject *obj)
+    {
+        bool ok = true;
+        for (u32 i = 0; i < TerrainNodeInputCount(node->type); ++i)
+        {
+            ok &= GraphReadNode(graph, obj, g_terrain_input_names[(u32)node->type][i], &node->inputs[i]);
+        }
+
+        switch (node->type)
+        {
+            case TerrainNodeType::Noise:
+            {
+                u32 function = (u32)node->noise.function;
+                u32 fractal  = (u32)node->noise.cb.fractal;
+                Noise_CB *cb = &node->noise.cb;
+
+                // TOML integers are 32 bits, so the seed is stored as its low and high words
+                i32 seed_lo = (i32)(u32)cb->seed;
+                i32 seed_hi = (i32)(u32)(cb->seed >> 32);
+                ok &= GraphReadEnum(obj, "function", g_terrain_noise_names, Function_Count, &function);
+                ok &= GraphReadEnum(obj, "fractal", g_terrain_fractal_names, Fractal_Count, &fractal);
+                ok &= GraphReadFloat(obj, "scale",      &cb->scale);
+                ok &= GraphReadInt(obj,   "seed",       &seed_lo);
+                ok &= GraphReadInt(obj,   "seed_hi",    &seed_hi);
+                ok &= GraphReadInt(obj,   "octaves",    &cb->octaves);
+                ok &= GraphReadFloat(obj, "lacunarity", &cb->lacunarity);
+                ok &= GraphReadFloat(obj, "decay",      &cb->decay);
+                ok &= GraphReadFloat(obj, "threshold",  &cb->threshold);
+                node->noise.function = (ComputeFunction)function;
+                cb->fractal = (i32)fractal;
+                cb->seed    = ((u64)(u32)seed_hi << 32) | (u32)seed_lo;
+            } break;
+
+            case TerrainNodeType::Combine:
+            {
+                u32 op = (u32)node->combine.op;
+                ok &= GraphReadEnum(obj, "op", g_terrain_combine_names, (u32)TerrainCombineOp::Count, &op);
+                ok &= GraphReadFloat(obj, "weight", &node->combine.weight);
+                node->combine.op = (TerrainCombineOp)op;
+            } break;
+
+            case TerrainNodeType::Remap:
+            {
+                ok &= GraphReadFloat(obj, "in_min",   &node->remap.in_min);
+                ok &= GraphReadFloat(obj, "in_max",   &node->remap.in_max);
+                ok &= GraphReadFloat(obj, "out_min",  &node->remap.out_min);
+                ok &= GraphReadFloat(obj, "out_max",  &node->remap.out_max);
+                ok &= GraphReadFloat(obj, "exponent", &node->remap.exponent);
+            } break;
+
+            case TerrainNodeType::Erode:
+            {
+                HydraulicErosionDesc *hydraulic = &node->erode.hydraulic;
+                ThermalErosionDesc   *thermal   = &node->erode.thermal;
+                ok &= GraphReadUint(obj,  "seed",                  &hydraulic->seed);
+                ok &= GraphReadFloat(obj, "droplets_per_sample",   &hydraulic->droplets_per_sample);
+                ok &= GraphReadUint(obj,  "max_lifetime",          &hydraulic->max_lifetime);
+                ok &= GraphReadFloat(obj, "inertia",               &hydraulic->inertia);
+                ok &= GraphReadFloat(obj, "sediment_capacity",     &hydraulic->sediment_capacity);
+                ok &= GraphReadFloat(obj, "min_sediment_capacity", &hydraulic->min_sediment_capacity);
+                ok &= GraphReadFloat(obj, "erode_speed",           &hydraulic->erode_speed);
+                ok &= GraphReadFloat(obj, "deposit_speed",         &hydraulic->deposit_speed);
+                ok &= GraphReadFloat(obj, "evaporate_speed",       &hydraulic->evaporate_speed);
+                ok &= GraphReadFloat(obj, "gravity",               &hydraulic->gravity);
+                ok &= GraphReadFloat(obj, "initial_water",         &hydraulic->initial_water);
+                ok &= GraphReadFloat(obj, "initial_speed",         &hydraulic->initial_speed);
+                ok &= GraphReadUint(obj,  "radius",                &hydraulic->radius);
+                ok &= GraphReadUint(obj,  "tile_size",             &hydraulic->tile_size);
+                ok &= GraphReadUint(obj,  "thermal_iterations",    &thermal->iterations);
+                ok &= GraphReadFloat(obj, "talus",                 &thermal->talus);
+                ok &= GraphReadFloat(obj, "thermal_rate",          &thermal->rate);
+            } break;
+
+            case TerrainNodeType::Clamp:
+            {
+                ok &= GraphReadFloat(obj, "min", &node->clamp.min);
+                ok &= GraphReadFloat(obj, "max", &node->clamp.max);
+            } break;
+
+            default: break;
+        }
+
+        return ok;
+    }
+
+    file_internal void
+    GraphWrite(char **text, const char *fmt, ...)
+    {
+        va_list args;
+        va_start(args, fmt);
+        va_list copy;
+        va_copy(copy, args);
+        i32 len = vsnprintf(NULL, 0, fmt, copy);
+        va_end(copy);
+
+        // vsnprintf writes the null terminator, which is dropped again
+        u64 start = arrlen(*text);
+        arraddn(*text, len + 1);
+        vsnprintf(*text + start, len + 1, fmt, args);
+        arrsetlen(*text, start + len);
+        va_end(args);
+    }
+
+    // The TOML parser does not read exponents, so floats are written in fixed notation with the
+    // 9 significant digits a float needs to read back the same
+    file_internal void
+    GraphWriteFloat(char **text, const char *key, r32 value)
+    {
+        i32 decimals = 1;
+        if (value != 0.0f)
+        {
+            i32 exponent = (i32)floorf(log10f(fabsf(value)));
+            decimals = 8 - exponent;
+            decimals = (decimals < 1) ? 1 : ((decimals > 60) ? 60 : decimals);
+        }
+        GraphWrite(text, "%s = %.*f\n", key, decimals, value);
+    }
+
+    file_internal void
+    WriteTerrainNode(TerrainGraph *graph, TerrainNode *node, char **text)
+    {
+        GraphWrite(text, "\n[%s]\n", node->name);
+        GraphWrite(text, "type = \"%s\"\n", g_terrain_node_names[(u32)node->type]);
+        for (u32 i = 0; i < TerrainNodeInputCount(node->type); ++i)
+        {
+            if (node->inputs[i] == TERRAIN_GRAPH_NONE) continue;
+            GraphWrite(text, "%s = \"%s\"\n", g_terrain_input_names[(u32)node->type][i], graph->nodes[node->inputs[i]].name);
+        }
+
+        switch (node->type)
+        {
+            case TerrainNodeType::Noise:
+            {
+                Noise_CB *cb = &node->noise.cb;
+                GraphWrite(text, "function = \"%s\"\n", g_terrain_noise_names[node->noise.function]);
+                GraphWrite(text, "fractal = \"%s\"\n", g_terrain_fractal_names[cb->fractal]);
+                GraphWriteFloat(text, "scale", cb->scale);
+                GraphWrite(text, "seed = %d\n", (i32)(u32)cb->seed);
+                GraphWrite(text, "seed_hi = %d\n", (i32)(u32)(cb->seed >> 32));
+                GraphWrite(text, "octaves = %d\n", cb->octaves);
+                GraphWriteFloat(text, "lacunarity", cb->lacunarity);
+                GraphWriteFloat(text, "decay", cb->decay);
+                GraphWriteFloat(text, "threshold", cb->threshold);
+            } break;
+
+            case TerrainNodeType::Combine:
+            {
+                GraphWrite(text, "op = \"%s\"\n", g_terrain_combine_names[(u32)node->combine.op]);
+                GraphWriteFloat(text, "weight", node->combine.weight);
+            } break;
+
+            case TerrainNodeType::Remap:
+            {
+                GraphWriteFloat(text, "in_min",   node->remap.in_min);
+                GraphWriteFloat(text, "in_max",   node->remap.in_max);
+                GraphWriteFloat(text, "out_min",  node->remap.out_min);
+                GraphWriteFloat(text, "out_max",  node->remap.out_max);
+                GraphWriteFloat(text, "exponent", node->remap.exponent);
+            } break;
+
+            case TerrainNodeType::Erode:
+            {
+                HydraulicErosionDesc *hydraulic = &node->erode.hydraulic;
+                ThermalErosionDesc   *thermal   = &node->erode.thermal;
+                GraphWrite(text, "seed = %d\n", (i32)hydraulic->seed);
+                GraphWriteFloat(text, "droplets_per_sample",   hydraulic->droplets_per_sample);
+                GraphWrite(text, "max_lifetime = %u\n", hydraulic->max_lifetime);
+                GraphWriteFloat(text, "inertia",               hydraulic->inertia);
+                GraphWriteFloat(text, "sediment_capacity",     hydraulic->sediment_capacity);
+                GraphWriteFloat(text, "min_sediment_capacity", hydraulic->min_sediment_capacity);
+                GraphWriteFloat(text, "erode_speed",           hydraulic->erode_speed);
+                GraphWriteFloat(text, "deposit_speed",         hydraulic->deposit_speed);
+                GraphWriteFloat(text, "evaporate_speed",       hydraulic->evaporate_speed);
+                GraphWriteFloat(text, "gravity",               hydraulic->gravity);
+                GraphWriteFloat(text, "initial_water",         hydraulic->initial_water);
+                GraphWriteFloat(text, "initial_speed",         hydraulic->initial_speed);
+                GraphWrite(text, "radius = %u\n", hydraulic->radius);
+                GraphWrite(text, "tile_size = %u\n", hydraulic->tile_size);
+                GraphWrite(text, "thermal_iterations = %u\n", thermal->iterations);
+                GraphWriteFloat(text, "talus",                 thermal->talus);
+                GraphWriteFloat(text, "thermal_rate",          thermal->rate);
+            } break;
+
+            case TerrainNodeType::Clamp:
+            {
+                GraphWriteFloat(text, "min", node->clamp.min);
+                GraphWriteFloat(text, "max", node->clamp.max);
+            } break;
+
+            default: break;
+        }
+    }
+
+}; // terrain
+
+u32 terrain::TerrainNodeInputCount(TerrainNodeType type)
+{
+    u32 result = 0;
+    switch (type)
+    {
+        case TerrainNodeType::Combine: result = 2; break;
+        case TerrainNodeType::Remap:
+        case TerrainNodeType::Erode:
+        case TerrainNodeType::Clamp:   result = 1; break;
+        default: break;
+    }
+    return result;
+}
+
+void terrain::TerrainGraphInit(TerrainGraph *graph, u32 width, u32 height)
+{
+    *graph = {};
+    graph->width  = width;
+    graph->height = height;
+    graph->output = TERRAIN_GRAPH_NONE;
+}
+
+void terrain::TerrainGraphFree(TerrainGraph *graph)
+{
+    for (u32 i = 0; i < (u32)arrlen(graph->nodes); ++i)
+    {
+        if (graph->nodes[i].output) SysFree(graph->nodes[i].output);
+    }
+    arrfree(graph->nodes);
+    *graph = {};
+}
+
+void terrain::TerrainGraphResize(TerrainGraph *graph, u32 width, u32 height)
+{
+    for (u32 i = 0; i < (u32)arrlen(graph->nodes); ++i)
+    {
+        if (graph->nodes[i].output) SysFree(graph->nodes[i].output);
+        graph->nodes[i].output = NULL;
+    }
+    graph->width  = width;
+    graph->height = height;
+}
+
+u32 terrain::TerrainGraphAddNode(TerrainGraph *graph, TerrainNodeType type, const char *name)
+{
+    assert(strlen(name) < TERRAIN_GRAPH_NAME_LEN && "Terrain node name is too long");
+
+    TerrainNode node = {};
+    node.type = type;
+    strncpy(node.name, name, TERRAIN_GRAPH_NAME_LEN - 1);
+    for (u32 i = 0; i < TERRAIN_GRAPH_MAX_INPUTS; ++i) node.inputs[i] = TERRAIN_GRAPH_NONE;
+
+    node.noise.function      = Function_Perlin;
+    node.noise.cb.scale      = 0.004f;
+    node.noise.cb.octaves    = 6;
+    node.noise.cb.lacunarity = 2.0f;
+    node.noise.cb.decay      = 0.5f;
+    node.noise.cb.fractal    = Fractal_FBm;
+
+    node.combine.op          = TerrainCombineOp::Add;
+    node.combine.weight      = 1.0f;
+
+    node.remap.in_max        = 1.0f;
+    node.remap.out_max       = 1.0f;
+    node.remap.exponent      = 1.0f;
+
+    node.clamp.max           = 1.0f;
+
+    arrput(graph->nodes, node);
+    return (u32)arrlen(graph->nodes) - 1;
+}
+
+u32 terrain::TerrainGraphFindNode(TerrainGraph *graph, const char *name)
+{
+    for (u32 i = 0; i < (u32)arrlen(graph->nodes); ++i)
+    {
+        if (strcmp(graph->nodes[i].name, name) == 0) return i;
+    }
+    return TERRAIN_GRAPH_NONE;
+}
+
+void terrain::TerrainGraphConnect(TerrainGraph *graph, u32 from, u32 to, u32 input)
+{
+    assert(to < (u32)arrlen(graph->nodes) && input < TERRAIN_GRAPH_MAX_INPUTS);
+    graph->nodes[to].inputs[input] = from;
+}
+
+terrain::TerrainGraphResult terrain::TerrainGraphEvaluate(TerrainGraph *graph, u32 node, TerrainGraphStats *stats)
+{
+    if (stats) *stats = {};
+
+    u32 node_count = (u32)arrlen(graph->nodes);
+    if (node >= node_count) return TerrainGraphResult::InvalidNode;
+
+    TerrainGraphResult result = TerrainGraphResult::Success;
+
+    // Per node: 0 not visited, 1 on the stack, 2 done
+    u8  *state = (u8*)SysAlloc(node_count);
+    u32 *order = (u32*)SysAlloc(sizeof(u32) * node_count);  // needed nodes, inputs first
+    u32 *stack = (u32*)SysAlloc(sizeof(u32) * node_count);  // node
+    u32 *slot  = (u32*)SysAlloc(sizeof(u32) * node_count);  // next input to visit
+    memset(state, 0, node_count);
+
+    u32 order_count = 0;
+    u32 top = 0;
+    stack[top] = node;
+    slot[top]  = 0;
+    state[node] = 1;
+    ++top;
+
+    while (top > 0 && result == TerrainGraphResult::Success)
+    {
+        u32 current = stack[top - 1];
+        TerrainNode *n = &graph->nodes[current];
+
+        if (slot[top - 1] == 0 && !IsTerrainNodeValid(n))
+        {
+            result = TerrainGraphResult::InvalidNode;
+            break;
+        }
+
+        if (slot[top - 1] < TerrainNodeInputCount(n->type))
+        {
+            u32 input = n->inputs[slot[top - 1]++];
+            if (input >= node_count)   result = TerrainGraphResult::MissingInput;
+            else if (state[input] == 1) result = TerrainGraphResult::Cycle;
+            else if (state[input] == 0)
+            {
+                state[input] = 1;
+                stack[top] = input;
+                slot[top]  = 0;
+                ++top;
+            }
+            continue;
+        }
+
+        state[current] = 2;
+        order[order_count++] = current;
+        --top;
+    }
+
+    if (result == TerrainGraphResult::Success)
+    {
+        TerrainGraphEval eval = {};
+        eval.graph           = graph;
+        eval.hashes          = (u64*)SysAlloc(sizeof(u64) * node_count);
+        eval.dependents      = (u32*)SysAlloc(sizeof(u32) * node_count * TERRAIN_GRAPH_MAX_INPUTS);
+        eval.first_dependent = (u32*)SysAlloc(sizeof(u32) * (node_count + 1));
+        eval.pending         = (std::atomic<i32>*)SysAlloc(sizeof(std::atomic<i32>) * node_count);
+        eval.tasks           = (TerrainGraphTask*)SysAlloc(sizeof(TerrainGraphTask) * node_count);
+
+        // Hashes and dirty nodes, "state" now marks the dirty nodes
+        memset(state, 0, node_count);
+        memset(eval.first_dependent, 0, sizeof(u32) * (node_count + 1));
+        for (u32 i = 0; i < order_count; ++i)
+        {
+            u32 current = order[i];
+            TerrainNode *n = &graph->nodes[current];
+            u32 input_count = TerrainNodeInputCount(n->type);
+
+            u64 input_hashes[TERRAIN_GRAPH_MAX_INPUTS];
+            for (u32 k = 0; k < input_count; ++k) input_hashes[k] = eval.hashes[n->inputs[k]];
+
+            eval.hashes[current] = HashTerrainNode(graph, n, input_hashes);
+            state[current] = (!n->output || n->hash != eval.hashes[current]) ? 1 : 0;
+
+            // A clean node can have a dirty input (a new node with the same settings), it is
+            // not run so it is not a dependent
+            i32 dirty_inputs = 0;
+            for (u32 k = 0; k < input_count && state[current]; ++k)
+            {
+                if (state[n->inputs[k]])
+                {
+                    dirty_inputs++;
+                    eval.first_dependent[n->inputs[k] + 1]++;
+                }
+            }
+
+            eval.pending[current].store(dirty_inputs, std::memory_order_relaxed);
+            eval.tasks[current].eval = &eval;
+            eval.tasks[current].node = current;
+
+            if (stats)
+            {
+                if (state[current]) stats->nodes_evaluated++;
+                else                stats->nodes_cached++;
+            }
+        }
+
+        // Dependents of the dirty nodes, as offsets into eval.dependents
+        for (u32 i = 0; i < node_count; ++i) eval.first_dependent[i + 1] += eval.first_dependent[i];
+        u32 *fill = slot;
+        memcpy(fill, eval.first_dependent, sizeof(u32) * node_count);
+        for (u32 i = 0; i < order_count; ++i)
+        {
+            u32 current = order[i];
+            if (!state[current]) continue;
+
+            TerrainNode *n = &graph->nodes[current];
+            for (u32 k = 0; k < TerrainNodeInputCount(n->type); ++k)
+            {
+                if (state[n->inputs[k]]) eval.dependents[fill[n->inputs[k]]++] = current;
+            }
+        }
+        // Every counted dependent was written, TerrainGraphRunTask reads all of them
+        for (u32 i = 0; i < node_count; ++i) Assert(fill[i] == eval.first_dependent[i + 1]);
+
+        for (u32 i = 0; i < order_count; ++i)
+        {
+            u32 current = order[i];
+            if (state[current] && eval.pending[current].load(std::memory_order_relaxed) == 0)
+            {
+                JobSystemSubmit(TerrainGraphRunTask, &eval.tasks[current], &eval.counter);
+            }
+        }
+        JobSystemWait(&eval.counter);
+
+        SysFree(eval.tasks);
+        SysFree(eval.pending);
+        SysFree(eval.first_dependent);
+        SysFree(eval.dependents);
+        SysFree(eval.hashes);
+    }
+
+    SysFree(slot);
+    SysFree(stack);
+    SysFree(order);
+    SysFree(state);
+
+    return result;
+}
+
+terrain::TerrainGraphResult terrain::TerrainGraphLoad(TerrainGraph *graph, const char *path)
+{
+    TerrainGraphInit(graph, 0, 0);
+
+    Toml toml;
+    if (TomlLoad(&toml, path) != TomlResult_Success || TomlGetObjectCount(&toml) == 0)
+    {
+        TomlFree(&toml);
+        return TerrainGraphResult::FileError;
+    }
+
+    TerrainGraphResult result = TerrainGraphResult::Success;
+    i32 graph_object = -1;
+
+    // Nodes first, so the inputs can refer to nodes further down the file
+    for (i32 i = 0; i < TomlGetObjectCount(&toml) && result == TerrainGraphResult::Success; ++i)
+    {
+        const char *name = TomlGetObjectName(&toml, i);
+        if (strcmp(name, "graph") == 0)
+        {
+            graph_object = i;
+            continue;
+        }
+
+        TomlObject obj = TomlGetObjectAt(&toml, i);
+        u32 type = (u32)TerrainNodeType::Count;
+        if (strlen(name) >= TERRAIN_GRAPH_NAME_LEN || !TomlGetData(&obj, "type") ||
+            !GraphReadEnum(&obj, "type", g_terrain_node_names, (u32)TerrainNodeType::Count, &type))
+        {
+            result = TerrainGraphResult::InvalidNode;
+            break;
+        }
+        TerrainGraphAddNode(graph, (TerrainNodeType)type, name);
+    }
+
+    if (result == TerrainGraphResult::Success)
+    {
+        u32 node = 0;
+        for (i32 i = 0; i < TomlGetObjectCount(&toml); ++i)
+        {
+            if (i == graph_object) continue;
+
+            TomlObject obj = TomlGetObjectAt(&toml, i);
+            if (!ReadTerrainNode(graph, &graph->nodes[node++], &obj))
+            {
+                result = TerrainGraphResult::InvalidNode;
+                break;
+            }
+        }
+    }
+
+    if (result == TerrainGraphResult::Success)
+    {
+        if (graph_object < 0) result = TerrainGraphResult::FileError;
+        else
+        {
+            TomlObject obj = TomlGetObjectAt(&toml, graph_object);
+            if (!GraphReadUint(&obj, "width", &graph->width) || !GraphReadUint(&obj, "height", &graph->height) ||
+                !GraphReadNode(graph, &obj, "output", &graph->output))
+            {
+                result = TerrainGraphResult::InvalidNode;
+            }
+        }
+    }
+
+    TomlFree(&toml);
+    if (result != TerrainGraphResult::Success) TerrainGraphFree(graph);
+    return result;
+}
+
+terrain::TerrainGraphResult terrain::TerrainGraphSave(TerrainGraph *graph, const char *path)
+{
+    char *text = NULL;
+    GraphWrite(&text, "[graph]\n");
+    GraphWrite(&text, "width = %u\n", graph->width);
+    GraphWrite(&text, "height = %u\n", graph->height);
+    if (graph->output < (u32)arrlen(graph->nodes))
+    {
+        GraphWrite(&text, "output = \"%s\"\n", graph->nodes[graph->output].name);
+    }
+
+    for (u32 i = 0; i < (u32)arrlen(graph->nodes); ++i)
+    {
+        WriteTerrainNode(graph, &graph->nodes[i], &text);
+    }
+
+    PlatformErrorType error = PlatformWriteBufferToFile(path, (u8*)text, arrlen(text));
+    arrfree(text);
+
+    return (error == PlatformError_Success) ? TerrainGraphResult::Success : TerrainGraphResult::FileError;
+}
+
+terrain::TerrainGraphResult terrain::TerrainGraphBake(const char *graph_path, const char *terrain_path, u32 tile_size)
+{
+    TerrainGraph graph;
+    TerrainGraphResult result = TerrainGraphLoad(&graph, graph_path);
+    if (result != TerrainGraphResult::Success) return result;
+
+    TerrainGraphStats stats;
+    result = TerrainGraphEvaluate(&graph, graph.output, &stats);
+    if (result == TerrainGraphResult::Success)
+    {
+        LogInfo("Terrain graph \"%s\": evaluated %u nodes at %ux%u.", graph_path, stats.nodes_evaluated,
+                graph.width, graph.height);
+
+        TerrainNode *output = &graph.nodes[graph.output];
+        if (!TerrainFileWrite(terrain_path, output->output, graph.width, graph.height, tile_size))
+        {
+            result = TerrainGraphResult::FileError;
+        }
+    }
+
+    TerrainGraphFree(&graph);
+    return result;
+}
+
+#undef GRAPH_HASH_SEED
+#undef GRAPH_SAMPLES_PER_JOB
@@ -0,0 +1,175 @@
+#ifndef _TERRAIN_GRAPH_H
+#define _TERRAIN_GRAPH_H
+
+//
+// Terrain generation graph. Every node produces a width x height heightmap from its
+// parameters and the heightmaps of its inputs: noise (TerrainNoise.h), combine, remap,
+// erode (TerrainErosion.h) and clamp. The editor draws the graph in TerrainGenWindow,
+// and the headless build bakes it from a file (see TerrainGraphBake).
+//
+// Evaluating a node runs the nodes it depends on in dependency order. Nodes without a
+// path between them run at the same time on the job system: a node is submitted as soon
+// as its last input is done. Each node keeps its heightmap along with a hash of its
+// parameters and of the hashes of its inputs. A node is only run again when that hash
+// changes, so editing a node only re-runs the nodes downstream of it.
+//
+// A graph is stored as TOML, one object per node plus a "graph" object:
+//
+//     [graph]
+//     width  = 1024
+//     height = 1024
+//     output = "eroded"           node that is baked
+//
+//     [base]
+//     type     = "noise"
+//     function = "perlin"         see g_terrain_noise_names
+//     scale    = 0.004
+//     octaves  = 6
+//     seed     = 1                low 32 bits of the 64-bit seed, "seed_hi" holds the rest
+//
+//     [eroded]
+//     type  = "erode"
+//     input = "base"              combine nodes take "a" and "b"
+//
+// Parameters that are left out keep their default value. Node names are TOML identifiers.
+//
+
+#define TERRAIN_GRAPH_NONE          U32_MAX // no node
+#define TERRAIN_GRAPH_MAX_INPUTS    2
+#define TERRAIN_GRAPH_NAME_LEN      32
+
+namespace terrain
+{
+    enum class TerrainNodeType : u8
+    {
+        Noise,        // GenerateHeightmap
+        Combine,      // a and b combined with a TerrainCombineOp
+        Remap,        // [in_min, in_max] to [out_min, out_max], with a power curve
+        Erode,        // ErodeHydraulic, then ErodeThermal
+        Clamp,
+
+        Count,
+    };
+
+    enum class TerrainCombineOp : u8
+    {
+        Add,          // a + b * weight
+        Subtract,     // a - b * weight
+        Multiply,     // a * b
+        Min,
+        Max,
+        Lerp,         // a + (b - a) * weight
+
+        Count,
+    };
+
+    enum class TerrainGraphResult : u8
+    {
+        Success,
+        InvalidNode,  // unknown node or parameter out of range
+        MissingInput, // an input is not connected
+        Cycle,        // the node depends on itself
+        FileError,    // the graph file could not be read or written
+    };
+
+    struct TerrainNodeNoise
+    {
+        ComputeFunction function;
+        Noise_CB        cb;
+    };
+
+    struct TerrainNodeCombine
+    {
+        TerrainCombineOp op;
+        r32              weight;
+    };
+
+    struct TerrainNodeRemap
+    {
+        r32 in_min;
+        r32 in_max;
+        r32 out_min;
+        r32 out_max;
+        r32 exponent;  // applied to the input once it is normalized to [0, 1]
+    };
+
+    struct TerrainNodeErode
+    {
+        HydraulicErosionDesc hydraulic;  // no droplets to skip it
+        ThermalErosionDesc   thermal;    // no iterations to skip it
+    };
+
+    struct TerrainNodeClamp
+    {
+        r32 min;
+        r32 max;
+    };
+
+    struct TerrainNode
+    {
+        TerrainNodeType type;
+        char            name[TERRAIN_GRAPH_NAME_LEN];
+        u32             inputs[TERRAIN_GRAPH_MAX_INPUTS]; // node indices, TERRAIN_GRAPH_NONE if not connected
+
+        // Parameters, the ones of "type" are used
+        TerrainNodeNoise   noise;
+        TerrainNodeCombine combine;
+        TerrainNodeRemap   remap;
+        TerrainNodeErode   erode;
+        TerrainNodeClamp   clamp;
+
+        // Cache, written by TerrainGraphEvaluate
+        u64             hash;   // hash "output" was produced with
+        r32            *output; // width x height samples, NULL until the node is evaluated
+    };
+
+    struct TerrainGraph
+    {
+        TerrainNode *nodes;     // stb_ds array, edit the parameters in place
+        u32          width;
+        u32          height;
+        u32          output;    // node baked by TerrainGraphBake
+    };
+
+    struct TerrainGraphStats
+    {
+        u32 nodes_evaluated;    // nodes that were run
+        u32 nodes_cached;       // nodes that were needed but still up to date
+    };
+
+    // Names used in the graph files, indexed by the enums
+    extern const char *g_terrain_node_names[(u32)TerrainNodeType::Count];
+    extern const char *g_terrain_combine_names[(u32)TerrainCombineOp::Count];
+    extern const char *g_terrain_noise_names[Function_Count];
+    extern const char *g_terrain_fractal_names[Fractal_Count];
+
+    void TerrainGraphInit(TerrainGraph *graph, u32 width, u32 height);
+    void TerrainGraphFree(TerrainGraph *graph);
+    // Drops the cached heightmaps
+    void TerrainGraphResize(TerrainGraph *graph, u32 width, u32 height);
+
+    // Adds a node with the default parameters of "type" and no inputs, returns its index
+    u32  TerrainGraphAddNode(TerrainGraph *graph, TerrainNodeType type, const char *name);
+    // Returns TERRAIN_GRAPH_NONE if there is no node called "name"
+    u32  TerrainGraphFindNode(TerrainGraph *graph, const char *name);
+    // Connects the output of "from" to input "input" of "to"
+    void TerrainGraphConnect(TerrainGraph *graph, u32 from, u32 to, u32 input);
+    // Inputs a node of "type" reads
+    u32  TerrainNodeInputCount(TerrainNodeType type);
+
+    // Brings "node" and the nodes it depends on up to date. The heightmap is in
+    // graph->nodes[node].output, until the node is evaluated again or the graph is resized.
+    // @param stats: (output) optional
+    TerrainGraphResult TerrainGraphEvaluate(TerrainGraph *graph, u32 node, TerrainGraphStats *stats = NULL);
+
+    // @param graph: (output) initialized by the call, free it with TerrainGraphFree
+    TerrainGraphResult TerrainGraphLoad(TerrainGraph *graph, const char *path);
+    TerrainGraphResult TerrainGraphSave(TerrainGraph *graph, const char *path);
+
+    // Loads a graph, evaluates its output node and writes it as a terrain file (TerrainFile.h)
+    // @param tile_size: samples on a tile side of the terrain file, 2^n + 1
+    TerrainGraphResult TerrainGraphBake(const char *graph_path, const char *terrain_path, u32 tile_size = 257);
+
+}; // terrain
+
+#endif //_TERRAIN_GRAPH_H
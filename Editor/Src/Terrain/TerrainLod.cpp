@@ -0,0 +1,423 @@
+
+// NOTE(Dustin): The geometric error of a tile is measured against its own mesh, with the
+// triangulation of the Standard mesher (cells split along the top right - bottom left
+// diagonal), at every full resolution sample the tile covers. A parent takes the max of its
+// error and its children's errors, so splitting a tile never increases the error on screen.
+
+#define LOD_MAX_LEVELS      16    // node x/y are stored in 16 bits
+#define LOD_SAMPLES_PER_JOB 65536 // rough number of heightmap samples each build job reads
+
+namespace terrain
+{
+    struct LodBuildJob
+    {
+        TerrainQuadtree *tree;
+        const r32       *heightmap;
+        u32              heightmap_size;
+        u32              level;
+    };
+
+    struct LodFrame
+    {
+        TerrainQuadtree  *tree;
+        TerrainLodView   *view;
+        v4                planes[6];  // view frustum, normals point inside
+        r32               lod_factor; // screen pixels per world unit at a distance of 1
+        TerrainLodNode  **nodes;
+        TerrainLodStats  *stats;
+    };
+
+    FORCE_INLINE u32
+    LodLevelOffset(u32 level)
+    {
+        return (u32)(((1ULL << (2 * level)) - 1) / 3);
+    }
+
+    FORCE_INLINE u32
+    LodNodeIndex(u32 level, u32 x, u32 y)
+    {
+        return LodLevelOffset(level) + (y << level) + x;
+    }
+
+    FORCE_INLINE bool
+    LodIsSplit(TerrainQuadtree *tree, u32 node)
+    {
+        return (tree->split[node / 64] >> (node % 64)) & 1;
+    }
+
+    FORCE_INLINE void
+    LodSetSplit(TerrainQuadtree *tree, u32 node)
+    {
+        tree->split[node / 64] |= 1ULL << (node % 64);
+    }
+
+    FORCE_INLINE bool
+    IsPowerOfTwo(u32 v)
+    {
+        return v > 0 && (v & (v - 1)) == 0;
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // Build
+
+    // Job callback, bounds of the full resolution tiles [begin, end)
+    file_internal void
+    LodBuildLeaves(u32 begin, u32 end, void *args)
+    {
+        LodBuildJob *job = (LodBuildJob*)args;
+        TerrainQuadtree *tree = job->tree;
+
+        u32 level = job->level;
+        u32 cells = tree->tile_vertices - 1;
+        u32 side  = 1 << level;
+
+        for (u32 n = begin; n < end; ++n)
+        {
+            u32 x = n % side;
+            u32 y = n / side;
+
+            // NOTE(Dustin): fast_minf/fast_maxf are not exact, and against a R32_MAX sentinel they
+            // return 0, so the bounds are seeded with a sample and compared directly.
+            r32 min_h = job->heightmap[(u64)y * cells * job->heightmap_size + x * cells];
+            r32 max_h = min_h;
+            for (u32 j = 0; j <= cells; ++j)
+            {
+                const r32 *row = job->heightmap + (u64)(y * cells + j) * job->heightmap_size + x * cells;
+                for (u32 i = 0; i <= cells; ++i)
+                {
+                    if (row[i] < min_h) min_h = row[i];
+                    if (row[i] > max_h) max_h = row[i];
+                }
+            }
+
+            u32 node = LodNodeIndex(level, x, y);
+            tree->min_height[node] = min_h * tree->height_scale;
+            tree->max_height[node] = max_h * tree->height_scale;
+            tree->error[node]      = 0.0f;
+        }
+    }
+
+    // Job callback, bounds and errors of the tiles [begin, end) of a level above the leaves
+    file_internal void
+    LodBuildInner(u32 begin, u32 end, void *args)
+    {
+        LodBuildJob *job = (LodBuildJob*)args;
+        TerrainQuadtree *tree = job->tree;
+
+        u32 level = job->level;
+        u32 cells = tree->tile_vertices - 1;
+        u32 side  = 1 << level;
+        u32 step  = 1 << (tree->levels - 1 - level); // heightmap samples between tile vertices
+        r32 inv_step = 1.0f / (r32)step;
+
+        for (u32 n = begin; n < end; ++n)
+        {
+            u32 x = n % side;
+            u32 y = n / side;
+            u32 origin_x = x * cells * step;
+            u32 origin_y = y * cells * step;
+
+            r32 max_error = 0.0f;
+            for (u32 cr = 0; cr < cells; ++cr)
+            {
+                for (u32 cc = 0; cc < cells; ++cc)
+                {
+                    u32 sx = origin_x + cc * step;
+                    u32 sy = origin_y + cr * step;
+
+                    const r32 *top    = job->heightmap + (u64)sy * job->heightmap_size + sx;
+                    const r32 *bottom = top + (u64)step * job->heightmap_size;
+
+                    r32 h00 = top[0];
+                    r32 h10 = top[step];
+                    r32 h01 = bottom[0];
+                    r32 h11 = bottom[step];
+
+                    for (u32 j = 0; j <= step; ++j)
+                    {
+                        const r32 *row = top + (u64)j * job->heightmap_size;
+                        r32 v = (r32)j * inv_step;
+                        for (u32 i = 0; i <= step; ++i)
+                        {
+                            r32 u = (r32)i * inv_step;
+                            r32 h = (u + v <= 1.0f)
+                                ? h00 + u * (h10 - h00) + v * (h01 - h00)
+                                : h11 + (1.0f - u) * (h01 - h11) + (1.0f - v) * (h10 - h11);
+                            max_error = fast_maxf(max_error, fabsf(h - row[i]));
+                        }
+                    }
+                }
+            }
+
+            u32 node = LodNodeIndex(level, x, y);
+            u32 first = LodNodeIndex(level + 1, 2 * x, 2 * y);
+            r32 min_h = tree->min_height[first];
+            r32 max_h = tree->max_height[first];
+            r32 error = max_error * tree->height_scale;
+            for (u32 c = 0; c < 4; ++c)
+            {
+                u32 child = LodNodeIndex(level + 1, 2 * x + (c & 1), 2 * y + (c >> 1));
+                if (tree->min_height[child] < min_h) min_h = tree->min_height[child];
+                if (tree->max_height[child] > max_h) max_h = tree->max_height[child];
+                if (tree->error[child] > error)      error = tree->error[child];
+            }
+
+            tree->min_height[node] = min_h;
+            tree->max_height[node] = max_h;
+            tree->error[node]      = error;
+        }
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // Selection
+
+    // Gribb & Hartmann, the planes are combinations of the rows of the clip matrix
+    file_internal void
+    LodExtractFrustum(m4 *m, v4 planes[6])
+    {
+        v4 rows[4];
+        for (u32 i = 0; i < 4; ++i)
+        {
+            rows[i] = { m->p[0][i], m->p[1][i], m->p[2][i], m->p[3][i] };
+        }
+
+        for (u32 i = 0; i < 3; ++i)
+        {
+            planes[2 * i + 0] = { rows[3].x + rows[i].x, rows[3].y + rows[i].y, rows[3].z + rows[i].z, rows[3].w + rows[i].w };
+            planes[2 * i + 1] = { rows[3].x - rows[i].x, rows[3].y - rows[i].y, rows[3].z - rows[i].z, rows[3].w - rows[i].w };
+        }
+    }
+
+    FORCE_INLINE void
+    LodNodeAabb(TerrainQuadtree *tree, u32 level, u32 x, u32 y, v3 *min, v3 *max)
+    {
+        u32 node = LodNodeIndex(level, x, y);
+        r32 size = tree->world_size / (r32)(1 << level);
+
+        *min = { (r32)x * size,       tree->min_height[node], (r32)y * size       };
+        *max = { (r32)(x + 1) * size, tree->max_height[node], (r32)(y + 1) * size };
+    }
+
+    file_internal bool
+    LodIsVisible(LodFrame *frame, v3 min, v3 max)
+    {
+        for (u32 i = 0; i < 6; ++i)
+        {
+            v4 p = frame->planes[i];
+
+            // Corner of the box furthest along the plane normal
+            r32 d = p.x * ((p.x >= 0.0f) ? max.x : min.x) +
+                    p.y * ((p.y >= 0.0f) ? max.y : min.y) +
+                    p.z * ((p.z >= 0.0f) ? max.z : min.z) + p.w;
+            if (d < 0.0f) return false;
+        }
+        return true;
+    }
+
+    file_internal bool
+    LodNeedsSplit(LodFrame *frame, u32 level, u32 x, u32 y, v3 min, v3 max)
+    {
+        TerrainQuadtree *tree = frame->tree;
+        if (level + 1 >= tree->levels) return false;
+
+        r32 error = tree->error[LodNodeIndex(level, x, y)];
+        if (error <= 0.0f) return false;
+
+        v3 pos = frame->view->position;
+        r32 dx = fast_maxf(fast_maxf(min.x - pos.x, pos.x - max.x), 0.0f);
+        r32 dy = fast_maxf(fast_maxf(min.y - pos.y, pos.y - max.y), 0.0f);
+        r32 dz = fast_maxf(fast_maxf(min.z - pos.z, pos.z - max.z), 0.0f);
+        r32 distance = sqrtf(dx * dx + dy * dy + dz * dz);
+
+        return error * frame->lod_factor > frame->view->max_screen_error * distance;
+    }
+
+    // Splits a tile and whatever is needed to keep every tile within one level of its neighbours:
+    // the parent, and the parents of the neighbours, so they exist at this level.
+    file_internal void
+    LodForceSplit(TerrainQuadtree *tree, u32 level, u32 x, u32 y)
+    {
+        u32 node = LodNodeIndex(level, x, y);
+        if (LodIsSplit(tree, node)) return;
+
+        LodSetSplit(tree, node);
+        if (level == 0) return;
+
+        u32 side = 1 << level;
+        LodForceSplit(tree, level - 1, x / 2, y / 2);
+        if (x > 0)        LodForceSplit(tree, level - 1, (x - 1) / 2, y / 2);
+        if (x + 1 < side) LodForceSplit(tree, level - 1, (x + 1) / 2, y / 2);
+        if (y > 0)        LodForceSplit(tree, level - 1, x / 2, (y - 1) / 2);
+        if (y + 1 < side) LodForceSplit(tree, level - 1, x / 2, (y + 1) / 2);
+    }
+
+    // First pass, splits the visible tiles that are over the screen error
+    file_internal void
+    LodRefine(LodFrame *frame, u32 level, u32 x, u32 y)
+    {
+        frame->stats->nodes_visited++;
+
+        v3 min, max;
+        LodNodeAabb(frame->tree, level, x, y, &min, &max);
+        if (!LodIsVisible(frame, min, max))
+        {
+            frame->stats->nodes_culled++;
+            return;
+        }
+
+        if (LodNeedsSplit(frame, level, x, y, min, max))
+        {
+            LodForceSplit(frame->tree, level, x, y);
+            for (u32 c = 0; c < 4; ++c)
+            {
+                LodRefine(frame, level + 1, 2 * x + (c & 1), 2 * y + (c >> 1));
+            }
+        }
+    }
+
+    // True if the neighbour of a tile at (x, y) is drawn at a coarser level
+    FORCE_INLINE bool
+    LodIsCoarser(TerrainQuadtree *tree, u32 level, i32 x, i32 y)
+    {
+        i32 side = 1 << level;
+        if (level == 0 || x < 0 || y < 0 || x >= side || y >= side) return false;
+        return !LodIsSplit(tree, LodNodeIndex(level - 1, (u32)x / 2, (u32)y / 2));
+    }
+
+    // Second pass, emits the unsplit visible tiles. Tiles split to balance the tree were not
+    // refined, so visibility is tested again here.
+    file_internal void
+    LodEmit(LodFrame *frame, u32 level, u32 x, u32 y)
+    {
+        TerrainQuadtree *tree = frame->tree;
+        frame->stats->nodes_visited++;
+
+        if (LodIsSplit(tree, LodNodeIndex(level, x, y)))
+        {
+            for (u32 c = 0; c < 4; ++c)
+            {
+                LodEmit(frame, level + 1, 2 * x + (c & 1), 2 * y + (c >> 1));
+            }
+            return;
+        }
+
+        v3 min, max;
+        LodNodeAabb(tree, level, x, y, &min, &max);
+        if (!LodIsVisible(frame, min, max)) return;
+
+        TerrainLodNode node = {};
+        node.level = (u8)level;
+        node.x     = (u16)x;
+        node.y     = (u16)y;
+        if (LodIsCoarser(tree, level, (i32)x,     (i32)y - 1)) node.stitch_edges |= Edge_NegZ;
+        if (LodIsCoarser(tree, level, (i32)x + 1, (i32)y    )) node.stitch_edges |= Edge_PosX;
+        if (LodIsCoarser(tree, level, (i32)x,     (i32)y + 1)) node.stitch_edges |= Edge_PosZ;
+        if (LodIsCoarser(tree, level, (i32)x - 1, (i32)y    )) node.stitch_edges |= Edge_NegX;
+
+        arrput(*frame->nodes, node);
+        frame->stats->nodes_selected++;
+        frame->stats->triangles += tree->triangle_counts[node.stitch_edges];
+    }
+
+}; // terrain
+
+bool terrain::QuadtreeInit(TerrainQuadtree *tree, TerrainLodDesc *desc)
+{
+    *tree = {};
+
+    u32 cells = desc->tile_vertices - 1;
+    if (desc->tile_vertices < 3 || !IsPowerOfTwo(cells)) return false;
+    if (desc->heightmap_size < desc->tile_vertices || (desc->heightmap_size - 1) % cells != 0) return false;
+
+    u32 root_tiles = (desc->heightmap_size - 1) / cells; // full resolution tiles on a side
+    if (!IsPowerOfTwo(root_tiles)) return false;
+
+    u32 levels = 1;
+    while ((1u << (levels - 1)) < root_tiles) ++levels;
+    if (levels > LOD_MAX_LEVELS) return false;
+
+    tree->levels         = levels;
+    tree->tile_vertices  = desc->tile_vertices;
+    tree->heightmap_size = desc->heightmap_size;
+    tree->world_size     = desc->world_size;
+    tree->height_scale   = desc->height_scale;
+    tree->node_count     = LodLevelOffset(levels);
+
+    tree->min_height = (r32*)SysAlloc(sizeof(r32) * tree->node_count);
+    tree->max_height = (r32*)SysAlloc(sizeof(r32) * tree->node_count);
+    tree->error      = (r32*)SysAlloc(sizeof(r32) * tree->node_count);
+    tree->split      = (u64*)SysAlloc(sizeof(u64) * ((tree->node_count + 63) / 64));
+
+    LodBuildJob job = {};
+    job.tree           = tree;
+    job.heightmap      = desc->heightmap;
+    job.heightmap_size = desc->heightmap_size;
+
+    // Every level reads the whole heightmap once, from the leaves up to the root
+    for (u32 level = levels; level-- > 0;)
+    {
+        job.level = level;
+
+        u32 tiles = 1 << (2 * level);
+        u32 samples_per_tile = (root_tiles >> level) * cells;
+        samples_per_tile *= samples_per_tile;
+        u32 tiles_per_job = (samples_per_tile < LOD_SAMPLES_PER_JOB) ? LOD_SAMPLES_PER_JOB / samples_per_tile : 1;
+
+        JobSystemParallelFor(tiles, tiles_per_job, (level + 1 == levels) ? LodBuildLeaves : LodBuildInner, &job);
+    }
+
+    for (u32 edges = 0; edges <= Edge_All; ++edges)
+    {
+        TerrainMeshDesc mesh_desc = {};
+        mesh_desc.meshing_strategy = TerrainMeshType::Standard;
+        mesh_desc.width            = desc->tile_vertices;
+        mesh_desc.height           = desc->tile_vertices;
+        mesh_desc.stitch_edges     = edges;
+
+        TerrainMesh mesh = {};
+        BuildMesh(&mesh_desc, &mesh);
+        tree->triangle_counts[edges] = mesh.index_count / 3;
+    }
+
+    return true;
+}
+
+void terrain::QuadtreeFree(TerrainQuadtree *tree)
+{
+    if (tree->min_height) SysFree(tree->min_height);
+    if (tree->max_height) SysFree(tree->max_height);
+    if (tree->error)      SysFree(tree->error);
+    if (tree->split)      SysFree(tree->split);
+    *tree = {};
+}
+
+void terrain::QuadtreeSelect(TerrainQuadtree *tree, TerrainLodView *view, TerrainLodNode **nodes,
+                             TerrainLodStats *stats)
+{
+    TerrainLodStats local_stats = {};
+
+    LodFrame frame = {};
+    frame.tree       = tree;
+    frame.view       = view;
+    frame.lod_factor = view->viewport_height / (2.0f * tanf(0.5f * degrees_to_radians(view->fov)));
+    frame.nodes      = nodes;
+    frame.stats      = stats ? stats : &local_stats;
+    *frame.stats     = {};
+    LodExtractFrustum(&view->proj_view, frame.planes);
+
+    arrsetlen(*nodes, 0);
+    if (tree->levels == 0) return;
+
+    memset(tree->split, 0, sizeof(u64) * ((tree->node_count + 63) / 64));
+
+    LodRefine(&frame, 0, 0, 0);
+    LodEmit(&frame, 0, 0, 0);
+}
+
+void terrain::QuadtreeNodeBounds(TerrainQuadtree *tree, TerrainLodNode *node, v3 *min, v3 *max)
+{
+    LodNodeAabb(tree, node->level, node->x, node->y, min, max);
+}
+
+#undef LOD_SAMPLES_PER_JOB
+#undef LOD_MAX_LEVELS
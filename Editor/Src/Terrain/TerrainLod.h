@@ -0,0 +1,89 @@
+#ifndef _TERRAIN_LOD_H
+#define _TERRAIN_LOD_H
+
+//
+// Chunked LOD for large terrains. The heightmap is covered by a quadtree of tiles, where
+// every tile is drawn with the same tile_vertices x tile_vertices grid, so a tile one level
+// up covers 4x the area at half the resolution. Each tile stores its height bounds and its
+// geometric error: how far (in world units) its mesh is from the full resolution heightmap.
+//
+// Every frame QuadtreeSelect walks the tree from the root, culls tiles outside the view
+// frustum and splits a tile while its error projected on the screen is over the allowed
+// pixel error. Neighbouring tiles are kept within one level of each other, and the edges
+// of a tile that meet a coarser neighbour are marked so they can be drawn with the stitched
+// index set (see TerrainMeshDesc::stitch_edges), so there are no cracks between levels.
+//
+// Selection only needs the CPU, so it can be tested and profiled headless.
+//
+
+namespace terrain
+{
+    struct TerrainLodDesc
+    {
+        const r32 *heightmap;  // heightmap_size x heightmap_size samples, row-major
+        u32 heightmap_size;    // (tile_vertices - 1) * 2^(levels - 1) + 1
+        u32 tile_vertices;     // vertices on a tile side, 2^n + 1
+        r32 world_size;        // world units covered by the heightmap in x and z
+        r32 height_scale;      // world height of a heightmap value of 1
+    };
+
+    struct TerrainQuadtree
+    {
+        u32  levels;           // level 0 is the root, level "levels - 1" the full resolution tiles
+        u32  tile_vertices;
+        u32  heightmap_size;
+        r32  world_size;
+        r32  height_scale;
+
+        // Per node, nodes of level L start at (4^L - 1) / 3 and are stored row-major
+        u32  node_count;
+        r32 *min_height;       // world units
+        r32 *max_height;       // world units
+        r32 *error;            // world units, never smaller than the error of the children
+
+        u64 *split;            // bit per node, rebuilt by every QuadtreeSelect
+        u32  triangle_counts[Edge_All + 1]; // per stitch_edges combination
+    };
+
+    struct TerrainLodView
+    {
+        v3  position;          // camera position, world space
+        m4  proj_view;         // used to extract the view frustum
+        r32 viewport_height;   // pixels
+        r32 fov;               // vertical field of view, degrees
+        r32 max_screen_error;  // pixels a tile may be off by before it is split
+    };
+
+    // A tile to draw
+    struct TerrainLodNode
+    {
+        u8  level;
+        u8  stitch_edges;      // TerrainEdge bits that meet a coarser tile
+        u16 x;                 // tile within the level
+        u16 y;
+    };
+
+    struct TerrainLodStats
+    {
+        u32 nodes_visited;     // visits of both selection passes
+        u32 nodes_culled;
+        u32 nodes_selected;
+        u64 triangles;
+    };
+
+    // Computes the tile bounds and errors, the heightmap is not referenced after this returns.
+    // Returns false if the heightmap and tile sizes do not form a quadtree.
+    bool QuadtreeInit(TerrainQuadtree *tree, TerrainLodDesc *desc);
+    void QuadtreeFree(TerrainQuadtree *tree);
+
+    // @param nodes: (output) stb_ds array, cleared and filled with the tiles to draw
+    // @param stats: (output) optional
+    void QuadtreeSelect(TerrainQuadtree *tree, TerrainLodView *view, TerrainLodNode **nodes,
+                        TerrainLodStats *stats = NULL);
+
+    // World space bounds of a tile
+    void QuadtreeNodeBounds(TerrainQuadtree *tree, TerrainLodNode *node, v3 *min, v3 *max);
+
+}; // terrain
+
+#endif //_TERRAIN_LOD_H
@@ -0,0 +1,1277 @@
+
+// NOTE(Dustin): Vertex positions and uvs follow the grid the renderer has always used:
+// vertex (c, r) sits at -0.5 + c / width and the uvs wrap "tiling" times across the tile.
+// Meshers that place vertices off the grid points (Pizza) use fractional (c, r).
+
+#define MESH_ROWS_PER_JOB 16 // rows of a mesh handed to each meshing job
+
+namespace terrain
+{
+    struct MeshJob
+    {
+        TerrainMeshDesc *desc;
+        void            *vertices; // in desc->vertex_format
+        u32             *indices;
+    };
+
+    FORCE_INLINE bool
+    IsValidGrid(TerrainMeshDesc *desc)
+    {
+        return desc->width >= 2 && desc->height >= 2;
+    }
+
+    // Vertex (c, r) of the grid sits on heightmap sample (c, r)
+    FORCE_INLINE TerrainNormalDesc
+    GridNormalDesc(TerrainMeshDesc *desc)
+    {
+        TerrainNormalDesc result = {};
+        result.heightmap    = desc->heightmap;
+        result.width        = desc->width;
+        result.height       = desc->height;
+        result.spacing_x    = 1.0f / (r32)desc->width;
+        result.spacing_z    = 1.0f / (r32)desc->height;
+        result.height_scale = desc->height_scale;
+        result.kernel       = desc->normal_kernel;
+        return result;
+    }
+
+    // Normal of the heightmap sample closest to (c, r), up without a heightmap
+    FORCE_INLINE v3
+    GridNormal(TerrainMeshDesc *desc, r32 c, r32 r)
+    {
+        if (!desc->heightmap)
+        {
+            v3 up = { 0.0f, 1.0f, 0.0f };
+            return up;
+        }
+
+        TerrainNormalDesc normal_desc = GridNormalDesc(desc);
+        return SampleNormal(&normal_desc, (u32)(c + 0.5f), (u32)(r + 0.5f));
+    }
+
+    // Grid vertex, the normal is left to the caller
+    FORCE_INLINE TerrainVertex
+    GridVertexNoNormal(TerrainMeshDesc *desc, r32 c, r32 r)
+    {
+        const r32 min_x = -0.5f;
+        const r32 max_x =  0.5f;
+
+        const r32 min_z = -0.5f;
+        const r32 max_z =  0.5f;
+
+        const r32 step_x = (r32)(max_x - min_x) / (r32)desc->width;
+        const r32 step_z = (r32)(max_z - min_z) / (r32)desc->height;
+
+        TerrainVertex result;
+
+        r32 uvx = desc->tiling * (c / (r32)desc->width);
+        r32 uvz = desc->tiling * (r / (r32)desc->height);
+
+        result.uvs.x = (r32)(uvx - (i32)uvx);
+        result.uvs.y = (r32)(uvz - (i32)uvz);
+
+        result.pos.x = min_x + c * step_x;
+        result.pos.y = min_z + r * step_z;
+
+        return result;
+    }
+
+    FORCE_INLINE TerrainCompactVertex
+    CompactGridVertex(TerrainMeshDesc *desc, r32 c, r32 r, v3 normal)
+    {
+        TerrainCompactVertex result;
+        result.grid_x = (u16)(2.0f * c + 0.5f);
+        result.grid_z = (u16)(2.0f * r + 0.5f);
+        // Without a heightmap every normal is up, which encodes to 0
+        result.norms  = desc->heightmap ? OctEncode(normal.x, normal.y, normal.z) : 0;
+        return result;
+    }
+
+    // Writes vertex "index" of grid point (c, r) in the vertex format of the mesh
+    FORCE_INLINE void
+    PutGridVertex(TerrainMeshDesc *desc, void *vertices, u32 index, r32 c, r32 r, v3 normal)
+    {
+        if (desc->vertex_format == TerrainVertexFormat::Compact)
+        {
+            ((TerrainCompactVertex*)vertices)[index] = CompactGridVertex(desc, c, r, normal);
+        }
+        else
+        {
+            TerrainVertex vertex = GridVertexNoNormal(desc, c, r);
+            vertex.norms = normal;
+            ((TerrainVertex*)vertices)[index] = vertex;
+        }
+    }
+
+    FORCE_INLINE void
+    PutGridVertex(TerrainMeshDesc *desc, void *vertices, u32 index, r32 c, r32 r)
+    {
+        PutGridVertex(desc, vertices, index, c, r, GridNormal(desc, c, r));
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // Grid vertices, shared by the Standard and TriangleStrip meshes
+
+    // Job callback, fills rows [begin, end) of the grid vertices
+    file_internal void
+    GridVertexRows(u32 begin, u32 end, void *args)
+    {
+        MeshJob *job = (MeshJob*)args;
+        TerrainMeshDesc *desc = job->desc;
+
+        // The rows of the grid are the rows of the heightmap, so the normals are baked a
+        // row at a time instead of one vertex at a time
+        TerrainNormalDesc normal_desc = GridNormalDesc(desc);
+        v3 up = GridNormal(desc, 0.0f, 0.0f);
+
+        if (desc->vertex_format == TerrainVertexFormat::Compact)
+        {
+            TerrainCompactVertex *vertices = (TerrainCompactVertex*)job->vertices;
+
+            for (u32 r = begin; r < end; ++r)
+            {
+                TerrainCompactVertex *row = vertices + r * desc->width;
+                for (u32 c = 0; c < desc->width; ++c)
+                {
+                    row[c].grid_x = (u16)(2 * c);
+                    row[c].grid_z = (u16)(2 * r);
+                    row[c].norms  = 0; // up
+                }
+            }
+
+            if (desc->heightmap)
+            {
+                BakeNormalRowsOct(&normal_desc, begin, end, &vertices[0].norms, sizeof(TerrainCompactVertex));
+            }
+        }
+        else
+        {
+            TerrainVertex *vertices = (TerrainVertex*)job->vertices;
+
+            for (u32 r = begin; r < end; ++r)
+            {
+                TerrainVertex *row = vertices + r * desc->width;
+                for (u32 c = 0; c < desc->width; ++c)
+                {
+                    row[c] = GridVertexNoNormal(desc, (r32)c, (r32)r);
+                    row[c].norms = up;
+                }
+            }
+
+            if (desc->heightmap)
+            {
+                BakeNormalRows(&normal_desc, begin, end, &vertices[0].norms, sizeof(TerrainVertex), NULL, 0);
+            }
+        }
+    }
+
+    file_internal void
+    BuildGridVertices(TerrainMeshDesc *desc, TerrainMesh *mesh)
+    {
+        mesh->vertex_count = desc->width * desc->height;
+        if (mesh->vertices)
+        {
+            MeshJob job = {};
+            job.desc     = desc;
+            job.vertices = mesh->vertices;
+            JobSystemParallelFor(desc->height, MESH_ROWS_PER_JOB, GridVertexRows, &job);
+        }
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // Standard: triangle list, two triangles per grid cell
+
+    file_internal void
+    StandardCapacity(TerrainMeshDesc *desc, u32 *max_vertices, u32 *max_indices)
+    {
+        bool valid = IsValidGrid(desc);
+        *max_vertices = valid ? desc->width * desc->height : 0;
+        *max_indices  = valid ? 6 * (desc->width - 1) * (desc->height - 1) : 0;
+    }
+
+    // Job callback, fills the indices of cell rows [begin, end)
+    file_internal void
+    StandardIndexRows(u32 begin, u32 end, void *args)
+    {
+        MeshJob *job = (MeshJob*)args;
+        u32 w = job->desc->width;
+
+        u32 i = begin * 6 * (w - 1);
+        for (u32 r = begin; r < end; ++r)
+        {
+            for (u32 c = 0; c < w - 1; ++c)
+            {
+                u32 top    = (r + 0) * w + c;
+                u32 bottom = (r + 1) * w + c;
+
+                // Same winding as the triangle strip
+                job->indices[i++] = top;
+                job->indices[i++] = bottom;
+                job->indices[i++] = top + 1;
+
+                job->indices[i++] = top + 1;
+                job->indices[i++] = bottom;
+                job->indices[i++] = bottom + 1;
+            }
+        }
+    }
+
+    // Twice the signed area of (a, b, c), positive for the winding the meshes use
+    FORCE_INLINE i64
+    GridOrient(i32 ax, i32 ay, i32 bx, i32 by, i32 cx, i32 cy)
+    {
+        return (i64)(bx - cx) * (ay - cy) - (i64)(by - cy) * (ax - cx);
+    }
+
+    // Appends grid triangle (a, b, c), flipping it to the mesh winding if needed
+    FORCE_INLINE void
+    PushGridTriangle(u32 width, u32 *indices, u32 *count, u32 a, u32 b, u32 c)
+    {
+        if (GridOrient(a % width, a / width, b % width, b / width, c % width, c / width) < 0)
+        {
+            u32 t = b;
+            b = c;
+            c = t;
+        }
+
+        indices[(*count)++] = a;
+        indices[(*count)++] = b;
+        indices[(*count)++] = c;
+    }
+
+    // Standard grid with stitched edges. The inner cells are meshed as usual, the ring of cells
+    // along each edge is a strip between the edge vertices (every other one when stitched)
+    // and the row of vertices just inside it.
+    file_internal u32
+    StandardStitchedIndices(TerrainMeshDesc *desc, u32 *indices)
+    {
+        u32 w = desc->width;
+        u32 h = desc->height;
+        u32 count = 0;
+
+        for (u32 r = 1; r + 2 < h; ++r)
+        {
+            for (u32 c = 1; c + 2 < w; ++c)
+            {
+                u32 top    = (r + 0) * w + c;
+                u32 bottom = (r + 1) * w + c;
+                PushGridTriangle(w, indices, &count, top,     bottom, top + 1);
+                PushGridTriangle(w, indices, &count, top + 1, bottom, bottom + 1);
+            }
+        }
+
+        struct EdgeRing
+        {
+            u32 edge;
+            i32 outer_x, outer_y; // first vertex of the edge
+            i32 dir_x, dir_y;     // along the edge
+            i32 in_x, in_y;       // towards the inside of the tile
+            u32 length;           // vertices on the edge
+        };
+
+        EdgeRing rings[] = {
+            { Edge_NegZ, 0,              0,              1, 0,  0,  1, w },
+            { Edge_PosX, (i32)w - 1,     0,              0, 1, -1,  0, h },
+            { Edge_PosZ, 0,              (i32)h - 1,     1, 0,  0, -1, w },
+            { Edge_NegX, 0,              0,              0, 1,  1,  0, h },
+        };
+
+        for (u32 e = 0; e < ARRAYCOUNT(rings); ++e)
+        {
+            EdgeRing *ring = &rings[e];
+
+            u32 step = (desc->stitch_edges & ring->edge) ? 2 : 1;
+            u32 outer_last = (ring->length - 1) / step; // outer vertex k is at k * step along the edge
+            u32 inner_last = ring->length - 3;          // inner vertex j is at j + 1 along the edge
+
+            #define RING_OUTER(k) (u32)((ring->outer_y + ring->dir_y * (i32)((k) * step)) * (i32)w + \
+                                       (ring->outer_x + ring->dir_x * (i32)((k) * step)))
+            #define RING_INNER(j) (u32)((ring->outer_y + ring->in_y + ring->dir_y * (i32)((j) + 1)) * (i32)w + \
+                                       (ring->outer_x + ring->in_x + ring->dir_x * (i32)((j) + 1)))
+
+            u32 i = 0;
+            u32 j = 0;
+            while (i < outer_last || j < inner_last)
+            {
+                bool advance_outer = (j == inner_last) || (i < outer_last && (i + 1) * step <= j + 2);
+                if (advance_outer)
+                {
+                    PushGridTriangle(w, indices, &count, RING_OUTER(i), RING_OUTER(i + 1), RING_INNER(j));
+                    ++i;
+                }
+                else
+                {
+                    PushGridTriangle(w, indices, &count, RING_OUTER(i), RING_INNER(j + 1), RING_INNER(j));
+                    ++j;
+                }
+            }
+
+            #undef RING_OUTER
+            #undef RING_INNER
+        }
+
+        return count;
+    }
+
+    file_internal void
+    BuildStandardMesh(TerrainMeshDesc *desc, TerrainMesh *mesh)
+    {
+        mesh->topology = MeshTopology::TriangleList;
+        StandardCapacity(desc, &mesh->vertex_count, &mesh->index_count);
+        if (!IsValidGrid(desc)) return;
+
+        BuildGridVertices(desc, mesh);
+
+        if (desc->stitch_edges)
+        {
+            bool valid = desc->width >= 3 && desc->height >= 3;
+            if ((desc->stitch_edges & (Edge_NegZ | Edge_PosZ)) && (desc->width  & 1) == 0) valid = false;
+            if ((desc->stitch_edges & (Edge_NegX | Edge_PosX)) && (desc->height & 1) == 0) valid = false;
+            assert(valid && "Stitched edges need at least 3 and an odd number of vertices");
+
+            if (valid)
+            {
+                if (mesh->indices)
+                {
+                    mesh->index_count = StandardStitchedIndices(desc, mesh->indices);
+                }
+                else
+                {
+                    // Every stitched edge drops one triangle per pair of edge cells
+                    u32 triangles = 2 * (desc->width - 1) * (desc->height - 1);
+                    if (desc->stitch_edges & Edge_NegZ) triangles -= (desc->width  - 1) / 2;
+                    if (desc->stitch_edges & Edge_PosZ) triangles -= (desc->width  - 1) / 2;
+                    if (desc->stitch_edges & Edge_NegX) triangles -= (desc->height - 1) / 2;
+                    if (desc->stitch_edges & Edge_PosX) triangles -= (desc->height - 1) / 2;
+                    mesh->index_count = 3 * triangles;
+                }
+                return;
+            }
+        }
+
+        if (mesh->indices)
+        {
+            MeshJob job = {};
+            job.desc    = desc;
+            job.indices = mesh->indices;
+            JobSystemParallelFor(desc->height - 1, MESH_ROWS_PER_JOB, StandardIndexRows, &job);
+        }
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // TriangleStrip: a single strip that snakes across the grid rows
+
+    file_internal void
+    TriangleStripCapacity(TerrainMeshDesc *desc, u32 *max_vertices, u32 *max_indices)
+    {
+        bool valid = IsValidGrid(desc);
+        *max_vertices = valid ? desc->width * desc->height : 0;
+        *max_indices  = valid ? (desc->width * desc->height) + (desc->width - 1) * (desc->height - 2) : 0;
+    }
+
+    // Job callback, fills the strip indices for rows [begin, end)
+    file_internal void
+    TriangleStripIndexRows(u32 begin, u32 end, void *args)
+    {
+        MeshJob *job = (MeshJob*)args;
+        u32 w = job->desc->width;
+        u32 *indices = job->indices;
+
+        // Even rows emit 2 * width indices and odd rows 2 * (width - 1), so the
+        // first index of a row only depends on the rows before it.
+        u32 i = ((begin + 1) / 2) * (2 * w) + (begin / 2) * (2 * (w - 1));
+
+        for (u32 r = begin; r < end; r++)
+        {
+            if ((r & 1) == 0)
+            { // even rows
+                for (u32 c = 0; c < w; c++)
+                {
+                    indices[i++] = (r + 0) * w + c;
+                    indices[i++] = (r + 1) * w + c;
+                }
+            }
+            else
+            {
+                for (u32 c = w - 1; c > 0; c--)
+                {
+                    indices[i++] = c + (r + 1) * w;
+                    indices[i++] = c - 1 + (r + 0) * w;
+                }
+            }
+        }
+    }
+
+    file_internal void
+    BuildTriangleStripMesh(TerrainMeshDesc *desc, TerrainMesh *mesh)
+    {
+        mesh->topology = MeshTopology::TriangleStrip;
+        TriangleStripCapacity(desc, &mesh->vertex_count, &mesh->index_count);
+        if (!IsValidGrid(desc)) return;
+
+        BuildGridVertices(desc, mesh);
+        if (mesh->indices)
+        {
+            MeshJob job = {};
+            job.desc    = desc;
+            job.indices = mesh->indices;
+            JobSystemParallelFor(desc->height - 1, MESH_ROWS_PER_JOB, TriangleStripIndexRows, &job);
+
+            // Odd heights end the strip on the first vertex of the last row
+            if ((desc->height & 1) && desc->height > 2)
+            {
+                mesh->indices[mesh->index_count - 1] = (desc->height - 1) * desc->width;
+            }
+        }
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // LowPoly: every cell has its own 4 vertices. The first (provoking) vertex of each triangle
+    // is not used as the first vertex of any other triangle, so per-face data such as flat
+    // normals can be stored on it and read with "nointerpolation". This costs 4 vertices per
+    // cell instead of the 6 of an unindexed flat shaded mesh.
+
+    // Flat normal of the triangle through grid points a, b and c
+    FORCE_INLINE v3
+    LowPolyFaceNormal(TerrainMeshDesc *desc, u32 a, u32 b, u32 c)
+    {
+        u32 w = desc->width;
+        v3 pa = { (r32)(a % w) / (r32)w, desc->heightmap[a] * desc->height_scale, (r32)(a / w) / (r32)desc->height };
+        v3 pb = { (r32)(b % w) / (r32)w, desc->heightmap[b] * desc->height_scale, (r32)(b / w) / (r32)desc->height };
+        v3 pc = { (r32)(c % w) / (r32)w, desc->heightmap[c] * desc->height_scale, (r32)(c / w) / (r32)desc->height };
+
+        // (b - a) x (c - a) points up for the winding of the meshes
+        return v3_norm(v3_cross(v3_sub(pb, pa), v3_sub(pc, pa)));
+    }
+
+    file_internal void
+    LowPolyCapacity(TerrainMeshDesc *desc, u32 *max_vertices, u32 *max_indices)
+    {
+        bool valid = IsValidGrid(desc);
+        *max_vertices = valid ? 4 * (desc->width - 1) * (desc->height - 1) : 0;
+        *max_indices  = valid ? 6 * (desc->width - 1) * (desc->height - 1) : 0;
+    }
+
+    // Job callback, fills the vertices and indices of cell rows [begin, end)
+    file_internal void
+    LowPolyRows(u32 begin, u32 end, void *args)
+    {
+        MeshJob *job = (MeshJob*)args;
+        TerrainMeshDesc *desc = job->desc;
+        u32 cells_x = desc->width - 1;
+
+        for (u32 r = begin; r < end; ++r)
+        {
+            for (u32 c = 0; c < cells_x; ++c)
+            {
+                u32 v = 4 * (r * cells_x + c);
+
+                // v + 0: top left, v + 1: top right, v + 2: bottom left, v + 3: bottom right
+                if (job->vertices)
+                {
+                    v3 normal_0, normal_3;
+                    if (desc->heightmap)
+                    {
+                        u32 top    = (r + 0) * desc->width + c;
+                        u32 bottom = (r + 1) * desc->width + c;
+                        normal_0 = LowPolyFaceNormal(desc, top,        bottom,  top + 1);
+                        normal_3 = LowPolyFaceNormal(desc, bottom + 1, top + 1, bottom);
+                    }
+                    else
+                    {
+                        normal_0 = GridNormal(desc, 0.0f, 0.0f);
+                        normal_3 = normal_0;
+                    }
+
+                    PutGridVertex(desc, job->vertices, v + 0, (r32)(c + 0), (r32)(r + 0), normal_0);
+                    PutGridVertex(desc, job->vertices, v + 1, (r32)(c + 1), (r32)(r + 0));
+                    PutGridVertex(desc, job->vertices, v + 2, (r32)(c + 0), (r32)(r + 1));
+                    PutGridVertex(desc, job->vertices, v + 3, (r32)(c + 1), (r32)(r + 1), normal_3);
+                }
+
+                if (job->indices)
+                {
+                    u32 *indices = job->indices + 6 * (r * cells_x + c);
+                    indices[0] = v + 0;
+                    indices[1] = v + 2;
+                    indices[2] = v + 1;
+
+                    indices[3] = v + 3;
+                    indices[4] = v + 1;
+                    indices[5] = v + 2;
+                }
+            }
+        }
+    }
+
+    file_internal void
+    BuildLowPolyMesh(TerrainMeshDesc *desc, TerrainMesh *mesh)
+    {
+        mesh->topology = MeshTopology::TriangleList;
+        LowPolyCapacity(desc, &mesh->vertex_count, &mesh->index_count);
+        if (!IsValidGrid(desc) || (!mesh->vertices && !mesh->indices)) return;
+
+        MeshJob job = {};
+        job.desc     = desc;
+        job.vertices = mesh->vertices;
+        job.indices  = mesh->indices;
+        JobSystemParallelFor(desc->height - 1, MESH_ROWS_PER_JOB, LowPolyRows, &job);
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // Pizza: a fan of slices from the center of the tile to every vertex on its border. The
+    // border keeps the full grid resolution, so a distant tile drawn as a Pizza lines up with
+    // full resolution neighbours without cracks, at 2 * (width + height - 2) triangles.
+
+    FORCE_INLINE u32
+    PizzaBorderCount(TerrainMeshDesc *desc)
+    {
+        return 2 * (desc->width + desc->height) - 4;
+    }
+
+    file_internal void
+    PizzaCapacity(TerrainMeshDesc *desc, u32 *max_vertices, u32 *max_indices)
+    {
+        bool valid = IsValidGrid(desc);
+        *max_vertices = valid ? PizzaBorderCount(desc) + 1 : 0;
+        *max_indices  = valid ? 3 * PizzaBorderCount(desc) : 0;
+    }
+
+    file_internal void
+    BuildPizzaMesh(TerrainMeshDesc *desc, TerrainMesh *mesh)
+    {
+        mesh->topology = MeshTopology::TriangleList;
+        PizzaCapacity(desc, &mesh->vertex_count, &mesh->index_count);
+        if (!IsValidGrid(desc)) return;
+
+        u32 w = desc->width;
+        u32 h = desc->height;
+        u32 border_count = PizzaBorderCount(desc);
+
+        if (mesh->vertices)
+        {
+            // Walk the border clockwise from the top left corner
+            void *vertices = mesh->vertices;
+            u32 v = 0;
+            for (u32 c = 0; c < w; ++c)         PutGridVertex(desc, vertices, v++, (r32)c,       0.0f);
+            for (u32 r = 1; r < h; ++r)         PutGridVertex(desc, vertices, v++, (r32)(w - 1), (r32)r);
+            for (u32 c = w - 1; c-- > 0;)       PutGridVertex(desc, vertices, v++, (r32)c,       (r32)(h - 1));
+            for (u32 r = h - 1; r-- > 1;)       PutGridVertex(desc, vertices, v++, 0.0f,         (r32)r);
+
+            PutGridVertex(desc, vertices, v, (w - 1) * 0.5f, (h - 1) * 0.5f);
+        }
+
+        if (mesh->indices)
+        {
+            for (u32 i = 0; i < border_count; ++i)
+            {
+                mesh->indices[3 * i + 0] = border_count;
+                mesh->indices[3 * i + 1] = (i + 1) % border_count;
+                mesh->indices[3 * i + 2] = i;
+            }
+        }
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // TIN: greedy insertion (Garland & Heckbert, "Fast Polygonal Approximation of Terrains and
+    // Height Fields"). Starts from the two triangles that cover the tile and repeatedly inserts
+    // the grid point with the largest vertical error, keeping the mesh Delaunay with edge flips,
+    // until no point is further than max_error from the mesh.
+    //
+    // Triangles are stored as 3 point indices, and half-edge e (= 3 * triangle + edge) knows the
+    // opposite half-edge in the neighbouring triangle (-1 on the tile border). Each triangle
+    // stores the grid point with its largest error, and the triangles are kept in a max-heap
+    // by that error. Triangles are only rescanned when an insertion changes them.
+
+    struct TinMesher
+    {
+        const r32 *heightmap;
+        u32        width;
+        u32        height;
+
+        i32       *points;         // x, y grid coordinates
+        u32        point_count;
+
+        u32       *triangles;      // 3 points per triangle
+        i32       *halfedges;      // opposite half-edge of each triangle edge
+        u32        edge_count;     // 3 * triangle count
+
+        i32       *candidates;     // x, y of the point with the largest error, per triangle
+        i32       *queue_indices;  // position of each triangle in the queue, -1 if not queued
+        u32       *queue;          // max-heap of triangles by error
+        r32       *queue_errors;   // error of each queue entry
+        u32        queue_count;
+
+        u32       *pending;        // triangles that need a new candidate
+        u32        pending_count;
+    };
+
+    FORCE_INLINE r32
+    TinHeightAt(TinMesher *tin, i32 x, i32 y)
+    {
+        return tin->heightmap[(u64)y * tin->width + x];
+    }
+
+    // Twice the signed area of (a, b, c), positive for the winding the meshes use
+    FORCE_INLINE i64
+    TinOrient(i32 ax, i32 ay, i32 bx, i32 by, i32 cx, i32 cy)
+    {
+        return (i64)(bx - cx) * (ay - cy) - (i64)(by - cy) * (ax - cx);
+    }
+
+    // True if p is inside the circumcircle of (a, b, c)
+    FORCE_INLINE bool
+    TinInCircle(i32 ax, i32 ay, i32 bx, i32 by, i32 cx, i32 cy, i32 px, i32 py)
+    {
+        r64 dx = ax - px, dy = ay - py;
+        r64 ex = bx - px, ey = by - py;
+        r64 fx = cx - px, fy = cy - py;
+
+        r64 ap = dx * dx + dy * dy;
+        r64 bp = ex * ex + ey * ey;
+        r64 cp = fx * fx + fy * fy;
+
+        return dx * (ey * cp - bp * fy) - dy * (ex * cp - bp * fx) + ap * (ex * fy - ey * fx) < 0.0;
+    }
+
+    FORCE_INLINE u32
+    TinAddPoint(TinMesher *tin, i32 x, i32 y)
+    {
+        u32 result = tin->point_count++;
+        tin->points[2 * result + 0] = x;
+        tin->points[2 * result + 1] = y;
+        return result;
+    }
+
+    //
+    // Queue
+
+    FORCE_INLINE bool
+    TinQueueLess(TinMesher *tin, u32 i, u32 j)
+    {
+        return tin->queue_errors[i] > tin->queue_errors[j];
+    }
+
+    FORCE_INLINE void
+    TinQueueSwap(TinMesher *tin, u32 i, u32 j)
+    {
+        u32 t = tin->queue[i];
+        tin->queue[i] = tin->queue[j];
+        tin->queue[j] = t;
+
+        r32 e = tin->queue_errors[i];
+        tin->queue_errors[i] = tin->queue_errors[j];
+        tin->queue_errors[j] = e;
+
+        tin->queue_indices[tin->queue[i]] = (i32)i;
+        tin->queue_indices[tin->queue[j]] = (i32)j;
+    }
+
+    file_internal void
+    TinQueueUp(TinMesher *tin, u32 j)
+    {
+        while (j > 0)
+        {
+            u32 i = (j - 1) / 2;
+            if (!TinQueueLess(tin, j, i)) break;
+            TinQueueSwap(tin, i, j);
+            j = i;
+        }
+    }
+
+    // Returns true if the entry moved down
+    file_internal bool
+    TinQueueDown(TinMesher *tin, u32 i0, u32 n)
+    {
+        u32 i = i0;
+        for (;;)
+        {
+            u32 j1 = 2 * i + 1;
+            if (j1 >= n) break;
+
+            u32 j2 = j1 + 1;
+            u32 j  = (j2 < n && TinQueueLess(tin, j2, j1)) ? j2 : j1;
+            if (!TinQueueLess(tin, j, i)) break;
+
+            TinQueueSwap(tin, i, j);
+            i = j;
+        }
+        return i > i0;
+    }
+
+    FORCE_INLINE void
+    TinQueuePush(TinMesher *tin, u32 t, r32 error)
+    {
+        u32 i = tin->queue_count++;
+        tin->queue_indices[t] = (i32)i;
+        tin->queue[i]         = t;
+        tin->queue_errors[i]  = error;
+        TinQueueUp(tin, i);
+    }
+
+    FORCE_INLINE u32
+    TinQueuePopBack(TinMesher *tin)
+    {
+        u32 t = tin->queue[--tin->queue_count];
+        tin->queue_indices[t] = -1;
+        return t;
+    }
+
+    FORCE_INLINE u32
+    TinQueuePop(TinMesher *tin)
+    {
+        u32 n = tin->queue_count - 1;
+        TinQueueSwap(tin, 0, n);
+        TinQueueDown(tin, 0, n);
+        return TinQueuePopBack(tin);
+    }
+
+    // Removes a triangle that is about to be replaced, from the queue or the pending list
+    file_internal void
+    TinQueueRemove(TinMesher *tin, u32 t)
+    {
+        i32 i = tin->queue_indices[t];
+        if (i < 0)
+        {
+            for (u32 p = 0; p < tin->pending_count; ++p)
+            {
+                if (tin->pending[p] == t)
+                {
+                    tin->pending[p] = tin->pending[--tin->pending_count];
+                    return;
+                }
+            }
+            assert(false && "Triangle is neither queued nor pending");
+            return;
+        }
+
+        u32 n = tin->queue_count - 1;
+        if ((u32)i != n)
+        {
+            TinQueueSwap(tin, (u32)i, n);
+            if (!TinQueueDown(tin, (u32)i, n)) TinQueueUp(tin, (u32)i);
+        }
+        TinQueuePopBack(tin);
+    }
+
+    //
+    // Triangulation
+
+    // @param e: first half-edge of the triangle, reuses a triangle when it is less than edge_count
+    // Returns the first half-edge of the triangle
+    file_internal u32
+    TinAddTriangle(TinMesher *tin, u32 a, u32 b, u32 c, i32 ab, i32 bc, i32 ca, u32 e)
+    {
+        u32 t = e / 3;
+
+        tin->triangles[e + 0] = a;
+        tin->triangles[e + 1] = b;
+        tin->triangles[e + 2] = c;
+
+        tin->halfedges[e + 0] = ab;
+        tin->halfedges[e + 1] = bc;
+        tin->halfedges[e + 2] = ca;
+
+        if (ab >= 0) tin->halfedges[ab] = (i32)(e + 0);
+        if (bc >= 0) tin->halfedges[bc] = (i32)(e + 1);
+        if (ca >= 0) tin->halfedges[ca] = (i32)(e + 2);
+
+        if (e == tin->edge_count) tin->edge_count += 3;
+
+        tin->candidates[2 * t + 0] = 0;
+        tin->candidates[2 * t + 1] = 0;
+        tin->queue_indices[t]      = -1;
+        tin->pending[tin->pending_count++] = t;
+
+        return e;
+    }
+
+    FORCE_INLINE u32
+    TinAddTriangle(TinMesher *tin, u32 a, u32 b, u32 c, i32 ab, i32 bc, i32 ca)
+    {
+        return TinAddTriangle(tin, a, b, c, ab, bc, ca, tin->edge_count);
+    }
+
+    // Flips half-edge a and its opposite if the pair is not Delaunay, then checks the new edges
+    file_internal void
+    TinLegalize(TinMesher *tin, u32 a)
+    {
+        i32 b = tin->halfedges[a];
+        if (b < 0) return;
+
+        u32 a0 = a - a % 3;
+        u32 b0 = (u32)b - (u32)b % 3;
+        u32 al = a0 + (a + 1) % 3;
+        u32 ar = a0 + (a + 2) % 3;
+        u32 bl = b0 + ((u32)b + 2) % 3;
+        u32 br = b0 + ((u32)b + 1) % 3;
+
+        u32 p0 = tin->triangles[ar];
+        u32 pr = tin->triangles[a];
+        u32 pl = tin->triangles[al];
+        u32 p1 = tin->triangles[bl];
+
+        i32 *pts = tin->points;
+        if (!TinInCircle(pts[2 * p0], pts[2 * p0 + 1], pts[2 * pr], pts[2 * pr + 1],
+                         pts[2 * pl], pts[2 * pl + 1], pts[2 * p1], pts[2 * p1 + 1]))
+        {
+            return;
+        }
+
+        i32 hal = tin->halfedges[al];
+        i32 har = tin->halfedges[ar];
+        i32 hbl = tin->halfedges[bl];
+        i32 hbr = tin->halfedges[br];
+
+        TinQueueRemove(tin, a0 / 3);
+        TinQueueRemove(tin, b0 / 3);
+
+        u32 t0 = TinAddTriangle(tin, p0, p1, pl, -1, hbl, hal, a0);
+        u32 t1 = TinAddTriangle(tin, p1, p0, pr, (i32)t0, har, hbr, b0);
+
+        TinLegalize(tin, t0 + 1);
+        TinLegalize(tin, t1 + 2);
+    }
+
+    // Inserts point pn on half-edge a
+    file_internal void
+    TinSplitEdge(TinMesher *tin, u32 pn, u32 a)
+    {
+        u32 a0 = a - a % 3;
+        u32 al = a0 + (a + 1) % 3;
+        u32 ar = a0 + (a + 2) % 3;
+
+        u32 p0 = tin->triangles[ar];
+        u32 pr = tin->triangles[a];
+        u32 pl = tin->triangles[al];
+        i32 hal = tin->halfedges[al];
+        i32 har = tin->halfedges[ar];
+
+        i32 b = tin->halfedges[a];
+        if (b < 0)
+        {
+            // Edge on the tile border
+            u32 t0 = TinAddTriangle(tin, pn, p0, pr, -1, har, -1, a0);
+            u32 t1 = TinAddTriangle(tin, p0, pn, pl, (i32)t0, -1, hal);
+            TinLegalize(tin, t0 + 1);
+            TinLegalize(tin, t1 + 2);
+            return;
+        }
+
+        u32 b0 = (u32)b - (u32)b % 3;
+        u32 bl = b0 + ((u32)b + 2) % 3;
+        u32 br = b0 + ((u32)b + 1) % 3;
+        u32 p1 = tin->triangles[bl];
+        i32 hbl = tin->halfedges[bl];
+        i32 hbr = tin->halfedges[br];
+
+        TinQueueRemove(tin, b0 / 3);
+
+        u32 t0 = TinAddTriangle(tin, p0, pr, pn, har, -1, -1, a0);
+        u32 t1 = TinAddTriangle(tin, pr, p1, pn, hbr, -1, (i32)t0 + 1, b0);
+        u32 t2 = TinAddTriangle(tin, p1, pl, pn, hbl, -1, (i32)t1 + 1);
+        u32 t3 = TinAddTriangle(tin, pl, p0, pn, hal, (i32)t0 + 2, (i32)t2 + 1);
+
+        TinLegalize(tin, t0);
+        TinLegalize(tin, t1);
+        TinLegalize(tin, t2);
+        TinLegalize(tin, t3);
+    }
+
+    // Scans the grid points inside triangle t for the one furthest from the triangle's plane
+    // and queues t with that error
+    file_internal void
+    TinFindCandidate(TinMesher *tin, u32 t)
+    {
+        i32 *pts = tin->points;
+        u32 *tri = tin->triangles + 3 * t;
+
+        i32 p0x = pts[2 * tri[0]], p0y = pts[2 * tri[0] + 1];
+        i32 p1x = pts[2 * tri[1]], p1y = pts[2 * tri[1] + 1];
+        i32 p2x = pts[2 * tri[2]], p2y = pts[2 * tri[2] + 1];
+
+        i32 min_x = fast_min(p0x, fast_min(p1x, p2x));
+        i32 min_y = fast_min(p0y, fast_min(p1y, p2y));
+        i32 max_x = fast_max(p0x, fast_max(p1x, p2x));
+        i32 max_y = fast_max(p0y, fast_max(p1y, p2y));
+
+        // Edge functions at (min_x, min_y), stepped incrementally across the bounding box
+        i64 w00 = TinOrient(p1x, p1y, p2x, p2y, min_x, min_y);
+        i64 w01 = TinOrient(p2x, p2y, p0x, p0y, min_x, min_y);
+        i64 w02 = TinOrient(p0x, p0y, p1x, p1y, min_x, min_y);
+
+        i64 a01 = p1y - p0y, b01 = p0x - p1x;
+        i64 a12 = p2y - p1y, b12 = p1x - p2x;
+        i64 a20 = p0y - p2y, b20 = p2x - p0x;
+
+        // Heights pre-divided by the area, so the edge functions act as barycentric weights
+        r64 area = (r64)TinOrient(p0x, p0y, p1x, p1y, p2x, p2y);
+        r64 z0 = TinHeightAt(tin, p0x, p0y) / area;
+        r64 z1 = TinHeightAt(tin, p1x, p1y) / area;
+        r64 z2 = TinHeightAt(tin, p2x, p2y) / area;
+
+        r32 max_error = 0.0f;
+        i32 mx = p0x;
+        i32 my = p0y;
+
+        for (i32 y = min_y; y <= max_y; ++y)
+        {
+            // Skip to the first column that can be inside the triangle
+            i64 dx = 0;
+            if (w00 < 0 && a12 > 0 && -w00 / a12 > dx) dx = -w00 / a12;
+            if (w01 < 0 && a20 > 0 && -w01 / a20 > dx) dx = -w01 / a20;
+            if (w02 < 0 && a01 > 0 && -w02 / a01 > dx) dx = -w02 / a01;
+
+            i64 w0 = w00 + a12 * dx;
+            i64 w1 = w01 + a20 * dx;
+            i64 w2 = w02 + a01 * dx;
+
+            bool was_inside = false;
+            for (i32 x = min_x + (i32)dx; x <= max_x; ++x)
+            {
+                if (w0 >= 0 && w1 >= 0 && w2 >= 0)
+                {
+                    was_inside = true;
+
+                    r64 z  = z0 * (r64)w0 + z1 * (r64)w1 + z2 * (r64)w2;
+                    r32 dz = (r32)fabs(z - TinHeightAt(tin, x, y));
+                    if (dz > max_error)
+                    {
+                        max_error = dz;
+                        mx = x;
+                        my = y;
+                    }
+                }
+                else if (was_inside)
+                {
+                    break;
+                }
+
+                w0 += a12;
+                w1 += a20;
+                w2 += a01;
+            }
+
+            w00 += b12;
+            w01 += b20;
+            w02 += b01;
+        }
+
+        // Rounding can leave a tiny error on the corners, which are already in the mesh
+        if ((mx == p0x && my == p0y) || (mx == p1x && my == p1y) || (mx == p2x && my == p2y))
+        {
+            max_error = 0.0f;
+        }
+
+        tin->candidates[2 * t + 0] = mx;
+        tin->candidates[2 * t + 1] = my;
+        TinQueuePush(tin, t, max_error);
+    }
+
+    file_internal void
+    TinFlush(TinMesher *tin)
+    {
+        for (u32 i = 0; i < tin->pending_count; ++i)
+        {
+            TinFindCandidate(tin, tin->pending[i]);
+        }
+        tin->pending_count = 0;
+    }
+
+    // Inserts the candidate of the triangle with the largest error
+    file_internal void
+    TinStep(TinMesher *tin)
+    {
+        u32 t  = TinQueuePop(tin);
+        u32 e0 = 3 * t + 0;
+        u32 e1 = 3 * t + 1;
+        u32 e2 = 3 * t + 2;
+
+        u32 p0 = tin->triangles[e0];
+        u32 p1 = tin->triangles[e1];
+        u32 p2 = tin->triangles[e2];
+
+        i32 *pts = tin->points;
+        i32 ax = pts[2 * p0], ay = pts[2 * p0 + 1];
+        i32 bx = pts[2 * p1], by = pts[2 * p1 + 1];
+        i32 cx = pts[2 * p2], cy = pts[2 * p2 + 1];
+        i32 px = tin->candidates[2 * t + 0];
+        i32 py = tin->candidates[2 * t + 1];
+
+        u32 pn = TinAddPoint(tin, px, py);
+
+        if (TinOrient(ax, ay, bx, by, px, py) == 0)
+        {
+            TinSplitEdge(tin, pn, e0);
+        }
+        else if (TinOrient(bx, by, cx, cy, px, py) == 0)
+        {
+            TinSplitEdge(tin, pn, e1);
+        }
+        else if (TinOrient(cx, cy, ax, ay, px, py) == 0)
+        {
+            TinSplitEdge(tin, pn, e2);
+        }
+        else
+        {
+            i32 h0 = tin->halfedges[e0];
+            i32 h1 = tin->halfedges[e1];
+            i32 h2 = tin->halfedges[e2];
+
+            u32 t0 = TinAddTriangle(tin, p0, p1, pn, h0, -1, -1, e0);
+            u32 t1 = TinAddTriangle(tin, p1, p2, pn, h1, -1, (i32)t0 + 1);
+            u32 t2 = TinAddTriangle(tin, p2, p0, pn, h2, (i32)t0 + 2, (i32)t1 + 1);
+
+            TinLegalize(tin, t0);
+            TinLegalize(tin, t1);
+            TinLegalize(tin, t2);
+        }
+
+        TinFlush(tin);
+    }
+
+    FORCE_INLINE r32
+    TinMaxError(TinMesher *tin)
+    {
+        return (tin->queue_count > 0) ? tin->queue_errors[0] : 0.0f;
+    }
+
+    FORCE_INLINE u32
+    TinTriangleCount(TinMesher *tin)
+    {
+        return tin->edge_count / 3;
+    }
+
+    file_internal void
+    TinInit(TinMesher *tin, const r32 *heightmap, u32 width, u32 height)
+    {
+        *tin = {};
+        tin->heightmap = heightmap;
+        tin->width     = width;
+        tin->height    = height;
+
+        // Every inserted point adds at most two triangles
+        u64 max_points    = (u64)width * height;
+        u64 max_triangles = 2 * max_points;
+
+        tin->points        = (i32*)SysAlloc(sizeof(i32) * 2 * max_points);
+        tin->triangles     = (u32*)SysAlloc(sizeof(u32) * 3 * max_triangles);
+        tin->halfedges     = (i32*)SysAlloc(sizeof(i32) * 3 * max_triangles);
+        tin->candidates    = (i32*)SysAlloc(sizeof(i32) * 2 * max_triangles);
+        tin->queue_indices = (i32*)SysAlloc(sizeof(i32) * max_triangles);
+        tin->queue         = (u32*)SysAlloc(sizeof(u32) * max_triangles);
+        tin->queue_errors  = (r32*)SysAlloc(sizeof(r32) * max_triangles);
+        tin->pending       = (u32*)SysAlloc(sizeof(u32) * max_triangles);
+
+        i32 x1 = (i32)width  - 1;
+        i32 y1 = (i32)height - 1;
+
+        u32 p0 = TinAddPoint(tin, 0,  0);
+        u32 p1 = TinAddPoint(tin, x1, 0);
+        u32 p2 = TinAddPoint(tin, 0,  y1);
+        u32 p3 = TinAddPoint(tin, x1, y1);
+
+        u32 t0 = TinAddTriangle(tin, p3, p0, p2, -1, -1, -1);
+        TinAddTriangle(tin, p0, p3, p1, (i32)t0, -1, -1);
+        TinFlush(tin);
+    }
+
+    file_internal void
+    TinFree(TinMesher *tin)
+    {
+        SysFree(tin->points);
+        SysFree(tin->triangles);
+        SysFree(tin->halfedges);
+        SysFree(tin->candidates);
+        SysFree(tin->queue_indices);
+        SysFree(tin->queue);
+        SysFree(tin->queue_errors);
+        SysFree(tin->pending);
+    }
+
+    file_internal void
+    TinCapacity(TerrainMeshDesc *desc, u32 *max_vertices, u32 *max_indices)
+    {
+        // Worst case every grid point is inserted
+        bool valid = IsValidGrid(desc);
+        *max_vertices = valid ? desc->width * desc->height : 0;
+        *max_indices  = valid ? 6 * (desc->width - 1) * (desc->height - 1) : 0;
+    }
+
+    file_internal void
+    BuildTinMesh(TerrainMeshDesc *desc, TerrainMesh *mesh)
+    {
+        mesh->topology     = MeshTopology::TriangleList;
+        mesh->vertex_count = 0;
+        mesh->index_count  = 0;
+        if (!IsValidGrid(desc)) return;
+
+        assert(desc->heightmap && "TIN meshes are built from a CPU heightmap");
+
+        TinMesher tin;
+        TinInit(&tin, desc->heightmap, desc->width, desc->height);
+
+        while (TinMaxError(&tin) > desc->max_error)
+        {
+            TinStep(&tin);
+        }
+
+        mesh->vertex_count = tin.point_count;
+        mesh->index_count  = tin.edge_count;
+
+        if (mesh->vertices)
+        {
+            for (u32 i = 0; i < tin.point_count; ++i)
+            {
+                PutGridVertex(desc, mesh->vertices, i, (r32)tin.points[2 * i + 0], (r32)tin.points[2 * i + 1]);
+            }
+        }
+
+        if (mesh->indices)
+        {
+            memcpy(mesh->indices, tin.triangles, sizeof(u32) * tin.edge_count);
+        }
+
+        TinFree(&tin);
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // Clipmap: Standard grid with the cells of the hole left out
+
+    FORCE_INLINE bool
+    IsClipmapHole(TerrainMeshDesc *desc, u32 c, u32 r)
+    {
+        return c >= desc->hole_x && c < desc->hole_x + desc->hole_size &&
+               r >= desc->hole_y && r < desc->hole_y + desc->hole_size;
+    }
+
+    file_internal void
+    BuildClipmapMesh(TerrainMeshDesc *desc, TerrainMesh *mesh)
+    {
+        mesh->topology = MeshTopology::TriangleList;
+        StandardCapacity(desc, &mesh->vertex_count, &mesh->index_count);
+        if (!IsValidGrid(desc)) return;
+
+        assert(desc->hole_size == 0 ||
+               (desc->hole_x + desc->hole_size < desc->width && desc->hole_y + desc->hole_size < desc->height));
+
+        BuildGridVertices(desc, mesh);
+
+        u32 w = desc->width;
+        u32 count = 0;
+        for (u32 r = 0; r + 1 < desc->height; ++r)
+        {
+            for (u32 c = 0; c + 1 < w; ++c)
+            {
+                if (IsClipmapHole(desc, c, r)) continue;
+
+                if (mesh->indices)
+                {
+                    u32 top    = (r + 0) * w + c;
+                    u32 bottom = (r + 1) * w + c;
+
+                    mesh->indices[count + 0] = top;
+                    mesh->indices[count + 1] = bottom;
+                    mesh->indices[count + 2] = top + 1;
+
+                    mesh->indices[count + 3] = top + 1;
+                    mesh->indices[count + 4] = bottom;
+                    mesh->indices[count + 5] = bottom + 1;
+                }
+                count += 6;
+            }
+        }
+        mesh->index_count = count;
+    }
+
+    //---------------------------------------------------------------------------------------------
+
+    file_global TerrainMesher g_meshers[(u32)TerrainMeshType::Count] = {
+        { StandardCapacity,      BuildStandardMesh      }, // Standard
+        { TriangleStripCapacity, BuildTriangleStripMesh }, // TriangleStrip
+        { PizzaCapacity,         BuildPizzaMesh         }, // Pizza
+        { LowPolyCapacity,       BuildLowPolyMesh       }, // LowPoly
+        { TinCapacity,           BuildTinMesh           }, // TIN
+        { StandardCapacity,      BuildClipmapMesh       }, // Clipmap
+    };
+
+}; // terrain
+
+void terrain::RegisterMesher(TerrainMeshType type, TerrainMesher mesher)
+{
+    assert((u32)type < (u32)TerrainMeshType::Count);
+    g_meshers[(u32)type] = mesher;
+}
+
+bool terrain::HasMesher(TerrainMeshType type)
+{
+    return (u32)type < (u32)TerrainMeshType::Count && g_meshers[(u32)type].build != NULL;
+}
+
+u32 terrain::GetVertexSize(TerrainVertexFormat format)
+{
+    return (format == TerrainVertexFormat::Compact) ? sizeof(TerrainCompactVertex) : sizeof(TerrainVertex);
+}
+
+void terrain::GetMeshCapacity(TerrainMeshDesc *desc, u32 *max_vertices, u32 *max_indices)
+{
+    *max_vertices = 0;
+    *max_indices  = 0;
+    if (HasMesher(desc->meshing_strategy) && g_meshers[(u32)desc->meshing_strategy].capacity)
+    {
+        g_meshers[(u32)desc->meshing_strategy].capacity(desc, max_vertices, max_indices);
+    }
+}
+
+void terrain::BuildMesh(TerrainMeshDesc *desc, TerrainMesh *mesh)
+{
+    mesh->vertex_count = 0;
+    mesh->index_count  = 0;
+
+    assert(HasMesher(desc->meshing_strategy) && "No mesher registered for the meshing strategy");
+    assert((desc->vertex_format != TerrainVertexFormat::Compact || (desc->width < 32768 && desc->height < 32768)) &&
+           "Compact vertices store the grid point in 16 bits");
+    if (HasMesher(desc->meshing_strategy))
+    {
+        g_meshers[(u32)desc->meshing_strategy].build(desc, mesh);
+    }
+}
+
+void terrain::TinErrorReport(const r32 *heightmap, u32 width, u32 height,
+                             const r32 *max_errors, u32 count, u32 *triangle_counts)
+{
+    if (width < 2 || height < 2 || count == 0)
+    {
+        for (u32 i = 0; i < count; ++i) triangle_counts[i] = 0;
+        return;
+    }
+
+    r32 min_error = max_errors[0];
+    for (u32 i = 0; i < count; ++i)
+    {
+        triangle_counts[i] = 0;
+        min_error = fast_minf(min_error, max_errors[i]);
+    }
+
+    TinMesher tin;
+    TinInit(&tin, heightmap, width, height);
+
+    for (;;)
+    {
+        r32 error = TinMaxError(&tin);
+        for (u32 i = 0; i < count; ++i)
+        {
+            if (triangle_counts[i] == 0 && error <= max_errors[i])
+            {
+                triangle_counts[i] = TinTriangleCount(&tin);
+            }
+        }
+
+        if (error <= min_error) break;
+        TinStep(&tin);
+    }
+
+    TinFree(&tin);
+}
+
+#undef MESH_ROWS_PER_JOB
@@ -0,0 +1,146 @@
+#ifndef _TERRAIN_MESHER_H
+#define _TERRAIN_MESHER_H
+
+//
+// CPU meshing of terrain tiles. A mesher turns a tile description into vertex and
+// index arrays, it does not touch the GPU, so the meshes can be built on worker
+// threads, in tools or in the headless build and uploaded by the caller.
+//
+// A tile is a grid of width x height vertices that covers [-0.5, 0.5) in x and z.
+// Every mesher places its vertices on that grid (or between grid points), so the
+// height can be sampled from the heightmap with the vertex uvs.
+//
+// Meshers are looked up per TerrainMeshType and can be replaced with RegisterMesher.
+//
+
+enum class TerrainMeshType : u8
+{
+    Standard,      // simple mesh generation
+    TriangleStrip, // optimized for low poly count
+    Pizza,         // optmized for low poly count for DLOD
+    LowPoly,       // optimized for low poly normals with low memory overhead
+    TIN,           // optimizaed for mesh detail
+    Clipmap,       // ring of a geometry clipmap level, see TerrainClipmap.h
+
+    Count,
+};
+
+enum class TerrainVertexFormat : u8
+{
+    Full,          // terrain::TerrainVertex, 28 bytes
+    Compact,       // terrain::TerrainCompactVertex, 8 bytes
+
+    Count,
+};
+
+namespace terrain
+{
+    // Terrain vertex that does not include the height componenet
+    struct TerrainVertex
+    {
+        v2 pos;   // position (x,z)
+        v3 norms; // normals
+        v2 uvs;   // tex coords
+    };
+
+    // Terrain vertex that only stores its grid point. The position and uvs follow from the
+    // grid point, the vertex counts and the tiling of the tile, so the vertex shader rebuilds
+    // them from the tile constants.
+    struct TerrainCompactVertex
+    {
+        u16 grid_x; // grid point, in half cells (a Pizza center can sit between grid points)
+        u16 grid_z;
+        u32 norms;  // octahedral encoded normal, see OctEncodeNormal
+    };
+
+    enum class MeshTopology : u8
+    {
+        TriangleList,
+        TriangleStrip,
+    };
+
+    // Tile edges, as bits of TerrainMeshDesc::stitch_edges
+    enum TerrainEdge
+    {
+        Edge_NegZ = BIT(0), // first row
+        Edge_PosX = BIT(1), // last column
+        Edge_PosZ = BIT(2), // last row
+        Edge_NegX = BIT(3), // first column
+
+        Edge_All  = Edge_NegZ | Edge_PosX | Edge_PosZ | Edge_NegX,
+    };
+
+    struct TerrainMeshDesc
+    {
+        TerrainMeshType meshing_strategy;
+        u32 width;        // # of vertices in the x direction
+        u32 height;       // # of vertices in the y direction
+        r32 tiling;       // texture tiling on a mesh tile
+        TerrainVertexFormat vertex_format; // Compact grids are limited to 32767 vertices on a side
+
+        // Standard only. Edges that meet a tile with half the resolution, these edges skip
+        // every other vertex so they line up with the neighbour. The stitched edges need an
+        // odd vertex count.
+        u32 stitch_edges; // TerrainEdge bits
+
+        // Clipmap only. Square hole of hole_size cells at cell (hole_x, hole_y), where the next
+        // finer level is drawn. A hole_size of 0 is a full grid (the finest level).
+        u32 hole_x;
+        u32 hole_y;
+        u32 hole_size;
+
+        // Normals are baked from the heightmap when there is one (see TerrainNormals.h), and point
+        // up otherwise. LowPoly stores the flat normal of each triangle on its provoking vertex.
+        const r32 *heightmap;        // width x height samples, row-major, required by TIN
+        r32 height_scale;            // height of a heightmap value of 1, in tile units (a tile is 1 wide)
+        NormalKernel normal_kernel;
+
+        // TIN only
+        r32 max_error;               // maximum vertical error, in heightmap units
+    };
+
+    struct TerrainMesh
+    {
+        void          *vertices;     // TerrainVertex or TerrainCompactVertex, see vertex_format
+        u32           *indices;
+        u32            vertex_count;
+        u32            index_count;
+        MeshTopology   topology;
+    };
+
+    // @param max_vertices: (output) upper bound of the vertex count
+    // @param max_indices:  (output) upper bound of the index count
+    typedef void (*PFN_MeshCapacity)(TerrainMeshDesc *desc, u32 *max_vertices, u32 *max_indices);
+    // Fills mesh->vertices and mesh->indices, either may be NULL to skip it. Sets the counts and topology.
+    typedef void (*PFN_MeshBuild)(TerrainMeshDesc *desc, TerrainMesh *mesh);
+
+    struct TerrainMesher
+    {
+        PFN_MeshCapacity capacity;
+        PFN_MeshBuild    build;
+    };
+
+    // @param mesher: replaces the mesher used for "type"
+    void RegisterMesher(TerrainMeshType type, TerrainMesher mesher);
+    bool HasMesher(TerrainMeshType type);
+
+    // Bytes of a vertex in "format"
+    u32 GetVertexSize(TerrainVertexFormat format);
+
+    // Size the arrays passed to BuildMesh with this
+    void GetMeshCapacity(TerrainMeshDesc *desc, u32 *max_vertices, u32 *max_indices);
+
+    // @param mesh: vertices/indices must hold at least the capacity returned by GetMeshCapacity
+    void BuildMesh(TerrainMeshDesc *desc, TerrainMesh *mesh);
+
+    // Runs the TIN mesher once over "heightmap" and records the triangle count of the mesh
+    // at the point each max error is first met, so the cheapest mesh for an error budget
+    // can be picked without meshing once per budget.
+    // @param max_errors:      list of "count" errors, in any order
+    // @param triangle_counts: (output) triangle count for each error
+    void TinErrorReport(const r32 *heightmap, u32 width, u32 height,
+                        const r32 *max_errors, u32 count, u32 *triangle_counts);
+
+}; // terrain
+
+#endif //_TERRAIN_MESHER_H
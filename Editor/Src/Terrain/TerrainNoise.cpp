@@ -0,0 +1,595 @@
+
+// NOTE(Dustin): The kernels below are line-by-line ports of the HLSL in
+// data/shaders/NoiseFunctions, including the order of the floating point operations,
+// so they produce the same heightmaps as the GPU. A few GPU behaviours are emulated:
+// - int arithmetic in the hashes wraps
+// - lerp(a, b, t) is evaluated as a + t * (b - a)
+//
+// The kernels are written once against the Lane* functions (TerrainNoiseLanes.h), which
+// map to AVX2, SSE2 or plain scalar code depending on the target.
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+#define NOISE_LANES 8
+
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#include <emmintrin.h>
+#if defined(__SSE4_1__) || defined(__AVX__)
+#include <smmintrin.h>
+#define NOISE_SSE4_1
+#endif
+#define NOISE_LANES 4
+
+#else
+
+// No SIMD support, the kernels run on single float "lanes"
+#define NOISE_LANES 1
+
+#endif
+
+#define NOISE_ROWS_PER_JOB_SAMPLES 16384 // rough number of samples each job generates
+
+namespace terrain
+{
+    struct NoiseJob
+    {
+        ComputeFunction fn;
+        Noise_CB       *cb;
+        r32            *heightmap;
+        u32             width;
+        i32             offset_x;
+        i32             offset_y;
+    };
+
+    typedef void (*PFN_NoiseRow)(Noise_CB *cb, r32 *row, u32 width, i32 offset_x, i32 y);
+
+#include "Terrain/TerrainNoiseLanes.h"
+
+    // hashAvalanche() from NoiseCommon.hlsl
+    FORCE_INLINE u32
+    NoiseHashAvalanche(u32 h)
+    {
+        h ^= h >> 15;
+        h *= NOISE_PRIME_2;
+        h ^= h >> 13;
+        h *= NOISE_PRIME_3;
+        h ^= h >> 16;
+        return h;
+    }
+
+    // octaveKey() from NoiseCommon.hlsl
+    FORCE_INLINE NoiseKey
+    NoiseOctaveKey(u64 seed, i32 octave)
+    {
+        NoiseKey key;
+        key.lo = (u32)seed ^ NoiseHashAvalanche((u32)octave + NOISE_PRIME_1);
+        key.hi = (u32)(seed >> 32);
+        return key;
+    }
+
+    // hash() from NoiseCommon.hlsl
+    FORCE_INLINE lane_u32
+    LaneNoiseHash(lane_u32 seed)
+    {
+        seed = LaneAddU(LaneAddU(seed, LaneSetU(0x7ed55d16)), LaneShlU(seed, 12));
+        seed = LaneXorU(LaneXorU(seed, LaneSetU(0xc761c23c)), LaneShrU(seed, 19));
+        seed = LaneAddU(LaneAddU(seed, LaneSetU(0x165667b1)), LaneShlU(seed, 5));
+        seed = LaneXorU(LaneAddU(seed, LaneSetU(0xd3a2646c)), LaneShlU(seed, 9));
+        seed = LaneAddU(LaneAddU(seed, LaneSetU(0xfd7046c5)), LaneShlU(seed, 3));
+        seed = LaneXorU(LaneXorU(seed, LaneSetU(0xb55a4f09)), LaneShrU(seed, 16));
+        return seed;
+    }
+
+    // gradIndex() from SimplexNoise.hlsl, the multiply by 12 done with shifts
+    FORCE_INLINE lane_u32
+    LaneGradIndex(lane_u32 h)
+    {
+        lane_u32 top = LaneShrU(h, 16);
+        return LaneShrU(LaneAddU(LaneShlU(top, 3), LaneShlU(top, 2)), 16);
+    }
+
+    // Flips the sign of v in the lanes where "bit" is set in hash, "shift" moves the bit to the sign bit
+    FORCE_INLINE lane_r32
+    LaneNegateIf(lane_r32 v, lane_u32 hash, u32 bit, i32 shift)
+    {
+        lane_u32 sign = LaneShlU(LaneAndU(hash, LaneSetU(bit)), shift);
+        return LaneXor(v, LaneAsR32(sign));
+    }
+
+    // grad() from PerlinNoise.hlsl for z = 0. Note that 0xD and 0xF use z, not x.
+    FORCE_INLINE lane_r32
+    LanePerlinGrad(lane_u32 hash, lane_r32 x, lane_r32 y)
+    {
+        lane_u32 h = LaneAndU(hash, LaneSetU(0xF));
+
+        lane_r32 lt8  = LaneAsR32(LaneCmpLtU(h, LaneSetU(8)));
+        lane_r32 lt4  = LaneAsR32(LaneCmpLtU(h, LaneSetU(4)));
+        lane_r32 uses_x = LaneAsR32(LaneOrU(LaneCmpEqU(h, LaneSetU(12)), LaneCmpEqU(h, LaneSetU(14))));
+
+        lane_r32 u = LaneSelect(lt8, x, y);
+        lane_r32 v = LaneSelect(lt4, y, LaneAnd(uses_x, x));
+
+        return LaneAdd(LaneNegateIf(u, h, 1, 31), LaneNegateIf(v, h, 2, 30));
+    }
+
+    // Ken Perlin's fade function
+    FORCE_INLINE lane_r32
+    LaneFade(lane_r32 t)
+    {
+        lane_r32 inner = LaneAdd(LaneMul(t, LaneSub(LaneMul(t, LaneSet(6.0f)), LaneSet(15.0f))), LaneSet(10.0f));
+        return LaneMul(LaneMul(LaneMul(t, t), t), inner);
+    }
+
+    // perlinNoise() from PerlinNoise.hlsl on the z = 0 plane. The corners at z + 1 have
+    // no weight there, since w = fade(0) = 0, so they are skipped.
+    file_internal lane_r32
+    LanePerlinNoise(lane_r32 x, lane_r32 y, NoiseKey key)
+    {
+        lane_r32 one = LaneSet(1.0f);
+
+        lane_r32 cell_x = LaneFloor(x);
+        lane_r32 cell_y = LaneFloor(y);
+        lane_u32 ix = LaneTruncToI32(cell_x);
+        lane_u32 iy = LaneTruncToI32(cell_y);
+        lane_u32 iz = LaneSetU(0);
+
+        x = LaneSub(x, cell_x);
+        y = LaneSub(y, cell_y);
+
+        lane_r32 u = LaneFade(x);
+        lane_r32 v = LaneFade(y);
+
+        lane_u32 ix1 = LaneAddU(ix, LaneSetU(1));
+        lane_u32 iy1 = LaneAddU(iy, LaneSetU(1));
+        lane_r32 x1  = LaneSub(x, one);
+        lane_r32 y1  = LaneSub(y, one);
+
+        lane_u32 col0 = LaneHashColumn(ix,  key);
+        lane_u32 col1 = LaneHashColumn(ix1, key);
+
+        lane_r32 i00 = LanePerlinGrad(LaneHashLattice3(col0, iy,  iz, key), x,  y);
+        lane_r32 i10 = LanePerlinGrad(LaneHashLattice3(col1, iy,  iz, key), x1, y);
+        lane_r32 i01 = LanePerlinGrad(LaneHashLattice3(col0, iy1, iz, key), x,  y1);
+        lane_r32 i11 = LanePerlinGrad(LaneHashLattice3(col1, iy1, iz, key), x1, y1);
+
+        lane_r32 lx0 = LaneLerp(i00, i10, u);
+        lane_r32 lx1 = LaneLerp(i01, i11, u);
+
+        return LaneLerp(lx0, lx1, v);
+    }
+
+    FORCE_INLINE lane_r32
+    LaneSamplePositionX(u32 x, i32 offset_x)
+    {
+        lane_u32 ix = LaneAddU(LaneSetU((u32)((i32)x + offset_x)), LaneIndex());
+        return LaneAdd(LaneFromI32(ix), LaneSet(0.5f));
+    }
+
+    // Stores a full lane, or the first "count" samples of it at the end of a row
+    FORCE_INLINE void
+    LaneStoreRow(r32 *dst, lane_r32 v, u32 count)
+    {
+        if (count == NOISE_LANES)
+        {
+            LaneStore(dst, v);
+        }
+        else
+        {
+            r32 tmp[NOISE_LANES];
+            LaneStore(tmp, v);
+            memcpy(dst, tmp, count * sizeof(r32));
+        }
+    }
+
+    // simplexNoise() from SimplexNoise.hlsl
+    file_internal lane_r32
+    LaneSimplexNoise(lane_r32 xin, lane_r32 yin, lane_r32 zin, NoiseKey key)
+    {
+        const r32 F3 = 1.0f / 3.0f;
+        const r32 G3 = 1.0f / 6.0f;
+
+        lane_r32 s = LaneMul(LaneAdd(LaneAdd(xin, yin), zin), LaneSet(F3));
+        lane_u32 i = LaneTruncToI32(LaneFloor(LaneAdd(xin, s)));
+        lane_u32 j = LaneTruncToI32(LaneFloor(LaneAdd(yin, s)));
+        lane_u32 k = LaneTruncToI32(LaneFloor(LaneAdd(zin, s)));
+        lane_r32 t = LaneMul(LaneFromI32(LaneAddU(LaneAddU(i, j), k)), LaneSet(G3));
+        lane_r32 x0 = LaneSub(xin, LaneSub(LaneFromI32(i), t));
+        lane_r32 y0 = LaneSub(yin, LaneSub(LaneFromI32(j), t));
+        lane_r32 z0 = LaneSub(zin, LaneSub(LaneFromI32(k), t));
+
+        lane_u32 ones = LaneSetU(U32_MAX);
+        lane_u32 xy = LaneAsU32(LaneCmpGe(x0, y0));
+        lane_u32 yz = LaneAsU32(LaneCmpGe(y0, z0));
+        lane_u32 xz = LaneAsU32(LaneCmpGe(x0, z0));
+        lane_u32 i1 = LaneAndU(xy, xz);
+        lane_u32 j1 = LaneAndU(LaneXorU(xy, ones), yz);
+        lane_u32 k1 = LaneXorU(LaneOrU(xz, yz), ones);
+        lane_u32 i2 = LaneOrU(xy, xz);
+        lane_u32 j2 = LaneOrU(LaneXorU(xy, ones), yz);
+        lane_u32 k2 = LaneXorU(LaneAndU(xz, yz), ones);
+
+        lane_r32 g3  = LaneSet(G3);
+        lane_r32 g32 = LaneSet(2.0f * G3);
+        lane_r32 g33 = LaneSet(3.0f * G3);
+        lane_r32 one = LaneSet(1.0f);
+
+        lane_r32 cx[4], cy[4], cz[4];
+        cx[0] = x0;
+        cy[0] = y0;
+        cz[0] = z0;
+        cx[1] = LaneAdd(LaneSub(x0, LaneMaskToOne(i1)), g3);
+        cy[1] = LaneAdd(LaneSub(y0, LaneMaskToOne(j1)), g3);
+        cz[1] = LaneAdd(LaneSub(z0, LaneMaskToOne(k1)), g3);
+        cx[2] = LaneAdd(LaneSub(x0, LaneMaskToOne(i2)), g32);
+        cy[2] = LaneAdd(LaneSub(y0, LaneMaskToOne(j2)), g32);
+        cz[2] = LaneAdd(LaneSub(z0, LaneMaskToOne(k2)), g32);
+        cx[3] = LaneAdd(LaneSub(x0, one), g33);
+        cy[3] = LaneAdd(LaneSub(y0, one), g33);
+        cz[3] = LaneAdd(LaneSub(z0, one), g33);
+
+        // Masks are -1, so subtracting them adds 1
+        lane_u32 ci[4], cj[4], ck[4];
+        ci[0] = i;                   cj[0] = j;                   ck[0] = k;
+        ci[1] = LaneSubU(i, i1);     cj[1] = LaneSubU(j, j1);     ck[1] = LaneSubU(k, k1);
+        ci[2] = LaneSubU(i, i2);     cj[2] = LaneSubU(j, j2);     ck[2] = LaneSubU(k, k2);
+        ci[3] = LaneSubU(i, ones);   cj[3] = LaneSubU(j, ones);   ck[3] = LaneSubU(k, ones);
+
+        lane_r32 n = LaneSet(0.0f);
+        for (u32 c = 0; c < 4; ++c)
+        {
+            lane_u32 g = LaneGradIndex(LaneHashLattice3(LaneHashColumn(ci[c], key), cj[c], ck[c], key));
+
+            // gradMap[g]
+            lane_r32 lt8 = LaneAsR32(LaneCmpLtU(g, LaneSetU(8)));
+            lane_r32 lt4 = LaneAsR32(LaneCmpLtU(g, LaneSetU(4)));
+            lane_r32 gx = LaneAnd(lt8, LaneNegateIf(one, g, 1, 31));
+            lane_r32 gy = LaneSelect(lt4, LaneNegateIf(one, g, 2, 30),
+                                     LaneSelect(lt8, LaneSet(0.0f), LaneNegateIf(one, g, 1, 31)));
+            lane_r32 gz = LaneSelect(lt4, LaneSet(0.0f), LaneNegateIf(one, g, 2, 30));
+
+            lane_r32 tc = LaneSub(LaneSet(0.6f), LaneMul(cx[c], cx[c]));
+            tc = LaneSub(tc, LaneMul(cy[c], cy[c]));
+            tc = LaneSub(tc, LaneMul(cz[c], cz[c]));
+
+            lane_r32 dot = LaneAdd(LaneAdd(LaneMul(gx, cx[c]), LaneMul(gy, cy[c])), LaneMul(gz, cz[c]));
+            lane_r32 t2  = LaneMul(tc, tc);
+            lane_r32 nc  = LaneMul(LaneMul(t2, t2), dot);
+            nc = LaneSelect(LaneCmpLt(tc, LaneSet(0.0f)), LaneSet(0.0f), nc);
+
+            n = LaneAdd(n, nc);
+        }
+
+        return LaneMul(LaneSet(32.0f), n);
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // Base noise functions, one per ComputeFunction. Each returns noise in [-1, 1] at (x, y)
+    // and matches baseNoise() in the compute shader of the same name.
+
+    FORCE_INLINE lane_u32
+    LaneFloorToI32(lane_r32 v)
+    {
+        return LaneTruncToI32(LaneFloor(v));
+    }
+
+    // unitFloat() from NoiseCommon.hlsl
+    FORCE_INLINE lane_r32
+    LaneUnitFloat(lane_u32 h)
+    {
+        return LaneMul(LaneFromI32(LaneShrU(h, 8)), LaneSet(1.0f / 16777216.0f));
+    }
+
+    // cellValue() from ValueNoise.hlsl
+    // @param column: LaneHashColumn() of the cell x
+    FORCE_INLINE lane_r32
+    LaneCellValue(lane_u32 column, lane_u32 y, NoiseKey key)
+    {
+        return LaneSub(LaneMul(LaneUnitFloat(LaneHashColumnCell(column, y, key)), LaneSet(2.0f)), LaneSet(1.0f));
+    }
+
+    // cubic() from NoiseCommon.hlsl
+    FORCE_INLINE lane_r32
+    LaneCubic(lane_r32 p0, lane_r32 p1, lane_r32 p2, lane_r32 p3, lane_r32 x)
+    {
+        lane_r32 a = LaneSub(LaneAdd(LaneMul(LaneSet(3.0f), LaneSub(p1, p2)), p3), p0);
+        lane_r32 b = LaneSub(LaneAdd(LaneSub(LaneMul(LaneSet(2.0f), p0), LaneMul(LaneSet(5.0f), p1)), LaneMul(LaneSet(4.0f), p2)), p3);
+        lane_r32 c = LaneAdd(LaneSub(p2, p0), LaneMul(x, LaneAdd(b, LaneMul(x, a))));
+        return LaneAdd(p1, LaneMul(LaneMul(LaneSet(0.5f), x), c));
+    }
+
+    file_internal lane_r32
+    CheckerNoise(lane_r32 x, lane_r32 y, NoiseKey key)
+    {
+        lane_u32 sum = LaneAddU(LaneAddU(LaneFloorToI32(x), LaneFloorToI32(y)), LaneSetU(key.lo));
+        lane_r32 odd = LaneAsR32(LaneCmpEqU(LaneAndU(sum, LaneSetU(1)), LaneSetU(1)));
+        return LaneSelect(odd, LaneSet(1.0f), LaneSet(-1.0f));
+    }
+
+    file_internal lane_r32
+    DiscreteNoise(lane_r32 x, lane_r32 y, NoiseKey key)
+    {
+        return LaneCellValue(LaneHashColumn(LaneFloorToI32(x), key), LaneFloorToI32(y), key);
+    }
+
+    // bilinearValueNoise() from ValueNoise.hlsl
+    FORCE_INLINE lane_r32
+    LaneBilinearValueNoise(lane_r32 x, lane_r32 y, NoiseKey key, bool faded)
+    {
+        lane_r32 cell_x = LaneFloor(x);
+        lane_r32 cell_y = LaneFloor(y);
+        lane_r32 tx = LaneSub(x, cell_x);
+        lane_r32 ty = LaneSub(y, cell_y);
+        lane_u32 ix = LaneTruncToI32(cell_x);
+        lane_u32 iy = LaneTruncToI32(cell_y);
+        lane_u32 ix1 = LaneAddU(ix, LaneSetU(1));
+        lane_u32 iy1 = LaneAddU(iy, LaneSetU(1));
+
+        if (faded)
+        {
+            tx = LaneFade(tx);
+            ty = LaneFade(ty);
+        }
+
+        lane_u32 col0 = LaneHashColumn(ix,  key);
+        lane_u32 col1 = LaneHashColumn(ix1, key);
+
+        lane_r32 v00 = LaneCellValue(col0, iy,  key);
+        lane_r32 v10 = LaneCellValue(col1, iy,  key);
+        lane_r32 v01 = LaneCellValue(col0, iy1, key);
+        lane_r32 v11 = LaneCellValue(col1, iy1, key);
+
+        return LaneLerp(LaneLerp(v00, v10, tx), LaneLerp(v01, v11, tx), ty);
+    }
+
+    file_internal lane_r32
+    LinearValueNoise(lane_r32 x, lane_r32 y, NoiseKey key)
+    {
+        return LaneBilinearValueNoise(x, y, key, false);
+    }
+
+    file_internal lane_r32
+    FadedValueNoise(lane_r32 x, lane_r32 y, NoiseKey key)
+    {
+        return LaneBilinearValueNoise(x, y, key, true);
+    }
+
+    file_internal lane_r32
+    CubicValueNoise(lane_r32 x, lane_r32 y, NoiseKey key)
+    {
+        lane_r32 cell_x = LaneFloor(x);
+        lane_r32 cell_y = LaneFloor(y);
+        lane_r32 tx = LaneSub(x, cell_x);
+        lane_r32 ty = LaneSub(y, cell_y);
+        lane_u32 ix = LaneTruncToI32(cell_x);
+        lane_u32 iy = LaneTruncToI32(cell_y);
+
+        lane_u32 cx[4];
+        for (u32 c = 0; c < 4; ++c) cx[c] = LaneHashColumn(LaneAddU(ix, LaneSetU(c - 1)), key);
+
+        lane_r32 rows[4];
+        for (u32 r = 0; r < 4; ++r)
+        {
+            lane_u32 cy = LaneAddU(iy, LaneSetU(r - 1));
+            rows[r] = LaneCubic(LaneCellValue(cx[0], cy, key), LaneCellValue(cx[1], cy, key),
+                                LaneCellValue(cx[2], cy, key), LaneCellValue(cx[3], cy, key), tx);
+        }
+
+        return LaneCubic(rows[0], rows[1], rows[2], rows[3], ty);
+    }
+
+    file_internal lane_r32
+    PerlinNoise(lane_r32 x, lane_r32 y, NoiseKey key)
+    {
+        return LanePerlinNoise(x, y, key);
+    }
+
+    file_internal lane_r32
+    SimplexNoise(lane_r32 x, lane_r32 y, NoiseKey key)
+    {
+        return LaneSimplexNoise(x, y, LaneSet(0.5f), key);
+    }
+
+    // Distance to the nearest feature point, with one feature point per cell. The nearest
+    // one is always in the 3x3 cells around the sample, so only those are searched.
+    file_internal lane_r32
+    WorleyNoise(lane_r32 x, lane_r32 y, NoiseKey key)
+    {
+        lane_r32 cell_x = LaneFloor(x);
+        lane_r32 cell_y = LaneFloor(y);
+        lane_r32 fx = LaneSub(x, cell_x);
+        lane_r32 fy = LaneSub(y, cell_y);
+        lane_u32 ix = LaneTruncToI32(cell_x);
+        lane_u32 iy = LaneTruncToI32(cell_y);
+
+        lane_u32 columns[3];
+        for (i32 ox = -1; ox <= 1; ++ox) columns[ox + 1] = LaneHashColumn(LaneAddU(ix, LaneSetU((u32)ox)), key);
+
+        lane_r32 min_dist2 = LaneSet(8.0f);
+        for (i32 oy = -1; oy <= 1; ++oy)
+        {
+            lane_u32 cy = LaneAddU(iy, LaneSetU((u32)oy));
+            for (i32 ox = -1; ox <= 1; ++ox)
+            {
+                lane_u32 h = LaneHashColumnCell(columns[ox + 1], cy, key);
+
+                lane_r32 dx = LaneSub(LaneAdd(LaneSet((r32)ox), LaneUnitFloat(h)), fx);
+                lane_r32 dy = LaneSub(LaneAdd(LaneSet((r32)oy), LaneUnitFloat(LaneNoiseHash(h))), fy);
+                min_dist2 = LaneMin(min_dist2, LaneAdd(LaneMul(dx, dx), LaneMul(dy, dy)));
+            }
+        }
+
+        return LaneSub(LaneMul(LaneSaturate(LaneSqrt(min_dist2)), LaneSet(2.0f)), LaneSet(1.0f));
+    }
+
+    // One spot per cell with a hashed center and radius, see SpotsNoise.hlsl
+    file_internal lane_r32
+    SpotsNoise(lane_r32 x, lane_r32 y, NoiseKey key)
+    {
+        lane_r32 cell_x = LaneFloor(x);
+        lane_r32 cell_y = LaneFloor(y);
+        lane_r32 fx = LaneSub(x, cell_x);
+        lane_r32 fy = LaneSub(y, cell_y);
+        lane_u32 ix = LaneTruncToI32(cell_x);
+        lane_u32 iy = LaneTruncToI32(cell_y);
+
+        lane_r32 quarter = LaneSet(0.25f);
+        lane_r32 half    = LaneSet(0.5f);
+
+        lane_u32 columns[3];
+        for (i32 ox = -1; ox <= 1; ++ox) columns[ox + 1] = LaneHashColumn(LaneAddU(ix, LaneSetU((u32)ox)), key);
+
+        lane_r32 v = LaneSet(0.0f);
+        for (i32 oy = -1; oy <= 1; ++oy)
+        {
+            lane_u32 cy = LaneAddU(iy, LaneSetU((u32)oy));
+            for (i32 ox = -1; ox <= 1; ++ox)
+            {
+                lane_u32 h0 = LaneHashColumnCell(columns[ox + 1], cy, key);
+                lane_u32 h1 = LaneNoiseHash(h0);
+                lane_u32 h2 = LaneNoiseHash(h1);
+
+                lane_r32 dx = LaneSub(LaneAdd(LaneSet((r32)ox), LaneAdd(quarter, LaneMul(half, LaneUnitFloat(h0)))), fx);
+                lane_r32 dy = LaneSub(LaneAdd(LaneSet((r32)oy), LaneAdd(quarter, LaneMul(half, LaneUnitFloat(h1)))), fy);
+                lane_r32 radius = LaneAdd(LaneSet(0.15f), LaneMul(LaneSet(0.25f), LaneUnitFloat(h2)));
+
+                lane_r32 dist = LaneSqrt(LaneAdd(LaneMul(dx, dx), LaneMul(dy, dy)));
+                lane_r32 s = LaneSaturate(LaneSub(LaneSet(1.0f), LaneDiv(dist, radius)));
+                v = LaneMax(v, LaneMul(LaneMul(s, s), LaneSub(LaneSet(3.0f), LaneMul(LaneSet(2.0f), s))));
+            }
+        }
+
+        return LaneSub(LaneMul(v, LaneSet(2.0f)), LaneSet(1.0f));
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // Fractal layer, same as NoiseFractal.hlsl
+
+    // fractalOctave(), maps one octave of [-1, 1] noise to [0, 1]
+    FORCE_INLINE lane_r32
+    LaneFractalOctave(lane_r32 n, i32 fractal)
+    {
+        if (fractal == Fractal_Ridged)
+        {
+            n = LaneSub(LaneSet(1.0f), LaneAbs(n));
+            return LaneMul(n, n);
+        }
+        else if (fractal == Fractal_Turbulence)
+        {
+            return LaneAbs(n);
+        }
+
+        return LaneAdd(LaneSet(0.5f), LaneMul(LaneSet(0.5f), n));
+    }
+
+    template <lane_r32 (*BaseNoise)(lane_r32 x, lane_r32 y, NoiseKey key)>
+    file_internal void
+    FractalRow(Noise_CB *cb, r32 *row, u32 width, i32 offset_x, i32 y)
+    {
+        lane_r32 scale      = LaneSet(cb->scale);
+        lane_r32 lacunarity = LaneSet(cb->lacunarity);
+        lane_r32 threshold  = LaneSet(cb->threshold);
+        lane_r32 row_y      = LaneMul(LaneSet((r32)(y) + 0.5f), scale);
+
+        // The octave amplitudes are the same for every sample
+        r32 norm = 0.0f;
+        r32 amp  = 1.0f;
+        for (i32 i = 0; i < cb->octaves; ++i)
+        {
+            norm += amp;
+            amp  *= cb->decay;
+        }
+
+        for (u32 x = 0; x < width; x += NOISE_LANES)
+        {
+            lane_r32 pos_x = LaneMul(LaneSamplePositionX(x, offset_x), scale);
+            lane_r32 pos_y = row_y;
+
+            lane_r32 acc = LaneSet(0.0f);
+            amp = 1.0f;
+            for (i32 i = 0; i < cb->octaves; ++i)
+            {
+                lane_r32 n = BaseNoise(pos_x, pos_y, NoiseOctaveKey(cb->seed, i));
+                acc = LaneAdd(acc, LaneMul(LaneFractalOctave(n, cb->fractal), LaneSet(amp)));
+
+                pos_x = LaneMul(pos_x, lacunarity);
+                pos_y = LaneMul(pos_y, lacunarity);
+                amp *= cb->decay;
+            }
+
+            lane_r32 height = (norm > 0.0f) ? LaneSaturate(LaneDiv(acc, LaneSet(norm))) : LaneSet(0.0f);
+            height = LaneSelect(LaneCmpLt(height, threshold), LaneSet(0.0f), height);
+
+            u32 count = (width - x < NOISE_LANES) ? width - x : NOISE_LANES;
+            LaneStoreRow(row + x, height, count);
+        }
+    }
+
+    file_internal PFN_NoiseRow
+    GetNoiseRowFunction(ComputeFunction fn)
+    {
+        PFN_NoiseRow result = NULL;
+        switch (fn)
+        {
+            case Function_Checker:     result = FractalRow<CheckerNoise>;     break;
+            case Function_Discrete:    result = FractalRow<DiscreteNoise>;    break;
+            case Function_LinearValue: result = FractalRow<LinearValueNoise>; break;
+            case Function_FadedValue:  result = FractalRow<FadedValueNoise>;  break;
+            case Function_CubicValue:  result = FractalRow<CubicValueNoise>;  break;
+            case Function_Perlin:      result = FractalRow<PerlinNoise>;      break;
+            case Function_Simplex:     result = FractalRow<SimplexNoise>;     break;
+            case Function_Worley:      result = FractalRow<WorleyNoise>;      break;
+            case Function_Spots:       result = FractalRow<SpotsNoise>;       break;
+            default: break;
+        }
+        return result;
+    }
+
+    // Job callback, generates rows [begin, end) of the heightmap
+    file_internal void
+    GenerateHeightmapRows(u32 begin, u32 end, void *args)
+    {
+        NoiseJob *job = (NoiseJob*)args;
+        PFN_NoiseRow row_fn = GetNoiseRowFunction(job->fn);
+
+        for (u32 y = begin; y < end; ++y)
+        {
+            row_fn(job->cb, job->heightmap + (u64)y * job->width, job->width, job->offset_x, (i32)y + job->offset_y);
+        }
+    }
+
+}; // terrain
+
+bool terrain::HasCpuFunction(ComputeFunction fn)
+{
+    return GetNoiseRowFunction(fn) != NULL;
+}
+
+bool terrain::GenerateHeightmap(ComputeFunction fn, Noise_CB *cb, r32 *heightmap, u32 width, u32 height,
+                                i32 offset_x, i32 offset_y)
+{
+    if (!HasCpuFunction(fn)) return false;
+
+    NoiseJob job = {};
+    job.fn        = fn;
+    job.cb        = cb;
+    job.heightmap = heightmap;
+    job.width     = width;
+    job.offset_x  = offset_x;
+    job.offset_y  = offset_y;
+
+    u32 rows_per_job = (width > 0 && width < NOISE_ROWS_PER_JOB_SAMPLES) ? NOISE_ROWS_PER_JOB_SAMPLES / width : 1;
+    JobSystemParallelFor(height, rows_per_job, GenerateHeightmapRows, &job);
+
+    return true;
+}
+
+#undef NOISE_PRIME_5
+#undef NOISE_PRIME_4
+#undef NOISE_PRIME_3
+#undef NOISE_PRIME_2
+#undef NOISE_PRIME_1
+#undef NOISE_ROWS_PER_JOB_SAMPLES
+#undef NOISE_SSE4_1
+#undef NOISE_LANES
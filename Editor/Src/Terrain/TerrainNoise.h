@@ -0,0 +1,72 @@
+#ifndef _TERRAIN_NOISE_H
+#define _TERRAIN_NOISE_H
+
+//
+// CPU implementation of the heightmap noise kernels in data/shaders/NoiseFunctions.
+// Each kernel takes the same Noise_CB parameters as its compute shader and writes
+// the same values, so heightmaps can be generated without a GPU (offline bakes,
+// headless builds).
+//
+// Every function returns noise in [-1, 1] per octave, and the octaves go through a
+// shared fractal layer (see FractalType). Heights are normalized to [0, 1].
+//
+// The random values come from integer hashes of the lattice points and a 64-bit seed
+// (hashLattice2/3 in NoiseCommon.hlsl). Nothing is looked up in tables and nothing
+// repeats within 2^32 cells, and any two seeds give unrelated noise.
+//
+// Samples are evaluated 8 at a time with AVX2 (build with /arch:AVX2 or -mavx2),
+// otherwise 4 at a time with SSE2. Rows are split across the job system.
+//
+
+namespace terrain
+{
+    enum ComputeFunction
+    {
+        Function_Checker,
+        Function_Discrete,
+        Function_LinearValue,
+        Function_FadedValue,
+        Function_CubicValue,
+        Function_Perlin,
+        Function_Simplex,
+        Function_Worley,
+        Function_Spots,
+
+        Function_Count,
+    };
+
+    // How the octaves of a ComputeFunction are combined. Must match FRACTAL_* in NoiseFractal.hlsl.
+    enum FractalType
+    {
+        Fractal_FBm,        // sum of the octaves
+        Fractal_Ridged,     // sum of (1 - |octave|)^2, sharp ridges where the noise crosses 0
+        Fractal_Turbulence, // sum of |octave|, creases where the noise crosses 0
+
+        Fractal_Count,
+    };
+
+    // Layout of the NoiseCB constant buffer in NoiseData.hlsl
+    struct Noise_CB
+    {
+        u64 seed;
+        r32 scale;
+        i32 octaves;
+        r32 lacunarity;
+        r32 decay;
+        r32 threshold; // for bounded noise
+        i32 fractal;   // FractalType
+    };
+
+    // Returns true if "fn" can be generated on the CPU
+    bool HasCpuFunction(ComputeFunction fn);
+
+    // Fills a row-major width x height heightmap. Sample (x, y) is evaluated at the same
+    // position as the compute thread (x + offset_x, y + offset_y), so neighbouring regions
+    // of a larger heightmap can be generated separately. Returns false if "fn" is not
+    // supported on the CPU.
+    bool GenerateHeightmap(ComputeFunction fn, Noise_CB *cb, r32 *heightmap, u32 width, u32 height,
+                           i32 offset_x = 0, i32 offset_y = 0);
+
+}; // terrain
+
+#endif //_TERRAIN_NOISE_H
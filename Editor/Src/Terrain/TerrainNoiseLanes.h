@@ -0,0 +1,259 @@
+//
+// Lane layer of the CPU noise kernels in TerrainNoise.cpp: the Lane* functions on AVX2, SSE2
+// (SSE4.1) or scalar lanes, and the lattice hashes of NoiseCommon.hlsl written against them.
+//
+// There is no include guard. The file is included inside a namespace, once per backend:
+// TerrainNoise.cpp includes it for the backend of the target, and the noise self test
+// includes every backend to check that they hash the same bits. Before including it, define
+// NOISE_LANES to 8 (AVX2), 4 (SSE2, plus NOISE_SSE4_1 for SSE4.1) or 1 (scalar) and include
+// the matching intrinsics headers.
+//
+
+// Lattice hash constants, same as NoiseCommon.hlsl
+#define NOISE_PRIME_1 0x9E3779B1u
+#define NOISE_PRIME_2 0x85EBCA77u
+#define NOISE_PRIME_3 0xC2B2AE3Du
+#define NOISE_PRIME_4 0x27D4EB2Fu
+#define NOISE_PRIME_5 0x165667B1u
+
+    // Seed of an octave, the uint2 key of NoiseCommon.hlsl
+    struct NoiseKey
+    {
+        u32 lo;
+        u32 hi;
+    };
+
+    //---------------------------------------------------------------------------------------------
+    // Lanes. Masks are all ones/all zeros per lane.
+
+#if NOISE_LANES == 8
+
+    typedef __m256  lane_r32;
+    typedef __m256i lane_u32;
+
+    FORCE_INLINE lane_r32 LaneSet(r32 v)                             { return _mm256_set1_ps(v); }
+    FORCE_INLINE lane_u32 LaneSetU(u32 v)                            { return _mm256_set1_epi32((i32)v); }
+    FORCE_INLINE lane_u32 LaneIndex()                                { return _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7); }
+    FORCE_INLINE void     LaneStore(r32 *dst, lane_r32 v)            { _mm256_storeu_ps(dst, v); }
+
+    FORCE_INLINE lane_r32 LaneAdd(lane_r32 a, lane_r32 b)            { return _mm256_add_ps(a, b); }
+    FORCE_INLINE lane_r32 LaneSub(lane_r32 a, lane_r32 b)            { return _mm256_sub_ps(a, b); }
+    FORCE_INLINE lane_r32 LaneMul(lane_r32 a, lane_r32 b)            { return _mm256_mul_ps(a, b); }
+    FORCE_INLINE lane_r32 LaneDiv(lane_r32 a, lane_r32 b)            { return _mm256_div_ps(a, b); }
+    FORCE_INLINE lane_r32 LaneSqrt(lane_r32 a)                       { return _mm256_sqrt_ps(a); }
+    FORCE_INLINE lane_r32 LaneMin(lane_r32 a, lane_r32 b)            { return _mm256_min_ps(a, b); }
+    FORCE_INLINE lane_r32 LaneMax(lane_r32 a, lane_r32 b)            { return _mm256_max_ps(a, b); }
+    FORCE_INLINE lane_r32 LaneFloor(lane_r32 a)                      { return _mm256_floor_ps(a); }
+    FORCE_INLINE lane_r32 LaneCmpLt(lane_r32 a, lane_r32 b)          { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    FORCE_INLINE lane_r32 LaneCmpGe(lane_r32 a, lane_r32 b)          { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    FORCE_INLINE lane_r32 LaneSelect(lane_r32 m, lane_r32 a, lane_r32 b) { return _mm256_blendv_ps(b, a, m); }
+    FORCE_INLINE lane_r32 LaneAnd(lane_r32 a, lane_r32 b)            { return _mm256_and_ps(a, b); }
+    FORCE_INLINE lane_r32 LaneXor(lane_r32 a, lane_r32 b)            { return _mm256_xor_ps(a, b); }
+
+    FORCE_INLINE lane_u32 LaneAddU(lane_u32 a, lane_u32 b)           { return _mm256_add_epi32(a, b); }
+    FORCE_INLINE lane_u32 LaneSubU(lane_u32 a, lane_u32 b)           { return _mm256_sub_epi32(a, b); }
+    FORCE_INLINE lane_u32 LaneMulU(lane_u32 a, lane_u32 b)           { return _mm256_mullo_epi32(a, b); }
+    FORCE_INLINE lane_u32 LaneAndU(lane_u32 a, lane_u32 b)           { return _mm256_and_si256(a, b); }
+    FORCE_INLINE lane_u32 LaneOrU(lane_u32 a, lane_u32 b)            { return _mm256_or_si256(a, b); }
+    FORCE_INLINE lane_u32 LaneXorU(lane_u32 a, lane_u32 b)           { return _mm256_xor_si256(a, b); }
+    FORCE_INLINE lane_u32 LaneShlU(lane_u32 a, i32 n)                { return _mm256_sll_epi32(a, _mm_cvtsi32_si128(n)); }
+    FORCE_INLINE lane_u32 LaneShrU(lane_u32 a, i32 n)                { return _mm256_srl_epi32(a, _mm_cvtsi32_si128(n)); }
+    FORCE_INLINE lane_u32 LaneCmpEqU(lane_u32 a, lane_u32 b)         { return _mm256_cmpeq_epi32(a, b); }
+    // Signed compare, only valid for values < 2^31
+    FORCE_INLINE lane_u32 LaneCmpLtU(lane_u32 a, lane_u32 b)         { return _mm256_cmpgt_epi32(b, a); }
+
+    FORCE_INLINE lane_r32 LaneAsR32(lane_u32 a)                      { return _mm256_castsi256_ps(a); }
+    FORCE_INLINE lane_u32 LaneAsU32(lane_r32 a)                      { return _mm256_castps_si256(a); }
+    FORCE_INLINE lane_r32 LaneFromI32(lane_u32 a)                    { return _mm256_cvtepi32_ps(a); }
+    FORCE_INLINE lane_u32 LaneTruncToI32(lane_r32 a)                 { return _mm256_cvttps_epi32(a); }
+
+#elif NOISE_LANES == 4
+
+    typedef __m128  lane_r32;
+    typedef __m128i lane_u32;
+
+    FORCE_INLINE lane_r32 LaneSet(r32 v)                             { return _mm_set1_ps(v); }
+    FORCE_INLINE lane_u32 LaneSetU(u32 v)                            { return _mm_set1_epi32((i32)v); }
+    FORCE_INLINE lane_u32 LaneIndex()                                { return _mm_setr_epi32(0, 1, 2, 3); }
+    FORCE_INLINE void     LaneStore(r32 *dst, lane_r32 v)            { _mm_storeu_ps(dst, v); }
+
+    FORCE_INLINE lane_r32 LaneAdd(lane_r32 a, lane_r32 b)            { return _mm_add_ps(a, b); }
+    FORCE_INLINE lane_r32 LaneSub(lane_r32 a, lane_r32 b)            { return _mm_sub_ps(a, b); }
+    FORCE_INLINE lane_r32 LaneMul(lane_r32 a, lane_r32 b)            { return _mm_mul_ps(a, b); }
+    FORCE_INLINE lane_r32 LaneDiv(lane_r32 a, lane_r32 b)            { return _mm_div_ps(a, b); }
+    FORCE_INLINE lane_r32 LaneSqrt(lane_r32 a)                       { return _mm_sqrt_ps(a); }
+    FORCE_INLINE lane_r32 LaneMin(lane_r32 a, lane_r32 b)            { return _mm_min_ps(a, b); }
+    FORCE_INLINE lane_r32 LaneMax(lane_r32 a, lane_r32 b)            { return _mm_max_ps(a, b); }
+    FORCE_INLINE lane_r32 LaneCmpLt(lane_r32 a, lane_r32 b)          { return _mm_cmplt_ps(a, b); }
+    FORCE_INLINE lane_r32 LaneCmpGe(lane_r32 a, lane_r32 b)          { return _mm_cmpge_ps(a, b); }
+    FORCE_INLINE lane_r32 LaneAnd(lane_r32 a, lane_r32 b)            { return _mm_and_ps(a, b); }
+    FORCE_INLINE lane_r32 LaneXor(lane_r32 a, lane_r32 b)            { return _mm_xor_ps(a, b); }
+    FORCE_INLINE lane_r32 LaneSelect(lane_r32 m, lane_r32 a, lane_r32 b)
+    {
+        return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+    }
+
+    FORCE_INLINE lane_u32 LaneAddU(lane_u32 a, lane_u32 b)           { return _mm_add_epi32(a, b); }
+    FORCE_INLINE lane_u32 LaneSubU(lane_u32 a, lane_u32 b)           { return _mm_sub_epi32(a, b); }
+    FORCE_INLINE lane_u32 LaneAndU(lane_u32 a, lane_u32 b)           { return _mm_and_si128(a, b); }
+    FORCE_INLINE lane_u32 LaneOrU(lane_u32 a, lane_u32 b)            { return _mm_or_si128(a, b); }
+    FORCE_INLINE lane_u32 LaneXorU(lane_u32 a, lane_u32 b)           { return _mm_xor_si128(a, b); }
+    FORCE_INLINE lane_u32 LaneShlU(lane_u32 a, i32 n)                { return _mm_sll_epi32(a, _mm_cvtsi32_si128(n)); }
+    FORCE_INLINE lane_u32 LaneShrU(lane_u32 a, i32 n)                { return _mm_srl_epi32(a, _mm_cvtsi32_si128(n)); }
+    FORCE_INLINE lane_u32 LaneCmpEqU(lane_u32 a, lane_u32 b)         { return _mm_cmpeq_epi32(a, b); }
+    // Signed compare, only valid for values < 2^31
+    FORCE_INLINE lane_u32 LaneCmpLtU(lane_u32 a, lane_u32 b)         { return _mm_cmplt_epi32(a, b); }
+
+    FORCE_INLINE lane_r32 LaneAsR32(lane_u32 a)                      { return _mm_castsi128_ps(a); }
+    FORCE_INLINE lane_u32 LaneAsU32(lane_r32 a)                      { return _mm_castps_si128(a); }
+    FORCE_INLINE lane_r32 LaneFromI32(lane_u32 a)                    { return _mm_cvtepi32_ps(a); }
+    FORCE_INLINE lane_u32 LaneTruncToI32(lane_r32 a)                 { return _mm_cvttps_epi32(a); }
+
+    FORCE_INLINE lane_r32
+    LaneFloor(lane_r32 a)
+    {
+#if defined(NOISE_SSE4_1)
+        return _mm_floor_ps(a);
+#else
+        // Truncate, then step down where truncation rounded up. Values >= 2^23 have no
+        // fractional part and may not fit in an int, so they are passed through.
+        lane_r32 trunc = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+        lane_r32 fix   = _mm_and_ps(_mm_cmpgt_ps(trunc, a), _mm_set1_ps(1.0f));
+        lane_r32 fl    = _mm_sub_ps(trunc, fix);
+        lane_r32 abs_a = _mm_andnot_ps(_mm_set1_ps(-0.0f), a);
+        return LaneSelect(_mm_cmplt_ps(abs_a, _mm_set1_ps(8388608.0f)), fl, a);
+#endif
+    }
+
+    FORCE_INLINE lane_u32
+    LaneMulU(lane_u32 a, lane_u32 b)
+    {
+#if defined(NOISE_SSE4_1)
+        return _mm_mullo_epi32(a, b);
+#else
+        lane_u32 even = _mm_mul_epu32(a, b);
+        lane_u32 odd  = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+        return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                  _mm_shuffle_epi32(odd,  _MM_SHUFFLE(0, 0, 2, 0)));
+#endif
+    }
+
+#else // NOISE_LANES == 1
+
+    typedef r32 lane_r32;
+    typedef u32 lane_u32;
+
+    FORCE_INLINE lane_r32 LaneAsR32(lane_u32 a)                      { r32 r; memcpy(&r, &a, sizeof(r)); return r; }
+    FORCE_INLINE lane_u32 LaneAsU32(lane_r32 a)                      { u32 r; memcpy(&r, &a, sizeof(r)); return r; }
+    FORCE_INLINE lane_r32 LaneMask(bool b)                           { return LaneAsR32(b ? U32_MAX : 0); }
+
+    FORCE_INLINE lane_r32 LaneSet(r32 v)                             { return v; }
+    FORCE_INLINE lane_u32 LaneSetU(u32 v)                            { return v; }
+    FORCE_INLINE lane_u32 LaneIndex()                                { return 0; }
+    FORCE_INLINE void     LaneStore(r32 *dst, lane_r32 v)            { *dst = v; }
+
+    FORCE_INLINE lane_r32 LaneAdd(lane_r32 a, lane_r32 b)            { return a + b; }
+    FORCE_INLINE lane_r32 LaneSub(lane_r32 a, lane_r32 b)            { return a - b; }
+    FORCE_INLINE lane_r32 LaneMul(lane_r32 a, lane_r32 b)            { return a * b; }
+    FORCE_INLINE lane_r32 LaneDiv(lane_r32 a, lane_r32 b)            { return a / b; }
+    FORCE_INLINE lane_r32 LaneSqrt(lane_r32 a)                       { return sqrtf(a); }
+    // Same NaN behaviour as minps/maxps: the second operand is returned
+    FORCE_INLINE lane_r32 LaneMin(lane_r32 a, lane_r32 b)            { return (a < b) ? a : b; }
+    FORCE_INLINE lane_r32 LaneMax(lane_r32 a, lane_r32 b)            { return (a > b) ? a : b; }
+    FORCE_INLINE lane_r32 LaneFloor(lane_r32 a)                      { return floorf(a); }
+    FORCE_INLINE lane_r32 LaneCmpLt(lane_r32 a, lane_r32 b)          { return LaneMask(a < b); }
+    FORCE_INLINE lane_r32 LaneCmpGe(lane_r32 a, lane_r32 b)          { return LaneMask(a >= b); }
+    FORCE_INLINE lane_r32 LaneSelect(lane_r32 m, lane_r32 a, lane_r32 b) { return LaneAsU32(m) ? a : b; }
+    FORCE_INLINE lane_r32 LaneAnd(lane_r32 a, lane_r32 b)            { return LaneAsR32(LaneAsU32(a) & LaneAsU32(b)); }
+    FORCE_INLINE lane_r32 LaneXor(lane_r32 a, lane_r32 b)            { return LaneAsR32(LaneAsU32(a) ^ LaneAsU32(b)); }
+
+    FORCE_INLINE lane_u32 LaneAddU(lane_u32 a, lane_u32 b)           { return a + b; }
+    FORCE_INLINE lane_u32 LaneSubU(lane_u32 a, lane_u32 b)           { return a - b; }
+    FORCE_INLINE lane_u32 LaneMulU(lane_u32 a, lane_u32 b)           { return a * b; }
+    FORCE_INLINE lane_u32 LaneAndU(lane_u32 a, lane_u32 b)           { return a & b; }
+    FORCE_INLINE lane_u32 LaneOrU(lane_u32 a, lane_u32 b)            { return a | b; }
+    FORCE_INLINE lane_u32 LaneXorU(lane_u32 a, lane_u32 b)           { return a ^ b; }
+    FORCE_INLINE lane_u32 LaneShlU(lane_u32 a, i32 n)                { return a << n; }
+    FORCE_INLINE lane_u32 LaneShrU(lane_u32 a, i32 n)                { return a >> n; }
+    FORCE_INLINE lane_u32 LaneCmpEqU(lane_u32 a, lane_u32 b)         { return (a == b) ? U32_MAX : 0; }
+    // Signed compare, only valid for values < 2^31
+    FORCE_INLINE lane_u32 LaneCmpLtU(lane_u32 a, lane_u32 b)         { return ((i32)a < (i32)b) ? U32_MAX : 0; }
+
+    FORCE_INLINE lane_r32 LaneFromI32(lane_u32 a)                    { return (r32)(i32)a; }
+
+    // Out of range values (and NaN) return 0x80000000, same as cvttps2dq
+    FORCE_INLINE lane_u32
+    LaneTruncToI32(lane_r32 a)
+    {
+        if (a >= -2147483648.0f && a < 2147483648.0f) return (u32)(i32)a;
+        return 0x80000000;
+    }
+
+#endif // NOISE_LANES
+
+    FORCE_INLINE lane_r32
+    LaneSaturate(lane_r32 v)
+    {
+        // max() returns the second operand for NaN, so NaN saturates to 0 like the GPU
+        return LaneMin(LaneMax(v, LaneSet(0.0f)), LaneSet(1.0f));
+    }
+
+    FORCE_INLINE lane_r32
+    LaneAbs(lane_r32 v)
+    {
+        return LaneAnd(v, LaneAsR32(LaneSetU(0x7FFFFFFF)));
+    }
+
+    FORCE_INLINE lane_r32
+    LaneLerp(lane_r32 a, lane_r32 b, lane_r32 t)
+    {
+        return LaneAdd(a, LaneMul(t, LaneSub(b, a)));
+    }
+
+    // Converts a lane mask to 1.0f/0.0f
+    FORCE_INLINE lane_r32
+    LaneMaskToOne(lane_u32 m)
+    {
+        return LaneAnd(LaneAsR32(m), LaneSet(1.0f));
+    }
+
+    // hashRound() from NoiseCommon.hlsl
+    FORCE_INLINE lane_u32
+    LaneHashRound(lane_u32 h, lane_u32 v)
+    {
+        h = LaneAddU(h, LaneMulU(v, LaneSetU(NOISE_PRIME_3)));
+        h = LaneOrU(LaneShlU(h, 17), LaneShrU(h, 15));
+        return LaneMulU(h, LaneSetU(NOISE_PRIME_4));
+    }
+
+    // hashAvalanche() from NoiseCommon.hlsl
+    FORCE_INLINE lane_u32
+    LaneHashAvalanche(lane_u32 h)
+    {
+        h = LaneMulU(LaneXorU(h, LaneShrU(h, 15)), LaneSetU(NOISE_PRIME_2));
+        h = LaneMulU(LaneXorU(h, LaneShrU(h, 13)), LaneSetU(NOISE_PRIME_3));
+        return LaneXorU(h, LaneShrU(h, 16));
+    }
+
+    // hashLattice2() from NoiseCommon.hlsl, split in two so the cells of a column can share
+    // the round of x: LaneHashColumn(x) once, then LaneHashColumnCell() for every y.
+    FORCE_INLINE lane_u32
+    LaneHashColumn(lane_u32 x, NoiseKey key)
+    {
+        return LaneHashRound(LaneSetU(key.lo + NOISE_PRIME_5), x);
+    }
+
+    FORCE_INLINE lane_u32
+    LaneHashColumnCell(lane_u32 column, lane_u32 y, NoiseKey key)
+    {
+        return LaneHashAvalanche(LaneXorU(LaneHashRound(column, y), LaneSetU(key.hi)));
+    }
+
+    // hashLattice3() from NoiseCommon.hlsl
+    // @param column: LaneHashColumn() of x
+    FORCE_INLINE lane_u32
+    LaneHashLattice3(lane_u32 column, lane_u32 y, lane_u32 z, NoiseKey key)
+    {
+        lane_u32 h = LaneHashRound(LaneHashRound(column, y), z);
+        return LaneHashAvalanche(LaneXorU(h, LaneSetU(key.hi)));
+    }
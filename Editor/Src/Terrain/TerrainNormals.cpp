@@ -0,0 +1,413 @@
+// NOTE(Dustin): With the gradient (gx, gz) of the heights, in world height per world unit, the
+// surface normal is normalize(-gx, 1, -gz) and the tangent along +x is normalize(1, gx, 0).
+// The y of the normal is always positive on a height field, so the octahedral encoding never
+// has to fold the lower half, and since |n| cancels out of the projection, the encoded normal
+// is just (-gx, -gz) / (|gx| + |gz| + 1) without a square root.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NORMALS_SSE2
+#endif
+
+#define NORMALS_ROWS_PER_JOB_SAMPLES 16384 // rough number of samples each job bakes
+
+namespace terrain
+{
+    struct NormalJob
+    {
+        TerrainNormalDesc *desc;
+        v3  *normals;
+        v4  *tangents;
+        u32 *encoded;          // octahedral normals, written instead of normals
+        u32  normal_stride;    // bytes, also the stride of the encoded normals
+        u32  tangent_stride;   // bytes
+    };
+
+    // Per row constants of the gradient
+    struct NormalRow
+    {
+        const r32 *up;     // row y - 1, clamped
+        const r32 *mid;    // row y
+        const r32 *down;   // row y + 1, clamped
+        r32 scale_x;       // height_scale / distance between the columns x - 1 and x + 1
+        r32 scale_z;       // height_scale / distance between the rows up and down
+    };
+
+    file_internal NormalRow
+    GetNormalRow(TerrainNormalDesc *desc, u32 y)
+    {
+        u32 y0 = (y > 0) ? y - 1 : y;
+        u32 y1 = (y + 1 < desc->height) ? y + 1 : y;
+
+        NormalRow result;
+        result.up      = desc->heightmap + y0 * desc->width;
+        result.mid     = desc->heightmap + y  * desc->width;
+        result.down    = desc->heightmap + y1 * desc->width;
+        result.scale_x = desc->height_scale / (2.0f * desc->spacing_x);
+        result.scale_z = (y1 > y0) ? desc->height_scale / ((r32)(y1 - y0) * desc->spacing_z) : 0.0f;
+        return result;
+    }
+
+    // Gradient at column x of a row, clamps the columns at the edges
+    FORCE_INLINE void
+    RowGradient(TerrainNormalDesc *desc, NormalRow *row, u32 x, r32 *gx, r32 *gz)
+    {
+        u32 x0 = (x > 0) ? x - 1 : x;
+        u32 x1 = (x + 1 < desc->width) ? x + 1 : x;
+
+        // The edge columns are one cell apart instead of two
+        r32 scale_x = (x1 > x0) ? row->scale_x * 2.0f / (r32)(x1 - x0) : 0.0f;
+
+        if (desc->kernel == NormalKernel::Sobel)
+        {
+            // Differences of neighbours first, they cancel exactly where the sums would round
+            r32 dx = (row->up[x1]   - row->up[x0])   + 2.0f * (row->mid[x1] - row->mid[x0]) + (row->down[x1] - row->down[x0]);
+            r32 dz = (row->down[x0] - row->up[x0])   + 2.0f * (row->down[x] - row->up[x])   + (row->down[x1] - row->up[x1]);
+
+            *gx = dx * 0.25f * scale_x;
+            *gz = dz * 0.25f * row->scale_z;
+        }
+        else
+        {
+            *gx = (row->mid[x1] - row->mid[x0]) * scale_x;
+            *gz = (row->down[x] - row->up[x])   * row->scale_z;
+        }
+    }
+
+    FORCE_INLINE v3
+    NormalFromGradient(r32 gx, r32 gz)
+    {
+        r32 inv = 1.0f / sqrtf(gx * gx + gz * gz + 1.0f);
+
+        v3 result;
+        result.x = -gx * inv;
+        result.y = inv;
+        result.z = -gz * inv;
+        return result;
+    }
+
+    FORCE_INLINE v4
+    TangentFromGradient(r32 gx)
+    {
+        r32 inv = 1.0f / sqrtf(gx * gx + 1.0f);
+
+        v4 result;
+        result.x = inv;
+        result.y = gx * inv;
+        result.z = 0.0f;
+        result.w = -1.0f;
+        return result;
+    }
+
+    FORCE_INLINE u32
+    OctPack(r32 x, r32 z)
+    {
+        x = (x < -1.0f) ? -1.0f : ((x > 1.0f) ? 1.0f : x);
+        z = (z < -1.0f) ? -1.0f : ((z > 1.0f) ? 1.0f : z);
+
+        // Round half away from zero, like lroundf without the library call
+        u32 qx = (u16)(i16)(x * 32767.0f + ((x >= 0.0f) ? 0.5f : -0.5f));
+        u32 qz = (u16)(i16)(z * 32767.0f + ((z >= 0.0f) ? 0.5f : -0.5f));
+        return qx | (qz << 16);
+    }
+
+    // Takes the components instead of a v3, so the meshers can inline it per vertex
+    FORCE_INLINE u32
+    OctEncode(r32 nx, r32 ny, r32 nz)
+    {
+        r32 inv = 1.0f / (fabsf(nx) + fabsf(ny) + fabsf(nz));
+        r32 x = nx * inv;
+        r32 z = nz * inv;
+
+        // Unfold the lower half of the octahedron onto the corners of the square
+        if (ny < 0.0f)
+        {
+            r32 fx = (1.0f - fabsf(z)) * ((x >= 0.0f) ? 1.0f : -1.0f);
+            r32 fz = (1.0f - fabsf(x)) * ((z >= 0.0f) ? 1.0f : -1.0f);
+            x = fx;
+            z = fz;
+        }
+
+        return OctPack(x, z);
+    }
+
+    FORCE_INLINE u32
+    OctEncodeGradient(r32 gx, r32 gz)
+    {
+        r32 inv = 1.0f / (fabsf(gx) + fabsf(gz) + 1.0f);
+        return OctPack(-gx * inv, -gz * inv);
+    }
+
+    FORCE_INLINE void
+    StoreSample(NormalJob *job, u32 i, r32 gx, r32 gz)
+    {
+        if (job->encoded)
+        {
+            *(u32*)((u8*)job->encoded + (u64)i * job->normal_stride) = OctEncodeGradient(gx, gz);
+            return;
+        }
+
+        *(v3*)((u8*)job->normals + (u64)i * job->normal_stride) = NormalFromGradient(gx, gz);
+        if (job->tangents)
+        {
+            *(v4*)((u8*)job->tangents + (u64)i * job->tangent_stride) = TangentFromGradient(gx);
+        }
+    }
+
+#if defined(NORMALS_SSE2)
+
+    // 1 / sqrt(v), refined with a Newton step to full float precision
+    FORCE_INLINE __m128
+    NormalsRsqrt(__m128 v)
+    {
+        __m128 r = _mm_rsqrt_ps(v);
+        __m128 half_v = _mm_mul_ps(v, _mm_set1_ps(0.5f));
+        return _mm_mul_ps(r, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(half_v, _mm_mul_ps(r, r))));
+    }
+
+    FORCE_INLINE __m128
+    NormalsAbs(__m128 v)
+    {
+        return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+    }
+
+    // Bakes the columns of a row from column 1 on, 4 at a time, and returns the first column left
+    file_internal u32
+    BakeRowSimd(TerrainNormalDesc *desc, NormalRow *row, NormalJob *job, u32 base)
+    {
+        u32 x = 1;
+
+        __m128 scale_x = _mm_set1_ps(row->scale_x);
+        __m128 scale_z = _mm_set1_ps(row->scale_z);
+        __m128 one     = _mm_set1_ps(1.0f);
+        __m128 two     = _mm_set1_ps(2.0f);
+        __m128 quarter = _mm_set1_ps(0.25f);
+        __m128 oct_one = _mm_set1_ps(32767.0f);
+        __m128 sign    = _mm_set1_ps(-0.0f);
+        bool sobel     = desc->kernel == NormalKernel::Sobel;
+
+        // Column x reads x + 1, so the last group has to end before the last column
+        for (; x + 5 <= desc->width; x += 4)
+        {
+            __m128 gx, gz;
+            if (sobel)
+            {
+                __m128 up_l   = _mm_loadu_ps(row->up   + x - 1);
+                __m128 up_c   = _mm_loadu_ps(row->up   + x);
+                __m128 up_r   = _mm_loadu_ps(row->up   + x + 1);
+                __m128 mid_l  = _mm_loadu_ps(row->mid  + x - 1);
+                __m128 mid_r  = _mm_loadu_ps(row->mid  + x + 1);
+                __m128 down_l = _mm_loadu_ps(row->down + x - 1);
+                __m128 down_c = _mm_loadu_ps(row->down + x);
+                __m128 down_r = _mm_loadu_ps(row->down + x + 1);
+
+                __m128 dx = _mm_add_ps(_mm_add_ps(_mm_sub_ps(up_r, up_l), _mm_sub_ps(down_r, down_l)),
+                                       _mm_mul_ps(two, _mm_sub_ps(mid_r, mid_l)));
+                __m128 dz = _mm_add_ps(_mm_add_ps(_mm_sub_ps(down_l, up_l), _mm_sub_ps(down_r, up_r)),
+                                       _mm_mul_ps(two, _mm_sub_ps(down_c, up_c)));
+
+                gx = _mm_mul_ps(_mm_mul_ps(dx, quarter), scale_x);
+                gz = _mm_mul_ps(_mm_mul_ps(dz, quarter), scale_z);
+            }
+            else
+            {
+                __m128 left  = _mm_loadu_ps(row->mid  + x - 1);
+                __m128 right = _mm_loadu_ps(row->mid  + x + 1);
+                __m128 up    = _mm_loadu_ps(row->up   + x);
+                __m128 down  = _mm_loadu_ps(row->down + x);
+
+                gx = _mm_mul_ps(_mm_sub_ps(right, left), scale_x);
+                gz = _mm_mul_ps(_mm_sub_ps(down, up), scale_z);
+            }
+
+            u32 i = base + x;
+            if (job->encoded)
+            {
+                __m128 inv = _mm_div_ps(one, _mm_add_ps(_mm_add_ps(NormalsAbs(gx), NormalsAbs(gz)), one));
+                __m128i qx = _mm_cvtps_epi32(_mm_mul_ps(_mm_xor_ps(_mm_mul_ps(gx, inv), sign), oct_one));
+                __m128i qz = _mm_cvtps_epi32(_mm_mul_ps(_mm_xor_ps(_mm_mul_ps(gz, inv), sign), oct_one));
+
+                __m128i packed = _mm_or_si128(_mm_and_si128(qx, _mm_set1_epi32(0xFFFF)), _mm_slli_epi32(qz, 16));
+                if (job->normal_stride == sizeof(u32))
+                {
+                    _mm_storeu_si128((__m128i*)(job->encoded + i), packed);
+                }
+                else
+                {
+                    alignas(16) u32 encoded[4];
+                    _mm_store_si128((__m128i*)encoded, packed);
+                    for (u32 k = 0; k < 4; ++k)
+                    {
+                        *(u32*)((u8*)job->encoded + (u64)(i + k) * job->normal_stride) = encoded[k];
+                    }
+                }
+                continue;
+            }
+
+            __m128 inv = NormalsRsqrt(_mm_add_ps(_mm_add_ps(_mm_mul_ps(gx, gx), _mm_mul_ps(gz, gz)), one));
+
+            alignas(16) r32 nx[4], ny[4], nz[4];
+            _mm_store_ps(nx, _mm_xor_ps(_mm_mul_ps(gx, inv), sign));
+            _mm_store_ps(ny, inv);
+            _mm_store_ps(nz, _mm_xor_ps(_mm_mul_ps(gz, inv), sign));
+
+            for (u32 k = 0; k < 4; ++k)
+            {
+                v3 *n = (v3*)((u8*)job->normals + (u64)(i + k) * job->normal_stride);
+                n->x = nx[k];
+                n->y = ny[k];
+                n->z = nz[k];
+            }
+
+            if (job->tangents)
+            {
+                __m128 inv_t = NormalsRsqrt(_mm_add_ps(_mm_mul_ps(gx, gx), one));
+
+                alignas(16) r32 tx[4], ty[4];
+                _mm_store_ps(tx, inv_t);
+                _mm_store_ps(ty, _mm_mul_ps(gx, inv_t));
+
+                for (u32 k = 0; k < 4; ++k)
+                {
+                    v4 *t = (v4*)((u8*)job->tangents + (u64)(i + k) * job->tangent_stride);
+                    t->x = tx[k];
+                    t->y = ty[k];
+                    t->z = 0.0f;
+                    t->w = -1.0f;
+                }
+            }
+        }
+
+        return x;
+    }
+
+#endif
+
+    file_internal void
+    BakeRows(NormalJob *job, u32 begin, u32 end)
+    {
+        TerrainNormalDesc *desc = job->desc;
+
+        for (u32 y = begin; y < end; ++y)
+        {
+            NormalRow row = GetNormalRow(desc, y);
+            u32 base = y * desc->width;
+
+            // Column 0 and the columns the SIMD loop leaves take the scalar path
+            u32 x = 1;
+#if defined(NORMALS_SSE2)
+            x = BakeRowSimd(desc, &row, job, base);
+#endif
+            r32 gx, gz;
+            RowGradient(desc, &row, 0, &gx, &gz);
+            StoreSample(job, base, gx, gz);
+
+            for (; x < desc->width; ++x)
+            {
+                RowGradient(desc, &row, x, &gx, &gz);
+                StoreSample(job, base + x, gx, gz);
+            }
+        }
+    }
+
+    // Job callback, bakes rows [begin, end)
+    file_internal void
+    BakeNormalJob(u32 begin, u32 end, void *args)
+    {
+        BakeRows((NormalJob*)args, begin, end);
+    }
+
+    file_internal void
+    BakeOnJobs(TerrainNormalDesc *desc, NormalJob *job)
+    {
+        if (desc->width == 0 || desc->height == 0) return;
+
+        u32 rows_per_job = fast_max(1, NORMALS_ROWS_PER_JOB_SAMPLES / desc->width);
+        JobSystemParallelFor(desc->height, rows_per_job, BakeNormalJob, job);
+    }
+
+}; // terrain
+
+void terrain::BakeNormalRows(TerrainNormalDesc *desc, u32 begin, u32 end,
+                             v3 *normals, u32 normal_stride, v4 *tangents, u32 tangent_stride)
+{
+    if (desc->width == 0) return;
+
+    NormalJob job = {};
+    job.desc           = desc;
+    job.normals        = normals;
+    job.tangents       = tangents;
+    job.normal_stride  = normal_stride;
+    job.tangent_stride = tangent_stride;
+    BakeRows(&job, begin, fast_min(end, desc->height));
+}
+
+void terrain::BakeNormalRowsOct(TerrainNormalDesc *desc, u32 begin, u32 end, u32 *normals, u32 normal_stride)
+{
+    if (desc->width == 0) return;
+
+    NormalJob job = {};
+    job.desc          = desc;
+    job.encoded       = normals;
+    job.normal_stride = normal_stride;
+    BakeRows(&job, begin, fast_min(end, desc->height));
+}
+
+void terrain::BakeNormals(TerrainNormalDesc *desc, v3 *normals, v4 *tangents)
+{
+    NormalJob job = {};
+    job.desc           = desc;
+    job.normals        = normals;
+    job.tangents       = tangents;
+    job.normal_stride  = sizeof(v3);
+    job.tangent_stride = sizeof(v4);
+    BakeOnJobs(desc, &job);
+}
+
+void terrain::BakeNormalsOct(TerrainNormalDesc *desc, u32 *normals)
+{
+    NormalJob job = {};
+    job.desc          = desc;
+    job.encoded       = normals;
+    job.normal_stride = sizeof(u32);
+    BakeOnJobs(desc, &job);
+}
+
+v3 terrain::SampleNormal(TerrainNormalDesc *desc, u32 x, u32 y)
+{
+    x = fast_min(x, desc->width  - 1);
+    y = fast_min(y, desc->height - 1);
+
+    NormalRow row = GetNormalRow(desc, y);
+
+    r32 gx, gz;
+    RowGradient(desc, &row, x, &gx, &gz);
+    return NormalFromGradient(gx, gz);
+}
+
+u32 terrain::OctEncodeNormal(v3 normal)
+{
+    return OctEncode(normal.x, normal.y, normal.z);
+}
+
+v3 terrain::OctDecodeNormal(u32 encoded)
+{
+    // -32768 is the same as -32767
+    r32 x = (r32)fast_max((i16)(encoded & 0xFFFF), -32767) / 32767.0f;
+    r32 z = (r32)fast_max((i16)(encoded >> 16),    -32767) / 32767.0f;
+    r32 y = 1.0f - fabsf(x) - fabsf(z);
+
+    if (y < 0.0f)
+    {
+        r32 fx = (1.0f - fabsf(z)) * ((x >= 0.0f) ? 1.0f : -1.0f);
+        r32 fz = (1.0f - fabsf(x)) * ((z >= 0.0f) ? 1.0f : -1.0f);
+        x = fx;
+        z = fz;
+    }
+
+    v3 result = { x, y, z };
+    return v3_norm(result);
+}
+
+#undef NORMALS_ROWS_PER_JOB_SAMPLES
+#undef NORMALS_SSE2
@@ -0,0 +1,68 @@
+#ifndef _TERRAIN_NORMALS_H
+#define _TERRAIN_NORMALS_H
+
+//
+// Normals and tangents baked from a heightmap on the CPU, so the shaders do not have to
+// rebuild them from the heights for every sample they shade.
+//
+// The gradient at a sample is taken with central differences or a 3x3 Sobel filter
+// (smoother on noisy heightmaps), edges fall back to one-sided differences. Rows are
+// baked 4 samples at a time with SSE2 and spread over the job system.
+//
+// The heightmap is a height field over the xz plane, y up. With the uvs increasing along
+// +x and +z (as the terrain meshes lay them out), the tangent follows the surface along
+// +x and the bitangent is cross(normal, tangent) * tangent.w, with tangent.w = -1.
+//
+// Normals can also be stored octahedral encoded in 32 bits: the normal is projected on
+// the octahedron |x| + |y| + |z| = 1, unfolded onto the xz square and stored as two
+// snorm16, x in the low bits and z in the high bits. The error stays under 0.005 degrees.
+//
+
+namespace terrain
+{
+    enum class NormalKernel : u8
+    {
+        CentralDifference, // 4 samples
+        Sobel,             // 8 samples, smooths the noise of the heightmap
+    };
+
+    struct TerrainNormalDesc
+    {
+        const r32 *heightmap;  // width x height samples, row-major
+        u32 width;
+        u32 height;
+        r32 spacing_x;         // distance between two samples in x
+        r32 spacing_z;         // distance between two samples in z
+        r32 height_scale;      // height of a heightmap value of 1, in the units of the spacing
+        NormalKernel kernel;
+    };
+
+    // Bakes the rows [begin, end) on the calling thread. The outputs are addressed with a
+    // byte stride, so they can be written straight into vertices.
+    // @param normals:  (output) sample (x, y) at (u8*)normals + (y * width + x) * normal_stride
+    // @param tangents: (output) optional, same addressing with tangent_stride
+    void BakeNormalRows(TerrainNormalDesc *desc, u32 begin, u32 end,
+                        v3 *normals, u32 normal_stride, v4 *tangents, u32 tangent_stride);
+
+    // Same as BakeNormalRows, with octahedral encoded normals
+    void BakeNormalRowsOct(TerrainNormalDesc *desc, u32 begin, u32 end, u32 *normals, u32 normal_stride);
+
+    // Bakes every sample on the job system
+    // @param normals:  (output) width * height normals
+    // @param tangents: (output) optional, width * height tangents
+    void BakeNormals(TerrainNormalDesc *desc, v3 *normals, v4 *tangents = NULL);
+
+    // Same as BakeNormals, with octahedral encoded normals
+    // @param normals: (output) width * height encoded normals
+    void BakeNormalsOct(TerrainNormalDesc *desc, u32 *normals);
+
+    // Normal of a single sample
+    v3 SampleNormal(TerrainNormalDesc *desc, u32 x, u32 y);
+
+    // @param normal: unit vector
+    u32 OctEncodeNormal(v3 normal);
+    v3  OctDecodeNormal(u32 encoded);
+
+}; // terrain
+
+#endif //_TERRAIN_NORMALS_H
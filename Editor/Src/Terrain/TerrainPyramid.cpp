@@ -0,0 +1,542 @@
+// NOTE(Dustin): The SIMD loops reduce the same samples in the same order as the scalar
+// code, so every row gives the same bits whichever path reduces it:
+// - min/max of r32 are "a < b ? a : b", the semantics of minps/maxps
+// - the r32 average is ((a0 + b0) + (a1 + b1)) * 0.25, a row pair first
+// - the u16 average is rounded, (sum + 2) / 4
+// - Lanczos sums its 8 taps in order, the vertical pass first
+//
+// The u16 kernels only have signed 16-bit min/max/madd in SSE2, so the samples are flipped
+// into the signed range (x ^ 0x8000) and back.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PYRAMID_SSE2
+#endif
+
+#define PYRAMID_TILE_SIZE            256   // level 0 samples on a side of the tiles reduced by a job
+#define PYRAMID_TILE_LEVELS          8     // levels below level 0 that fit in a tile, log2(PYRAMID_TILE_SIZE)
+#define PYRAMID_ROWS_PER_JOB_SAMPLES 65536 // rough number of source samples each row job reads
+#define PYRAMID_LANCZOS_TAPS         8     // source samples the Lanczos kernel reads on a side
+
+namespace terrain
+{
+    struct PyramidLevelJob
+    {
+        HeightFormat  format;
+        PyramidReduce reduce;
+        const void   *src;
+        u32           src_width;
+        u32           src_height;
+        void         *dst;
+    };
+
+    struct PyramidTileJob
+    {
+        HeightPyramid *pyramid;
+        u32            tiles_x;
+        u32            levels;  // levels reduced in the tiles, after level 0
+    };
+
+    FORCE_INLINE u32
+    PyramidSampleSize(HeightFormat format)
+    {
+        return (format == HeightFormat::U16) ? sizeof(u16) : sizeof(r32);
+    }
+
+    FORCE_INLINE const u8*
+    PyramidRow(const void *level, u32 width, u32 y, u32 sample_size)
+    {
+        return (const u8*)level + (u64)y * width * sample_size;
+    }
+
+    FORCE_INLINE r32 PyramidMin(r32 a, r32 b) { return (a < b) ? a : b; }
+    FORCE_INLINE r32 PyramidMax(r32 a, r32 b) { return (a > b) ? a : b; }
+
+    // Lanczos 2 over a downsampling by 2: the taps sit 0.5, 1.5, 2.5 and 3.5 samples from
+    // the center of the block, 0.25 to 1.75 lobes in the coarse level
+    file_internal void
+    PyramidLanczosWeights(r32 weights[PYRAMID_LANCZOS_TAPS])
+    {
+        r64 w[PYRAMID_LANCZOS_TAPS / 2];
+        r64 sum = 0.0;
+        for (u32 i = 0; i < PYRAMID_LANCZOS_TAPS / 2; ++i)
+        {
+            r64 x  = 0.25 + 0.5 * (r64)i;
+            r64 px = 3.14159265358979323846 * x;
+            w[i] = (sin(px) / px) * (sin(0.5 * px) / (0.5 * px));
+            sum += 2.0 * w[i];
+        }
+
+        for (u32 i = 0; i < PYRAMID_LANCZOS_TAPS / 2; ++i)
+        {
+            weights[PYRAMID_LANCZOS_TAPS / 2 - 1 - i] = (r32)(w[i] / sum);
+            weights[PYRAMID_LANCZOS_TAPS / 2 + i]     = (r32)(w[i] / sum);
+        }
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // 2x2 reduction of a row pair into dst[begin, end). Column 2x + 1 is clamped to the row.
+
+    file_internal void
+    ReduceRowR32(PyramidReduce reduce, const r32 *a, const r32 *b, u32 src_width, r32 *dst, u32 begin, u32 end)
+    {
+        u32 x = begin;
+
+#if defined(PYRAMID_SSE2)
+        // 8 source samples per 4 samples, the block of the last sample is full
+        u32 simd_end = fast_min(end, src_width / 2);
+        simd_end = (simd_end > x) ? x + ((simd_end - x) & ~3u) : x;
+
+        for (; x < simd_end; x += 4)
+        {
+            __m128 a0 = _mm_loadu_ps(a + 2 * x);
+            __m128 a1 = _mm_loadu_ps(a + 2 * x + 4);
+            __m128 b0 = _mm_loadu_ps(b + 2 * x);
+            __m128 b1 = _mm_loadu_ps(b + 2 * x + 4);
+
+            __m128 r;
+            if (reduce == PyramidReduce::Min)
+            {
+                __m128 v0 = _mm_min_ps(a0, b0);
+                __m128 v1 = _mm_min_ps(a1, b1);
+                r = _mm_min_ps(_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1)));
+            }
+            else if (reduce == PyramidReduce::Max)
+            {
+                __m128 v0 = _mm_max_ps(a0, b0);
+                __m128 v1 = _mm_max_ps(a1, b1);
+                r = _mm_max_ps(_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1)));
+            }
+            else
+            {
+                __m128 v0 = _mm_add_ps(a0, b0);
+                __m128 v1 = _mm_add_ps(a1, b1);
+                r = _mm_add_ps(_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1)));
+                r = _mm_mul_ps(r, _mm_set1_ps(0.25f));
+            }
+            _mm_storeu_ps(dst + x, r);
+        }
+#endif
+
+        for (; x < end; ++x)
+        {
+            u32 x0 = 2 * x;
+            u32 x1 = fast_min(x0 + 1, src_width - 1);
+
+            if (reduce == PyramidReduce::Min)
+                dst[x] = PyramidMin(PyramidMin(a[x0], b[x0]), PyramidMin(a[x1], b[x1]));
+            else if (reduce == PyramidReduce::Max)
+                dst[x] = PyramidMax(PyramidMax(a[x0], b[x0]), PyramidMax(a[x1], b[x1]));
+            else
+                dst[x] = ((a[x0] + b[x0]) + (a[x1] + b[x1])) * 0.25f;
+        }
+    }
+
+#if defined(PYRAMID_SSE2)
+
+    // Signed 32-bit lanes holding flipped samples to u16, the values are in [-32768, 32767]
+    FORCE_INLINE __m128i
+    PackFlippedU16(__m128i lo, __m128i hi)
+    {
+        return _mm_xor_si128(_mm_packs_epi32(lo, hi), _mm_set1_epi16((i16)0x8000));
+    }
+
+    // Min or max of the sample pairs of flipped u16, sign extended to 32 bits
+    FORCE_INLINE __m128i
+    PairReduceFlipped(__m128i v, bool max)
+    {
+        __m128i odd = _mm_srli_epi32(v, 16);
+        __m128i r   = max ? _mm_max_epi16(v, odd) : _mm_min_epi16(v, odd);
+        return _mm_srai_epi32(_mm_slli_epi32(r, 16), 16);
+    }
+
+#endif
+
+    file_internal void
+    ReduceRowU16(PyramidReduce reduce, const u16 *a, const u16 *b, u32 src_width, u16 *dst, u32 begin, u32 end)
+    {
+        u32 x = begin;
+
+#if defined(PYRAMID_SSE2)
+        // 16 source samples per 8 samples
+        u32 simd_end = fast_min(end, src_width / 2);
+        simd_end = (simd_end > x) ? x + ((simd_end - x) & ~7u) : x;
+
+        __m128i flip = _mm_set1_epi16((i16)0x8000);
+        for (; x < simd_end; x += 8)
+        {
+            __m128i a0 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(a + 2 * x)),     flip);
+            __m128i a1 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(a + 2 * x + 8)), flip);
+            __m128i b0 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(b + 2 * x)),     flip);
+            __m128i b1 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(b + 2 * x + 8)), flip);
+
+            __m128i lo, hi;
+            if (reduce == PyramidReduce::Average)
+            {
+                // Pair sums of the flipped samples are 65536 under the real ones, so the
+                // four sums are 131072 = 4 * 32768 under, which the divide by 4 keeps flipped
+                __m128i ones = _mm_set1_epi16(1);
+                __m128i two  = _mm_set1_epi32(2);
+                lo = _mm_add_epi32(_mm_madd_epi16(a0, ones), _mm_madd_epi16(b0, ones));
+                hi = _mm_add_epi32(_mm_madd_epi16(a1, ones), _mm_madd_epi16(b1, ones));
+                lo = _mm_srai_epi32(_mm_add_epi32(lo, two), 2);
+                hi = _mm_srai_epi32(_mm_add_epi32(hi, two), 2);
+            }
+            else
+            {
+                bool max = (reduce == PyramidReduce::Max);
+                __m128i v0 = max ? _mm_max_epi16(a0, b0) : _mm_min_epi16(a0, b0);
+                __m128i v1 = max ? _mm_max_epi16(a1, b1) : _mm_min_epi16(a1, b1);
+                lo = PairReduceFlipped(v0, max);
+                hi = PairReduceFlipped(v1, max);
+            }
+            _mm_storeu_si128((__m128i*)(dst + x), PackFlippedU16(lo, hi));
+        }
+#endif
+
+        for (; x < end; ++x)
+        {
+            u32 x0 = 2 * x;
+            u32 x1 = fast_min(x0 + 1, src_width - 1);
+
+            if (reduce == PyramidReduce::Min)
+                dst[x] = (u16)fast_min(fast_min(a[x0], b[x0]), fast_min(a[x1], b[x1]));
+            else if (reduce == PyramidReduce::Max)
+                dst[x] = (u16)fast_max(fast_max(a[x0], b[x0]), fast_max(a[x1], b[x1]));
+            else
+                dst[x] = (u16)(((u32)a[x0] + b[x0] + a[x1] + b[x1] + 2) >> 2);
+        }
+    }
+
+    file_internal void
+    ReduceRow(HeightFormat format, PyramidReduce reduce, const void *src, u32 src_width, u32 src_height,
+              void *dst, u32 y, u32 begin, u32 end)
+    {
+        u32 sample_size = PyramidSampleSize(format);
+        u32 dst_width   = (src_width + 1) / 2;
+
+        const void *a = PyramidRow(src, src_width, 2 * y, sample_size);
+        const void *b = PyramidRow(src, src_width, fast_min(2 * y + 1, src_height - 1), sample_size);
+        void *row     = (void*)PyramidRow(dst, dst_width, y, sample_size);
+
+        if (format == HeightFormat::U16)
+            ReduceRowU16(reduce, (const u16*)a, (const u16*)b, src_width, (u16*)row, begin, end);
+        else
+            ReduceRowR32(reduce, (const r32*)a, (const r32*)b, src_width, (r32*)row, begin, end);
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // Lanczos. A row of the coarse level is filtered vertically over 8 source rows into
+    // "column", then horizontally. With the source columns clamped and shifted by the 3 taps
+    // left of the block, tap k of sample x reads padded column 2x + k, so the even taps read
+    // the even padded columns at x + k / 2 and the odd ones the odd padded columns: split in
+    // two arrays, the horizontal pass is a plain 4-wide loop.
+
+    // Vertical pass of the rows around row y of the coarse level
+    // @param column: (output) src_width samples
+    file_internal void
+    LanczosColumns(HeightFormat format, const void *src, u32 src_width, u32 src_height, u32 y,
+                   const r32 weights[PYRAMID_LANCZOS_TAPS], r32 *column)
+    {
+        u32 sample_size = PyramidSampleSize(format);
+
+        const void *rows[PYRAMID_LANCZOS_TAPS];
+        for (u32 k = 0; k < PYRAMID_LANCZOS_TAPS; ++k)
+        {
+            i32 r = (i32)(2 * y + k) - (PYRAMID_LANCZOS_TAPS / 2 - 1);
+            r = fast_clamp(0, (i32)src_height - 1, r);
+            rows[k] = PyramidRow(src, src_width, (u32)r, sample_size);
+        }
+
+        u32 x = 0;
+
+#if defined(PYRAMID_SSE2)
+        __m128 w[PYRAMID_LANCZOS_TAPS];
+        for (u32 k = 0; k < PYRAMID_LANCZOS_TAPS; ++k) w[k] = _mm_set1_ps(weights[k]);
+
+        for (; x + 4 <= src_width; x += 4)
+        {
+            __m128 acc = _mm_setzero_ps();
+            for (u32 k = 0; k < PYRAMID_LANCZOS_TAPS; ++k)
+            {
+                __m128 v;
+                if (format == HeightFormat::U16)
+                {
+                    __m128i s = _mm_loadl_epi64((const __m128i*)((const u16*)rows[k] + x));
+                    v = _mm_cvtepi32_ps(_mm_unpacklo_epi16(s, _mm_setzero_si128()));
+                }
+                else
+                {
+                    v = _mm_loadu_ps((const r32*)rows[k] + x);
+                }
+                acc = _mm_add_ps(acc, _mm_mul_ps(w[k], v));
+            }
+            _mm_storeu_ps(column + x, acc);
+        }
+#endif
+
+        for (; x < src_width; ++x)
+        {
+            r32 acc = 0.0f;
+            for (u32 k = 0; k < PYRAMID_LANCZOS_TAPS; ++k)
+            {
+                r32 v = (format == HeightFormat::U16) ? (r32)((const u16*)rows[k])[x] : ((const r32*)rows[k])[x];
+                acc += weights[k] * v;
+            }
+            column[x] = acc;
+        }
+    }
+
+    FORCE_INLINE u16
+    LanczosToU16(r32 v)
+    {
+        v = PyramidMin(PyramidMax(v, 0.0f), 65535.0f);
+        return (u16)(v + 0.5f);
+    }
+
+    // Horizontal pass, writes samples [begin, end) of a row of the coarse level
+    // @param scratch: 2 * (dst_width + PYRAMID_LANCZOS_TAPS / 2) samples
+    file_internal void
+    LanczosRow(HeightFormat format, const r32 *column, u32 src_width, const r32 weights[PYRAMID_LANCZOS_TAPS],
+               r32 *scratch, void *dst, u32 begin, u32 end)
+    {
+        u32 dst_width = (src_width + 1) / 2;
+        u32 count     = dst_width + PYRAMID_LANCZOS_TAPS / 2 - 1;
+        r32 *even = scratch;
+        r32 *odd  = scratch + count + 1;
+
+        // Padded column p is source column p - 3
+        for (u32 i = 0; i < count; ++i)
+        {
+            i32 e = (i32)(2 * i) - (PYRAMID_LANCZOS_TAPS / 2 - 1);
+            even[i] = column[fast_clamp(0, (i32)src_width - 1, e)];
+            odd[i]  = column[fast_clamp(0, (i32)src_width - 1, e + 1)];
+        }
+
+        u32 x = begin;
+
+#if defined(PYRAMID_SSE2)
+        __m128 w[PYRAMID_LANCZOS_TAPS];
+        for (u32 k = 0; k < PYRAMID_LANCZOS_TAPS; ++k) w[k] = _mm_set1_ps(weights[k]);
+
+        for (; x + 4 <= end; x += 4)
+        {
+            __m128 acc = _mm_setzero_ps();
+            for (u32 k = 0; k < PYRAMID_LANCZOS_TAPS; k += 2)
+            {
+                acc = _mm_add_ps(acc, _mm_mul_ps(w[k],     _mm_loadu_ps(even + x + k / 2)));
+                acc = _mm_add_ps(acc, _mm_mul_ps(w[k + 1], _mm_loadu_ps(odd  + x + k / 2)));
+            }
+
+            if (format == HeightFormat::U16)
+            {
+                acc = _mm_min_ps(_mm_max_ps(acc, _mm_setzero_ps()), _mm_set1_ps(65535.0f));
+                __m128i v = _mm_cvttps_epi32(_mm_add_ps(acc, _mm_set1_ps(0.5f)));
+                v = _mm_sub_epi32(v, _mm_set1_epi32(32768));
+                _mm_storel_epi64((__m128i*)((u16*)dst + x), PackFlippedU16(v, v));
+            }
+            else
+            {
+                _mm_storeu_ps((r32*)dst + x, acc);
+            }
+        }
+#endif
+
+        for (; x < end; ++x)
+        {
+            r32 acc = 0.0f;
+            for (u32 k = 0; k < PYRAMID_LANCZOS_TAPS; k += 2)
+            {
+                acc += weights[k]     * even[x + k / 2];
+                acc += weights[k + 1] * odd[x + k / 2];
+            }
+
+            if (format == HeightFormat::U16) ((u16*)dst)[x] = LanczosToU16(acc);
+            else                             ((r32*)dst)[x] = acc;
+        }
+    }
+
+    file_internal void
+    LanczosRows(PyramidLevelJob *job, u32 begin, u32 end)
+    {
+        u32 dst_width = (job->src_width + 1) / 2;
+        u32 sample_size = PyramidSampleSize(job->format);
+
+        r32 weights[PYRAMID_LANCZOS_TAPS];
+        PyramidLanczosWeights(weights);
+
+        r32 *column  = (r32*)SysAlloc(sizeof(r32) * (job->src_width + 2 * (dst_width + PYRAMID_LANCZOS_TAPS / 2)));
+        r32 *scratch = column + job->src_width;
+
+        for (u32 y = begin; y < end; ++y)
+        {
+            LanczosColumns(job->format, job->src, job->src_width, job->src_height, y, weights, column);
+            void *row = (void*)PyramidRow(job->dst, dst_width, y, sample_size);
+            LanczosRow(job->format, column, job->src_width, weights, scratch, row, 0, dst_width);
+        }
+
+        SysFree(column);
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // Jobs
+
+    file_internal void
+    ReduceLevelRows(PyramidLevelJob *job, u32 begin, u32 end)
+    {
+        if (job->reduce == PyramidReduce::Lanczos)
+        {
+            LanczosRows(job, begin, end);
+            return;
+        }
+
+        u32 dst_width = (job->src_width + 1) / 2;
+        for (u32 y = begin; y < end; ++y)
+        {
+            ReduceRow(job->format, job->reduce, job->src, job->src_width, job->src_height, job->dst, y, 0, dst_width);
+        }
+    }
+
+    // Job callback, reduces rows [begin, end) of a level
+    file_internal void
+    PyramidLevelRows(u32 begin, u32 end, void *args)
+    {
+        ReduceLevelRows((PyramidLevelJob*)args, begin, end);
+    }
+
+    // Job callback, reduces tiles [begin, end) through the tile levels. Tile edges at level
+    // 0 are multiples of 2^levels, so the blocks of a tile never reach into another tile.
+    file_internal void
+    PyramidTiles(u32 begin, u32 end, void *args)
+    {
+        PyramidTileJob *job = (PyramidTileJob*)args;
+        HeightPyramid *pyramid = job->pyramid;
+
+        for (u32 tile = begin; tile < end; ++tile)
+        {
+            u32 tile_x = (tile % job->tiles_x) * PYRAMID_TILE_SIZE;
+            u32 tile_y = (tile / job->tiles_x) * PYRAMID_TILE_SIZE;
+
+            for (u32 level = 1; level <= job->levels; ++level)
+            {
+                u32 x0 = tile_x >> level;
+                u32 y0 = tile_y >> level;
+                u32 x1 = fast_min((tile_x + PYRAMID_TILE_SIZE) >> level, pyramid->width[level]);
+                u32 y1 = fast_min((tile_y + PYRAMID_TILE_SIZE) >> level, pyramid->height[level]);
+
+                for (u32 y = y0; y < y1; ++y)
+                {
+                    ReduceRow(pyramid->format, pyramid->reduce, pyramid->level[level - 1],
+                              pyramid->width[level - 1], pyramid->height[level - 1],
+                              pyramid->level[level], y, x0, x1);
+                }
+            }
+        }
+    }
+
+}; // terrain
+
+u32 terrain::HeightPyramidLevelCount(u32 width, u32 height)
+{
+    u32 levels = 1;
+    while ((width > 1 || height > 1) && levels < HEIGHT_PYRAMID_MAX_LEVELS)
+    {
+        width  = (width  + 1) / 2;
+        height = (height + 1) / 2;
+        ++levels;
+    }
+    return levels;
+}
+
+bool terrain::HeightPyramidBuild(HeightPyramid *pyramid, HeightPyramidDesc *desc)
+{
+    *pyramid = {};
+    if (!desc->heightmap || desc->width == 0 || desc->height == 0) return false;
+
+    u32 levels = HeightPyramidLevelCount(desc->width, desc->height);
+    if (desc->levels > 0) levels = fast_min(levels, desc->levels);
+
+    pyramid->format = desc->format;
+    pyramid->reduce = desc->reduce;
+    pyramid->levels = levels;
+
+    u32 sample_size = PyramidSampleSize(desc->format);
+    u64 offsets[HEIGHT_PYRAMID_MAX_LEVELS];
+    u64 bytes = 0;
+
+    pyramid->width[0]  = desc->width;
+    pyramid->height[0] = desc->height;
+    for (u32 level = 1; level < levels; ++level)
+    {
+        pyramid->width[level]  = (pyramid->width[level - 1]  + 1) / 2;
+        pyramid->height[level] = (pyramid->height[level - 1] + 1) / 2;
+        offsets[level] = bytes;
+        bytes += (u64)pyramid->width[level] * pyramid->height[level] * sample_size;
+    }
+
+    pyramid->level[0] = (void*)desc->heightmap;
+    if (levels == 1) return true;
+
+    u8 *data = (u8*)SysAlloc(bytes);
+    for (u32 level = 1; level < levels; ++level) pyramid->level[level] = data + offsets[level];
+
+    // The tiles take the levels that fit in them, the rows the rest
+    u32 first_row_level = 1;
+    if (desc->reduce != PyramidReduce::Lanczos)
+    {
+        PyramidTileJob job = {};
+        job.pyramid = pyramid;
+        job.tiles_x = (desc->width + PYRAMID_TILE_SIZE - 1) / PYRAMID_TILE_SIZE;
+        job.levels  = fast_min(levels - 1, PYRAMID_TILE_LEVELS);
+
+        u32 tiles_y = (desc->height + PYRAMID_TILE_SIZE - 1) / PYRAMID_TILE_SIZE;
+        JobSystemParallelFor(job.tiles_x * tiles_y, 1, PyramidTiles, &job);
+
+        first_row_level = job.levels + 1;
+    }
+
+    for (u32 level = first_row_level; level < levels; ++level)
+    {
+        PyramidLevelJob job = {};
+        job.format     = desc->format;
+        job.reduce     = desc->reduce;
+        job.src        = pyramid->level[level - 1];
+        job.src_width  = pyramid->width[level - 1];
+        job.src_height = pyramid->height[level - 1];
+        job.dst        = pyramid->level[level];
+
+        // A row of the level reads two rows of the source, eight with Lanczos
+        u32 row_samples = job.src_width * ((desc->reduce == PyramidReduce::Lanczos) ? PYRAMID_LANCZOS_TAPS : 2);
+        u32 rows_per_job = fast_max(1, PYRAMID_ROWS_PER_JOB_SAMPLES / row_samples);
+        JobSystemParallelFor(pyramid->height[level], rows_per_job, PyramidLevelRows, &job);
+    }
+
+    return true;
+}
+
+void terrain::HeightPyramidFree(HeightPyramid *pyramid)
+{
+    if (pyramid->levels > 1) SysFree(pyramid->level[1]);
+    *pyramid = {};
+}
+
+void terrain::HeightReduceRows(HeightFormat format, PyramidReduce reduce, const void *src, u32 src_width, u32 src_height,
+                               void *dst, u32 begin, u32 end)
+{
+    if (src_width == 0 || src_height == 0) return;
+
+    PyramidLevelJob job = {};
+    job.format     = format;
+    job.reduce     = reduce;
+    job.src        = src;
+    job.src_width  = src_width;
+    job.src_height = src_height;
+    job.dst        = dst;
+    ReduceLevelRows(&job, begin, end);
+}
+
+#undef PYRAMID_TILE_SIZE
+#undef PYRAMID_TILE_LEVELS
+#undef PYRAMID_ROWS_PER_JOB_SAMPLES
+#undef PYRAMID_LANCZOS_TAPS
+#undef PYRAMID_SSE2
@@ -0,0 +1,81 @@
+#ifndef _TERRAIN_PYRAMID_H
+#define _TERRAIN_PYRAMID_H
+
+//
+// Mip pyramids of single channel heightmaps, built on the CPU so the heights keep their
+// full precision (the GPU HeightmapDownsampler renders into an 8-bit target).
+//
+// Level 0 is the heightmap itself, level L + 1 has ceil(w / 2) x ceil(h / 2) samples.
+// Sample (x, y) of level L + 1 reduces the 2x2 block at (2x, 2y) of level L, where a block
+// at an odd right or bottom edge repeats its last column or row:
+// - Min and Max keep the lowest and highest height of the block, so a sample of level L
+//   bounds the 2^L x 2^L heights under it. Use them for LOD bounds and culling.
+// - Average is a box filter.
+// - Lanczos weighs 8x8 samples around the block with a 2-lobe Lanczos kernel. It keeps
+//   more detail than the box filter in previews, but can overshoot the heights a little.
+//
+// Min, Max and Average reduce square tiles of the heightmap on the job system: a job takes
+// a tile of level 0 down through the levels that fit in the tile while it is still in the
+// cache. The levels past the tiles, and every level of Lanczos (which reads past the
+// block), are reduced level by level in bands of rows. Rows are reduced 4 (r32) or 8 (u16)
+// samples at a time with SSE2, and the results do not depend on the thread count.
+//
+
+#define HEIGHT_PYRAMID_MAX_LEVELS 32
+
+namespace terrain
+{
+    enum class HeightFormat : u8
+    {
+        R32,
+        U16,
+    };
+
+    enum class PyramidReduce : u8
+    {
+        Min,
+        Max,
+        Average,
+        Lanczos,
+    };
+
+    struct HeightPyramidDesc
+    {
+        const void   *heightmap;  // width x height samples of "format", row-major
+        u32           width;
+        u32           height;
+        HeightFormat  format;
+        PyramidReduce reduce;
+        u32           levels;     // including level 0, 0 to go down to 1x1
+    };
+
+    struct HeightPyramid
+    {
+        HeightFormat  format;
+        PyramidReduce reduce;
+        u32           levels;
+        u32           width[HEIGHT_PYRAMID_MAX_LEVELS];
+        u32           height[HEIGHT_PYRAMID_MAX_LEVELS];
+        // Samples of each level, row-major. Level 0 is the heightmap of the desc, it is not
+        // copied and has to outlive the pyramid. The other levels share one allocation.
+        void         *level[HEIGHT_PYRAMID_MAX_LEVELS];
+    };
+
+    // Number of levels down to 1x1
+    u32  HeightPyramidLevelCount(u32 width, u32 height);
+
+    // Returns false if the heightmap is empty
+    // @param pyramid: (output) free it with HeightPyramidFree
+    bool HeightPyramidBuild(HeightPyramid *pyramid, HeightPyramidDesc *desc);
+    void HeightPyramidFree(HeightPyramid *pyramid);
+
+    // Reduces the rows [begin, end) of the level below "src" on the calling thread, to
+    // stream a level through without the rest of the pyramid.
+    // @param src: src_width x src_height samples of "format", row-major
+    // @param dst: (output) ceil(src_width / 2) samples per row, rows [begin, end) are written
+    void HeightReduceRows(HeightFormat format, PyramidReduce reduce, const void *src, u32 src_width, u32 src_height,
+                          void *dst, u32 begin, u32 end);
+
+}; // terrain
+
+#endif //_TERRAIN_PYRAMID_H
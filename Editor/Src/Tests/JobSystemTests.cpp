@@ -0,0 +1,89 @@
+
+// Benchmarks of Core/JobSystem.h
+
+#define JOB_BENCH_FOR_COUNT  100000
+#define JOB_BENCH_FOR_GRAIN  64
+#define JOB_BENCH_FOR_ITERS  200
+#define JOB_BENCH_EMPTY_JOBS 100000
+#define JOB_BENCH_NESTED     100
+
+file_global std::atomic<u64> g_job_bench_sum;
+
+static void
+JobBenchRange(u32 begin, u32 end, void *args)
+{
+    u64 sum = 0;
+    for (u32 i = begin; i < end; ++i) sum += i;
+    g_job_bench_sum += sum;
+}
+
+static void
+JobBenchEmpty(void *args)
+{
+}
+
+// A job that forks its own parallel_for and waits on it from inside the worker
+static void
+JobBenchNested(void *args)
+{
+    JobSystemParallelFor(1000, 10, JobBenchRange, NULL);
+}
+
+// -bench jobs: parallel_for, submit/wait of empty jobs and nested parallel_for on 1 to N
+// threads. Restarts the job system for every thread count.
+static void
+BenchJobSystem()
+{
+    u32 restore_workers = JobSystemGetThreadCount() - 1;
+
+    PosixProcessorInfo processor_info = {};
+    PosixGetProcessorInfo(&processor_info);
+    u32 max_threads = (processor_info.logical_processor_count > 4) ? processor_info.logical_processor_count : 4;
+
+    for (u32 thread_count = 1; thread_count <= max_threads; thread_count *= 2)
+    {
+        JobSystemFree();
+        JobSystemInit(thread_count - 1);
+
+        char label[64];
+        Timer timer;
+
+        u64 for_sum = (u64)JOB_BENCH_FOR_COUNT * (JOB_BENCH_FOR_COUNT - 1) / 2;
+        g_job_bench_sum = 0;
+        TimerBegin(&timer);
+        for (u32 i = 0; i < JOB_BENCH_FOR_ITERS; ++i)
+        {
+            JobSystemParallelFor(JOB_BENCH_FOR_COUNT, JOB_BENCH_FOR_GRAIN, JobBenchRange, NULL);
+        }
+        r64 ms = TimerMiliSecondsElapsed(&timer);
+        if (g_job_bench_sum != for_sum * JOB_BENCH_FOR_ITERS) LogError("parallel_for missed ranges on %u threads!", thread_count);
+        snprintf(label, sizeof(label), "parallel_for, %u threads", thread_count);
+        BenchReport(label, ms, (r64)JOB_BENCH_FOR_ITERS * (JOB_BENCH_FOR_COUNT / JOB_BENCH_FOR_GRAIN), "ranges");
+
+        JobCounter counter;
+        TimerBegin(&timer);
+        for (u32 i = 0; i < JOB_BENCH_EMPTY_JOBS; ++i)
+        {
+            JobSystemSubmit(JobBenchEmpty, NULL, &counter);
+        }
+        JobSystemWait(&counter);
+        ms = TimerMiliSecondsElapsed(&timer);
+        snprintf(label, sizeof(label), "submit/wait, %u threads", thread_count);
+        BenchReport(label, ms, JOB_BENCH_EMPTY_JOBS, "jobs");
+
+        g_job_bench_sum = 0;
+        TimerBegin(&timer);
+        for (u32 i = 0; i < JOB_BENCH_NESTED; ++i)
+        {
+            JobSystemSubmit(JobBenchNested, NULL, &counter);
+        }
+        JobSystemWait(&counter);
+        ms = TimerMiliSecondsElapsed(&timer);
+        if (g_job_bench_sum != (u64)JOB_BENCH_NESTED * (1000 * 999 / 2)) LogError("Nested parallel_for missed ranges on %u threads!", thread_count);
+        snprintf(label, sizeof(label), "nested parallel_for, %u threads", thread_count);
+        BenchReport(label, ms, JOB_BENCH_NESTED * 100, "ranges");
+    }
+
+    JobSystemFree();
+    JobSystemInit(restore_workers);
+}
@@ -0,0 +1,456 @@
+
+// Self tests and benchmarks of Common/Util/Memory.h and SysMemory
+
+//-----------------------------------------------------------------------------------------------//
+// Trace replay
+
+// One step of an allocation trace: allocates "size" bytes into "slot", or releases the
+// slot when size is 0
+struct MemoryTraceOp
+{
+    u32 slot;
+    u32 size;
+};
+
+#define MEMORY_TRACE_SLOTS 8192
+#define MEMORY_TRACE_OPS   400000
+
+// Records a trace shaped like an editor session: mostly small strings and array headers,
+// some buffers of a few KB, and rare large blocks, with lifetimes from immediate to the
+// whole session. The same seed gives the same trace.
+static MemoryTraceOp*
+MemoryRecordTrace(u64 seed)
+{
+    MemoryTraceOp *trace = (MemoryTraceOp*)SysAlloc(sizeof(MemoryTraceOp) * MEMORY_TRACE_OPS);
+    bool *live = (bool*)SysAlloc(MEMORY_TRACE_SLOTS);
+    memset(live, 0, MEMORY_TRACE_SLOTS);
+
+    TestRng rng = TestRngInit(seed);
+    for (u32 i = 0; i < MEMORY_TRACE_OPS; ++i)
+    {
+        u32 slot = TestRandomRange(&rng, MEMORY_TRACE_SLOTS);
+        u32 size = 0;
+        if (!live[slot])
+        {
+            u32 kind = TestRandomRange(&rng, 100);
+            if      (kind < 80) size = 8 + TestRandomRange(&rng, 248);
+            else if (kind < 98) size = 256 + TestRandomRange(&rng, _KB(16));
+            else                size = _KB(16) + TestRandomRange(&rng, _KB(256));
+        }
+        live[slot] = size != 0;
+        trace[i] = { slot, size };
+    }
+
+    SysFree(live);
+    return trace;
+}
+
+// @returns the time to replay the trace in ms
+static r64
+MemoryReplayTrace(memory_mode mode, MemoryTraceOp *trace, u64 *peak)
+{
+    u64 heap_size = _MB(512);
+    void *backing = PlatformVirtualAlloc(heap_size);
+    void **slots = (void**)SysAlloc(sizeof(void*) * MEMORY_TRACE_SLOTS);
+    memset(slots, 0, sizeof(void*) * MEMORY_TRACE_SLOTS);
+
+    memory_t heap;
+    memory_init(&heap, heap_size, backing, mode);
+
+    *peak = 0;
+    Timer timer;
+    TimerBegin(&timer);
+    for (u32 i = 0; i < MEMORY_TRACE_OPS; ++i)
+    {
+        MemoryTraceOp op = trace[i];
+        if (op.size)
+        {
+            slots[op.slot] = memory_alloc(heap, op.size);
+            u64 used = (u64)((char*)heap->Brkp - (char*)heap->Start);
+            if (used > *peak) *peak = used;
+        }
+        else if (slots[op.slot])
+        {
+            memory_release(heap, slots[op.slot]);
+            slots[op.slot] = NULL;
+        }
+    }
+    r64 ms = TimerMiliSecondsElapsed(&timer);
+
+    for (u32 i = 0; i < MEMORY_TRACE_SLOTS; ++i)
+    {
+        if (slots[i]) memory_release(heap, slots[i]);
+    }
+    memory_free(&heap);
+    SysFree(slots);
+    PlatformVirtualFree(backing);
+    return ms;
+}
+
+// -bench memory_trace: the same recorded trace replayed against both memory_t modes
+static void
+BenchMemoryTrace()
+{
+    MemoryTraceOp *trace = MemoryRecordTrace(1);
+
+    const char *names[] = { "first fit", "segregated fit" };
+    memory_mode modes[] = { MemoryMode_FirstFit, MemoryMode_Segregated };
+    for (u32 i = 0; i < ARRAYCOUNT(modes); ++i)
+    {
+        u64 peak;
+        r64 ms = MemoryReplayTrace(modes[i], trace, &peak);
+        BenchReport(names[i], ms, MEMORY_TRACE_OPS, "ops");
+        LogInfo("    %.1f ns/op, heap high water %.1f MB", ms * 1e6 / MEMORY_TRACE_OPS, peak / (1024.0 * 1024.0));
+    }
+
+    SysFree(trace);
+}
+
+//-----------------------------------------------------------------------------------------------//
+// Multi-threaded throughput
+
+#define MEMORY_MT_SLOTS 256
+#define MEMORY_MT_OPS   400000
+
+struct MemoryThreadArgs
+{
+    u32              seed;
+    memory_t         heap;  // NULL to use SysMemory
+    pthread_mutex_t *lock;
+};
+
+// Alloc/free churn of small blocks, the way worker threads allocate job data and strings
+static void*
+MemoryThreadChurn(void *ptr)
+{
+    MemoryThreadArgs args = *(MemoryThreadArgs*)ptr;
+    void *slots[MEMORY_MT_SLOTS] = {};
+    TestRng rng = TestRngInit(args.seed);
+    for (u32 i = 0; i < MEMORY_MT_OPS; ++i)
+    {
+        u32 slot = TestRandomRange(&rng, MEMORY_MT_SLOTS);
+        if (args.heap)
+        {
+            pthread_mutex_lock(args.lock);
+            if (slots[slot]) memory_release(args.heap, slots[slot]);
+            slots[slot] = slots[slot] ? NULL : memory_alloc(args.heap, 16 + TestRandomRange(&rng, 496));
+            pthread_mutex_unlock(args.lock);
+        }
+        else
+        {
+            if (slots[slot]) SysMemoryRelease(slots[slot]);
+            slots[slot] = slots[slot] ? NULL : SysMemoryAlloc(16 + TestRandomRange(&rng, 496));
+        }
+    }
+
+    for (u32 i = 0; i < MEMORY_MT_SLOTS; ++i)
+    {
+        if (!slots[i]) continue;
+        if (args.heap)
+        {
+            pthread_mutex_lock(args.lock);
+            memory_release(args.heap, slots[i]);
+            pthread_mutex_unlock(args.lock);
+        }
+        else SysMemoryRelease(slots[i]);
+    }
+    if (!args.heap) SysMemoryThreadFlush();
+    return NULL;
+}
+
+// -bench memory_mt: small block churn on 1 to N threads, through SysMemory's thread caches
+// and through one memory_t behind a lock (SysMemory before the caches)
+static void
+BenchMemoryThreads()
+{
+    PosixProcessorInfo processor_info = {};
+    PosixGetProcessorInfo(&processor_info);
+    u32 max_threads = (processor_info.logical_processor_count > 4) ? processor_info.logical_processor_count : 4;
+
+    u64 heap_size = _MB(64);
+    void *backing = PlatformVirtualAlloc(heap_size);
+    pthread_mutex_t lock;
+    pthread_mutex_init(&lock, NULL);
+
+    for (u32 locked = 0; locked < 2; ++locked)
+    {
+        for (u32 thread_count = 1; thread_count <= max_threads; thread_count *= 2)
+        {
+            memory_t heap = NULL;
+            if (locked) memory_init(&heap, heap_size, backing, MemoryMode_Segregated);
+
+            pthread_t        *threads = (pthread_t*)SysAlloc(sizeof(pthread_t) * thread_count);
+            MemoryThreadArgs *args    = (MemoryThreadArgs*)SysAlloc(sizeof(MemoryThreadArgs) * thread_count);
+            Timer timer;
+            TimerBegin(&timer);
+            for (u32 i = 0; i < thread_count; ++i)
+            {
+                args[i] = { i + 1, heap, &lock };
+                pthread_create(threads + i, NULL, MemoryThreadChurn, args + i);
+            }
+            for (u32 i = 0; i < thread_count; ++i) pthread_join(threads[i], NULL);
+            r64 ms = TimerMiliSecondsElapsed(&timer);
+            SysFree(args);
+            SysFree(threads);
+
+            if (heap) memory_free(&heap);
+
+            char label[64];
+            snprintf(label, sizeof(label), "%s, %u threads", locked ? "locked memory_t" : "thread caches", thread_count);
+            BenchReport(label, ms, (r64)MEMORY_MT_OPS * thread_count, "ops");
+        }
+    }
+
+    pthread_mutex_destroy(&lock);
+    PlatformVirtualFree(backing);
+}
+
+//-----------------------------------------------------------------------------------------------//
+// Realloc self test
+
+#define MEMORY_STRESS_SLOTS 512
+#define MEMORY_STRESS_OPS   200000
+
+// memory_t's header layout: the block header is one pointer in front of the data
+#define MEMORY_TEST_HEADER(ptr) ((header_t)((char*)(ptr) - sizeof(void*)))
+
+// Walks every block from Start to the break pointer and checks the allocator's bookkeeping:
+// the blocks tile the heap, the usage counters match the used blocks, every free block is
+// linked in the free list (or its bin), and no two free blocks sit next to each other.
+static void
+MemoryCheckHeap(memory_t heap)
+{
+    bool segregated = heap->Mode == MemoryMode_Segregated;
+
+    u64  used          = 0;
+    u64  count         = 0;
+    u64  free_blocks   = 0;
+    bool prev_free     = false;
+    bool adjacent_free = false;
+    bool bad_tag       = false;
+
+    char *iter = (char*)heap->Start;
+    while (iter < (char*)heap->Brkp)
+    {
+        header_t header = (header_t)iter;
+
+        // First fit blocks always reserve room for the free list links
+        u64 data_size = header->Size;
+        if (!segregated && data_size < 2 * sizeof(void*)) data_size = 2 * sizeof(void*);
+
+        if (header->Used)
+        {
+            used += header->Size;
+            ++count;
+        }
+        else
+        {
+            ++free_blocks;
+            if (prev_free) adjacent_free = true;
+            // Segregated fit keeps a copy of the size in the last 8 bytes of a free block
+            if (segregated && *(u64*)(iter + sizeof(void*) + data_size - sizeof(u64)) != header->Size) bad_tag = true;
+        }
+        if (segregated && (bool)header->PrevFree != prev_free) bad_tag = true;
+
+        prev_free = !header->Used;
+        iter += sizeof(void*) + data_size;
+    }
+
+    u64 listed = 0;
+    if (segregated)
+    {
+        for (u32 bin = 0; bin < ARRAYCOUNT(heap->Bins); ++bin)
+        {
+            if (((heap->BinMask >> bin) & 1) != (heap->Bins[bin] != NULL)) bad_tag = true;
+            for (header_t header = heap->Bins[bin]; header; header = header->Next) ++listed;
+        }
+    }
+    else
+    {
+        for (header_t header = heap->FreeList; header; header = header->Next) ++listed;
+    }
+
+    TestCheck(iter == (char*)heap->Brkp);
+    TestCheck(used == heap->UsedMemory);
+    TestCheck(count == heap->NumAllocations);
+    TestCheck(listed == free_blocks);
+    TestCheck(!adjacent_free);
+    TestCheck(!bad_tag);
+}
+
+static void
+MemoryFill(void *ptr, u64 size, u8 value)
+{
+    memset(ptr, value, size);
+}
+
+static bool
+MemoryHasFill(void *ptr, u64 size, u8 value)
+{
+    for (u64 i = 0; i < size; ++i)
+    {
+        if (((u8*)ptr)[i] != value) return false;
+    }
+    return true;
+}
+
+// The in-place paths of memory_realloc, each set up on an empty heap so blocks are laid
+// out in allocation order
+static void
+MemoryTestReallocCases(void *backing, u64 heap_size, memory_mode mode)
+{
+    memory_t heap;
+
+    // Growth into the physically next free block
+    memory_init(&heap, heap_size, backing, mode);
+    void *a = memory_alloc(heap, 64);
+    void *b = memory_alloc(heap, 64);
+    void *guard = memory_alloc(heap, 64);
+    MemoryFill(a, 64, 0xA1);
+    memory_release(heap, b);
+    void *grown = memory_realloc(heap, a, 120);
+    TestCheck(grown == a);
+    TestCheck(MemoryHasFill(grown, 64, 0xA1));
+    MemoryCheckHeap(heap);
+    memory_release(heap, grown);
+    memory_release(heap, guard);
+    memory_free(&heap);
+
+    // Growth of the last block moves the break pointer
+    memory_init(&heap, heap_size, backing, mode);
+    a = memory_alloc(heap, 64);
+    MemoryFill(a, 64, 0xB2);
+    void *brkp = heap->Brkp;
+    grown = memory_realloc(heap, a, 4096);
+    TestCheck(grown == a);
+    TestCheck((char*)heap->Brkp > (char*)brkp);
+    TestCheck(MemoryHasFill(grown, 64, 0xB2));
+    MemoryCheckHeap(heap);
+    memory_release(heap, grown);
+    memory_free(&heap);
+
+    // Shrink splits the block in place, and the tail coalesces with the free block after it,
+    // so growing back to the combined size of both stays in place
+    memory_init(&heap, heap_size, backing, mode);
+    a = memory_alloc(heap, 256);
+    b = memory_alloc(heap, 256);
+    guard = memory_alloc(heap, 64);
+    MemoryFill(a, 256, 0xC3);
+    u64 combined = MEMORY_TEST_HEADER(a)->Size + sizeof(void*) + MEMORY_TEST_HEADER(b)->Size;
+    memory_release(heap, b);
+    void *shrunk = memory_realloc(heap, a, 32);
+    TestCheck(shrunk == a);
+    TestCheck(MEMORY_TEST_HEADER(a)->Size < 256);
+    TestCheck(MemoryHasFill(shrunk, 32, 0xC3));
+    MemoryCheckHeap(heap);
+    grown = memory_realloc(heap, a, combined);
+    TestCheck(grown == a);
+    TestCheck(MemoryHasFill(grown, 32, 0xC3));
+    MemoryCheckHeap(heap);
+
+    // No room after the block: the data moves and the old block is released
+    MemoryFill(grown, combined, 0xD4);
+    void *moved = memory_realloc(heap, grown, combined + 1024);
+    TestCheck(moved != grown);
+    TestCheck(MemoryHasFill(moved, combined, 0xD4));
+    MemoryCheckHeap(heap);
+    memory_release(heap, moved);
+    memory_release(heap, guard);
+    MemoryCheckHeap(heap);
+    TestCheck(heap->NumAllocations == 0);
+    memory_free(&heap);
+}
+
+// Random allocs, releases and reallocs over a fixed set of slots. Every slot is filled with
+// its own byte, so a realloc that loses or overlaps data shows up on the next check.
+static void
+MemoryTestReallocStress(memory_t heap, u32 *in_place, u32 *moves)
+{
+    void **slots = (void**)SysAlloc(sizeof(void*) * MEMORY_STRESS_SLOTS);
+    u32   *sizes = (u32*)SysAlloc(sizeof(u32) * MEMORY_STRESS_SLOTS);
+    memset(slots, 0, sizeof(void*) * MEMORY_STRESS_SLOTS);
+    memset(sizes, 0, sizeof(u32) * MEMORY_STRESS_SLOTS);
+
+    *in_place = 0;
+    *moves    = 0;
+    u32 corrupt = 0;
+
+    TestRng rng = TestRngInit(7);
+    for (u32 i = 0; i < MEMORY_STRESS_OPS; ++i)
+    {
+        u32 slot = TestRandomRange(&rng, MEMORY_STRESS_SLOTS);
+        u32 size = 1 + TestRandomRange(&rng, TestRandomRange(&rng, 10) ? 512 : 8192);
+        u8  fill = (u8)(slot * 31 + 1);
+
+        if (!slots[slot])
+        {
+            slots[slot] = memory_alloc(heap, size);
+            sizes[slot] = size;
+            MemoryFill(slots[slot], size, fill);
+        }
+        else if (TestRandomRange(&rng, 4) == 0)
+        {
+            memory_release(heap, slots[slot]);
+            slots[slot] = NULL;
+        }
+        else
+        {
+            void *ptr = memory_realloc(heap, slots[slot], size);
+            u32 kept = (size < sizes[slot]) ? size : sizes[slot];
+            if (!MemoryHasFill(ptr, kept, fill)) ++corrupt;
+
+            if (size > sizes[slot])
+            {
+                if (ptr == slots[slot]) ++(*in_place);
+                else                    ++(*moves);
+            }
+            slots[slot] = ptr;
+            sizes[slot] = size;
+            MemoryFill(ptr, size, fill);
+        }
+
+        if (i % 1000 == 0) MemoryCheckHeap(heap);
+    }
+    MemoryCheckHeap(heap);
+    TestCheck(corrupt == 0);
+
+    for (u32 i = 0; i < MEMORY_STRESS_SLOTS; ++i)
+    {
+        if (slots[i]) memory_release(heap, slots[i]);
+    }
+    MemoryCheckHeap(heap);
+    TestCheck(heap->NumAllocations == 0 && heap->UsedMemory == 0);
+
+    SysFree(sizes);
+    SysFree(slots);
+}
+
+// -selftest memory_realloc: memory_realloc's in-place growth, shrink and coalescing, directed
+// and randomized, against both memory_t modes
+static void
+TestMemoryRealloc()
+{
+    u64 heap_size = _MB(64);
+    void *backing = PlatformVirtualAlloc(heap_size);
+
+    const char *names[] = { "first fit", "segregated fit" };
+    memory_mode modes[] = { MemoryMode_FirstFit, MemoryMode_Segregated };
+    for (u32 i = 0; i < ARRAYCOUNT(modes); ++i)
+    {
+        MemoryTestReallocCases(backing, heap_size, modes[i]);
+
+        memory_t heap;
+        memory_init(&heap, heap_size, backing, modes[i]);
+
+        u32 in_place, moves;
+        MemoryTestReallocStress(heap, &in_place, &moves);
+        TestCheck(in_place > 0 && moves > 0);
+        LogInfo("    %s: %u growths in place, %u moved", names[i], in_place, moves);
+
+        memory_free(&heap);
+    }
+
+    PlatformVirtualFree(backing);
+}
+
+#undef MEMORY_TEST_HEADER
@@ -0,0 +1,149 @@
+
+// Benchmarks of Common/Util/StrPool.h
+
+#define STR_POOL_MT_SLOTS    512
+#define STR_POOL_MT_OPS      200000
+#define STR_POOL_MT_NAMES    1024 // names of each kind, at most STR_POOL_MT_NAME_LEN bytes
+#define STR_POOL_MT_NAME_LEN 64
+
+struct StrPoolThreadArgs
+{
+    u32              thread;
+    const char      *asset_names;  // this thread's, STR_POOL_MT_NAMES x STR_POOL_MT_NAME_LEN
+    const char      *shared_names; // every thread's
+    pthread_mutex_t *lock;         // NULL to only use the pool's own locks
+    u64             *waits;        // (output) waits on "lock"
+};
+
+FORCE_INLINE void
+StrPoolBenchLock(StrPoolThreadArgs *args)
+{
+    if (!args->lock) return;
+    if (pthread_mutex_trylock(args->lock) != 0)
+    {
+        pthread_mutex_lock(args->lock);
+        ++*args->waits; // under the lock
+    }
+}
+
+FORCE_INLINE void
+StrPoolBenchUnlock(StrPoolThreadArgs *args)
+{
+    if (args->lock) pthread_mutex_unlock(args->lock);
+}
+
+// Create/free churn the way the loaders use strings: asset paths only one thread creates,
+// material names every thread shares, a ".meta" path now and then, and a long string
+// (past the slab pages) every 997 ops. Each string lives until its slot is reused.
+static void*
+StrPoolThreadChurn(void *ptr)
+{
+    StrPoolThreadArgs args = *(StrPoolThreadArgs*)ptr;
+
+    STR_ID slots[STR_POOL_MT_SLOTS];
+    for (u32 i = 0; i < STR_POOL_MT_SLOTS; ++i) slots[i].mask = INVALID_STR_ID;
+
+    char long_name[600];
+    memset(long_name, 'a' + args.thread % 26, sizeof(long_name));
+    for (u32 i = 0; i < STR_POOL_MT_OPS; ++i)
+    {
+        const char *name;
+        if (i % 997 == 0) name = long_name;
+        else if (i & 1)   name = args.asset_names  + ((i * 7919) % STR_POOL_MT_NAMES) * STR_POOL_MT_NAME_LEN;
+        else              name = args.shared_names + ((i * 31) % STR_POOL_MT_NAMES) * STR_POOL_MT_NAME_LEN;
+        u32 len = (name == long_name) ? 400 + i % 200 : (u32)strlen(name);
+
+        StrPoolBenchLock(&args);
+        STR_ID sid = StrInit(name, len);
+        if ((i & 15) == 0)
+        {
+            STR_ID meta = StrAdd(sid, ".meta", 5);
+            StrFree(sid);
+            sid = meta;
+        }
+
+        u32 slot = i % STR_POOL_MT_SLOTS;
+        if (IsStrIdValid(slots[slot])) StrFree(slots[slot]);
+        slots[slot] = sid;
+        StrPoolBenchUnlock(&args);
+    }
+
+    StrPoolBenchLock(&args);
+    for (u32 i = 0; i < STR_POOL_MT_SLOTS; ++i)
+    {
+        if (IsStrIdValid(slots[i])) StrFree(slots[i]);
+    }
+    StrPoolBenchUnlock(&args);
+    return NULL;
+}
+
+// -bench str_pool_mt: string create/free churn on 1 to N threads, through the pool's size
+// class and shard locks, and with every call behind one lock (the pool before the slab pages)
+static void
+BenchStrPoolThreads()
+{
+    PosixProcessorInfo processor_info = {};
+    PosixGetProcessorInfo(&processor_info);
+    u32 max_threads = (processor_info.logical_processor_count > 8) ? processor_info.logical_processor_count : 8;
+
+    pthread_mutex_t lock;
+    pthread_mutex_init(&lock, NULL);
+
+    // Names are formatted up front, so the timings are the pool's
+    u64 names_size = (u64)STR_POOL_MT_NAMES * STR_POOL_MT_NAME_LEN;
+    char *shared_names = (char*)SysAlloc(names_size);
+    char *asset_names  = (char*)SysAlloc(names_size * max_threads);
+    for (u32 i = 0; i < STR_POOL_MT_NAMES; ++i)
+    {
+        snprintf(shared_names + i * STR_POOL_MT_NAME_LEN, STR_POOL_MT_NAME_LEN, "shared/material_%u", i);
+        for (u32 t = 0; t < max_threads; ++t)
+        {
+            snprintf(asset_names + t * names_size + i * STR_POOL_MT_NAME_LEN, STR_POOL_MT_NAME_LEN,
+                     "assets/thread_%u/chunk_%u/mesh_%u.bin", t, i, i % 17);
+        }
+    }
+
+    for (u32 locked = 0; locked < 2; ++locked)
+    {
+        for (u32 thread_count = 1; thread_count <= max_threads; thread_count *= 2)
+        {
+            StrPoolStats before;
+            StrPoolGetStats(&before);
+            u64 waits = 0;
+
+            pthread_t         *threads = (pthread_t*)SysAlloc(sizeof(pthread_t) * thread_count);
+            StrPoolThreadArgs *args    = (StrPoolThreadArgs*)SysAlloc(sizeof(StrPoolThreadArgs) * thread_count);
+            Timer timer;
+            TimerBegin(&timer);
+            for (u32 i = 0; i < thread_count; ++i)
+            {
+                args[i] = { i, asset_names + i * names_size, shared_names, locked ? &lock : NULL, &waits };
+                pthread_create(threads + i, NULL, StrPoolThreadChurn, args + i);
+            }
+            for (u32 i = 0; i < thread_count; ++i) pthread_join(threads[i], NULL);
+            r64 ms = TimerMiliSecondsElapsed(&timer);
+            SysFree(args);
+            SysFree(threads);
+
+            StrPoolStats after;
+            StrPoolGetStats(&after);
+            waits += after.lock_waits - before.lock_waits;
+
+            r64 ops = (r64)STR_POOL_MT_OPS * thread_count;
+            char label[64];
+            snprintf(label, sizeof(label), "%s, %u threads", locked ? "one lock" : "pool locks", thread_count);
+            BenchReport(label, ms, ops, "ops");
+            LogInfo("    %.1f ns/op, %.2f lock waits per 1000 ops, %llu strings left", ms * 1e6 / ops,
+                    waits * 1000.0 / ops, (unsigned long long)(after.strings - before.strings));
+        }
+    }
+
+    SysFree(asset_names);
+    SysFree(shared_names);
+    pthread_mutex_destroy(&lock);
+}
+
+#undef STR_POOL_MT_NAME_LEN
+#undef STR_POOL_MT_NAMES
+#undef STR_POOL_MT_OPS
+#undef STR_POOL_MT_SLOTS
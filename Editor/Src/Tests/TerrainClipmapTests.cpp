@@ -0,0 +1,84 @@
+
+// Benchmarks of Terrain/TerrainClipmap.h
+
+#define CLIPMAP_BENCH_HEIGHTMAP 4097
+#define CLIPMAP_BENCH_FRAMES    4000
+
+// -bench clipmap: ClipmapUpdate cost per frame for a camera moving a fixed step every frame,
+// and for a teleport that refetches every level, against a 4097^2 CPU heightmap
+static void
+BenchClipmap()
+{
+    u32 hm_size = CLIPMAP_BENCH_HEIGHTMAP;
+    u64 heightmap_size = sizeof(r32) * hm_size * hm_size;
+    r32 *heightmap = (r32*)PlatformVirtualAlloc(heightmap_size);
+
+    terrain::Noise_CB cb = {};
+    cb.seed       = 3;
+    cb.scale      = 0.004f;
+    cb.octaves    = 6;
+    cb.lacunarity = 2.0f;
+    cb.decay      = 0.5f;
+    cb.threshold  = 0.0f;
+    cb.fractal    = terrain::Fractal_FBm;
+    terrain::GenerateHeightmap(terrain::Function_Perlin, &cb, heightmap, hm_size, hm_size);
+
+    terrain::ClipmapHeightmapSource source = { heightmap, hm_size, hm_size };
+
+    u32 sizes[] = { 129, 257, 513 };
+    r32 steps[] = { 0.25f, 1.0f, 4.0f }; // world units per frame, the level 0 spacing is 1
+    for (u32 i = 0; i < ARRAYCOUNT(sizes); ++i)
+    {
+        terrain::TerrainClipmapDesc desc = {};
+        desc.levels       = 8;
+        desc.size         = sizes[i];
+        desc.grid_spacing = 1.0f;
+        desc.source       = terrain::ClipmapSampleHeightmap;
+        desc.user         = &source;
+
+        terrain::TerrainClipmap clipmap;
+        terrain::ClipmapInit(&clipmap, &desc);
+
+        char label[64];
+        terrain::TerrainClipmapStats stats;
+        for (u32 j = 0; j < ARRAYCOUNT(steps); ++j)
+        {
+            v3 camera = { 2048.0f, 0.0f, 2048.0f };
+            terrain::ClipmapUpdate(&clipmap, camera, &stats);
+
+            u64 samples = 0;
+            Timer timer;
+            TimerBegin(&timer);
+            for (u32 frame = 0; frame < CLIPMAP_BENCH_FRAMES; ++frame)
+            {
+                camera.x += steps[j];
+                camera.z += steps[j] * 0.5f;
+                terrain::ClipmapUpdate(&clipmap, camera, &stats);
+                samples += stats.samples_fetched;
+            }
+            r64 ms = TimerMiliSecondsElapsed(&timer);
+
+            snprintf(label, sizeof(label), "%u^2, step %.2f", sizes[i], steps[j]);
+            BenchReport(label, ms, CLIPMAP_BENCH_FRAMES, "frames");
+            LogInfo("    %.2f us/frame, %.0f samples/frame", ms * 1000.0 / CLIPMAP_BENCH_FRAMES, (r64)samples / CLIPMAP_BENCH_FRAMES);
+        }
+
+        // Far enough that no level overlaps its previous position
+        u32 teleports = 50;
+        v3 camera = { 0.0f, 0.0f, 0.0f };
+        Timer timer;
+        TimerBegin(&timer);
+        for (u32 k = 0; k < teleports; ++k)
+        {
+            camera.x += (k & 1) ? -50000.0f : 50000.0f;
+            terrain::ClipmapUpdate(&clipmap, camera, &stats);
+        }
+        r64 ms = TimerMiliSecondsElapsed(&timer);
+        snprintf(label, sizeof(label), "%u^2, teleport", sizes[i]);
+        BenchReport(label, ms, teleports, "frames");
+
+        terrain::ClipmapFree(&clipmap);
+    }
+
+    PlatformVirtualFree(heightmap);
+}
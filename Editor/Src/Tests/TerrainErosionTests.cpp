@@ -0,0 +1,103 @@
+
+// Benchmarks of Terrain/TerrainErosion.h
+
+#define EROSION_BENCH_HEIGHTMAP 1024
+
+// FNV-1a of the height bits, to check that every thread count erodes the same heights
+static u64
+ErosionBenchChecksum(const r32 *heightmap, u64 count)
+{
+    u64 hash = 1469598103934665603ull;
+    for (u64 i = 0; i < count; ++i)
+    {
+        u32 bits;
+        memcpy(&bits, heightmap + i, sizeof(bits));
+        hash = (hash ^ bits) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// -bench erosion: hydraulic droplets per second and thermal iterations on a 1024^2 heightmap,
+// on 1 to N threads. Restarts the job system for every thread count.
+static void
+BenchErosion()
+{
+    u32 restore_workers = JobSystemGetThreadCount() - 1;
+
+    PosixProcessorInfo processor_info = {};
+    PosixGetProcessorInfo(&processor_info);
+    u32 max_threads = (processor_info.logical_processor_count > 4) ? processor_info.logical_processor_count : 4;
+
+    u32 size = EROSION_BENCH_HEIGHTMAP;
+    u64 samples = (u64)size * size;
+    r32 *base      = (r32*)PlatformVirtualAlloc(sizeof(r32) * samples);
+    r32 *heightmap = (r32*)PlatformVirtualAlloc(sizeof(r32) * samples);
+
+    terrain::Noise_CB cb = {};
+    cb.seed       = 7;
+    cb.scale      = 4.0f / size;
+    cb.octaves    = 6;
+    cb.lacunarity = 2.0f;
+    cb.decay      = 0.5f;
+    cb.threshold  = 0.0f;
+    cb.fractal    = terrain::Fractal_FBm;
+    terrain::GenerateHeightmap(terrain::Function_Perlin, &cb, base, size, size);
+
+    terrain::HydraulicErosionDesc hydraulic = {};
+    hydraulic.seed = 42;
+
+    // Steeper, so the talus matters
+    terrain::ThermalErosionDesc thermal = {};
+    thermal.talus = 0.08f;
+
+    u64 hydraulic_checksum = 0;
+    u64 thermal_checksum   = 0;
+    bool deterministic = true;
+    r64 hydraulic_single_ms = 0.0;
+    for (u32 thread_count = 1; thread_count <= max_threads; thread_count *= 2)
+    {
+        JobSystemFree();
+        JobSystemInit(thread_count - 1);
+
+        char label[64];
+        Timer timer;
+
+        memcpy(heightmap, base, sizeof(r32) * samples);
+        terrain::ErosionStats stats = {};
+        TimerBegin(&timer);
+        terrain::ErodeHydraulic(&hydraulic, heightmap, size, size, &stats);
+        r64 ms = TimerMiliSecondsElapsed(&timer);
+        if (thread_count == 1) hydraulic_single_ms = ms;
+
+        snprintf(label, sizeof(label), "hydraulic, %u threads", thread_count);
+        BenchReport(label, ms, (r64)stats.droplets, "droplets");
+        LogInfo("    %.2fx over 1 thread, %.2f droplets simulated per droplet (halos)",
+                hydraulic_single_ms / ms, (r64)stats.droplets_simulated / (r64)stats.droplets);
+
+        u64 checksum = ErosionBenchChecksum(heightmap, samples);
+        if (thread_count == 1) hydraulic_checksum = checksum;
+        deterministic &= (checksum == hydraulic_checksum);
+
+        memcpy(heightmap, base, sizeof(r32) * samples);
+        TimerBegin(&timer);
+        terrain::ErodeThermal(&thermal, heightmap, size, size);
+        ms = TimerMiliSecondsElapsed(&timer);
+
+        snprintf(label, sizeof(label), "thermal x%u, %u threads", thermal.iterations, thread_count);
+        BenchReport(label, ms, (r64)samples * thermal.iterations, "samples");
+
+        checksum = ErosionBenchChecksum(heightmap, samples);
+        if (thread_count == 1) thermal_checksum = checksum;
+        deterministic &= (checksum == thermal_checksum);
+    }
+
+    // The tiles are seeded from their position, so the thread count must not change the heights
+    if (deterministic) LogInfo("    same heights on every thread count");
+    else LogError("The eroded heights depend on the thread count!");
+
+    PlatformVirtualFree(heightmap);
+    PlatformVirtualFree(base);
+
+    JobSystemFree();
+    JobSystemInit(restore_workers);
+}
@@ -0,0 +1,194 @@
+
+// Self tests and benchmarks of Terrain/TerrainFile.h
+
+// Written to the working directory and removed afterwards
+#define TERRAIN_FILE_TEST_PATH "selftest.mterrain"
+
+static r32*
+TerrainFileTestHeightmap(u32 width, u32 height, u64 seed)
+{
+    r32 *heightmap = (r32*)PlatformVirtualAlloc(sizeof(r32) * width * height);
+
+    terrain::Noise_CB cb = {};
+    cb.seed       = seed;
+    cb.scale      = 0.004f;
+    cb.octaves    = 8;
+    cb.lacunarity = 2.0f;
+    cb.decay      = 0.5f;
+    cb.threshold  = 0.0f;
+    cb.fractal    = terrain::Fractal_FBm;
+    terrain::GenerateHeightmap(terrain::Function_Perlin, &cb, heightmap, width, height);
+
+    return heightmap;
+}
+
+static const char*
+TerrainFileEncodingName(terrain::TerrainTileEncoding encoding)
+{
+    return (encoding == terrain::TerrainTileEncoding_Quantized16) ? "quantized16" : "predicted16";
+}
+
+// Writes a heightmap that is not a multiple of the tile size, opens and validates the file,
+// then pages in every mip of every tile through a cache smaller than the file and compares
+// it to the heightmap. Both encodings quantize the same way, so they have to decode to the
+// same heights.
+static void
+TerrainFileTestRoundTrip()
+{
+    u32 width = 1000, height = 700, tile_size = 129;
+    r32 *heightmap = TerrainFileTestHeightmap(width, height, 5);
+
+    r32 *decoded = NULL; // Quantized16 heights of every tile mip, in page-in order
+    u64  decoded_count = 0;
+
+    terrain::TerrainTileEncoding encodings[] = { terrain::TerrainTileEncoding_Quantized16, terrain::TerrainTileEncoding_Predicted16 };
+    for (u32 e = 0; e < ARRAYCOUNT(encodings); ++e)
+    {
+        TestCheck(terrain::TerrainFileWrite(TERRAIN_FILE_TEST_PATH, heightmap, width, height, tile_size, encodings[e]));
+
+        terrain::TerrainFile file;
+        if (!TestCheck(terrain::TerrainFileOpen(&file, TERRAIN_FILE_TEST_PATH, 4))) continue;
+        TestCheck(terrain::TerrainFileValidate(&file, TERRAIN_FILE_TEST_PATH));
+
+        terrain::TerrainFileHeader *header = file.header;
+        u32 cells = tile_size - 1;
+        TestCheck(header->tiles_x == 8 && header->tiles_y == 6 && header->mip_count == 8);
+
+        if (!decoded)
+        {
+            for (u32 mip = 0; mip < header->mip_count; ++mip)
+            {
+                u32 side = terrain::TerrainFileMipSize(&file, mip);
+                decoded_count += (u64)side * side * header->tiles_x * header->tiles_y;
+            }
+            decoded = (r32*)SysAlloc(sizeof(r32) * decoded_count);
+        }
+
+        bool bounds_match = true;
+        bool heights_match = true;
+        bool encodings_match = true;
+        u64 index = 0;
+        for (u32 ty = 0; ty < header->tiles_y; ++ty)
+        {
+            for (u32 tx = 0; tx < header->tiles_x; ++tx)
+            {
+                terrain::TerrainFileTile *tile = file.tiles + ty * header->tiles_x + tx;
+
+                // Samples past the heightmap repeat its edge
+                r32 min_height = heightmap[ty * cells * width + tx * cells];
+                r32 max_height = min_height;
+                for (u32 y = 0; y <= cells; ++y)
+                {
+                    for (u32 x = 0; x <= cells; ++x)
+                    {
+                        r32 h = heightmap[fast_min(ty * cells + y, height - 1) * width + fast_min(tx * cells + x, width - 1)];
+                        if (h < min_height) min_height = h;
+                        if (h > max_height) max_height = h;
+                    }
+                }
+                if (tile->min_height != min_height || tile->max_height != max_height) bounds_match = false;
+
+                // Half a quantization step, and some room for the float math of the decode
+                r32 tolerance = 0.5f * (max_height - min_height) / 65535.0f + 1e-6f;
+                for (u32 mip = 0; mip < header->mip_count; ++mip)
+                {
+                    const r32 *heights = terrain::TerrainFileGetTile(&file, tx, ty, mip);
+                    u32 side = terrain::TerrainFileMipSize(&file, mip);
+                    for (u32 y = 0; y < side; ++y)
+                    {
+                        for (u32 x = 0; x < side; ++x)
+                        {
+                            u32 sx = fast_min(tx * cells + (x << mip), width - 1);
+                            u32 sy = fast_min(ty * cells + (y << mip), height - 1);
+                            r32 h  = heights[y * side + x];
+                            if (fabsf(h - heightmap[sy * width + sx]) > tolerance) heights_match = false;
+
+                            if (e == 0)                    decoded[index] = h;
+                            else if (decoded[index] != h)  encodings_match = false;
+                            ++index;
+                        }
+                    }
+                }
+            }
+        }
+        TestCheck(index == decoded_count);
+        TestCheck(bounds_match);
+        TestCheck(heights_match);
+        TestCheck(encodings_match);
+
+        LogInfo("    %s: %llu bytes", TerrainFileEncodingName(encodings[e]), (unsigned long long)file.mapping.size);
+        terrain::TerrainFileClose(&file);
+    }
+
+    remove(TERRAIN_FILE_TEST_PATH);
+    if (decoded) SysFree(decoded);
+    PlatformVirtualFree(heightmap);
+}
+
+// -selftest terrain_file
+static void
+TestTerrainFile()
+{
+    TerrainFileTestRoundTrip();
+}
+
+// -bench terrain_file: page-in latency of a 4097^2 heightmap in 257^2 tiles. Every tile mip
+// is paged in once through TerrainFileGetTile (map, decode, copy to the cache), then mip 0 is
+// streamed around the camera with TerrainFileStream, which decodes on the job system.
+static void
+BenchTerrainFile()
+{
+    u32 size = 4097, tile_size = 257;
+    r32 *heightmap = TerrainFileTestHeightmap(size, size, 9);
+
+    terrain::TerrainTileEncoding encodings[] = { terrain::TerrainTileEncoding_Quantized16, terrain::TerrainTileEncoding_Predicted16 };
+    for (u32 e = 0; e < ARRAYCOUNT(encodings); ++e)
+    {
+        terrain::TerrainFileWrite(TERRAIN_FILE_TEST_PATH, heightmap, size, size, tile_size, encodings[e]);
+
+        terrain::TerrainFile file;
+        terrain::TerrainFileOpen(&file, TERRAIN_FILE_TEST_PATH, 64);
+        terrain::TerrainFileHeader *header = file.header;
+        u32 tile_count = header->tiles_x * header->tiles_y;
+        const char *name = TerrainFileEncodingName(encodings[e]);
+        LogInfo("    %s: %.1f MB for %u tiles", name, file.mapping.size / (1024.0 * 1024.0), tile_count);
+
+        char label[64];
+        for (u32 mip = 0; mip < 3; ++mip)
+        {
+            Timer timer;
+            TimerBegin(&timer);
+            for (u32 tile = 0; tile < tile_count; ++tile)
+            {
+                terrain::TerrainFileGetTile(&file, tile % header->tiles_x, tile / header->tiles_x, mip);
+            }
+            r64 ms = TimerMiliSecondsElapsed(&timer);
+            snprintf(label, sizeof(label), "%s, mip %u page-in", name, mip);
+            BenchReport(label, ms, tile_count, "tiles");
+            LogInfo("    %.1f us/tile", ms * 1000.0 / tile_count);
+        }
+        terrain::TerrainFileClose(&file);
+
+        // A camera crossing the map, radius 2 keeps 25 tiles resident
+        terrain::TerrainFileOpen(&file, TERRAIN_FILE_TEST_PATH, 32);
+        u32 paged_in = 0;
+        Timer timer;
+        TimerBegin(&timer);
+        for (u32 step = 0; step <= 64; ++step)
+        {
+            r32 pos = (r32)step * (size - 1) / 64.0f;
+            terrain::TerrainFileStats stats;
+            terrain::TerrainFileStream(&file, pos, pos, 2, &stats);
+            paged_in += stats.tiles_paged_in;
+        }
+        r64 ms = TimerMiliSecondsElapsed(&timer);
+        snprintf(label, sizeof(label), "%s, stream", name);
+        BenchReport(label, ms, paged_in, "tiles");
+        terrain::TerrainFileClose(&file);
+    }
+
+    remove(TERRAIN_FILE_TEST_PATH);
+    PlatformVirtualFree(heightmap);
+}
+
+#undef TERRAIN_FILE_TEST_PATH
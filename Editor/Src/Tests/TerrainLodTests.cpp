@@ -0,0 +1,343 @@
+
+// Self tests and benchmarks of Terrain/TerrainLod.h
+
+//-----------------------------------------------------------------------------------------------//
+// Stitched tile meshes
+
+// Meshes a Standard tile with every stitch_edges combination and checks the index sets: the
+// triangles keep the mesh winding and cover the tile exactly once (twice the area of the
+// grid), and a stitched edge only uses the even vertices, the ones a neighbour with half
+// the resolution has too.
+static void
+LodTestStitchedMeshes()
+{
+    u32 sizes[] = { 3, 5, 9, 17, 33 };
+    for (u32 i = 0; i < ARRAYCOUNT(sizes); ++i)
+    {
+        u32 n = sizes[i];
+        u8 *used = (u8*)SysAlloc(n * n);
+
+        for (u32 edges = 0; edges <= terrain::Edge_All; ++edges)
+        {
+            terrain::TerrainMeshDesc desc = {};
+            desc.meshing_strategy = TerrainMeshType::Standard;
+            desc.width            = n;
+            desc.height           = n;
+            desc.tiling           = 1.0f;
+            desc.stitch_edges     = edges;
+
+            u32 max_vertices, max_indices;
+            terrain::GetMeshCapacity(&desc, &max_vertices, &max_indices);
+            terrain::TerrainMesh mesh = {};
+            mesh.indices = (u32*)SysAlloc(sizeof(u32) * max_indices);
+            terrain::BuildMesh(&desc, &mesh);
+
+            memset(used, 0, n * n);
+            i64 area = 0;
+            bool wound = true;
+            for (u32 t = 0; t + 2 < mesh.index_count; t += 3)
+            {
+                u32 a = mesh.indices[t], b = mesh.indices[t + 1], c = mesh.indices[t + 2];
+                i64 orient = terrain::GridOrient(a % n, a / n, b % n, b / n, c % n, c / n);
+                if (orient <= 0) wound = false;
+                area += orient;
+                used[a] = used[b] = used[c] = 1;
+            }
+            TestCheck(wound);
+            TestCheck(area == 2 * (i64)(n - 1) * (n - 1));
+
+            bool odd_unused = true;
+            bool border_used = true;
+            for (u32 k = 0; k < n; ++k)
+            {
+                bool odd = k & 1;
+                u32 border[4] = { k, (n - 1) * n + k, k * n, k * n + n - 1 };
+                u32 edge_bits[4] = { terrain::Edge_NegZ, terrain::Edge_PosZ, terrain::Edge_NegX, terrain::Edge_PosX };
+                for (u32 e = 0; e < 4; ++e)
+                {
+                    if ((edges & edge_bits[e]) && odd) odd_unused &= !used[border[e]];
+                    else                               border_used &= used[border[e]] != 0;
+                }
+            }
+            TestCheck(odd_unused);
+            TestCheck(border_used);
+
+            SysFree(mesh.indices);
+        }
+
+        SysFree(used);
+    }
+}
+
+//-----------------------------------------------------------------------------------------------//
+// Selection
+
+#define LOD_TEST_TILE      17
+#define LOD_TEST_LEVELS    5
+#define LOD_TEST_WORLD     1024.0f
+
+static terrain::TerrainLodView
+LodTestView(v3 position, v3 target, v3 up, r32 max_screen_error)
+{
+    terrain::TerrainLodView view = {};
+    view.position         = position;
+    view.proj_view        = m4_mul(m4_perspective(60.0f, 16.0f / 9.0f, 0.5f, 20000.0f), m4_look_at(position, target, up));
+    view.viewport_height  = 1080.0f;
+    view.fov              = 60.0f;
+    view.max_screen_error = max_screen_error;
+    return view;
+}
+
+// Checks what makes a selection crack free: the selected tiles do not overlap, neighbours
+// are at most one level apart, and a tile marks exactly the edges that meet a coarser tile.
+// Also checks the stats against the node list.
+static void
+LodCheckSelection(terrain::TerrainQuadtree *tree, terrain::TerrainLodNode *nodes, terrain::TerrainLodStats *stats)
+{
+    u32 count = (u32)arrlen(nodes);
+    TestCheck(stats->nodes_selected == count);
+
+    u64 triangles = 0;
+    for (u32 i = 0; i < count; ++i) triangles += tree->triangle_counts[nodes[i].stitch_edges];
+    TestCheck(stats->triangles == triangles);
+
+    // Owner of every full resolution tile
+    u32 res = 1u << (tree->levels - 1);
+    i32 *owner = (i32*)SysAlloc(sizeof(i32) * res * res);
+    for (u32 i = 0; i < res * res; ++i) owner[i] = -1;
+
+    bool overlap = false;
+    for (u32 i = 0; i < count; ++i)
+    {
+        u32 span = res >> nodes[i].level;
+        for (u32 y = nodes[i].y * span; y < (nodes[i].y + 1u) * span; ++y)
+        {
+            for (u32 x = nodes[i].x * span; x < (nodes[i].x + 1u) * span; ++x)
+            {
+                if (owner[y * res + x] >= 0) overlap = true;
+                owner[y * res + x] = (i32)i;
+            }
+        }
+    }
+    TestCheck(!overlap);
+
+    bool balanced = true;
+    bool stitched = true;
+    for (u32 y = 0; y < res; ++y)
+    {
+        for (u32 x = 0; x < res; ++x)
+        {
+            i32 a = owner[y * res + x];
+            if (a < 0) continue;
+
+            // Neighbour in +x, then in +z
+            for (u32 dir = 0; dir < 2; ++dir)
+            {
+                u32 nx = x + (dir == 0), ny = y + (dir == 1);
+                if (nx >= res || ny >= res) continue;
+                i32 b = owner[ny * res + nx];
+                if (b < 0 || b == a) continue;
+
+                u32 a_edge = (dir == 0) ? terrain::Edge_PosX : terrain::Edge_PosZ;
+                u32 b_edge = (dir == 0) ? terrain::Edge_NegX : terrain::Edge_NegZ;
+                i32 la = nodes[a].level, lb = nodes[b].level;
+                if (la - lb > 1 || lb - la > 1) balanced = false;
+
+                bool a_stitched = (nodes[a].stitch_edges & a_edge) != 0;
+                bool b_stitched = (nodes[b].stitch_edges & b_edge) != 0;
+                if (a_stitched != (la > lb) || b_stitched != (lb > la)) stitched = false;
+            }
+        }
+    }
+    TestCheck(balanced);
+    TestCheck(stitched);
+
+    SysFree(owner);
+}
+
+// Selection of a small quadtree from fixed cameras, where the result is known exactly or
+// bounded by the frustum
+static void
+LodTestSelection()
+{
+    u32 size = (LOD_TEST_TILE - 1) * (1 << (LOD_TEST_LEVELS - 1)) + 1;
+    r32 *heightmap = (r32*)SysAlloc(sizeof(r32) * size * size);
+
+    terrain::Noise_CB cb = {};
+    cb.seed       = 11;
+    cb.scale      = 0.01f;
+    cb.octaves    = 6;
+    cb.lacunarity = 2.0f;
+    cb.decay      = 0.5f;
+    cb.threshold  = 0.0f;
+    cb.fractal    = terrain::Fractal_FBm;
+    terrain::GenerateHeightmap(terrain::Function_Perlin, &cb, heightmap, size, size);
+
+    terrain::TerrainLodDesc desc = { heightmap, size, LOD_TEST_TILE, LOD_TEST_WORLD, 200.0f };
+    terrain::TerrainQuadtree tree;
+    TestCheck(terrain::QuadtreeInit(&tree, &desc));
+    TestCheck(tree.levels == LOD_TEST_LEVELS);
+
+    // The bounds of a tile are exactly the range of its samples
+    bool bounds_match = true;
+    u32  cells = LOD_TEST_TILE - 1;
+    r32  min_all = heightmap[0], max_all = heightmap[0];
+    for (u32 ty = 0; ty < (1u << (LOD_TEST_LEVELS - 1)); ++ty)
+    {
+        for (u32 tx = 0; tx < (1u << (LOD_TEST_LEVELS - 1)); ++tx)
+        {
+            r32 min_h = heightmap[ty * cells * size + tx * cells];
+            r32 max_h = min_h;
+            for (u32 y = ty * cells; y <= (ty + 1) * cells; ++y)
+            {
+                for (u32 x = tx * cells; x <= (tx + 1) * cells; ++x)
+                {
+                    r32 h = heightmap[y * size + x];
+                    if (h < min_h) min_h = h;
+                    if (h > max_h) max_h = h;
+                }
+            }
+            if (min_h < min_all) min_all = min_h;
+            if (max_h > max_all) max_all = max_h;
+
+            terrain::TerrainLodNode leaf = { LOD_TEST_LEVELS - 1, 0, (u16)tx, (u16)ty };
+            v3 min, max;
+            terrain::QuadtreeNodeBounds(&tree, &leaf, &min, &max);
+            if (min.y != min_h * desc.height_scale || max.y != max_h * desc.height_scale) bounds_match = false;
+        }
+    }
+    TestCheck(bounds_match);
+    TestCheck(tree.min_height[0] == min_all * desc.height_scale && tree.max_height[0] == max_all * desc.height_scale);
+    SysFree(heightmap);
+
+    terrain::TerrainLodNode  *nodes = NULL;
+    terrain::TerrainLodStats  stats;
+    r32 center = 0.5f * LOD_TEST_WORLD;
+    v3  above  = { center, 5000.0f, center };
+    v3  ground = { center, 0.0f, center };
+
+    // Looking down on the whole terrain with an unlimited error: only the root
+    terrain::TerrainLodView view = LodTestView(above, ground, { 0.0f, 0.0f, 1.0f }, 1e9f);
+    terrain::QuadtreeSelect(&tree, &view, &nodes, &stats);
+    TestCheck(arrlen(nodes) == 1 && nodes[0].level == 0 && nodes[0].stitch_edges == 0);
+    LodCheckSelection(&tree, nodes, &stats);
+
+    // No error allowed: every full resolution tile, none of them stitched
+    view = LodTestView(above, ground, { 0.0f, 0.0f, 1.0f }, 0.0f);
+    terrain::QuadtreeSelect(&tree, &view, &nodes, &stats);
+    u32 leaves = 1u << (2 * (LOD_TEST_LEVELS - 1));
+    u32 finest = 0;
+    for (u32 i = 0; i < (u32)arrlen(nodes); ++i) finest += (nodes[i].level == LOD_TEST_LEVELS - 1 && nodes[i].stitch_edges == 0);
+    TestCheck(arrlen(nodes) == leaves && finest == leaves);
+    LodCheckSelection(&tree, nodes, &stats);
+
+    // Looking away from the terrain: nothing
+    v3 outside = { -5000.0f, 100.0f, center };
+    view = LodTestView(outside, { -10000.0f, 100.0f, center }, { 0.0f, 1.0f, 0.0f }, 2.0f);
+    terrain::QuadtreeSelect(&tree, &view, &nodes, &stats);
+    TestCheck(arrlen(nodes) == 0 && stats.triangles == 0);
+
+    // Standing in the middle, looking along +x: nothing behind the camera is drawn, the tile
+    // under the camera is at full resolution and the tiles get coarser with distance
+    v3 eye = { center, 150.0f, center };
+    view = LodTestView(eye, { LOD_TEST_WORLD, 100.0f, center }, { 0.0f, 1.0f, 0.0f }, 8.0f);
+    terrain::QuadtreeSelect(&tree, &view, &nodes, &stats);
+    TestCheck(arrlen(nodes) > 1);
+    LodCheckSelection(&tree, nodes, &stats);
+
+    bool behind = false;
+    i32  under_level = -1;
+    i32  far_level   = LOD_TEST_LEVELS;
+    for (u32 i = 0; i < (u32)arrlen(nodes); ++i)
+    {
+        v3 min, max;
+        terrain::QuadtreeNodeBounds(&tree, nodes + i, &min, &max);
+        if (max.x < eye.x - 1.0f) behind = true;
+        if (min.x <= eye.x && eye.x <= max.x && min.z <= eye.z && eye.z <= max.z) under_level = nodes[i].level;
+        if (max.x >= LOD_TEST_WORLD && min.z <= eye.z && eye.z <= max.z && nodes[i].level < far_level) far_level = nodes[i].level;
+    }
+    TestCheck(!behind);
+    TestCheck(under_level == LOD_TEST_LEVELS - 1);
+    TestCheck(far_level < under_level);
+
+    arrfree(nodes);
+    terrain::QuadtreeFree(&tree);
+}
+
+// -selftest lod: stitched tile meshes and quadtree selection
+static void
+TestTerrainLod()
+{
+    LodTestStitchedMeshes();
+    LodTestSelection();
+}
+
+//-----------------------------------------------------------------------------------------------//
+// Selection cost
+
+#define LOD_BENCH_TILE  33
+#define LOD_BENCH_WORLD 4096.0f // 4 km on a side, 16 km^2
+#define LOD_BENCH_STEPS 200
+
+// -bench lod: a camera flying a loop over a 16 km^2 terrain, with the nodes visited, tiles
+// and triangles selected per frame
+static void
+BenchTerrainLod()
+{
+    u32 size = (LOD_BENCH_TILE - 1) * 128 + 1; // 8 levels, 1 m between samples
+    u64 heightmap_size = sizeof(r32) * size * size;
+    r32 *heightmap = (r32*)PlatformVirtualAlloc(heightmap_size);
+
+    terrain::Noise_CB cb = {};
+    cb.seed       = 534864359;
+    cb.scale      = 0.002f;
+    cb.octaves    = 8;
+    cb.lacunarity = 2.0f;
+    cb.decay      = 0.5f;
+    cb.threshold  = 0.0f;
+    cb.fractal    = terrain::Fractal_FBm;
+    terrain::GenerateHeightmap(terrain::Function_Perlin, &cb, heightmap, size, size);
+
+    terrain::TerrainLodDesc desc = { heightmap, size, LOD_BENCH_TILE, LOD_BENCH_WORLD, 600.0f };
+    terrain::TerrainQuadtree tree;
+    Timer timer;
+    TimerBegin(&timer);
+    terrain::QuadtreeInit(&tree, &desc);
+    LogInfo("    QuadtreeInit %.1f ms, %u levels, %u nodes", TimerMiliSecondsElapsed(&timer), tree.levels, tree.node_count);
+    PlatformVirtualFree(heightmap);
+
+    terrain::TerrainLodNode *nodes = NULL;
+    r32 max_errors[] = { 1.0f, 2.0f, 4.0f };
+    for (u32 i = 0; i < ARRAYCOUNT(max_errors); ++i)
+    {
+        u64 visited = 0, selected = 0, triangles = 0;
+        r64 ms = 0.0;
+        for (u32 step = 0; step < LOD_BENCH_STEPS; ++step)
+        {
+            r32 angle = MM_2PI * (r32)step / LOD_BENCH_STEPS;
+            r32 c = 0.5f * LOD_BENCH_WORLD;
+            v3 eye    = { c + 1200.0f * cosf(angle), 700.0f, c + 1200.0f * sinf(angle) };
+            v3 target = { c + 1200.0f * cosf(angle + 0.3f), 400.0f, c + 1200.0f * sinf(angle + 0.3f) };
+            terrain::TerrainLodView view = LodTestView(eye, target, { 0.0f, 1.0f, 0.0f }, max_errors[i]);
+
+            terrain::TerrainLodStats stats;
+            TimerBegin(&timer);
+            terrain::QuadtreeSelect(&tree, &view, &nodes, &stats);
+            ms += TimerMiliSecondsElapsed(&timer);
+
+            visited   += stats.nodes_visited;
+            selected  += stats.nodes_selected;
+            triangles += stats.triangles;
+        }
+
+        char label[64];
+        snprintf(label, sizeof(label), "select, %.0f px error", max_errors[i]);
+        BenchReport(label, ms, LOD_BENCH_STEPS, "frames");
+        LogInfo("    per frame: %.3f ms, %llu nodes visited, %llu tiles, %llu triangles", ms / LOD_BENCH_STEPS,
+                (unsigned long long)(visited / LOD_BENCH_STEPS), (unsigned long long)(selected / LOD_BENCH_STEPS),
+                (unsigned long long)(triangles / LOD_BENCH_STEPS));
+    }
+
+    arrfree(nodes);
+    terrain::QuadtreeFree(&tree);
+}
@@ -0,0 +1,65 @@
+
+// Benchmarks of Terrain/TerrainMesher.h
+
+#define MESH_BENCH_GRID         64  // tiles on a side
+#define MESH_BENCH_TILE         256 // vertices on a side of a tile
+#define MESH_BENCH_SAMPLE_TILES 64  // tiles meshed one by one, the full grid takes too long
+
+// -bench tiles: meshing a 64x64 grid of 256^2 tiles without the GPU, the way Terrain::Generate
+// did it (every tile meshed into its own allocation) and the way it does now (one mesh that
+// every tile shares, rows split across the job system).
+static void
+BenchTileMeshing()
+{
+    u32 tile_count = MESH_BENCH_GRID * MESH_BENCH_GRID;
+
+    const char *names[] = { "standard", "triangle strip" };
+    TerrainMeshType types[] = { TerrainMeshType::Standard, TerrainMeshType::TriangleStrip };
+    for (u32 i = 0; i < ARRAYCOUNT(types); ++i)
+    {
+        terrain::TerrainMeshDesc desc = {};
+        desc.meshing_strategy = types[i];
+        desc.width            = MESH_BENCH_TILE;
+        desc.height           = MESH_BENCH_TILE;
+        desc.tiling           = 1.0f;
+        desc.vertex_format    = TerrainVertexFormat::Full;
+
+        u32 max_vertices, max_indices;
+        terrain::GetMeshCapacity(&desc, &max_vertices, &max_indices);
+        u64 vertices_size = (u64)terrain::GetVertexSize(desc.vertex_format) * max_vertices;
+        u64 indices_size  = sizeof(u32) * max_indices;
+
+        char label[64];
+        Timer timer;
+        TimerBegin(&timer);
+        for (u32 tile = 0; tile < MESH_BENCH_SAMPLE_TILES; ++tile)
+        {
+            terrain::TerrainMesh mesh = {};
+            mesh.vertices = PlatformVirtualAlloc(vertices_size);
+            mesh.indices  = (u32*)PlatformVirtualAlloc(indices_size);
+            terrain::BuildMesh(&desc, &mesh);
+            PlatformVirtualFree(mesh.indices);
+            PlatformVirtualFree(mesh.vertices);
+        }
+        r64 ms = TimerMiliSecondsElapsed(&timer);
+        snprintf(label, sizeof(label), "%s, mesh per tile", names[i]);
+        BenchReport(label, ms, MESH_BENCH_SAMPLE_TILES, "tiles");
+        LogInfo("    %.1f ms for the %ux%u grid", ms * tile_count / MESH_BENCH_SAMPLE_TILES, MESH_BENCH_GRID, MESH_BENCH_GRID);
+
+        // The shared mesh is built once for the whole grid, the tiles only point at it
+        TimerBegin(&timer);
+        terrain::TerrainMesh mesh = {};
+        mesh.vertices = SysAlloc(vertices_size);
+        mesh.indices  = (u32*)SysAlloc(indices_size);
+        terrain::BuildMesh(&desc, &mesh);
+        terrain::TerrainMesh *tiles = (terrain::TerrainMesh*)SysAlloc(sizeof(terrain::TerrainMesh) * tile_count);
+        for (u32 tile = 0; tile < tile_count; ++tile) tiles[tile] = mesh;
+        ms = TimerMiliSecondsElapsed(&timer);
+        snprintf(label, sizeof(label), "%s, shared mesh", names[i]);
+        BenchReport(label, ms, tile_count, "tiles");
+
+        SysFree(tiles);
+        SysFree(mesh.indices);
+        SysFree(mesh.vertices);
+    }
+}
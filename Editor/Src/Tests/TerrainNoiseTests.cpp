@@ -0,0 +1,487 @@
+
+// Self tests and benchmarks of Terrain/TerrainNoise.h
+
+#define NOISE_BENCH_SIZE 2048
+
+#if defined(__AVX2__)
+#define NOISE_BENCH_LANES "AVX2, 8 lanes"
+#elif defined(__SSE4_1__) || defined(__AVX__)
+#define NOISE_BENCH_LANES "SSE4.1, 4 lanes"
+#elif defined(__SSE2__) || defined(_M_X64)
+#define NOISE_BENCH_LANES "SSE2, 4 lanes"
+#else
+#define NOISE_BENCH_LANES "scalar"
+#endif
+
+static terrain::Noise_CB
+NoiseBenchParams(u32 octaves)
+{
+    terrain::Noise_CB cb = {};
+    cb.seed       = 7;
+    cb.scale      = 0.01f;
+    cb.octaves    = (i32)octaves;
+    cb.lacunarity = 2.0f;
+    cb.decay      = 0.5f;
+    cb.threshold  = 0.0f;
+    cb.fractal    = terrain::Fractal_FBm;
+    return cb;
+}
+
+// @returns the best of "runs" timings of one heightmap, in ms
+static r64
+NoiseBenchHeightmap(terrain::ComputeFunction fn, terrain::Noise_CB *cb, r32 *heightmap, u32 size, u32 runs)
+{
+    r64 best = 0.0;
+    for (u32 i = 0; i < runs; ++i)
+    {
+        Timer timer;
+        TimerBegin(&timer);
+        terrain::GenerateHeightmap(fn, cb, heightmap, size, size);
+        r64 ms = TimerMiliSecondsElapsed(&timer);
+        if (i == 0 || ms < best) best = ms;
+    }
+    return best;
+}
+
+// -bench noise: the CPU versions of the PerlinNoise and SimplexNoise kernels on a 2048^2
+// heightmap, on the calling thread alone and across the job system. The lane width is
+// picked at compile time: CXX="g++ -mavx2" ./build_headless.sh release to compare AVX2 to SSE.
+static void
+BenchNoise()
+{
+    LogInfo("    %s, %d job threads", NOISE_BENCH_LANES, JobSystemGetThreadCount());
+
+    u32 size = NOISE_BENCH_SIZE;
+    r32 *heightmap = (r32*)SysAlloc(sizeof(r32) * size * size);
+    u32 restore_workers = JobSystemGetThreadCount() - 1;
+
+    const char *names[] = { "perlin", "simplex" };
+    terrain::ComputeFunction fns[] = { terrain::Function_Perlin, terrain::Function_Simplex };
+    u32 octave_counts[] = { 1, 6 };
+
+    for (u32 threaded = 0; threaded < 2; ++threaded)
+    {
+        JobSystemFree();
+        JobSystemInit(threaded ? restore_workers : 0);
+
+        for (u32 i = 0; i < ARRAYCOUNT(fns); ++i)
+        {
+            for (u32 j = 0; j < ARRAYCOUNT(octave_counts); ++j)
+            {
+                terrain::Noise_CB cb = NoiseBenchParams(octave_counts[j]);
+                r64 ms = NoiseBenchHeightmap(fns[i], &cb, heightmap, size, 3);
+
+                char label[64];
+                snprintf(label, sizeof(label), "%s, %u oct, %u threads", names[i], octave_counts[j], JobSystemGetThreadCount());
+                BenchReport(label, ms, (r64)size * size / 1e6, "Msamples");
+            }
+        }
+    }
+
+    SysFree(heightmap);
+}
+
+// Generation time of one ComputeFunction on a 1024^2 heightmap with each fractal type, so
+// large worlds can be budgeted per function
+static void
+NoiseBenchFunction(terrain::ComputeFunction fn)
+{
+    u32 size = NOISE_BENCH_SIZE / 2;
+    r32 *heightmap = (r32*)SysAlloc(sizeof(r32) * size * size);
+
+    const char *fractal_names[] = { "fbm", "ridged", "turbulence" };
+    for (i32 fractal = 0; fractal < terrain::Fractal_Count; ++fractal)
+    {
+        terrain::Noise_CB cb = NoiseBenchParams(4);
+        cb.fractal = fractal;
+        r64 ms = NoiseBenchHeightmap(fn, &cb, heightmap, size, 3);
+
+        char label[64];
+        snprintf(label, sizeof(label), "%s, 4 oct", fractal_names[fractal]);
+        BenchReport(label, ms, (r64)size * size / 1e6, "Msamples");
+    }
+
+    SysFree(heightmap);
+}
+
+// -bench noise_<function>
+static void BenchNoiseChecker()     { NoiseBenchFunction(terrain::Function_Checker);     }
+static void BenchNoiseDiscrete()    { NoiseBenchFunction(terrain::Function_Discrete);    }
+static void BenchNoiseLinearValue() { NoiseBenchFunction(terrain::Function_LinearValue); }
+static void BenchNoiseFadedValue()  { NoiseBenchFunction(terrain::Function_FadedValue);  }
+static void BenchNoiseCubicValue()  { NoiseBenchFunction(terrain::Function_CubicValue);  }
+static void BenchNoisePerlin()      { NoiseBenchFunction(terrain::Function_Perlin);      }
+static void BenchNoiseSimplex()     { NoiseBenchFunction(terrain::Function_Simplex);     }
+static void BenchNoiseWorley()      { NoiseBenchFunction(terrain::Function_Worley);      }
+static void BenchNoiseSpots()       { NoiseBenchFunction(terrain::Function_Spots);       }
+
+//-------------------------------------------------------------------------------------------------
+// Lattice hash determinism. The reference is NoiseCommon.hlsl itself, compiled as C++, and
+// every lane backend of TerrainNoise.cpp has to return the same bits.
+
+#define NOISE_HASH_TEST_BATCH 16 // lattice points hashed per key, a multiple of every lane width
+#define NOISE_HASH_BENCH_SIZE 4096
+
+// Just enough HLSL for NoiseCommon.hlsl
+namespace noise_hlsl
+{
+    typedef u32 uint;
+
+    struct uint2
+    {
+        u32 x, y;
+        uint2(u32 x_, u32 y_) : x(x_), y(y_) {}
+    };
+
+    struct float3
+    {
+        r32 x, y, z;
+        float3(r32 x_, r32 y_, r32 z_) : x(x_), y(y_), z(z_) {}
+    };
+
+    FORCE_INLINE r32 saturate(r32 v) { return (v < 0.0f) ? 0.0f : ((v > 1.0f) ? 1.0f : v); }
+
+#include "data/shaders/NoiseFunctions/NoiseCommon.hlsl"
+
+}; // noise_hlsl
+
+#undef EPSILON
+#undef NOISE_PRIME_5
+#undef NOISE_PRIME_4
+#undef NOISE_PRIME_3
+#undef NOISE_PRIME_2
+#undef NOISE_PRIME_1
+
+// The lattice hashes of NOISE_HASH_TEST_BATCH points under one key, the way the kernels call
+// them: the x round once per column, shared by the 2D and 3D hashes
+#define NOISE_HASH_TEST_BATCH_FN                                                                   \
+    static void                                                                                    \
+    NoiseHashBatch(u32 key_lo, u32 key_hi, const u32 *x, const u32 *y, const u32 *z,              \
+                   u32 *hash2, u32 *hash3)                                                         \
+    {                                                                                              \
+        NoiseKey key = { key_lo, key_hi };                                                         \
+        for (u32 i = 0; i < NOISE_HASH_TEST_BATCH; i += NOISE_LANES)                               \
+        {                                                                                          \
+            lane_u32 lx, ly, lz;                                                                   \
+            memcpy(&lx, x + i, sizeof(lx));                                                        \
+            memcpy(&ly, y + i, sizeof(ly));                                                        \
+            memcpy(&lz, z + i, sizeof(lz));                                                        \
+            lane_u32 column = LaneHashColumn(lx, key);                                             \
+            lane_u32 h2 = LaneHashColumnCell(column, ly, key);                                     \
+            lane_u32 h3 = LaneHashLattice3(column, ly, lz, key);                                   \
+            memcpy(hash2 + i, &h2, sizeof(h2));                                                    \
+            memcpy(hash3 + i, &h3, sizeof(h3));                                                    \
+        }                                                                                          \
+    }                                                                                              \
+                                                                                                   \
+    /* XOR of the 2D hashes of a row of lattice points, for the speed comparison */                \
+    static u32                                                                                     \
+    NoiseHashRow(u32 key_lo, u32 key_hi, u32 y, u32 width)                                         \
+    {                                                                                              \
+        NoiseKey key = { key_lo, key_hi };                                                         \
+        lane_u32 ly   = LaneSetU(y);                                                               \
+        lane_u32 lx   = LaneIndex();                                                               \
+        lane_u32 step = LaneSetU(NOISE_LANES);                                                     \
+        lane_u32 sum  = LaneSetU(0);                                                               \
+        for (u32 x = 0; x < width; x += NOISE_LANES)                                               \
+        {                                                                                          \
+            sum = LaneXorU(sum, LaneHashColumnCell(LaneHashColumn(lx, key), ly, key));             \
+            lx  = LaneAddU(lx, step);                                                              \
+        }                                                                                          \
+        u32 lanes[NOISE_LANES];                                                                    \
+        memcpy(lanes, &sum, sizeof(sum));                                                          \
+        u32 result = 0;                                                                            \
+        for (u32 i = 0; i < NOISE_LANES; ++i) result ^= lanes[i];                                  \
+        return result;                                                                             \
+    }
+
+// Each backend in its own namespace. SSE4.1 and AVX2 are compiled with a target pragma and
+// only run when the CPU supports them, so they are tested whatever the build targets.
+#if defined(__GNUC__) && !defined(__clang__) && (defined(__x86_64__) || defined(__i386__))
+#define NOISE_HASH_TEST_ALL_BACKENDS
+#include <immintrin.h>
+#endif
+
+namespace noise_lanes_scalar
+{
+#define NOISE_LANES 1
+#include "Terrain/TerrainNoiseLanes.h"
+    NOISE_HASH_TEST_BATCH_FN
+#undef NOISE_LANES
+}; // noise_lanes_scalar
+
+#if defined(__SSE2__) || defined(_M_X64)
+namespace noise_lanes_sse2
+{
+#define NOISE_LANES 4
+#include "Terrain/TerrainNoiseLanes.h"
+    NOISE_HASH_TEST_BATCH_FN
+#undef NOISE_LANES
+}; // noise_lanes_sse2
+#endif
+
+#if defined(NOISE_HASH_TEST_ALL_BACKENDS)
+#pragma GCC push_options
+#pragma GCC target("sse4.1")
+namespace noise_lanes_sse4_1
+{
+#define NOISE_LANES 4
+#define NOISE_SSE4_1
+#include "Terrain/TerrainNoiseLanes.h"
+    NOISE_HASH_TEST_BATCH_FN
+#undef NOISE_SSE4_1
+#undef NOISE_LANES
+}; // noise_lanes_sse4_1
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+namespace noise_lanes_avx2
+{
+#define NOISE_LANES 8
+#include "Terrain/TerrainNoiseLanes.h"
+    NOISE_HASH_TEST_BATCH_FN
+#undef NOISE_LANES
+}; // noise_lanes_avx2
+#pragma GCC pop_options
+#endif
+
+#undef NOISE_PRIME_5
+#undef NOISE_PRIME_4
+#undef NOISE_PRIME_3
+#undef NOISE_PRIME_2
+#undef NOISE_PRIME_1
+
+typedef void (*PFN_NoiseHashBatch)(u32 key_lo, u32 key_hi, const u32 *x, const u32 *y, const u32 *z,
+                                   u32 *hash2, u32 *hash3);
+typedef u32  (*PFN_NoiseHashRow)(u32 key_lo, u32 key_hi, u32 y, u32 width);
+
+struct NoiseHashBackend
+{
+    const char         *name;
+    bool                supported;
+    PFN_NoiseHashBatch  batch;
+    PFN_NoiseHashRow    row;
+};
+
+// @returns the backends the CPU can run
+static u32
+NoiseHashBackends(NoiseHashBackend *backends)
+{
+    u32 count = 0;
+    backends[count++] = { "scalar", true, noise_lanes_scalar::NoiseHashBatch, noise_lanes_scalar::NoiseHashRow };
+#if defined(__SSE2__) || defined(_M_X64)
+    backends[count++] = { "SSE2", true, noise_lanes_sse2::NoiseHashBatch, noise_lanes_sse2::NoiseHashRow };
+#endif
+#if defined(NOISE_HASH_TEST_ALL_BACKENDS)
+    __builtin_cpu_init();
+    backends[count++] = { "SSE4.1", (bool)__builtin_cpu_supports("sse4.1"),
+                          noise_lanes_sse4_1::NoiseHashBatch, noise_lanes_sse4_1::NoiseHashRow };
+    backends[count++] = { "AVX2", (bool)__builtin_cpu_supports("avx2"),
+                          noise_lanes_avx2::NoiseHashBatch, noise_lanes_avx2::NoiseHashRow };
+#endif
+    return count;
+}
+
+// A lattice point and its hashes, from NoiseCommon.hlsl
+struct NoiseHashVector
+{
+    u64 seed;
+    i32 octave;
+    i32 x, y, z;
+    u32 hash2; // hashLattice2(x, y, octaveKey(seed, octave))
+    u32 hash3; // hashLattice3(x, y, z, octaveKey(seed, octave))
+};
+
+// Generated from NoiseCommon.hlsl. A change here changes every terrain made with the CPU or
+// GPU noise, so only update the table on purpose.
+file_global NoiseHashVector g_noise_hash_vectors[] = {
+    { 0x0000000000000000ull,  0,           0,           0,       0, 0x55DE5FE5u, 0xAE7D8BC2u },
+    { 0x0000000000000000ull,  0,           1,           0,       0, 0xE189B1C1u, 0xB299DBA5u },
+    { 0x0000000000000000ull,  0,           0,           1,       0, 0x785183F1u, 0x41BCC6D5u },
+    { 0x0000000000000000ull,  0,           0,           0,       1, 0x55DE5FE5u, 0xB1DFB9C2u },
+    { 0x0000000000000007ull,  0,          -1,          -1,      -1, 0x49D4F00Au, 0x4C80435Eu },
+    { 0x0000000000000007ull,  1,          12,          34,       0, 0xE5FCDEE8u, 0x13C478C3u },
+    { 0x0000000000000007ull,  5,        -123,         456,       7, 0x30027A4Bu, 0x087EACF3u },
+    { 0x0000000000000008ull,  0,          12,          34,       0, 0x8C0F302Du, 0x5BC72202u },
+    { 0x0000000100000000ull,  0,           3,           5,       0, 0xBC5D7BA3u, 0xF40B285Au },
+    { 0x0000000100000000ull,  3,          -3,          -5,       2, 0x582CC8A9u, 0xCA927E9Fu },
+    { 0x8000000000000000ull,  0,      100000,     -100000,       9, 0x91E50C49u, 0xE739A8D6u },
+    { 0x0123456789ABCDEFull,  2,    50000000,      123456,     -77, 0xB2788E23u, 0xA3D58F6Cu },
+    { 0x0123456789ABCDEFull,  7, -I32_MAX - 1,     I32_MAX,       0, 0x42599ACEu, 0x186223B1u },
+    { 0xFFFFFFFFFFFFFFFFull,  0,         255,         256,     257, 0x4351E074u, 0xB9633349u },
+    { 0xFFFFFFFFFFFFFFFFull,  9,        -256,       65536,  -65536, 0x003B571Du, 0xED73DED1u },
+    { 0x000000000000002Aull, 11,        1723,       93241,  149812, 0xC82833EBu, 0xDA9CD965u },
+};
+
+// Hashes a batch with every backend and compares them to NoiseCommon.hlsl
+// @returns the number of mismatching hashes per backend, in mismatches
+static void
+NoiseHashCheckBatch(NoiseHashBackend *backends, u32 backend_count, u64 seed, i32 octave,
+                    const u32 *x, const u32 *y, const u32 *z, u32 *mismatches)
+{
+    noise_hlsl::uint2 key = noise_hlsl::octaveKey(noise_hlsl::uint2((u32)seed, (u32)(seed >> 32)), octave);
+
+    u32 expected2[NOISE_HASH_TEST_BATCH];
+    u32 expected3[NOISE_HASH_TEST_BATCH];
+    for (u32 i = 0; i < NOISE_HASH_TEST_BATCH; ++i)
+    {
+        expected2[i] = noise_hlsl::hashLattice2((i32)x[i], (i32)y[i], key);
+        expected3[i] = noise_hlsl::hashLattice3((i32)x[i], (i32)y[i], (i32)z[i], key);
+    }
+
+    for (u32 b = 0; b < backend_count; ++b)
+    {
+        if (!backends[b].supported) continue;
+
+        u32 hash2[NOISE_HASH_TEST_BATCH];
+        u32 hash3[NOISE_HASH_TEST_BATCH];
+        backends[b].batch(key.x, key.y, x, y, z, hash2, hash3);
+        for (u32 i = 0; i < NOISE_HASH_TEST_BATCH; ++i)
+        {
+            mismatches[b] += (hash2[i] != expected2[i]) + (hash3[i] != expected3[i]);
+        }
+    }
+}
+
+// -selftest noise_hash: the lattice hashes against fixed vectors, through NoiseCommon.hlsl
+// compiled as C++, the octave keys of TerrainNoise.cpp, and every lane backend
+static void
+TestNoiseHash()
+{
+    NoiseHashBackend backends[4];
+    u32 backend_count = NoiseHashBackends(backends);
+    u32 mismatches[ARRAYCOUNT(backends)] = {};
+
+    for (u32 i = 0; i < ARRAYCOUNT(g_noise_hash_vectors); ++i)
+    {
+        NoiseHashVector *v = g_noise_hash_vectors + i;
+
+        noise_hlsl::uint2 key = noise_hlsl::octaveKey(noise_hlsl::uint2((u32)v->seed, (u32)(v->seed >> 32)), v->octave);
+        TestCheck(noise_hlsl::hashLattice2(v->x, v->y, key) == v->hash2);
+        TestCheck(noise_hlsl::hashLattice3(v->x, v->y, v->z, key) == v->hash3);
+
+        terrain::NoiseKey cpu_key = terrain::NoiseOctaveKey(v->seed, v->octave);
+        TestCheck(cpu_key.lo == key.x && cpu_key.hi == key.y);
+
+        // The vector sits in a different lane for each entry, its neighbours fill the others
+        u32 x[NOISE_HASH_TEST_BATCH], y[NOISE_HASH_TEST_BATCH], z[NOISE_HASH_TEST_BATCH];
+        u32 lane = i % NOISE_HASH_TEST_BATCH;
+        for (u32 j = 0; j < NOISE_HASH_TEST_BATCH; ++j)
+        {
+            x[j] = (u32)v->x + (j - lane);
+            y[j] = (u32)v->y + (j - lane) * 7919u;
+            z[j] = (u32)v->z - (j - lane) * 104729u;
+        }
+        NoiseHashCheckBatch(backends, backend_count, v->seed, v->octave, x, y, z, mismatches);
+    }
+
+    // Random keys and lattice points over the whole 32-bit range
+    TestRng rng = TestRngInit(19);
+    for (u32 i = 0; i < 4096; ++i)
+    {
+        u64 seed = ((u64)TestRandom(&rng) << 32) | TestRandom(&rng);
+        i32 octave = (i32)TestRandomRange(&rng, 16);
+
+        u32 x[NOISE_HASH_TEST_BATCH], y[NOISE_HASH_TEST_BATCH], z[NOISE_HASH_TEST_BATCH];
+        for (u32 j = 0; j < NOISE_HASH_TEST_BATCH; ++j)
+        {
+            x[j] = TestRandom(&rng);
+            y[j] = TestRandom(&rng);
+            z[j] = TestRandom(&rng);
+        }
+        NoiseHashCheckBatch(backends, backend_count, seed, octave, x, y, z, mismatches);
+    }
+
+    for (u32 b = 0; b < backend_count; ++b)
+    {
+        if (backends[b].supported)
+        {
+            LogInfo("    %-8s %u mismatches", backends[b].name, mismatches[b]);
+            TestCheck(mismatches[b] == 0);
+        }
+        else
+        {
+            LogInfo("    %-8s not supported by this CPU, skipped", backends[b].name);
+        }
+    }
+}
+
+file_global volatile u32 g_noise_hash_sink;
+
+// -bench noise_hash: the lattice hash against the 256 entry permutation table it replaced,
+// per 2D lattice point over a 4096^2 grid
+static void
+BenchNoiseHash()
+{
+    u32 size = NOISE_HASH_BENCH_SIZE;
+    r64 points = (r64)size * size;
+    char label[64];
+    Timer timer;
+
+    // Ken Perlin's table, doubled so perm[perm[x] + y] needs no second wrap
+    u8 perm[512];
+    TestRng rng = TestRngInit(19);
+    u32 reseeds = 100000;
+    TimerBegin(&timer);
+    for (u32 r = 0; r < reseeds; ++r)
+    {
+        for (u32 i = 0; i < 256; ++i) perm[i] = (u8)i;
+        for (u32 i = 255; i > 0; --i)
+        {
+            u32 j = TestRandomRange(&rng, i + 1);
+            u8 tmp = perm[i];
+            perm[i] = perm[j];
+            perm[j] = tmp;
+        }
+        memcpy(perm + 256, perm, 256);
+    }
+    r64 reseed_ms = TimerMiliSecondsElapsed(&timer);
+
+    TimerBegin(&timer);
+    u32 sum = 0;
+    for (u32 y = 0; y < size; ++y)
+    {
+        for (u32 x = 0; x < size; ++x) sum ^= perm[perm[x & 255] + (y & 255)];
+    }
+    r64 ms = TimerMiliSecondsElapsed(&timer);
+    g_noise_hash_sink = sum;
+    BenchReport("permutation table", ms, points / 1e6, "Mpoints");
+    LogInfo("    %.2f ns/point, %.0f ns to reseed the table, repeats every 256 cells",
+            ms * 1e6 / points, reseed_ms * 1e6 / reseeds);
+
+    noise_hlsl::uint2 key = noise_hlsl::octaveKey(noise_hlsl::uint2(7, 0), 0);
+    TimerBegin(&timer);
+    sum = 0;
+    for (u32 y = 0; y < size; ++y)
+    {
+        for (u32 x = 0; x < size; ++x) sum ^= noise_hlsl::hashLattice2((i32)x, (i32)y, key);
+    }
+    ms = TimerMiliSecondsElapsed(&timer);
+    g_noise_hash_sink = sum;
+    BenchReport("hashLattice2, HLSL as C++", ms, points / 1e6, "Mpoints");
+    LogInfo("    %.2f ns/point", ms * 1e6 / points);
+
+    NoiseHashBackend backends[4];
+    u32 backend_count = NoiseHashBackends(backends);
+    for (u32 b = 0; b < backend_count; ++b)
+    {
+        if (!backends[b].supported) continue;
+
+        TimerBegin(&timer);
+        sum = 0;
+        for (u32 y = 0; y < size; ++y) sum ^= backends[b].row(key.x, key.y, y, size);
+        ms = TimerMiliSecondsElapsed(&timer);
+        g_noise_hash_sink = sum;
+
+        snprintf(label, sizeof(label), "hashLattice2, %s lanes", backends[b].name);
+        BenchReport(label, ms, points / 1e6, "Mpoints");
+        LogInfo("    %.2f ns/point", ms * 1e6 / points);
+    }
+}
+
+#undef NOISE_HASH_BENCH_SIZE
+#undef NOISE_HASH_TEST_BATCH_FN
+#undef NOISE_HASH_TEST_BATCH
+#undef NOISE_HASH_TEST_ALL_BACKENDS
+#undef NOISE_BENCH_LANES
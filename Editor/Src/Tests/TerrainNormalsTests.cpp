@@ -0,0 +1,104 @@
+
+// Benchmarks of Terrain/TerrainNormals.h
+
+#define NORMALS_BENCH_HEIGHTMAP 4097
+#define NORMALS_BENCH_RUNS      3
+
+// -bench normals: bakes the normals of a 4097^2 heightmap with each kernel. The baseline
+// calls SampleNormal for every sample on one thread, then the SSE2 rows are timed on one
+// thread and on the job system, with tangents and with octahedral encoding.
+static void
+BenchTerrainNormals()
+{
+    u32 size = NORMALS_BENCH_HEIGHTMAP;
+    u64 samples = (u64)size * size;
+    r32 *heightmap = (r32*)PlatformVirtualAlloc(sizeof(r32) * samples);
+    v3  *normals   = (v3*)PlatformVirtualAlloc(sizeof(v3) * samples);
+    v3  *reference = (v3*)PlatformVirtualAlloc(sizeof(v3) * samples);
+    v4  *tangents  = (v4*)PlatformVirtualAlloc(sizeof(v4) * samples);
+    u32 *encoded   = (u32*)PlatformVirtualAlloc(sizeof(u32) * samples);
+
+    terrain::Noise_CB cb = {};
+    cb.seed       = 3;
+    cb.scale      = 0.002f;
+    cb.octaves    = 10;
+    cb.lacunarity = 2.0f;
+    cb.decay      = 0.5f;
+    cb.threshold  = 0.0f;
+    cb.fractal    = terrain::Fractal_FBm;
+    terrain::GenerateHeightmap(terrain::Function_Perlin, &cb, heightmap, size, size);
+
+    LogInfo("    %ux%u heightmap, %u threads, best of %u runs", size, size, JobSystemGetThreadCount(), NORMALS_BENCH_RUNS);
+
+    const char *kernel_names[] = { "central", "sobel" };
+    for (u32 k = 0; k < ARRAYCOUNT(kernel_names); ++k)
+    {
+        terrain::TerrainNormalDesc desc = {};
+        desc.heightmap    = heightmap;
+        desc.width        = size;
+        desc.height       = size;
+        desc.spacing_x    = 1.0f;
+        desc.spacing_z    = 1.0f;
+        desc.height_scale = 800.0f;
+        desc.kernel       = (terrain::NormalKernel)k;
+
+        r64 best[5] = {};
+        r64 ms;
+        for (u32 run = 0; run < NORMALS_BENCH_RUNS; ++run)
+        {
+            Timer timer;
+            TimerBegin(&timer);
+            for (u32 y = 0; y < size; ++y)
+            {
+                for (u32 x = 0; x < size; ++x) reference[(u64)y * size + x] = terrain::SampleNormal(&desc, x, y);
+            }
+            ms = TimerMiliSecondsElapsed(&timer);
+            if (run == 0 || ms < best[0]) best[0] = ms;
+
+            TimerBegin(&timer);
+            terrain::BakeNormalRows(&desc, 0, size, normals, sizeof(v3), NULL, 0);
+            ms = TimerMiliSecondsElapsed(&timer);
+            if (run == 0 || ms < best[1]) best[1] = ms;
+
+            TimerBegin(&timer);
+            terrain::BakeNormals(&desc, normals);
+            ms = TimerMiliSecondsElapsed(&timer);
+            if (run == 0 || ms < best[2]) best[2] = ms;
+
+            TimerBegin(&timer);
+            terrain::BakeNormals(&desc, normals, tangents);
+            ms = TimerMiliSecondsElapsed(&timer);
+            if (run == 0 || ms < best[3]) best[3] = ms;
+
+            TimerBegin(&timer);
+            terrain::BakeNormalsOct(&desc, encoded);
+            ms = TimerMiliSecondsElapsed(&timer);
+            if (run == 0 || ms < best[4]) best[4] = ms;
+        }
+
+        // The baked rows have to agree with the per sample path they replace
+        r32 max_error = 0.0f;
+        r32 max_oct_error = 0.0f;
+        for (u64 i = 0; i < samples; ++i)
+        {
+            max_error     = fast_maxf(max_error, v3_mag(v3_sub(normals[i], reference[i])));
+            max_oct_error = fast_maxf(max_oct_error, v3_mag(v3_sub(terrain::OctDecodeNormal(encoded[i]), reference[i])));
+        }
+
+        const char *pass_names[] = { "SampleNormal, 1 thread", "rows, 1 thread", "rows, jobs", "rows + tangents, jobs", "octahedral, jobs" };
+        char label[64];
+        for (u32 p = 0; p < ARRAYCOUNT(pass_names); ++p)
+        {
+            snprintf(label, sizeof(label), "%s %s", kernel_names[k], pass_names[p]);
+            BenchReport(label, best[p], (r64)samples, "samples");
+        }
+        LogInfo("    %.1fx over SampleNormal on 1 thread, max deviation %.2e (octahedral %.2e)",
+                best[0] / best[1], max_error, max_oct_error);
+    }
+
+    PlatformVirtualFree(encoded);
+    PlatformVirtualFree(tangents);
+    PlatformVirtualFree(reference);
+    PlatformVirtualFree(normals);
+    PlatformVirtualFree(heightmap);
+}
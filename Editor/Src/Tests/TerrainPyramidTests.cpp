@@ -0,0 +1,209 @@
+
+// Benchmarks of Terrain/TerrainPyramid.h
+
+#define PYRAMID_BENCH_SIZE 8192
+#define PYRAMID_BENCH_RUNS 3
+#define PYRAMID_BENCH_TAPS 8
+
+// The straightforward version: one level at a time on one thread, every sample of the block
+// read with clamped indexing, no SIMD
+template <typename T>
+static void
+PyramidBenchNaiveLevel(terrain::PyramidReduce reduce, const r32 *weights, const T *src, u32 width, u32 height,
+                       T *dst, r32 *column)
+{
+    u32 dst_width  = (width + 1) / 2;
+    u32 dst_height = (height + 1) / 2;
+
+    if (reduce == terrain::PyramidReduce::Lanczos)
+    {
+        for (u32 y = 0; y < dst_height; ++y)
+        {
+            for (u32 x = 0; x < width; ++x)
+            {
+                r32 acc = 0.0f;
+                for (i32 k = 0; k < PYRAMID_BENCH_TAPS; ++k)
+                {
+                    i32 row = (i32)(2 * y) + k - PYRAMID_BENCH_TAPS / 2 + 1;
+                    row = (row < 0) ? 0 : ((row > (i32)height - 1) ? (i32)height - 1 : row);
+                    acc += weights[k] * (r32)src[(u64)row * width + x];
+                }
+                column[x] = acc;
+            }
+            for (u32 x = 0; x < dst_width; ++x)
+            {
+                r32 acc = 0.0f;
+                for (i32 k = 0; k < PYRAMID_BENCH_TAPS; ++k)
+                {
+                    i32 col = (i32)(2 * x) + k - PYRAMID_BENCH_TAPS / 2 + 1;
+                    col = (col < 0) ? 0 : ((col > (i32)width - 1) ? (i32)width - 1 : col);
+                    acc += weights[k] * column[col];
+                }
+                if (sizeof(T) == sizeof(u16))
+                {
+                    acc = (acc > 0.0f) ? acc : 0.0f;
+                    acc = (acc < 65535.0f) ? acc : 65535.0f;
+                    dst[(u64)y * dst_width + x] = (T)(u16)(acc + 0.5f);
+                }
+                else
+                {
+                    dst[(u64)y * dst_width + x] = (T)acc;
+                }
+            }
+        }
+        return;
+    }
+
+    for (u32 y = 0; y < dst_height; ++y)
+    {
+        u32 y0 = 2 * y;
+        u32 y1 = (2 * y + 1 < height) ? 2 * y + 1 : height - 1;
+        for (u32 x = 0; x < dst_width; ++x)
+        {
+            u32 x0 = 2 * x;
+            u32 x1 = (2 * x + 1 < width) ? 2 * x + 1 : width - 1;
+            T a = src[(u64)y0 * width + x0];
+            T b = src[(u64)y1 * width + x0];
+            T c = src[(u64)y0 * width + x1];
+            T d = src[(u64)y1 * width + x1];
+
+            T result;
+            if (reduce == terrain::PyramidReduce::Min)
+            {
+                T ab = (a < b) ? a : b;
+                T cd = (c < d) ? c : d;
+                result = (ab < cd) ? ab : cd;
+            }
+            else if (reduce == terrain::PyramidReduce::Max)
+            {
+                T ab = (a > b) ? a : b;
+                T cd = (c > d) ? c : d;
+                result = (ab > cd) ? ab : cd;
+            }
+            else if (sizeof(T) == sizeof(u16))
+            {
+                result = (T)(((u32)a + (u32)b + (u32)c + (u32)d + 2) >> 2);
+            }
+            else
+            {
+                result = (T)(((a + b) + (c + d)) * 0.25f);
+            }
+            dst[(u64)y * dst_width + x] = result;
+        }
+    }
+}
+
+// Builds every level below level 0 into "levels", one after the other
+// @returns the time in ms
+template <typename T>
+static r64
+PyramidBenchNaive(terrain::PyramidReduce reduce, const T *heightmap, u32 size, u32 level_count, T *levels, r32 *column)
+{
+    r32 weights[PYRAMID_BENCH_TAPS];
+    terrain::PyramidLanczosWeights(weights);
+
+    Timer timer;
+    TimerBegin(&timer);
+    const T *src = heightmap;
+    u32 width  = size;
+    u32 height = size;
+    T *dst = levels;
+    for (u32 level = 1; level < level_count; ++level)
+    {
+        PyramidBenchNaiveLevel<T>(reduce, weights, src, width, height, dst, column);
+        src    = dst;
+        width  = (width + 1) / 2;
+        height = (height + 1) / 2;
+        dst   += (u64)width * height;
+    }
+    return TimerMiliSecondsElapsed(&timer);
+}
+
+// -bench pyramid: HeightPyramidBuild on 8192^2 r32 and u16 heightmaps with every reduction,
+// against the naive scalar build. The two have to give the same bits.
+static void
+BenchHeightPyramid()
+{
+    u32 size = PYRAMID_BENCH_SIZE;
+    u64 samples = (u64)size * size;
+    u32 level_count = terrain::HeightPyramidLevelCount(size, size);
+
+    r32 *heights_r32 = (r32*)PlatformVirtualAlloc(sizeof(r32) * samples);
+    u16 *heights_u16 = (u16*)PlatformVirtualAlloc(sizeof(u16) * samples);
+    // The levels past level 0 take a third of its samples, plus the odd edges
+    void *naive_levels = PlatformVirtualAlloc(sizeof(r32) * (samples / 2));
+    r32  *column       = (r32*)PlatformVirtualAlloc(sizeof(r32) * size);
+
+    TestRng rng = TestRngInit(20);
+    for (u64 i = 0; i < samples; ++i)
+    {
+        u32 r = TestRandom(&rng);
+        heights_r32[i] = (r32)(r >> 8) * (100.0f / 16777216.0f) - 50.0f;
+        heights_u16[i] = (u16)(r >> 16);
+    }
+
+    LogInfo("    %ux%u, %u levels, %u threads, best of %u runs", size, size, level_count,
+            JobSystemGetThreadCount(), PYRAMID_BENCH_RUNS);
+
+    const char *format_names[] = { "r32", "u16" };
+    const char *reduce_names[] = { "min", "max", "average", "lanczos" };
+    for (u32 f = 0; f < ARRAYCOUNT(format_names); ++f)
+    {
+        terrain::HeightFormat format = (terrain::HeightFormat)f;
+        u32 sample_size = (format == terrain::HeightFormat::R32) ? sizeof(r32) : sizeof(u16);
+
+        for (u32 r = 0; r < ARRAYCOUNT(reduce_names); ++r)
+        {
+            terrain::HeightPyramidDesc desc = {};
+            desc.heightmap = (format == terrain::HeightFormat::R32) ? (void*)heights_r32 : (void*)heights_u16;
+            desc.width     = size;
+            desc.height    = size;
+            desc.format    = format;
+            desc.reduce    = (terrain::PyramidReduce)r;
+
+            r64 naive_ms   = 0.0;
+            r64 pyramid_ms = 0.0;
+            bool match = true;
+            for (u32 run = 0; run < PYRAMID_BENCH_RUNS; ++run)
+            {
+                r64 ms = (format == terrain::HeightFormat::R32)
+                    ? PyramidBenchNaive<r32>(desc.reduce, heights_r32, size, level_count, (r32*)naive_levels, column)
+                    : PyramidBenchNaive<u16>(desc.reduce, heights_u16, size, level_count, (u16*)naive_levels, column);
+                if (run == 0 || ms < naive_ms) naive_ms = ms;
+
+                terrain::HeightPyramid pyramid;
+                Timer timer;
+                TimerBegin(&timer);
+                terrain::HeightPyramidBuild(&pyramid, &desc);
+                ms = TimerMiliSecondsElapsed(&timer);
+                if (run == 0 || ms < pyramid_ms) pyramid_ms = ms;
+
+                u8 *naive_level = (u8*)naive_levels;
+                for (u32 level = 1; level < pyramid.levels; ++level)
+                {
+                    u64 level_size = (u64)pyramid.width[level] * pyramid.height[level] * sample_size;
+                    match &= (memcmp(naive_level, pyramid.level[level], level_size) == 0);
+                    naive_level += level_size;
+                }
+                terrain::HeightPyramidFree(&pyramid);
+            }
+
+            char label[64];
+            snprintf(label, sizeof(label), "%s %s, naive", format_names[f], reduce_names[r]);
+            BenchReport(label, naive_ms, (r64)samples / 1e6, "Msamples");
+            snprintf(label, sizeof(label), "%s %s, pyramid", format_names[f], reduce_names[r]);
+            BenchReport(label, pyramid_ms, (r64)samples / 1e6, "Msamples");
+            LogInfo("    %.1fx, %s", naive_ms / pyramid_ms, match ? "same levels" : "LEVELS DIFFER");
+            if (!match) LogError("The %s %s pyramid does not match the naive build!", format_names[f], reduce_names[r]);
+        }
+    }
+
+    PlatformVirtualFree(column);
+    PlatformVirtualFree(naive_levels);
+    PlatformVirtualFree(heights_u16);
+    PlatformVirtualFree(heights_r32);
+}
+
+#undef PYRAMID_BENCH_TAPS
+#undef PYRAMID_BENCH_RUNS
+#undef PYRAMID_BENCH_SIZE
@@ -0,0 +1,152 @@
+
+file_global u32 g_test_checks   = 0;
+file_global u32 g_test_failures = 0;
+
+static TestRng
+TestRngInit(u64 seed)
+{
+    TestRng result;
+    result.state = seed * 0x9E3779B97F4A7C15ull + 1;
+    return result;
+}
+
+static u32
+TestRandom(TestRng *rng)
+{
+    u64 x = rng->state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    rng->state = x;
+    return (u32)(x >> 32);
+}
+
+static u32
+TestRandomRange(TestRng *rng, u32 count)
+{
+    return (u32)(((u64)TestRandom(rng) * count) >> 32);
+}
+
+static void
+BenchReport(const char *label, r64 ms, r64 count, const char *unit)
+{
+    LogInfo("%-32s %10.2f ms  %12.1f %s/s", label, ms, count * 1000.0 / ms, unit);
+}
+
+static bool
+TestCheckImpl(bool passed, const char *expr, const char *file, int line)
+{
+    ++g_test_checks;
+    if (!passed)
+    {
+        ++g_test_failures;
+        LogError("%s(%d): check failed: %s", file, line, expr);
+    }
+    return passed;
+}
+
+#include "Tests/MemoryTests.cpp"
+#include "Tests/StrPoolTests.cpp"
+#include "Tests/JobSystemTests.cpp"
+#include "Tests/TerrainNoiseTests.cpp"
+#include "Tests/TerrainMesherTests.cpp"
+#include "Tests/TerrainLodTests.cpp"
+#include "Tests/TerrainClipmapTests.cpp"
+#include "Tests/TerrainFileTests.cpp"
+#include "Tests/TerrainNormalsTests.cpp"
+#include "Tests/TerrainErosionTests.cpp"
+#include "Tests/TerrainPyramidTests.cpp"
+#include "Tests/TomlTests.cpp"
+
+file_global TestEntry g_selftest_entries[] = {
+    { "memory_realloc", TestMemoryRealloc },
+    { "lod",            TestTerrainLod    },
+    { "terrain_file",   TestTerrainFile   },
+    { "noise_hash",     TestNoiseHash     },
+    { "toml_numbers",   TestTomlNumbers   },
+};
+
+file_global BenchEntry g_bench_entries[] = {
+    { "memory_trace",       BenchMemoryTrace      },
+    { "memory_mt",          BenchMemoryThreads    },
+    { "str_pool_mt",        BenchStrPoolThreads   },
+    { "jobs",               BenchJobSystem        },
+    { "noise",              BenchNoise            },
+    { "noise_checker",      BenchNoiseChecker     },
+    { "noise_discrete",     BenchNoiseDiscrete    },
+    { "noise_linear_value", BenchNoiseLinearValue },
+    { "noise_faded_value",  BenchNoiseFadedValue  },
+    { "noise_cubic_value",  BenchNoiseCubicValue  },
+    { "noise_perlin",       BenchNoisePerlin      },
+    { "noise_simplex",      BenchNoiseSimplex     },
+    { "noise_worley",       BenchNoiseWorley      },
+    { "noise_spots",        BenchNoiseSpots       },
+    { "noise_hash",         BenchNoiseHash        },
+    { "tiles",              BenchTileMeshing      },
+    { "lod",                BenchTerrainLod       },
+    { "clipmap",            BenchClipmap          },
+    { "terrain_file",       BenchTerrainFile      },
+    { "normals",            BenchTerrainNormals   },
+    { "erosion",            BenchErosion          },
+    { "pyramid",            BenchHeightPyramid    },
+    { "toml_cache",         BenchTomlCache        },
+};
+
+static int
+RunBench(const char *name)
+{
+    if (!name)
+    {
+        LogInfo("Benchmarks (-bench <name>, or all):");
+        for (u32 i = 0; i < ARRAYCOUNT(g_bench_entries); ++i) LogInfo("    %s", g_bench_entries[i].name);
+        return 0;
+    }
+
+    bool found = false;
+    for (u32 i = 0; i < ARRAYCOUNT(g_bench_entries); ++i)
+    {
+        if (strcmp(name, "all") != 0 && strcmp(name, g_bench_entries[i].name) != 0) continue;
+
+        LogInfo("-- %s", g_bench_entries[i].name);
+        g_bench_entries[i].fn();
+        found = true;
+    }
+
+    if (!found)
+    {
+        LogError("Unknown benchmark \"%s\", run -bench to list them.", name);
+        return 1;
+    }
+    return 0;
+}
+
+static int
+RunSelfTests(const char *name)
+{
+    g_test_checks   = 0;
+    g_test_failures = 0;
+
+    bool found = false;
+    for (u32 i = 0; i < ARRAYCOUNT(g_selftest_entries); ++i)
+    {
+        if (name && strcmp(name, g_selftest_entries[i].name) != 0) continue;
+
+        LogInfo("-- %s", g_selftest_entries[i].name);
+        g_selftest_entries[i].fn();
+        found = true;
+    }
+
+    if (!found)
+    {
+        LogError("Unknown self test \"%s\".", name);
+        return 1;
+    }
+
+    if (g_test_failures)
+    {
+        LogError("%u of %u checks failed.", g_test_failures, g_test_checks);
+        return 1;
+    }
+    LogInfo("All %u checks passed.", g_test_checks);
+    return 0;
+}
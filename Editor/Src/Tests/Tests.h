@@ -0,0 +1,50 @@
+#ifndef _TESTS_H
+#define _TESTS_H
+
+// NOTE(Dustin): Self tests and benchmarks for the core and terrain systems, run by the
+// headless build:
+//
+//     SaplingHeadless -selftest [name] runs every self test (or one), exits with 1 on a failure
+//     SaplingHeadless -bench <name>    runs one benchmark, "all" runs every one
+//     SaplingHeadless -bench           lists the benchmarks
+//
+// Each module keeps its tests and benchmarks in a file next to this one, and adds them to
+// the tables at the bottom of Tests.cpp. Build in release mode for numbers worth comparing.
+
+typedef void (*PFN_BenchFn)();
+
+struct BenchEntry
+{
+    const char  *name;
+    PFN_BenchFn  fn;
+};
+
+// Self tests share the entry layout, and report failures through TestCheck
+typedef BenchEntry TestEntry;
+
+// Logs the failed condition and counts it against the current -selftest run
+#define TestCheck(cond) TestCheckImpl((cond), #cond, __FILE__, __LINE__)
+
+// Deterministic xorshift, so every run replays the same sequence
+struct TestRng
+{
+    u64 state;
+};
+
+static TestRng TestRngInit(u64 seed);
+static u32     TestRandom(TestRng *rng);
+// [0, count)
+static u32     TestRandomRange(TestRng *rng, u32 count);
+
+// Logs "label: ms, and count / second in unit" for a timed loop
+static void    BenchReport(const char *label, r64 ms, r64 count, const char *unit);
+
+static bool    TestCheckImpl(bool passed, const char *expr, const char *file, int line);
+
+// @returns the process exit code
+static int     RunBench(const char *name);
+// @param name: NULL runs every self test
+// @returns the process exit code
+static int     RunSelfTests(const char *name);
+
+#endif //_TESTS_H
@@ -0,0 +1,218 @@
+
+// Self tests and benchmarks of Common/Util/Parsers/TomlParser.h
+
+// Written to the working directory and removed afterwards
+#define TOML_TEST_PATH "selftest.toml"
+
+static void
+TomlTestWrite(const char *path, const char *text)
+{
+    FILE *fp = fopen(path, "wb");
+    fwrite(text, 1, strlen(text), fp);
+    fclose(fp);
+}
+
+static TomlResult
+TomlTestLoad(Toml *toml, const char *text)
+{
+    TomlTestWrite(TOML_TEST_PATH, text);
+    TomlResult result = TomlLoad(toml, TOML_TEST_PATH);
+    remove(TOML_TEST_PATH);
+    return result;
+}
+
+// -selftest toml_numbers: integers, floats with exponents and '_' separators, and numbers
+// followed by name characters, which are errors
+static void
+TestTomlNumbers()
+{
+    const char *valid =
+        "[Numbers]\n"
+        "int          = 42\n"
+        "negative     = -17\n"
+        "separated    = 1_000_000\n"
+        "fraction     = 0.25\n"
+        "leading_dot  = .5\n"
+        "small        = 1e-5\n"
+        "large        = 2.5E+3\n"
+        "negative_exp = -3.5e2\n"
+        "plain_exp    = 4e2\n"
+        "list         = [1e-5, 2.5E+3, 3.0]\n";
+
+    Toml toml;
+    if (TestCheck(TomlTestLoad(&toml, valid) == TomlResult_Success))
+    {
+        TomlObject numbers = TomlGetObject(&toml, "Numbers");
+        TestCheck(TomlGetInt(&numbers, "int") == 42);
+        TestCheck(TomlGetInt(&numbers, "negative") == -17);
+        TestCheck(TomlGetInt(&numbers, "separated") == 1000000);
+        TestCheck(TomlGetFloat(&numbers, "fraction") == 0.25f);
+        TestCheck(TomlGetFloat(&numbers, "leading_dot") == 0.5f);
+        TestCheck(TomlGetFloat(&numbers, "small") == 1e-5f);
+        TestCheck(TomlGetFloat(&numbers, "large") == 2500.0f);
+        TestCheck(TomlGetFloat(&numbers, "negative_exp") == -350.0f);
+        TestCheck(TomlGetFloat(&numbers, "plain_exp") == 400.0f);
+
+        TomlData *list = TomlGetArray(&numbers, "list");
+        TestCheck(TomlGetArrayLen(list) == 3);
+        TestCheck(TomlGetFloatArrayElem(list, 0) == 1e-5f);
+        TestCheck(TomlGetFloatArrayElem(list, 1) == 2500.0f);
+        TestCheck(TomlGetFloatArrayElem(list, 2) == 3.0f);
+    }
+    TomlFree(&toml);
+
+    const char *invalid[] = {
+        "[Numbers]\nvalue = 12abc\n",
+        "[Numbers]\nvalue = 3.5f\n",
+        "[Numbers]\nvalue = 1e\n",
+        "[Numbers]\nvalue = 1e+\n",
+        "[Numbers]\nvalue = 1e5x\n",
+    };
+    for (u32 i = 0; i < ARRAYCOUNT(invalid); ++i)
+    {
+        TestCheck(TomlTestLoad(&toml, invalid[i]) == TomlResult_ParseError);
+        TomlFree(&toml);
+    }
+}
+
+#define TOML_BENCH_DIR   "bench_toml"
+#define TOML_BENCH_CACHE "bench_toml.cache"
+#define TOML_BENCH_FILES 10000
+#define TOML_BENCH_RUNS  3
+#define TOML_BENCH_PATH  32
+
+static void
+TomlBenchGuid(TestRng *rng, char *guid)
+{
+    const char *hex = "0123456789abcdef";
+    for (u32 i = 0; i < 32; ++i) guid[i] = hex[TestRandomRange(rng, 16)];
+    guid[32] = 0;
+}
+
+// Reads the values DeserializeMetafile reads, so every load touches the same data
+static u64
+TomlBenchConsume(Toml *toml)
+{
+    TomlObject obj = TomlGetObject(toml, "Metadata");
+    u64 result = strlen(toml->title) + strlen(TomlGetString(&obj, "GUID")) + TomlGetStringLen(&obj, "Icon");
+
+    TomlData *dependencies = TomlGetArray(&obj, "Dependencies");
+    for (int i = 0; i < TomlGetArrayLen(dependencies); ++i) result += TomlGetStringArrayElem(dependencies, i)[0];
+    return result;
+}
+
+// Loads every file, through the cache when "cache_path" is not NULL
+// @param from_cache: (output) files whose tables came from the cache
+// @returns the time in ms, cache open and close included
+static r64
+TomlBenchLoad(const char *paths, const char *cache_path, u64 *consumed, u32 *from_cache)
+{
+    *consumed   = 0;
+    *from_cache = 0;
+
+    Timer timer;
+    TimerBegin(&timer);
+    TomlCache cache;
+    if (cache_path) TomlCacheOpen(&cache, cache_path);
+    for (u32 i = 0; i < TOML_BENCH_FILES; ++i)
+    {
+        const char *path = paths + i * TOML_BENCH_PATH;
+
+        Toml toml;
+        TomlResult result = TomlLoadCached(&toml, path, cache_path ? &cache : NULL);
+        if (result != TomlResult_Success)
+        {
+            LogError("Failed to load \"%s\" (error %d).", path, (int)result);
+            continue;
+        }
+
+        *consumed   += TomlBenchConsume(&toml);
+        *from_cache += (toml.cache != NULL);
+        TomlFree(&toml);
+    }
+    if (cache_path) TomlCacheClose(&cache);
+    return TimerMiliSecondsElapsed(&timer);
+}
+
+// -bench toml_cache: startup over 10k asset metafiles. Cold parses every file with TomlLoad,
+// the first cached run parses and compiles them into an empty cache and writes it, and warm
+// runs load every document from the cache written by the one before. The files stay in the
+// page cache, so these are the parse and compile costs, not the disk.
+static void
+BenchTomlCache()
+{
+    mkdir(TOML_BENCH_DIR, 0755);
+    remove(TOML_BENCH_CACHE);
+
+    char *paths = (char*)SysAlloc(TOML_BENCH_FILES * TOML_BENCH_PATH);
+    TestRng rng = TestRngInit(25);
+    u64 bytes = 0;
+    for (u32 i = 0; i < TOML_BENCH_FILES; ++i)
+    {
+        char *path = paths + i * TOML_BENCH_PATH;
+        snprintf(path, TOML_BENCH_PATH, TOML_BENCH_DIR "/m%05u.meta", i);
+
+        // The layout SerializeMetafile writes
+        char guid[33], icon[33], text[512];
+        TomlBenchGuid(&rng, guid);
+        TomlBenchGuid(&rng, icon);
+        int len = snprintf(text, sizeof(text), "title = \"asset_%u\"\n\n[Metadata]\nGUID = \"%s\"\nIcon = \"%s\"\nDependencies = [",
+                           i, guid, (i % 3) ? icon : "");
+        u32 dependencies = TestRandomRange(&rng, 4);
+        for (u32 d = 0; d < dependencies; ++d)
+        {
+            TomlBenchGuid(&rng, guid);
+            len += snprintf(text + len, sizeof(text) - len, "%s\"%s\"", d ? ", " : "", guid);
+        }
+        len += snprintf(text + len, sizeof(text) - len, "]\n");
+
+        TomlTestWrite(path, text);
+        bytes += (u64)len;
+    }
+
+    u64 cold_consumed = 0, consumed = 0;
+    u32 from_cache = 0;
+    r64 cold_ms = 0.0;
+    for (u32 run = 0; run < TOML_BENCH_RUNS; ++run)
+    {
+        r64 ms = TomlBenchLoad(paths, NULL, &cold_consumed, &from_cache);
+        if (run == 0 || ms < cold_ms) cold_ms = ms;
+    }
+
+    r64 compile_ms = TomlBenchLoad(paths, TOML_BENCH_CACHE, &consumed, &from_cache);
+    bool match = (consumed == cold_consumed);
+
+    r64 warm_ms = 0.0;
+    u32 warm_from_cache = TOML_BENCH_FILES;
+    for (u32 run = 0; run < TOML_BENCH_RUNS; ++run)
+    {
+        r64 ms = TomlBenchLoad(paths, TOML_BENCH_CACHE, &consumed, &from_cache);
+        if (run == 0 || ms < warm_ms) warm_ms = ms;
+        match &= (consumed == cold_consumed);
+        warm_from_cache = (from_cache < warm_from_cache) ? from_cache : warm_from_cache;
+    }
+
+    struct stat cache_info = {};
+    stat(TOML_BENCH_CACHE, &cache_info);
+
+    LogInfo("    %u files, %.1f KB of text, %.1f KB cache, best of %u runs", TOML_BENCH_FILES,
+            bytes / 1024.0, cache_info.st_size / 1024.0, TOML_BENCH_RUNS);
+    BenchReport("cold, TomlLoad", cold_ms, TOML_BENCH_FILES, "files");
+    BenchReport("first run, compile to cache", compile_ms, TOML_BENCH_FILES, "files");
+    BenchReport("warm, TomlLoadCached", warm_ms, TOML_BENCH_FILES, "files");
+    LogInfo("    %.1fx over cold, %.2f us per file, %u of %u from the cache, %s", cold_ms / warm_ms,
+            warm_ms * 1000.0 / TOML_BENCH_FILES, warm_from_cache, TOML_BENCH_FILES,
+            match ? "same values" : "VALUES DIFFER");
+    if (!match) LogError("The cached documents do not match the parsed files!");
+
+    for (u32 i = 0; i < TOML_BENCH_FILES; ++i) remove(paths + i * TOML_BENCH_PATH);
+    remove(TOML_BENCH_CACHE);
+    rmdir(TOML_BENCH_DIR);
+    SysFree(paths);
+}
+
+#undef TOML_BENCH_PATH
+#undef TOML_BENCH_RUNS
+#undef TOML_BENCH_FILES
+#undef TOML_BENCH_CACHE
+#undef TOML_BENCH_DIR
@@ -1,7 +1,9 @@
 
 #define MAPLE_MEMORY_IMPLEMENTATION
+#define MAPLE_ARENA_IMPLEMENTATION
 #define MAPLE_STRING_IMPLEMENTATION
 #define MAPLE_STR_POOL_IMPLEMENTATION
+#define MAPLE_STR_BUILDER_IMPLEMENTATION
 #define MAPLE_MATH_IMPLEMENTATION
 #define STB_DS_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -31,9 +33,11 @@
 #include "Core/SysMemory.h"
 
 #include "Common/Util/Memory.h"
+#include "Common/Util/Arena.h"
 #include "Common/Util/stb_ds.h"
 #include "Common/Util/stb_image.h"
-//#include "Common/Util/StrPool.h"
+#include "Common/Util/StrPool.h"
+#include "Common/Util/StrBuilder.h"
 #include "Common/Util/MapleMath.h"
 #include "Common/Util/String.cpp"
 
@@ -46,10 +50,35 @@
 #include "Platform/HostWindow.h"
 
 #include "Core/SysMemory.cpp"
+#include "Core/JobSystem.h"
+#include "Core/JobSystem.cpp"
 
-// Load ImGui Library
+#include "Terrain/TerrainNoise.h"
+#include "Terrain/TerrainNoise.cpp"
+#include "Terrain/TerrainErosion.h"
+#include "Terrain/TerrainErosion.cpp"
+#include "Terrain/TerrainNormals.h"
+#include "Terrain/TerrainNormals.cpp"
+#include "Terrain/TerrainPyramid.h"
+#include "Terrain/TerrainPyramid.cpp"
+#include "Terrain/TerrainMesher.h"
+#include "Terrain/TerrainMesher.cpp"
+#include "Terrain/TerrainLod.h"
+#include "Terrain/TerrainLod.cpp"
+#include "Terrain/TerrainClipmap.h"
+#include "Terrain/TerrainClipmap.cpp"
+#include "Terrain/TerrainCodec.h"
+#include "Terrain/TerrainCodec.cpp"
+#include "Terrain/TerrainFile.h"
+#include "Terrain/TerrainFile.cpp"
+#include "Terrain/TerrainGraph.h"
+#include "Terrain/TerrainGraph.cpp"
+
+// Load ImGui Library. The Posix build is headless and does not use it.
+#if defined(_WIN32)
 #include "../ext/imgui/imgui.h"
 #include "../ext/imgui-node-editor/imgui_node_editor.h"
 #pragma comment(lib, "imgui.lib")
+#endif
 
 #include "Platform/Platform.cpp"
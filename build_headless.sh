@@ -0,0 +1,52 @@
+#!/bin/bash
+
+# Builds the headless (Posix) version of the engine core. There is no window,
+# renderer or editor in this build, see Editor/Src/Platform/Posix.
+#
+# usage: ./build_headless.sh [release]
+#
+# bin/<mode>/SaplingHeadless -bench lists the benchmarks, see Editor/Src/Tests/Tests.h.
+# bin/<mode>/SaplingHeadless -selftest runs the self tests and exits with 1 if any check fails.
+
+# Project directory
+HOST_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+
+# General Flags and whatnot
+
+CXX=${CXX:-g++}
+
+debug_flags="-O0 -g -D_DEBUG"
+release_flags="-O2 -DNDEBUG"
+linker_flags="-lpthread"
+defines=""
+common_flags="-std=c++17 -Wall -Wno-unused-function -Wno-unused-variable -Wno-unknown-pragmas ${defines} -I${HOST_DIR} -I${HOST_DIR}/Editor/Src"
+
+input_main="${HOST_DIR}/Editor/Src/UnityBuild.cpp"
+output_main="SaplingHeadless"
+
+mode=debug
+if [ "$1" == "release" ]; then mode=release; fi
+
+if [ "$mode" == "debug" ]; then
+    flags="${common_flags} ${debug_flags}"
+else
+    flags="${common_flags} ${release_flags}"
+fi
+
+echo "Building in ${mode} mode."
+
+mkdir -p "${HOST_DIR}/bin/${mode}"
+pushd "${HOST_DIR}/bin/${mode}" > /dev/null
+
+echo "     -Compiling Headless:"
+${CXX} ${flags} "${input_main}" -o ${output_main} ${linker_flags}
+if [ $? -ne 0 ]; then
+    echo "Error during compilation!"
+    popd > /dev/null
+    exit 1
+fi
+
+popd > /dev/null
+
+echo "Build complete!"
+exit 0
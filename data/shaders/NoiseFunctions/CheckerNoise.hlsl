@@ -0,0 +1,18 @@
+#include "NoiseCommon.hlsl"
+#include "NoiseData.hlsl"
+
+// Alternating -1/1 cells. The key only flips the parity, so the octaves differ.
+float checkerNoise(float2 pos, uint2 key)
+{
+	int x = (int)floor(pos.x);
+	int y = (int)floor(pos.y);
+
+	return ((x + y + (int)key.x) & 1) ? 1.0f : -1.0f;
+}
+
+float baseNoise(float2 pos, uint2 key)
+{
+	return checkerNoise(pos, key);
+}
+
+#include "NoiseFractal.hlsl"
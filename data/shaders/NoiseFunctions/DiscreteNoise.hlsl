@@ -0,0 +1,10 @@
+#include "NoiseCommon.hlsl"
+#include "NoiseData.hlsl"
+#include "ValueNoise.hlsl"
+
+float baseNoise(float2 pos, uint2 key)
+{
+	return discreteNoise(pos, key);
+}
+
+#include "NoiseFractal.hlsl"
@@ -0,0 +1,10 @@
+#include "NoiseCommon.hlsl"
+#include "NoiseData.hlsl"
+#include "ValueNoise.hlsl"
+
+float baseNoise(float2 pos, uint2 key)
+{
+	return bilinearValueNoise(pos, key, true);
+}
+
+#include "NoiseFractal.hlsl"
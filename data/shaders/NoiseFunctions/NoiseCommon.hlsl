@@ -14,6 +14,74 @@ unsigned int hash(unsigned int seed)
     return seed;
 }
 
+// Lattice hashes. A lattice point and a 64-bit key go through the rounds of xxHash32,
+// using integer math only so the CPU (TerrainNoise.cpp) gets the same bits. Each round is
+// a bijection of the coordinate, so the hashes along an axis only repeat after 2^32 cells,
+// and every bit of the key changes every hash.
+#define NOISE_PRIME_1 0x9E3779B1u
+#define NOISE_PRIME_2 0x85EBCA77u
+#define NOISE_PRIME_3 0xC2B2AE3Du
+#define NOISE_PRIME_4 0x27D4EB2Fu
+#define NOISE_PRIME_5 0x165667B1u
+
+uint rotl(uint v, uint r)
+{
+    return (v << r) | (v >> (32 - r));
+}
+
+uint hashRound(uint h, uint v)
+{
+    return rotl(h + v * NOISE_PRIME_3, 17) * NOISE_PRIME_4;
+}
+
+// Final mix of xxHash32
+uint hashAvalanche(uint h)
+{
+    h ^= h >> 15;
+    h *= NOISE_PRIME_2;
+    h ^= h >> 13;
+    h *= NOISE_PRIME_3;
+    h ^= h >> 16;
+    return h;
+}
+
+uint hashLattice2(int x, int y, uint2 key)
+{
+    uint h = key.x + NOISE_PRIME_5;
+    h = hashRound(h, (uint)x);
+    h = hashRound(h, (uint)y);
+    return hashAvalanche(h ^ key.y);
+}
+
+uint hashLattice3(int x, int y, int z, uint2 key)
+{
+    uint h = key.x + NOISE_PRIME_5;
+    h = hashRound(h, (uint)x);
+    h = hashRound(h, (uint)y);
+    h = hashRound(h, (uint)z);
+    return hashAvalanche(h ^ key.y);
+}
+
+// Key of an octave, so the octaves of a seed are unrelated to each other and to the
+// octaves of nearby seeds
+uint2 octaveKey(uint2 seed, int octave)
+{
+    return uint2(seed.x ^ hashAvalanche((uint)octave + NOISE_PRIME_1), seed.y);
+}
+
+// Hash of an integer grid cell, used by the cell based noise functions
+uint hashCell(int x, int y, uint2 key)
+{
+    return hashLattice2(x, y, key);
+}
+
+// Maps a hash to a float between [0, 1). Only the top 24 bits are used, so the
+// conversion is exact.
+float unitFloat(uint h)
+{
+    return (float)(h >> 8) * (1.0f / 16777216.0f);
+}
+
 // Returns a random integer between [min, max]
 int randomIntRange(int min, int max, int seed)
 {
@@ -74,12 +142,6 @@ float randomGrid(int x, int y, int z, int seed = 0)
     return mapToSigned(randomFloat((unsigned int)(x * 1723.0f + y * 93241.0f + z * 149812.0f + 3824.0f + seed)));
 }
 
-// Random unsigned int for a grid coordinate [0, MAXUINT]
-unsigned int randomIntGrid(float x, float y, float z, float seed = 0.0f)
-{
-    return hash((unsigned int)(x * 1723.0f + y * 93241.0f + z * 149812.0f + 3824 + seed));
-}
-
 // Random 3D vector as float3 from grid position
 float3 vectorNoise(int x, int y, int z)
 {
@@ -104,4 +166,10 @@ float3 nonuniformScaleVector(float3 v, float xf, float yf, float zf)
 float cubic(float p0, float p1, float p2, float p3, float x)
 {
     return p1 + 0.5f * x * (p2 - p0 + x * (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3 + x * (3.0f * (p1 - p2) + p3 - p0)));
+}
+
+// Ken Perlin's fade function
+float fade(float t)
+{
+    return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f); // 6t^5 - 15t^4 + 10t^3
 }
\ No newline at end of file
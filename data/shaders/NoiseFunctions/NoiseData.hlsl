@@ -12,12 +12,13 @@ struct ComputeShaderInput
 
 cbuffer NoiseCB : register( b0 )
 {
+	uint2  seed;    // 64-bit seed, low word first
     float  scale;
-	int    seed;
 	int    octaves;
 	float  lacunarity;
 	float  decay;
 	float  threshold;
+	int    fractal; // FRACTAL_* in NoiseFractal.hlsl
 };
 
 #define NoiseMap_RootSignature \
@@ -0,0 +1,52 @@
+// Fractal layer shared by the noise kernels. Define
+//     float baseNoise(float2 pos, uint2 key)
+// returning noise in [-1, 1] before including this file. Each octave samples
+// baseNoise at "lacunarity" times the previous frequency with its own key (see
+// octaveKey), and the octaves are combined as fBm, ridged or turbulence noise.
+
+#define FRACTAL_FBM        0
+#define FRACTAL_RIDGED     1
+#define FRACTAL_TURBULENCE 2
+
+// Maps one octave of [-1, 1] noise to [0, 1]
+float fractalOctave(float n)
+{
+	if (fractal == FRACTAL_RIDGED)
+	{
+		n = 1.0f - abs(n);
+		return n * n;
+	}
+	else if (fractal == FRACTAL_TURBULENCE)
+	{
+		return abs(n);
+	}
+
+	return 0.5f + 0.5f * n;
+}
+
+[RootSignature( NoiseMap_RootSignature )]
+[numthreads( BLOCK_SIZE, BLOCK_SIZE, 1 )]
+void main(ComputeShaderInput IN)
+{
+	float2 pos = (IN.DispatchThreadID.xy + 0.5f) * scale;
+
+	float acc  = 0.0f;
+	float amp  = 1.0f;
+	float norm = 0.0f; // sum of the octave amplitudes, keeps the result in [0, 1]
+
+	for (int i = 0; i < octaves; i++)
+	{
+		acc  += fractalOctave(baseNoise(pos, octaveKey(seed, i))) * amp;
+		norm += amp;
+
+		pos *= lacunarity;
+		amp *= decay;
+	}
+
+	float height = (norm > 0.0f) ? saturate(acc / norm) : 0.0f;
+
+	if (height < threshold)
+		heightmap[IN.DispatchThreadID.xy] = 0.0f;
+	else
+		heightmap[IN.DispatchThreadID.xy] = height;
+}
@@ -43,12 +43,6 @@ float grad(int hash, float x, float y, float z)
 	}
 }
 
-// Ken Perlin's fade function for Perlin noise
-float fade(float t)
-{
-	return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f); // 6t^5 - 15t^4 + 10t^3
-}
-
 // Dot product using a float[3] and float parameters
 // NOTE: could be cleaned up
 float dot(float g[3], float x, float y, float z)
@@ -56,23 +50,22 @@ float dot(float g[3], float x, float y, float z)
 	return g[0] * x + g[1] * y + g[2] * z;
 }
 
-float perlinNoise(float3 pos, float scale, int seed)
+float perlinNoise(float3 pos, float scale, uint2 key)
 {
-	float fseed = (float)seed;
-
 	pos.x = pos.x * scale;
 	pos.y = pos.y * scale;
 	pos.z = pos.z * scale;
 
 	// zero corner integer position
-	float ix = floor(pos.x);
-	float iy = floor(pos.y);
-	float iz = floor(pos.z);
+	float3 cell = floor(pos);
+	int ix = (int)cell.x;
+	int iy = (int)cell.y;
+	int iz = (int)cell.z;
 
 	// current position within unit cube
-	pos.x -= ix;
-	pos.y -= iy;
-	pos.z -= iz;
+	pos.x -= cell.x;
+	pos.y -= cell.y;
+	pos.z -= cell.z;
 
 	// adjust for fade
 	float u = fade(pos.x);
@@ -80,14 +73,14 @@ float perlinNoise(float3 pos, float scale, int seed)
 	float w = fade(pos.z);
 
 	// influence values
-	float i000 = grad(randomIntGrid(ix, iy, iz, fseed), pos.x, pos.y, pos.z);
-	float i100 = grad(randomIntGrid(ix + 1.0f, iy, iz, fseed), pos.x - 1.0f, pos.y, pos.z);
-	float i010 = grad(randomIntGrid(ix, iy + 1.0f, iz, fseed), pos.x, pos.y - 1.0f, pos.z);
-	float i110 = grad(randomIntGrid(ix + 1.0f, iy + 1.0f, iz, fseed), pos.x - 1.0f, pos.y - 1.0f, pos.z);
-	float i001 = grad(randomIntGrid(ix, iy, iz + 1.0f, fseed), pos.x, pos.y, pos.z - 1.0f);
-	float i101 = grad(randomIntGrid(ix + 1.0f, iy, iz + 1.0f, fseed), pos.x - 1.0f, pos.y, pos.z - 1.0f);
-	float i011 = grad(randomIntGrid(ix, iy + 1.0f, iz + 1.0f, fseed), pos.x, pos.y - 1.0f, pos.z - 1.0f);
-	float i111 = grad(randomIntGrid(ix + 1.0f, iy + 1.0f, iz + 1.0f, fseed), pos.x - 1.0f, pos.y - 1.0f, pos.z - 1.0f);
+	float i000 = grad(hashLattice3(ix,     iy,     iz,     key), pos.x,        pos.y,        pos.z);
+	float i100 = grad(hashLattice3(ix + 1, iy,     iz,     key), pos.x - 1.0f, pos.y,        pos.z);
+	float i010 = grad(hashLattice3(ix,     iy + 1, iz,     key), pos.x,        pos.y - 1.0f, pos.z);
+	float i110 = grad(hashLattice3(ix + 1, iy + 1, iz,     key), pos.x - 1.0f, pos.y - 1.0f, pos.z);
+	float i001 = grad(hashLattice3(ix,     iy,     iz + 1, key), pos.x,        pos.y,        pos.z - 1.0f);
+	float i101 = grad(hashLattice3(ix + 1, iy,     iz + 1, key), pos.x - 1.0f, pos.y,        pos.z - 1.0f);
+	float i011 = grad(hashLattice3(ix,     iy + 1, iz + 1, key), pos.x,        pos.y - 1.0f, pos.z - 1.0f);
+	float i111 = grad(hashLattice3(ix + 1, iy + 1, iz + 1, key), pos.x - 1.0f, pos.y - 1.0f, pos.z - 1.0f);
 
 	// interpolation
 	float x00 = lerp(i000, i100, u);
@@ -103,28 +96,9 @@ float perlinNoise(float3 pos, float scale, int seed)
 	return avg;
 }
 
-[RootSignature( NoiseMap_RootSignature )]
-[numthreads( BLOCK_SIZE, BLOCK_SIZE, 1 )]
-void main(ComputeShaderInput IN)
+float baseNoise(float2 pos, uint2 key)
 {
-	float acc = 1.0f;
-	float amp = 1.0f;
-	float scale_local = scale;
-
-	float pos_x = IN.DispatchThreadID.x + 0.5f;
-	float pos_y = IN.DispatchThreadID.y + 0.5f;
-	float pos_z = IN.DispatchThreadID.z; // Maybe make this 0?
-
-	for (int i = 0; i < octaves; i++)
-	{
-    	acc *= 1.0f - saturate(0.5f + 0.5f * perlinNoise(float3(pos_x * scale_local, pos_y * scale_local, pos_z * scale_local), 1.0f, seed ^ ((i + 38) * 27389482))) * amp;
-
-        scale_local *= lacunarity;
-        amp *= decay;
-    }
+	return perlinNoise(float3(pos, 0.0f), 1.0f, key);
+}
 
-	if (acc < threshold)
-		heightmap[IN.DispatchThreadID.xy] = 0.0f;	
-	else
-		heightmap[IN.DispatchThreadID.xy] = acc;
-}
\ No newline at end of file
+#include "NoiseFractal.hlsl"
@@ -7,20 +7,14 @@ static const float3 gradMap[12] = {
 	float3( 0.0f, 1.0f, 1.0f ),float3( 0.0f, -1.0f, 1.0f ),float3( 0.0f, 1.0f, -1.0f ),float3( 0.0f, -1.0f, -1.0f )
 };
 
-// Random value for simplex noise [0, 255]
-uint calcPerm(int p)
+// Maps a hash to a gradMap index, scaling the top 16 bits avoids an integer modulo
+uint gradIndex(uint h)
 {
-	return (uint)(hash(p));
-}
-
-// Random value for simplex noise [0, 11]
-uint calcPerm12(int p)
-{
-	return (uint)(hash(p) % 12);
+	return ((h >> 16) * 12) >> 16;
 }
 
 // Simplex noise adapted from Java code by Stefan Gustafson and Peter Eastman
-float simplexNoise(float3 pos, float scale, int seed)
+float simplexNoise(float3 pos, float scale, uint2 key)
 {
 	float xin = pos.x * scale;
 	float yin = pos.y * scale;
@@ -78,10 +72,11 @@ float simplexNoise(float3 pos, float scale, int seed)
 	float y3 = y0 - 1.0f + 3.0f*G3;
 	float z3 = z0 - 1.0f + 3.0f*G3;
 
-    int gi0 = calcPerm12(seed + (i * 607495) + (j * 359609) + (k * 654846));
-    int gi1 = calcPerm12(seed + (i + i1) * 607495 + (j + j1) * 359609 + (k + k1) * 654846);
-    int gi2 = calcPerm12(seed + (i + i2) * 607495 + (j + j2) * 359609 + (k + k2) * 654846);
-    int gi3 = calcPerm12(seed + (i + 1) * 607495 + (j + 1) * 359609 + (k + 1) * 654846);
+    // Gradient of each corner [0, 11]
+    int gi0 = gradIndex(hashLattice3(i,      j,      k,      key));
+    int gi1 = gradIndex(hashLattice3(i + i1, j + j1, k + k1, key));
+    int gi2 = gradIndex(hashLattice3(i + i2, j + j2, k + k2, key));
+    int gi3 = gradIndex(hashLattice3(i + 1,  j + 1,  k + 1,  key));
 
 	// Calculate the contribution from the four corners
 	float t0 = 0.6f - x0 * x0 - y0 * y0 - z0 * z0;
@@ -114,29 +109,10 @@ float simplexNoise(float3 pos, float scale, int seed)
 	return 32.0f*(n0 + n1 + n2 + n3);
 }
 
-[RootSignature( NoiseMap_RootSignature )]
-[numthreads( BLOCK_SIZE, BLOCK_SIZE, 1 )]
-void main(ComputeShaderInput IN)
+float baseNoise(float2 pos, uint2 key)
 {
-	float acc = 1.0f;
-	float amp = 1.0f;
-	float scale_local = scale;
-
-	float pos_x = IN.DispatchThreadID.x + 0.5f;
-	float pos_y = IN.DispatchThreadID.y + 0.5f;
-	float pos_z = IN.DispatchThreadID.z; // Maybe make this 0?
-
-	for (int i = 0; i < octaves; i++)
-	{
-		float val = saturate((simplexNoise(float3(pos_x * scale + 32240.7922f, pos_y * scale + 835622.882f, pos_z * scale + 824.371968f), 1.0f, seed) * 0.3f + 0.5f)) * amp;
-    	acc -= val;
-
-        scale_local *= lacunarity;
-        amp *= decay;
-    }
+	// Any z slice works, this one stays off the lattice planes
+	return simplexNoise(float3(pos, 0.5f), 1.0f, key);
+}
 
-	if (acc < threshold)
-		heightmap[IN.DispatchThreadID.xy] = 0.0f;	
-	else
-		heightmap[IN.DispatchThreadID.xy] = acc;
-}
\ No newline at end of file
+#include "NoiseFractal.hlsl"
@@ -0,0 +1,40 @@
+#include "NoiseCommon.hlsl"
+#include "NoiseData.hlsl"
+
+// Round spots with a smooth falloff, one per grid cell with a hashed center and
+// radius. Centers stay in the middle half of the cell and the radius is below
+// 0.4, so only the 3x3 cells around the sample can reach it.
+float spotsNoise(float2 pos, uint2 key)
+{
+	float2 cell = floor(pos);
+	float2 f = pos - cell;
+	int x = (int)cell.x;
+	int y = (int)cell.y;
+
+	float v = 0.0f;
+	for (int oy = -1; oy <= 1; oy++)
+	{
+		for (int ox = -1; ox <= 1; ox++)
+		{
+			uint h0 = hashCell(x + ox, y + oy, key);
+			uint h1 = hash(h0);
+			uint h2 = hash(h1);
+
+			float2 center = float2(ox, oy) + float2(0.25f + 0.5f * unitFloat(h0), 0.25f + 0.5f * unitFloat(h1));
+			float radius  = 0.15f + 0.25f * unitFloat(h2);
+
+			float2 d = center - f;
+			float s = saturate(1.0f - sqrt(d.x * d.x + d.y * d.y) / radius);
+			v = max(v, s * s * (3.0f - 2.0f * s));
+		}
+	}
+
+	return v * 2.0f - 1.0f;
+}
+
+float baseNoise(float2 pos, uint2 key)
+{
+	return spotsNoise(pos, key);
+}
+
+#include "NoiseFractal.hlsl"
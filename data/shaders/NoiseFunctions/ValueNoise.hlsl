@@ -0,0 +1,55 @@
+// Value noise: a random value per grid cell, interpolated between cells.
+
+// Random value of a grid cell [-1, 1]
+float cellValue(int x, int y, uint2 key)
+{
+	return unitFloat(hashCell(x, y, key)) * 2.0f - 1.0f;
+}
+
+// No interpolation, constant value per cell
+float discreteNoise(float2 pos, uint2 key)
+{
+	return cellValue((int)floor(pos.x), (int)floor(pos.y), key);
+}
+
+// Bilinear interpolation of the four surrounding cells. With "faded", the
+// interpolation weights go through the fade curve, which hides the cell edges.
+float bilinearValueNoise(float2 pos, uint2 key, bool faded)
+{
+	float2 cell = floor(pos);
+	float2 t = pos - cell;
+	int x = (int)cell.x;
+	int y = (int)cell.y;
+
+	if (faded)
+	{
+		t.x = fade(t.x);
+		t.y = fade(t.y);
+	}
+
+	float v00 = cellValue(x,     y,     key);
+	float v10 = cellValue(x + 1, y,     key);
+	float v01 = cellValue(x,     y + 1, key);
+	float v11 = cellValue(x + 1, y + 1, key);
+
+	return lerp(lerp(v00, v10, t.x), lerp(v01, v11, t.x), t.y);
+}
+
+// Bicubic interpolation of the surrounding 4x4 cells
+float cubicValueNoise(float2 pos, uint2 key)
+{
+	float2 cell = floor(pos);
+	float2 t = pos - cell;
+	int x = (int)cell.x;
+	int y = (int)cell.y;
+
+	float rows[4];
+	for (int r = 0; r < 4; r++)
+	{
+		int cy = y + r - 1;
+		rows[r] = cubic(cellValue(x - 1, cy, key), cellValue(x, cy, key),
+		                cellValue(x + 1, cy, key), cellValue(x + 2, cy, key), t.x);
+	}
+
+	return cubic(rows[0], rows[1], rows[2], rows[3], t.y);
+}
@@ -0,0 +1,35 @@
+#include "NoiseCommon.hlsl"
+#include "NoiseData.hlsl"
+
+// Cellular noise: distance to the nearest feature point. Every grid cell holds
+// one feature point at a hashed position, so the nearest one is always in the
+// 3x3 cells around the sample and only those are searched.
+float worleyNoise(float2 pos, uint2 key)
+{
+	float2 cell = floor(pos);
+	float2 f = pos - cell;
+	int x = (int)cell.x;
+	int y = (int)cell.y;
+
+	float min_dist2 = 8.0f;
+	for (int oy = -1; oy <= 1; oy++)
+	{
+		for (int ox = -1; ox <= 1; ox++)
+		{
+			uint h = hashCell(x + ox, y + oy, key);
+			float2 feature = float2(ox, oy) + float2(unitFloat(h), unitFloat(hash(h)));
+
+			float2 d = feature - f;
+			min_dist2 = min(min_dist2, d.x * d.x + d.y * d.y);
+		}
+	}
+
+	return saturate(sqrt(min_dist2)) * 2.0f - 1.0f;
+}
+
+float baseNoise(float2 pos, uint2 key)
+{
+	return worleyNoise(pos, key);
+}
+
+#include "NoiseFractal.hlsl"
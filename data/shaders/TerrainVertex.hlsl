@@ -1,16 +1,29 @@
-struct ModelViewProjection
+// Must match terrain::TerrainTileConstants
+struct TerrainTile
 {
     matrix MVP;
+    float4 UVTransform; // xy: scale, zw: offset into the heightmap
+    float4 Grid;        // compact vertices, xy: tile units per half cell, z: texture tiling
+    float  HeightScale;
 };
 
-ConstantBuffer<ModelViewProjection> ModelViewProjectionCB : register(b0);
+ConstantBuffer<TerrainTile> TerrainTileCB : register(b0);
 
+#if defined(TERRAIN_COMPACT_VERTEX)
+// Must match terrain::TerrainCompactVertex
+struct VertexInput
+{
+    uint2 Grid   : POSITION; // grid point, in half cells
+    uint  Normal : NORMAL;   // octahedral encoded
+};
+#else
 struct VertexInput
 {
     float2 Position : POSITION;
     float3 Normal   : NORMAL;
     float2 TexCoord : TEXCOORD;
 };
+#endif
 
 struct VertexShaderOutput
 {
@@ -25,15 +38,27 @@ VertexShaderOutput main(VertexInput IN)
 {
     VertexShaderOutput OUT;
 
+#if defined(TERRAIN_COMPACT_VERTEX)
+    // Same grid as the full vertices, see the note at the top of TerrainMesher.cpp
+    float2 grid     = (float2)IN.Grid * TerrainTileCB.Grid.xy;
+    float2 position = grid - 0.5f;
+    float2 texcoord = frac(grid * TerrainTileCB.Grid.z);
+#else
+    float2 position = IN.Position;
+    float2 texcoord = IN.TexCoord;
+#endif
+
+    float2 uv = texcoord * TerrainTileCB.UVTransform.xy + TerrainTileCB.UVTransform.zw;
+
 #if 1
-	float height = HeightmapTexture.SampleLevel(LinearRepeatSampler, IN.TexCoord, 0).x;
-    float4 pos = float4(IN.Position.x, height * 5.0f, IN.Position.y, 1.0f);
+	float height = HeightmapTexture.SampleLevel(LinearRepeatSampler, uv, 0).x;
+    float4 pos = float4(position.x, height * TerrainTileCB.HeightScale, position.y, 1.0f);
 #else
-	float4 pos = float4(IN.Position.x, 0.0f, IN.Position.y, 1.0f);
+	float4 pos = float4(position.x, 0.0f, position.y, 1.0f);
 #endif
 
-    OUT.Position = mul(ModelViewProjectionCB.MVP, pos);
-    OUT.TexCoord = IN.TexCoord;
+    OUT.Position = mul(TerrainTileCB.MVP, pos);
+    OUT.TexCoord = uv;
 
     return OUT;
 }
\ No newline at end of file
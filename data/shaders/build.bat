@@ -9,6 +9,7 @@ fxc /nologo /Od /Zi /T cs_5_1 /FoGenerateMips_CS.cso         GenerateMips_CS.hls
 fxc /nologo /Od /Zi /T cs_5_1 /FoPanoToCubemap_CS.cso        PanoToCubemap_CS.hlsl
 
 fxc /nologo /Od /Zi /T vs_5_1 /FoTerrainVertex.cso           TerrainVertex.hlsl
+fxc /nologo /Od /Zi /T vs_5_1 /DTERRAIN_COMPACT_VERTEX /FoTerrainVertexCompact.cso TerrainVertex.hlsl
 fxc /nologo /Od /Zi /T ps_5_1 /FoTerrainPixel.cso            TerrainPixel.hlsl
 
 fxc /nologo /Od /Zi /T vs_5_1 /FoSkybox_Vtx.cso              Skybox_Vtx.hlsl
@@ -16,8 +17,15 @@ fxc /nologo /Od /Zi /T ps_5_1 /FoSkybox_Pxl.cso              Skybox_Pxl.hlsl
 
 :: Noise algorithms
 
+fxc /nologo /Od /Zi /T cs_5_1 /FoCheckerNoise.cso            NoiseFunctions/CheckerNoise.hlsl
+fxc /nologo /Od /Zi /T cs_5_1 /FoDiscreteNoise.cso           NoiseFunctions/DiscreteNoise.hlsl
+fxc /nologo /Od /Zi /T cs_5_1 /FoLinearValueNoise.cso        NoiseFunctions/LinearValueNoise.hlsl
+fxc /nologo /Od /Zi /T cs_5_1 /FoFadedValueNoise.cso         NoiseFunctions/FadedValueNoise.hlsl
+fxc /nologo /Od /Zi /T cs_5_1 /FoCubicValueNoise.cso         NoiseFunctions/CubicValueNoise.hlsl
 fxc /nologo /Od /Zi /T cs_5_1 /FoPerlinNoise.cso             NoiseFunctions/PerlinNoise.hlsl
 fxc /nologo /Od /Zi /T cs_5_1 /FoSimplexNoise.cso            NoiseFunctions/SimplexNoise.hlsl
+fxc /nologo /Od /Zi /T cs_5_1 /FoWorleyNoise.cso             NoiseFunctions/WorleyNoise.hlsl
+fxc /nologo /Od /Zi /T cs_5_1 /FoSpotsNoise.cso              NoiseFunctions/SpotsNoise.hlsl
 
 fxc /nologo /Od /Zi /T vs_5_1 /FoHeightmapDownsample_Vtx.cso HeightmapDownsample_Vtx.hlsl
 fxc /nologo /Od /Zi /T ps_5_1 /FoHeightmapDownsample_Pxl.cso HeightmapDownsample_Pxl.hlsl